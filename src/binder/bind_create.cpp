@@ -112,7 +112,20 @@ auto Binder::BindCreate(duckdb_libpgquery::PGCreateStmt *pg_stmt) -> std::unique
     throw bustub::Exception("should have at least 1 column");
   }
 
-  return std::make_unique<CreateStatement>(std::move(table), std::move(columns));
+  std::vector<std::pair<std::string, std::string>> options;
+  if (pg_stmt->options != nullptr) {
+    for (auto c = pg_stmt->options->head; c != nullptr; c = lnext(c)) {
+      auto def_elem = reinterpret_cast<duckdb_libpgquery::PGDefElem *>(c->data.ptr_value);
+      auto name = StringUtil::Lower(def_elem->defname);
+      auto value = reinterpret_cast<duckdb_libpgquery::PGValue *>(def_elem->arg);
+      if (value == nullptr || value->type != duckdb_libpgquery::T_PGString) {
+        throw NotImplementedException(fmt::format("table option {} should be a string", name));
+      }
+      options.emplace_back(std::move(name), value->val.str);
+    }
+  }
+
+  return std::make_unique<CreateStatement>(std::move(table), std::move(columns), std::move(options));
 }
 
 auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<IndexStatement> {
@@ -2,6 +2,8 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
@@ -9,6 +11,7 @@
 #include "binder/bound_table_ref.h"
 #include "binder/expressions/bound_column_ref.h"
 #include "binder/expressions/bound_constant.h"
+#include "binder/statement/copy_statement.h"
 #include "binder/statement/delete_statement.h"
 #include "binder/statement/insert_statement.h"
 #include "binder/statement/select_statement.h"
@@ -84,4 +87,39 @@ auto Binder::BindUpdate(duckdb_libpgquery::PGUpdateStmt *stmt) -> std::unique_pt
   return std::make_unique<UpdateStatement>(std::move(table), std::move(filter_expr), std::move(target_expr));
 }
 
+auto Binder::BindCopy(duckdb_libpgquery::PGCopyStmt *stmt) -> std::unique_ptr<CopyStatement> {
+  if (!stmt->is_from) {
+    throw NotImplementedException("only COPY FROM is supported");
+  }
+  if (stmt->relation == nullptr || stmt->is_program || stmt->filename == nullptr) {
+    throw NotImplementedException("COPY only supports loading a table from a file");
+  }
+  if (stmt->attlist != nullptr) {
+    throw NotImplementedException("COPY with a column list is not supported");
+  }
+
+  auto table = BindBaseTableRef(stmt->relation->relname, std::nullopt);
+
+  std::vector<std::pair<std::string, std::string>> options;
+  if (stmt->options != nullptr) {
+    for (auto c = stmt->options->head; c != nullptr; c = lnext(c)) {
+      auto def_elem = reinterpret_cast<duckdb_libpgquery::PGDefElem *>(c->data.ptr_value);
+      auto name = StringUtil::Lower(def_elem->defname);
+      auto value = reinterpret_cast<duckdb_libpgquery::PGValue *>(def_elem->arg);
+      if (value == nullptr) {
+        // `HEADER` alone switches the option on.
+        options.emplace_back(std::move(name), "true");
+      } else if (value->type == duckdb_libpgquery::T_PGString) {
+        options.emplace_back(std::move(name), value->val.str);
+      } else if (value->type == duckdb_libpgquery::T_PGInteger) {
+        options.emplace_back(std::move(name), std::to_string(value->val.ival));
+      } else {
+        throw NotImplementedException(fmt::format("unsupported value of COPY option {}", name));
+      }
+    }
+  }
+
+  return std::make_unique<CopyStatement>(std::move(table), stmt->filename, std::move(options));
+}
+
 }  // namespace bustub
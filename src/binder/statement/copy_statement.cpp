@@ -0,0 +1,18 @@
+#include "binder/statement/copy_statement.h"
+#include "fmt/format.h"
+#include "fmt/ranges.h"
+
+namespace bustub {
+
+CopyStatement::CopyStatement(std::unique_ptr<BoundBaseTableRef> table, std::string file_path,
+                             std::vector<std::pair<std::string, std::string>> options)
+    : BoundStatement(StatementType::COPY_STATEMENT),
+      table_(std::move(table)),
+      file_path_(std::move(file_path)),
+      options_(std::move(options)) {}
+
+auto CopyStatement::ToString() const -> std::string {
+  return fmt::format("BoundCopy {{ table={}, file={}, options={} }}", *table_, file_path_, options_);
+}
+
+}  // namespace bustub
@@ -5,10 +5,17 @@
 
 namespace bustub {
 
-CreateStatement::CreateStatement(std::string table, std::vector<Column> columns)
-    : BoundStatement(StatementType::CREATE_STATEMENT), table_(std::move(table)), columns_(std::move(columns)) {}
+CreateStatement::CreateStatement(std::string table, std::vector<Column> columns,
+                                 std::vector<std::pair<std::string, std::string>> options)
+    : BoundStatement(StatementType::CREATE_STATEMENT),
+      table_(std::move(table)),
+      columns_(std::move(columns)),
+      options_(std::move(options)) {}
 
 auto CreateStatement::ToString() const -> std::string {
+  if (!options_.empty()) {
+    return fmt::format("BoundCreate {{\n  table={}\n  columns={}\n  options={}\n}}", table_, columns_, options_);
+  }
   return fmt::format("BoundCreate {{\n  table={}\n  columns={}\n}}", table_, columns_);
 }
 
@@ -25,6 +25,7 @@
 #include "binder/bound_expression.h"
 #include "binder/bound_order_by.h"
 #include "binder/bound_statement.h"
+#include "binder/statement/copy_statement.h"
 #include "binder/statement/create_statement.h"
 #include "binder/statement/delete_statement.h"
 #include "binder/statement/explain_statement.h"
@@ -67,6 +68,8 @@ auto Binder::BindStatement(duckdb_libpgquery::PGNode *stmt) -> std::unique_ptr<B
       return BindUpdate(reinterpret_cast<duckdb_libpgquery::PGUpdateStmt *>(stmt));
     case duckdb_libpgquery::T_PGIndexStmt:
       return BindIndex(reinterpret_cast<duckdb_libpgquery::PGIndexStmt *>(stmt));
+    case duckdb_libpgquery::T_PGCopyStmt:
+      return BindCopy(reinterpret_cast<duckdb_libpgquery::PGCopyStmt *>(stmt));
     case duckdb_libpgquery::T_PGVariableSetStmt:
       return BindVariableSet(reinterpret_cast<duckdb_libpgquery::PGVariableSetStmt *>(stmt));
     case duckdb_libpgquery::T_PGVariableShowStmt:
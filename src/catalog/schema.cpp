@@ -12,27 +12,39 @@
 
 #include "catalog/schema.h"
 
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <vector>
 
 namespace bustub {
 
-Schema::Schema(const std::vector<Column> &columns) {
-  uint32_t curr_offset = 0;
-  for (uint32_t index = 0; index < columns.size(); index++) {
-    Column column = columns[index];
-    // handle uninlined column
-    if (!column.IsInlined()) {
+Schema::Schema(const std::vector<Column> &columns) : columns_(columns) {
+  null_bitmap_size_ = (columns_.size() + 7) / 8;
+  std::vector<uint32_t> inlined_columns;
+  for (uint32_t index = 0; index < columns_.size(); index++) {
+    if (columns_[index].IsInlined()) {
+      inlined_columns.push_back(index);
+    } else {
       tuple_is_inlined_ = false;
       uninlined_columns_.push_back(index);
     }
-    // set column offset
-    column.column_offset_ = curr_offset;
-    curr_offset += column.GetFixedLength();
+  }
 
-    // add column
-    this->columns_.push_back(column);
+  // Fixed-width columns follow the null bitmap, widest first, so the packing leaves no holes.
+  std::stable_sort(inlined_columns.begin(), inlined_columns.end(), [&](uint32_t a, uint32_t b) {
+    return columns_[a].GetFixedLength() > columns_[b].GetFixedLength();
+  });
+  uint32_t curr_offset = null_bitmap_size_;
+  for (auto index : inlined_columns) {
+    columns_[index].column_offset_ = curr_offset;
+    curr_offset += columns_[index].GetFixedLength();
+  }
+  // Then the end offsets of the varchars, in column order.
+  varlen_offsets_start_ = curr_offset;
+  for (auto index : uninlined_columns_) {
+    columns_[index].column_offset_ = curr_offset;
+    curr_offset += sizeof(uint16_t);
   }
   // set tuple length
   length_ = curr_offset;
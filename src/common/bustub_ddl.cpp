@@ -1,6 +1,7 @@
-// DDL (Data Definition Language) statement handling in BusTub, including create table, create index, and set/show
-// variable.
+// DDL (Data Definition Language) statement handling in BusTub, including create table, create index, copy, and
+// set/show variable.
 
+#include <fstream>
 #include <optional>
 #include <shared_mutex>
 #include <string>
@@ -9,6 +10,7 @@
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
 #include "binder/bound_statement.h"
+#include "binder/statement/copy_statement.h"
 #include "binder/statement/create_statement.h"
 #include "binder/statement/explain_statement.h"
 #include "binder/statement/index_statement.h"
@@ -23,6 +25,7 @@
 #include "common/util/string_util.h"
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
+#include "execution/bulk_loader.h"
 #include "execution/execution_engine.h"
 #include "execution/executor_context.h"
 #include "execution/executors/mock_scan_executor.h"
@@ -41,8 +44,23 @@
 namespace bustub {
 
 void BustubInstance::HandleCreateStatement(Transaction *txn, const CreateStatement &stmt, ResultWriter &writer) {
+  auto storage = TableStorage::ROW;
+  for (const auto &[name, value] : stmt.options_) {
+    if (name != "storage") {
+      throw NotImplementedException(fmt::format("unsupported table option: {}", name));
+    }
+    auto storage_name = StringUtil::Lower(value);
+    if (storage_name == "pax") {
+      storage = TableStorage::PAX;
+    } else if (storage_name == "row") {
+      storage = TableStorage::ROW;
+    } else {
+      throw NotImplementedException(fmt::format("unsupported table storage: {}", value));
+    }
+  }
+
   std::unique_lock<std::shared_mutex> l(catalog_lock_);
-  auto info = catalog_->CreateTable(txn, stmt.table_, Schema(stmt.columns_));
+  auto info = catalog_->CreateTable(txn, stmt.table_, Schema(stmt.columns_), true, storage);
   l.unlock();
 
   if (info == nullptr) {
@@ -83,6 +101,56 @@ void BustubInstance::HandleIndexStatement(Transaction *txn, const IndexStatement
   WriteOneCell(fmt::format("Index created with id = {}", info->index_oid_), writer);
 }
 
+void BustubInstance::HandleCopyStatement(Transaction *txn, const CopyStatement &stmt, ResultWriter &writer) {
+  CopyOptions options;
+  auto single_char = [](const std::string &name, const std::string &value) {
+    if (value.size() != 1) {
+      throw NotImplementedException(fmt::format("COPY {} must be a single character", name));
+    }
+    return value[0];
+  };
+  for (const auto &[name, value] : stmt.options_) {
+    auto lower = StringUtil::Lower(value);
+    if (name == "format") {
+      if (lower == "csv") {
+        options.format_ = CopyFormat::CSV;
+      } else if (lower == "binary") {
+        options.format_ = CopyFormat::BINARY;
+      } else {
+        throw NotImplementedException(fmt::format("unsupported COPY format: {}", value));
+      }
+    } else if (name == "delimiter") {
+      options.delimiter_ = single_char(name, value);
+    } else if (name == "quote") {
+      options.quote_ = single_char(name, value);
+    } else if (name == "header") {
+      options.header_ = lower == "true" || lower == "on" || lower == "1";
+    } else if (name == "null") {
+      options.null_string_ = value;
+    } else {
+      throw NotImplementedException(fmt::format("unsupported COPY option: {}", name));
+    }
+  }
+
+  std::ifstream input(stmt.file_path_, std::ios::binary);
+  if (!input.is_open()) {
+    throw bustub::Exception(fmt::format("cannot open {}", stmt.file_path_));
+  }
+
+  std::shared_lock<std::shared_mutex> l(catalog_lock_);
+  auto *table_info = catalog_->GetTable(stmt.table_->oid_);
+  auto indexes = catalog_->GetTableIndexes(table_info->name_);
+  l.unlock();
+
+  if (txn != nullptr && !lock_manager_->LockTable(txn, LockManager::LockMode::EXCLUSIVE, table_info->oid_)) {
+    throw ExecutionException(fmt::format("COPY {}: transaction {} could not lock the table", table_info->name_,
+                                         txn->GetTransactionId()));
+  }
+  BulkLoader loader(catalog_, table_info, std::move(indexes), txn, options, copy_num_threads);
+  auto num_rows = loader.Load(input);
+  WriteOneCell(fmt::format("COPY {}", num_rows), writer);
+}
+
 void BustubInstance::HandleExplainStatement(Transaction *txn, const ExplainStatement &stmt, ResultWriter &writer) {
   std::string output;
 
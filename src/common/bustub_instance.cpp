@@ -6,6 +6,7 @@
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
 #include "binder/bound_statement.h"
+#include "binder/statement/copy_statement.h"
 #include "binder/statement/create_statement.h"
 #include "binder/statement/explain_statement.h"
 #include "binder/statement/index_statement.h"
@@ -32,6 +33,7 @@
 #include "planner/planner.h"
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/compressed_disk_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/disk/disk_manager_memory.h"
 #include "type/value_factory.h"
@@ -46,7 +48,11 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   enable_logging = false;
 
   // Storage related.
-  disk_manager_ = new DiskManager(db_file_name);
+  if (enable_page_compression) {
+    disk_manager_ = new CompressedDiskManager(db_file_name);
+  } else {
+    disk_manager_ = new DiskManager(db_file_name);
+  }
 
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
@@ -70,10 +76,11 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
 
 #ifndef __EMSCRIPTEN__
   lock_manager_->StartDeadlockDetection();
+  txn_manager_->StartVacuum();
 #endif
 
   // Checkpoint related.
-  checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_);
+  checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_, disk_manager_);
 
   // Catalog.
   catalog_ = new Catalog(buffer_pool_manager_, lock_manager_, log_manager_);
@@ -110,10 +117,11 @@ BustubInstance::BustubInstance() {
 
 #ifndef __EMSCRIPTEN__
   lock_manager_->StartDeadlockDetection();
+  txn_manager_->StartVacuum();
 #endif
 
   // Checkpoint related.
-  checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_);
+  checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_, disk_manager_);
 
   // Catalog.
   catalog_ = new Catalog(buffer_pool_manager_, lock_manager_, log_manager_);
@@ -163,6 +171,31 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdDisplayCompression(ResultWriter &writer) {
+  auto *disk_manager = dynamic_cast<CompressedDiskManager *>(disk_manager_);
+  if (disk_manager == nullptr) {
+    WriteOneCell("page compression is off", writer);
+    return;
+  }
+  auto stats = disk_manager->GetStats();
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("pages_written");
+  writer.WriteHeaderCell("pages_stored_raw");
+  writer.WriteHeaderCell("ratio");
+  writer.WriteHeaderCell("compress_ms");
+  writer.WriteHeaderCell("decompress_ms");
+  writer.EndHeader();
+  writer.BeginRow();
+  writer.WriteCell(fmt::format("{}", stats.pages_written_));
+  writer.WriteCell(fmt::format("{}", stats.pages_stored_raw_));
+  writer.WriteCell(fmt::format("{:.2f}", stats.Ratio()));
+  writer.WriteCell(fmt::format("{:.3f}", stats.compress_ns_ / 1e6));
+  writer.WriteCell(fmt::format("{:.3f}", stats.decompress_ns_ / 1e6));
+  writer.EndRow();
+  writer.EndTable();
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -176,6 +209,7 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 
 \dt: show all tables
 \di: show all indices
+\compression: show the page compression counters
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -194,13 +228,24 @@ auto BustubInstance::ExecuteSql(const std::string &sql, ResultWriter &writer,
   auto txn = txn_manager_->Begin();
   try {
     auto result = ExecuteSqlTxn(sql, writer, txn, std::move(check_options));
-    txn_manager_->Commit(txn);
+    // A transaction aborted by a write-write conflict is rolled back.
+    if (txn->GetState() == TransactionState::ABORTED) {
+      txn_manager_->Abort(txn);
+      delete txn;
+      return false;
+    }
+    auto committed = txn_manager_->Commit(txn);
     delete txn;
-    return result;
+    return result && committed;
   } catch (bustub::Exception &ex) {
     txn_manager_->Abort(txn);
     delete txn;
     throw ex;
+  } catch (TransactionAbortException &ex) {
+    // The lock manager gave up on the transaction, e.g. to break a deadlock.
+    txn_manager_->Abort(txn);
+    delete txn;
+    throw ExecutionException(ex.GetInfo());
   }
 }
 
@@ -216,6 +261,10 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayIndices(writer);
       return true;
     }
+    if (sql == "\\compression") {
+      CmdDisplayCompression(writer);
+      return true;
+    }
     if (sql == "\\help") {
       CmdDisplayHelp(writer);
       return true;
@@ -246,6 +295,11 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
         HandleIndexStatement(txn, index_stmt, writer);
         continue;
       }
+      case StatementType::COPY_STATEMENT: {
+        const auto &copy_stmt = dynamic_cast<const CopyStatement &>(*statement);
+        HandleCopyStatement(txn, copy_stmt, writer);
+        continue;
+      }
       case StatementType::VARIABLE_SHOW_STATEMENT: {
         const auto &show_stmt = dynamic_cast<const VariableShowStatement &>(*statement);
         HandleVariableShowStatement(txn, show_stmt, writer);
@@ -285,10 +339,6 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
     if (check_options != nullptr) {
       exec_ctx->InitCheckOptions(std::move(check_options));
     }
-    std::vector<Tuple> result_set{};
-    is_successful &= execution_engine_->Execute(optimized_plan, &result_set, txn, exec_ctx.get());
-
-    // Return the result set as a vector of string.
     auto schema = planner.plan_->OutputSchema();
 
     // Generate header for the result set.
@@ -299,14 +349,18 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
     }
     writer.EndHeader();
 
-    // Transforming result set into strings.
-    for (const auto &tuple : result_set) {
-      writer.BeginRow();
-      for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
-        writer.WriteCell(tuple.GetValue(&schema, i).ToString());
-      }
-      writer.EndRow();
-    }
+    // Stream every tuple into the writer as soon as it is produced.
+    is_successful &= execution_engine_->Execute(
+        optimized_plan,
+        [&](const Tuple &tuple) {
+          writer.BeginRow();
+          for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+            writer.WriteCell(tuple.GetValue(&schema, i).ToString());
+          }
+          writer.EndRow();
+          return writer.WantsMoreRows();
+        },
+        txn, exec_ctx.get());
     writer.EndTable();
   }
 
@@ -351,6 +405,10 @@ void BustubInstance::GenerateMockTable() {
 }
 
 BustubInstance::~BustubInstance() {
+  // The vacuum works on the table heaps, so it stops before they go.
+  txn_manager_->StopVacuum();
+  // The checkpoints append to the log, so they stop before it does.
+  checkpoint_manager_->StopCheckpointThread();
   if (enable_logging) {
     log_manager_->StopFlushThread();
   }
@@ -12,12 +12,53 @@
 
 #include "common/config.h"
 
+#include <algorithm>
+#include <thread>  // NOLINT
+
 namespace bustub {
 
 std::atomic<bool> enable_logging(false);
 
 std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
+size_t recovery_num_threads = std::max(1U, std::thread::hardware_concurrency());
+
+std::chrono::duration<int64_t> checkpoint_interval = std::chrono::seconds(30);
+
+bool enable_page_compression = false;
+
+bool enable_log_compression = false;
+
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
+std::chrono::milliseconds vacuum_interval = std::chrono::milliseconds(100);
+
+size_t lock_escalation_threshold = 5000;
+
+DeadlockPolicy deadlock_policy = DeadlockPolicy::DETECTION;
+
+bool deadlock_check_on_wait = false;
+
+size_t sort_memory_budget = 64 * 1024 * 1024;
+
+size_t aggregation_memory_budget = 64 * 1024 * 1024;
+
+size_t aggregation_num_threads = std::max(1U, std::thread::hardware_concurrency());
+
+size_t nlj_block_size = 1024;
+
+size_t nlj_inner_materialize_threshold = 4096;
+
+size_t insert_batch_size = 1024;
+
+size_t copy_num_threads = std::max(1U, std::thread::hardware_concurrency());
+
+size_t copy_chunk_size = 1024 * 1024;
+
+size_t toast_tuple_threshold = BUSTUB_PAGE_SIZE / 4;
+
+bool toast_compression = true;
+
+bool pax_column_encoding = true;
+
 }  // namespace bustub
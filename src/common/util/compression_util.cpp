@@ -0,0 +1,148 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util.cpp
+//
+// Identification: src/common/util/compression_util.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/compression_util.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = UINT16_MAX;
+constexpr int HASH_BITS = 12;
+constexpr uint8_t NIBBLE_MAX = 15;
+
+auto Load32(const char *data) -> uint32_t {
+  uint32_t bits;
+  memcpy(&bits, data, sizeof(bits));
+  return bits;
+}
+
+auto Hash(uint32_t bits) -> uint32_t { return (bits * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Append the extra bytes of a length whose nibble is 15. */
+void AppendLength(size_t len, std::string *out) {
+  for (; len >= UINT8_MAX; len -= UINT8_MAX) {
+    out->push_back(static_cast<char>(UINT8_MAX));
+  }
+  out->push_back(static_cast<char>(len));
+}
+
+/** Append a sequence, a match of length 0 meaning the last sequence. */
+void AppendSequence(std::string_view literals, size_t match_len, size_t offset, std::string *out) {
+  auto literal_nibble = std::min<size_t>(literals.size(), NIBBLE_MAX);
+  auto match_nibble = match_len == 0 ? 0 : std::min<size_t>(match_len - MIN_MATCH, NIBBLE_MAX);
+  out->push_back(static_cast<char>(literal_nibble << 4 | match_nibble));
+  if (literal_nibble == NIBBLE_MAX) {
+    AppendLength(literals.size() - NIBBLE_MAX, out);
+  }
+  out->append(literals);
+  if (match_len == 0) {
+    return;
+  }
+  out->push_back(static_cast<char>(offset & 0xFF));
+  out->push_back(static_cast<char>(offset >> 8));
+  if (match_nibble == NIBBLE_MAX) {
+    AppendLength(match_len - MIN_MATCH - NIBBLE_MAX, out);
+  }
+}
+
+/** Add the extra bytes of a length whose nibble is 15 to `len`. @return false if the input ends first */
+auto ReadLength(std::string_view input, size_t *pos, size_t *len) -> bool {
+  uint8_t byte;
+  do {
+    if (*pos >= input.size()) {
+      return false;
+    }
+    byte = static_cast<uint8_t>(input[(*pos)++]);
+    *len += byte;
+  } while (byte == UINT8_MAX);
+  return true;
+}
+
+}  // namespace
+
+auto CompressionUtil::Compress(std::string_view input) -> std::string {
+  std::string out;
+  out.reserve(input.size() / 2 + 16);
+  // The last position every hashed 4-byte prefix was seen at.
+  std::vector<int64_t> last_seen(1 << HASH_BITS, -1);
+  const char *data = input.data();
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= input.size()) {
+    auto bits = Load32(data + pos);
+    auto &slot = last_seen[Hash(bits)];
+    auto candidate = slot;
+    slot = static_cast<int64_t>(pos);
+    if (candidate < 0 || pos - candidate > MAX_OFFSET || Load32(data + candidate) != bits) {
+      pos++;
+      continue;
+    }
+    size_t len = MIN_MATCH;
+    while (pos + len < input.size() && data[candidate + len] == data[pos + len]) {
+      len++;
+    }
+    AppendSequence(input.substr(anchor, pos - anchor), len, pos - candidate, &out);
+    pos += len;
+    anchor = pos;
+  }
+  AppendSequence(input.substr(anchor), 0, 0, &out);
+  return out;
+}
+
+auto CompressionUtil::Decompress(std::string_view input, char *output, size_t size) -> bool {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < input.size()) {
+    auto token = static_cast<uint8_t>(input[in++]);
+    size_t literal_len = token >> 4;
+    if (literal_len == NIBBLE_MAX && !ReadLength(input, &in, &literal_len)) {
+      return false;
+    }
+    if (literal_len > input.size() - in || literal_len > size - out) {
+      return false;
+    }
+    memcpy(output + out, input.data() + in, literal_len);
+    in += literal_len;
+    out += literal_len;
+    if (in == input.size()) {
+      break;
+    }
+
+    if (input.size() - in < 2) {
+      return false;
+    }
+    size_t offset = static_cast<uint8_t>(input[in]) | static_cast<size_t>(static_cast<uint8_t>(input[in + 1])) << 8;
+    in += 2;
+    size_t match_len = token & NIBBLE_MAX;
+    if (match_len == NIBBLE_MAX && !ReadLength(input, &in, &match_len)) {
+      return false;
+    }
+    match_len += MIN_MATCH;
+    if (offset == 0 || offset > out || match_len > size - out) {
+      return false;
+    }
+    // Copy byte by byte, a match may overlap the bytes it produces.
+    for (size_t i = 0; i < match_len; i++, out++) {
+      output[out] = output[out - offset];
+    }
+  }
+  return out == size;
+}
+
+}  // namespace bustub
@@ -18,37 +18,950 @@
 
 namespace bustub {
 
-auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool { return true; }
+/** @return whether `lock_mode` is an intention lock, which tables take on the fast path */
+static auto IsIntention(LockManager::LockMode lock_mode) -> bool {
+  return lock_mode == LockManager::LockMode::INTENTION_SHARED ||
+         lock_mode == LockManager::LockMode::INTENTION_EXCLUSIVE;
+}
 
-auto LockManager::UnlockTable(Transaction *txn, const table_oid_t &oid) -> bool { return true; }
+auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool {
+  if (!CanTxnTakeLock(txn, lock_mode)) {
+    return false;
+  }
+  auto held = GetTableLockMode(txn, oid);
+  if (held.has_value()) {
+    return *held == lock_mode || UpgradeLockTable(txn, lock_mode, oid);
+  }
+  auto queue = GetTableQueue(oid);
+  if (IsIntention(lock_mode) && TryFastPathLock(txn, queue.get(), lock_mode, oid)) {
+    BookKeepTableLock(txn, lock_mode, oid, true);
+    return true;
+  }
 
-auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, const RID &rid) -> bool {
+  LockRequest *request;
+  {
+    std::scoped_lock pool_lock(table_request_pool_latch_);
+    request = table_request_pool_.Acquire(txn->GetTransactionId(), lock_mode, oid, RID());
+  }
+  std::unique_lock lock(queue->latch_);
+  CountStrongRequest(queue.get(), lock_mode, true);
+  queue->request_queue_.push_back(request);
+  GrantNewLocksIfPossible(queue.get());
+  if (!WaitForGrant(txn, queue, request, &lock, &num_table_waiting_)) {
+    queue->request_queue_.remove(request);
+    CountStrongRequest(queue.get(), lock_mode, false);
+    GrantNewLocksIfPossible(queue.get());
+    lock.unlock();
+    std::scoped_lock pool_lock(table_request_pool_latch_);
+    table_request_pool_.Release(request);
+    return false;
+  }
+  lock.unlock();
+  BookKeepTableLock(txn, lock_mode, oid, true);
   return true;
 }
 
+auto LockManager::UpgradeLockTable(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool {
+  auto queue = GetTableQueue(oid);
+  std::unique_lock lock(queue->latch_);
+  auto held = *GetTableLockMode(txn, oid);
+  if (queue->upgrading_ != INVALID_TXN_ID) {
+    AbortTxn(txn, AbortReason::UPGRADE_CONFLICT);
+  }
+  if (!CanLockUpgrade(held, lock_mode)) {
+    AbortTxn(txn, AbortReason::INCOMPATIBLE_UPGRADE);
+  }
+
+  // Drop the lock held, and queue the upgrade ahead of every waiting request.
+  auto txn_id = txn->GetTransactionId();
+  std::unique_lock pool_lock(table_request_pool_latch_);
+  if (auto fast = RemoveFastPathLock(txn_id, oid); fast.has_value()) {
+    queue->fast_path_.fetch_sub(*fast == LockMode::INTENTION_SHARED ? FAST_PATH_IS : FAST_PATH_IX);
+  } else {
+    auto it = std::find_if(queue->request_queue_.begin(), queue->request_queue_.end(),
+                           [&](LockRequest *request) { return request->txn_id_ == txn_id; });
+    BUSTUB_ASSERT(it != queue->request_queue_.end(), "table lock held but not queued");
+    table_request_pool_.Release(*it);
+    queue->request_queue_.erase(it);
+    CountStrongRequest(queue.get(), held, false);
+  }
+  BookKeepTableLock(txn, held, oid, false);
+  auto *request = table_request_pool_.Acquire(txn_id, lock_mode, oid, RID());
+  CountStrongRequest(queue.get(), lock_mode, true);
+  auto first_waiting = std::find_if(queue->request_queue_.begin(), queue->request_queue_.end(),
+                                    [](LockRequest *request) { return !request->granted_; });
+  queue->request_queue_.insert(first_waiting, request);
+  pool_lock.unlock();
+  queue->upgrading_ = txn_id;
+  GrantNewLocksIfPossible(queue.get());
+
+  bool granted = WaitForGrant(txn, queue, request, &lock, &num_table_waiting_);
+  queue->upgrading_ = INVALID_TXN_ID;
+  if (!granted) {
+    queue->request_queue_.remove(request);
+    CountStrongRequest(queue.get(), lock_mode, false);
+    GrantNewLocksIfPossible(queue.get());
+    pool_lock.lock();
+    table_request_pool_.Release(request);
+    return false;
+  }
+  BookKeepTableLock(txn, lock_mode, oid, true);
+  return true;
+}
+
+auto LockManager::UnlockTable(Transaction *txn, const table_oid_t &oid) -> bool {
+  auto held = GetTableLockMode(txn, oid);
+  if (!held.has_value()) {
+    AbortTxn(txn, AbortReason::ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD);
+  }
+  txn->LockTxn();
+  auto holds_rows = [oid](const auto &row_lock_set) {
+    auto rows = row_lock_set->find(oid);
+    return rows != row_lock_set->end() && !rows->second.empty();
+  };
+  bool rows_locked = holds_rows(txn->GetSharedRowLockSet()) || holds_rows(txn->GetExclusiveRowLockSet());
+  txn->UnlockTxn();
+  if (rows_locked) {
+    AbortTxn(txn, AbortReason::TABLE_UNLOCKED_BEFORE_UNLOCKING_ROWS);
+  }
+
+  auto queue = GetTableQueue(oid);
+  auto txn_id = txn->GetTransactionId();
+  if (auto fast = RemoveFastPathLock(txn_id, oid); fast.has_value()) {
+    ReleaseFastPathLock(queue.get(), *fast);
+  } else {
+    LockRequest *request;
+    {
+      std::scoped_lock lock(queue->latch_);
+      auto it = std::find_if(queue->request_queue_.begin(), queue->request_queue_.end(),
+                             [&](LockRequest *request) { return request->txn_id_ == txn_id && request->granted_; });
+      BUSTUB_ASSERT(it != queue->request_queue_.end(), "table lock held but not queued");
+      request = *it;
+      queue->request_queue_.erase(it);
+      CountStrongRequest(queue.get(), *held, false);
+      GrantNewLocksIfPossible(queue.get());
+    }
+    std::scoped_lock pool_lock(table_request_pool_latch_);
+    table_request_pool_.Release(request);
+  }
+  BookKeepTableLock(txn, *held, oid, false);
+  txn->LockTxn();
+  txn->GetEscalatedTableSet()->erase(oid);
+  txn->UnlockTxn();
+  UpdateStateOnUnlock(txn, *held);
+  return true;
+}
+
+auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, const RID &rid) -> bool {
+  if (lock_mode != LockMode::SHARED && lock_mode != LockMode::EXCLUSIVE) {
+    AbortTxn(txn, AbortReason::ATTEMPTED_INTENTION_LOCK_ON_ROW);
+  }
+  if (!CanTxnTakeLock(txn, lock_mode)) {
+    return false;
+  }
+  if (IsEscalated(txn, oid)) {
+    // The table lock the rows were escalated to covers them, or is made to.
+    auto table_lock_mode = GetTableLockMode(txn, oid);
+    if (table_lock_mode.has_value() && TableLockCoversRows(*table_lock_mode, lock_mode)) {
+      return true;
+    }
+    // The table heap locks the rows it inserts under a page latch, so the upgrade is not waited for: the rows are
+    // covered by X, or locked one by one under SIX, if either is granted at once, else the transaction gives up as if
+    // it was refused the wait.
+    if (table_lock_mode == LockMode::SHARED) {
+      if (TryUpgradeLockTable(txn, LockMode::EXCLUSIVE, oid)) {
+        return true;
+      }
+      if (!TryUpgradeLockTable(txn, LockMode::SHARED_INTENTION_EXCLUSIVE, oid)) {
+        txn->SetState(TransactionState::ABORTED);
+        return false;
+      }
+    }
+  }
+  if (!CheckAppropriateLockOnTable(txn, oid, lock_mode)) {
+    AbortTxn(txn, AbortReason::TABLE_LOCK_NOT_PRESENT);
+  }
+  auto held = GetRowLockMode(txn, oid, rid);
+  if (held == lock_mode) {
+    return true;
+  }
+  if (held.has_value() && !CanLockUpgrade(*held, lock_mode)) {
+    AbortTxn(txn, AbortReason::INCOMPATIBLE_UPGRADE);
+  }
+
+  // The partition latch is held until the request is queued, so that the queue is not removed meanwhile.
+  auto txn_id = txn->GetTransactionId();
+  auto &shard = GetRowShard(rid);
+  std::unique_lock shard_lock(shard.latch_);
+  auto &slot = shard.lock_map_[rid];
+  if (slot == nullptr) {
+    slot = std::make_shared<LockRequestQueue>();
+  }
+  auto queue = slot;
+  std::unique_lock lock(queue->latch_);
+  if (held.has_value()) {
+    if (queue->upgrading_ != INVALID_TXN_ID) {
+      AbortTxn(txn, AbortReason::UPGRADE_CONFLICT);
+    }
+    auto it = std::find_if(queue->request_queue_.begin(), queue->request_queue_.end(),
+                           [&](LockRequest *request) { return request->txn_id_ == txn_id; });
+    BUSTUB_ASSERT(it != queue->request_queue_.end(), "row lock held but not queued");
+    shard.pool_.Release(*it);
+    queue->request_queue_.erase(it);
+    BookKeepRowLock(txn, *held, oid, rid, false);
+    queue->upgrading_ = txn_id;
+  }
+  auto *request = shard.pool_.Acquire(txn_id, lock_mode, oid, rid);
+  auto first_waiting = held.has_value() ? std::find_if(queue->request_queue_.begin(), queue->request_queue_.end(),
+                                                       [](LockRequest *request) { return !request->granted_; })
+                                        : queue->request_queue_.end();
+  queue->request_queue_.insert(first_waiting, request);
+  shard_lock.unlock();
+  GrantNewLocksIfPossible(queue.get());
+
+  bool granted = WaitForGrant(txn, queue, request, &lock, &shard.num_waiting_);
+  if (held.has_value()) {
+    queue->upgrading_ = INVALID_TXN_ID;
+  }
+  if (granted) {
+    lock.unlock();
+    BookKeepRowLock(txn, lock_mode, oid, rid, true);
+    if (lock_escalation_threshold != 0) {
+      auto count_rows = [oid](const auto &row_lock_set) {
+        auto rows = row_lock_set->find(oid);
+        return rows == row_lock_set->end() ? 0 : rows->second.size();
+      };
+      txn->LockTxn();
+      auto num_rows = count_rows(txn->GetSharedRowLockSet()) + count_rows(txn->GetExclusiveRowLockSet());
+      txn->UnlockTxn();
+      if (num_rows > lock_escalation_threshold && (num_rows - 1) % lock_escalation_threshold == 0) {
+        EscalateRowLocks(txn, oid);
+      }
+    }
+    return true;
+  }
+  // Take the request out again, with the latches in order.
+  lock.unlock();
+  shard_lock.lock();
+  lock.lock();
+  queue->request_queue_.remove(request);
+  shard.pool_.Release(request);
+  if (queue->request_queue_.empty()) {
+    shard.lock_map_.erase(rid);
+  } else {
+    GrantNewLocksIfPossible(queue.get());
+  }
+  return false;
+}
+
 auto LockManager::UnlockRow(Transaction *txn, const table_oid_t &oid, const RID &rid, bool force) -> bool {
+  auto held = GetRowLockMode(txn, oid, rid);
+  if (!held.has_value()) {
+    // A row covered by the table lock is unlocked with the table.
+    if (IsEscalated(txn, oid)) {
+      return true;
+    }
+    AbortTxn(txn, AbortReason::ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD);
+  }
+  auto txn_id = txn->GetTransactionId();
+  auto &shard = GetRowShard(rid);
+  {
+    std::scoped_lock shard_lock(shard.latch_);
+    auto slot = shard.lock_map_.find(rid);
+    BUSTUB_ASSERT(slot != shard.lock_map_.end(), "row lock held but not queued");
+    auto queue = slot->second;
+    std::scoped_lock lock(queue->latch_);
+    auto it = std::find_if(queue->request_queue_.begin(), queue->request_queue_.end(),
+                           [&](LockRequest *request) { return request->txn_id_ == txn_id && request->granted_; });
+    BUSTUB_ASSERT(it != queue->request_queue_.end(), "row lock held but not queued");
+    shard.pool_.Release(*it);
+    queue->request_queue_.erase(it);
+    if (queue->request_queue_.empty()) {
+      shard.lock_map_.erase(slot);
+    } else {
+      GrantNewLocksIfPossible(queue.get());
+    }
+  }
+  BookKeepRowLock(txn, *held, oid, rid, false);
+  if (!force) {
+    UpdateStateOnUnlock(txn, *held);
+  }
   return true;
 }
 
 void LockManager::UnlockAll() {
-  // You probably want to unlock all table and txn locks here.
+  for (auto &[oid, queue] : table_lock_map_) {
+    for (auto *request : queue->request_queue_) {
+      delete request;
+    }
+    queue->request_queue_.clear();
+  }
+  for (auto &shard : row_lock_shards_) {
+    for (auto &[rid, queue] : shard.lock_map_) {
+      for (auto *request : queue->request_queue_) {
+        delete request;
+      }
+    }
+    shard.lock_map_.clear();
+  }
+}
+
+auto LockManager::AreLocksCompatible(LockMode l1, LockMode l2) -> bool {
+  switch (l1) {
+    case LockMode::INTENTION_SHARED:
+      return l2 != LockMode::EXCLUSIVE;
+    case LockMode::INTENTION_EXCLUSIVE:
+      return l2 == LockMode::INTENTION_SHARED || l2 == LockMode::INTENTION_EXCLUSIVE;
+    case LockMode::SHARED:
+      return l2 == LockMode::INTENTION_SHARED || l2 == LockMode::SHARED;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      return l2 == LockMode::INTENTION_SHARED;
+    case LockMode::EXCLUSIVE:
+      return false;
+  }
+  return false;
+}
+
+auto LockManager::CanTxnTakeLock(Transaction *txn, LockMode lock_mode) -> bool {
+  auto state = txn->GetState();
+  if (state == TransactionState::ABORTED || state == TransactionState::COMMITTED) {
+    return false;
+  }
+  switch (txn->GetIsolationLevel()) {
+    case IsolationLevel::READ_UNCOMMITTED:
+      if (lock_mode != LockMode::EXCLUSIVE && lock_mode != LockMode::INTENTION_EXCLUSIVE) {
+        AbortTxn(txn, AbortReason::LOCK_SHARED_ON_READ_UNCOMMITTED);
+      }
+      if (state == TransactionState::SHRINKING) {
+        AbortTxn(txn, AbortReason::LOCK_ON_SHRINKING);
+      }
+      break;
+    case IsolationLevel::READ_COMMITTED:
+      if (state == TransactionState::SHRINKING && lock_mode != LockMode::SHARED &&
+          lock_mode != LockMode::INTENTION_SHARED) {
+        AbortTxn(txn, AbortReason::LOCK_ON_SHRINKING);
+      }
+      break;
+    case IsolationLevel::REPEATABLE_READ:
+    case IsolationLevel::SNAPSHOT_ISOLATION:
+    case IsolationLevel::OPTIMISTIC:
+      if (state == TransactionState::SHRINKING) {
+        AbortTxn(txn, AbortReason::LOCK_ON_SHRINKING);
+      }
+      break;
+  }
+  return true;
+}
+
+void LockManager::GrantNewLocksIfPossible(LockRequestQueue *lock_request_queue) {
+  auto fast = lock_request_queue->fast_path_.load();
+  bool fast_is = (fast & FAST_PATH_COUNT_MASK) != 0;
+  bool fast_ix = ((fast >> 32) & FAST_PATH_COUNT_MASK) != 0;
+  // The granted requests come first in the queue, and the others are granted in order while compatible with them.
+  std::vector<LockMode> granted;
+  bool granted_any = false;
+  for (auto *request : lock_request_queue->request_queue_) {
+    auto mode = request->lock_mode_;
+    if (!request->granted_) {
+      bool compatible = (!fast_is || AreLocksCompatible(LockMode::INTENTION_SHARED, mode)) &&
+                        (!fast_ix || AreLocksCompatible(LockMode::INTENTION_EXCLUSIVE, mode)) &&
+                        std::all_of(granted.begin(), granted.end(),
+                                    [&](LockMode other) { return AreLocksCompatible(other, mode); });
+      if (!compatible) {
+        break;
+      }
+      request->granted_ = true;
+      granted_any = true;
+    }
+    granted.push_back(mode);
+  }
+  if (granted_any) {
+    lock_request_queue->cv_.notify_all();
+  }
+}
+
+auto LockManager::CanLockUpgrade(LockMode curr_lock_mode, LockMode requested_lock_mode) -> bool {
+  switch (curr_lock_mode) {
+    case LockMode::INTENTION_SHARED:
+      return true;
+    case LockMode::SHARED:
+    case LockMode::INTENTION_EXCLUSIVE:
+      return requested_lock_mode == LockMode::EXCLUSIVE ||
+             requested_lock_mode == LockMode::SHARED_INTENTION_EXCLUSIVE;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      return requested_lock_mode == LockMode::EXCLUSIVE;
+    case LockMode::EXCLUSIVE:
+      return false;
+  }
+  return false;
+}
+
+auto LockManager::CheckAppropriateLockOnTable(Transaction *txn, const table_oid_t &oid, LockMode row_lock_mode)
+    -> bool {
+  auto table_lock_mode = GetTableLockMode(txn, oid);
+  if (!table_lock_mode.has_value()) {
+    return false;
+  }
+  return row_lock_mode == LockMode::SHARED || *table_lock_mode == LockMode::EXCLUSIVE ||
+         *table_lock_mode == LockMode::INTENTION_EXCLUSIVE || *table_lock_mode == LockMode::SHARED_INTENTION_EXCLUSIVE;
+}
+
+void LockManager::AbortTxn(Transaction *txn, AbortReason reason) {
+  txn->SetState(TransactionState::ABORTED);
+  throw TransactionAbortException(txn->GetTransactionId(), reason);
+}
+
+auto LockManager::GetTableLockMode(Transaction *txn, table_oid_t oid) -> std::optional<LockMode> {
+  std::optional<LockMode> lock_mode;
+  txn->LockTxn();
+  if (txn->IsTableIntentionSharedLocked(oid)) {
+    lock_mode = LockMode::INTENTION_SHARED;
+  } else if (txn->IsTableIntentionExclusiveLocked(oid)) {
+    lock_mode = LockMode::INTENTION_EXCLUSIVE;
+  } else if (txn->IsTableSharedLocked(oid)) {
+    lock_mode = LockMode::SHARED;
+  } else if (txn->IsTableSharedIntentionExclusiveLocked(oid)) {
+    lock_mode = LockMode::SHARED_INTENTION_EXCLUSIVE;
+  } else if (txn->IsTableExclusiveLocked(oid)) {
+    lock_mode = LockMode::EXCLUSIVE;
+  }
+  txn->UnlockTxn();
+  return lock_mode;
+}
+
+auto LockManager::GetRowLockMode(Transaction *txn, table_oid_t oid, const RID &rid) -> std::optional<LockMode> {
+  std::optional<LockMode> lock_mode;
+  txn->LockTxn();
+  if (txn->IsRowSharedLocked(oid, rid)) {
+    lock_mode = LockMode::SHARED;
+  } else if (txn->IsRowExclusiveLocked(oid, rid)) {
+    lock_mode = LockMode::EXCLUSIVE;
+  }
+  txn->UnlockTxn();
+  return lock_mode;
+}
+
+void LockManager::BookKeepTableLock(Transaction *txn, LockMode lock_mode, table_oid_t oid, bool add) {
+  std::shared_ptr<std::unordered_set<table_oid_t>> lock_set;
+  switch (lock_mode) {
+    case LockMode::INTENTION_SHARED:
+      lock_set = txn->GetIntentionSharedTableLockSet();
+      break;
+    case LockMode::INTENTION_EXCLUSIVE:
+      lock_set = txn->GetIntentionExclusiveTableLockSet();
+      break;
+    case LockMode::SHARED:
+      lock_set = txn->GetSharedTableLockSet();
+      break;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      lock_set = txn->GetSharedIntentionExclusiveTableLockSet();
+      break;
+    case LockMode::EXCLUSIVE:
+      lock_set = txn->GetExclusiveTableLockSet();
+      break;
+  }
+  txn->LockTxn();
+  if (add) {
+    lock_set->insert(oid);
+  } else {
+    lock_set->erase(oid);
+  }
+  txn->UnlockTxn();
+}
+
+void LockManager::BookKeepRowLock(Transaction *txn, LockMode lock_mode, table_oid_t oid, const RID &rid, bool add) {
+  auto lock_set = lock_mode == LockMode::SHARED ? txn->GetSharedRowLockSet() : txn->GetExclusiveRowLockSet();
+  txn->LockTxn();
+  if (add) {
+    (*lock_set)[oid].insert(rid);
+  } else if (auto rows = lock_set->find(oid); rows != lock_set->end()) {
+    rows->second.erase(rid);
+    if (rows->second.empty()) {
+      lock_set->erase(rows);
+    }
+  }
+  txn->UnlockTxn();
+}
+
+void LockManager::UpdateStateOnUnlock(Transaction *txn, LockMode lock_mode) {
+  if (txn->GetState() != TransactionState::GROWING) {
+    return;
+  }
+  switch (txn->GetIsolationLevel()) {
+    case IsolationLevel::REPEATABLE_READ:
+    case IsolationLevel::SNAPSHOT_ISOLATION:
+    case IsolationLevel::OPTIMISTIC:
+      if (lock_mode == LockMode::SHARED || lock_mode == LockMode::EXCLUSIVE) {
+        txn->SetState(TransactionState::SHRINKING);
+      }
+      break;
+    case IsolationLevel::READ_COMMITTED:
+    case IsolationLevel::READ_UNCOMMITTED:
+      if (lock_mode == LockMode::EXCLUSIVE) {
+        txn->SetState(TransactionState::SHRINKING);
+      }
+      break;
+  }
+}
+
+auto LockManager::GetTableQueue(table_oid_t oid) -> std::shared_ptr<LockRequestQueue> {
+  {
+    std::shared_lock lock(table_lock_map_latch_);
+    if (auto it = table_lock_map_.find(oid); it != table_lock_map_.end()) {
+      return it->second;
+    }
+  }
+  std::unique_lock lock(table_lock_map_latch_);
+  auto &queue = table_lock_map_[oid];
+  if (queue == nullptr) {
+    queue = std::make_shared<LockRequestQueue>();
+  }
+  return queue;
 }
 
-void LockManager::AddEdge(txn_id_t t1, txn_id_t t2) {}
+auto LockManager::TryFastPathLock(Transaction *txn, LockRequestQueue *queue, LockMode lock_mode, table_oid_t oid)
+    -> bool {
+  auto one = lock_mode == LockMode::INTENTION_SHARED ? FAST_PATH_IS : FAST_PATH_IX;
+  auto state = queue->fast_path_.load();
+  do {
+    if ((state & FAST_PATH_CLOSED) != 0) {
+      return false;
+    }
+  } while (!queue->fast_path_.compare_exchange_weak(state, state + one));
 
-void LockManager::RemoveEdge(txn_id_t t1, txn_id_t t2) {}
+  auto &shard = GetFastPathShard(txn->GetTransactionId());
+  std::scoped_lock lock(shard.latch_);
+  shard.locks_[txn->GetTransactionId()].emplace_back(oid, lock_mode);
+  return true;
+}
 
-auto LockManager::HasCycle(txn_id_t *txn_id) -> bool { return false; }
+auto LockManager::RemoveFastPathLock(txn_id_t txn_id, table_oid_t oid) -> std::optional<LockMode> {
+  auto &shard = GetFastPathShard(txn_id);
+  std::scoped_lock lock(shard.latch_);
+  auto locks = shard.locks_.find(txn_id);
+  if (locks == shard.locks_.end()) {
+    return std::nullopt;
+  }
+  auto &table_locks = locks->second;
+  auto it = std::find_if(table_locks.begin(), table_locks.end(), [&](const auto &lock) { return lock.first == oid; });
+  if (it == table_locks.end()) {
+    return std::nullopt;
+  }
+  auto lock_mode = it->second;
+  table_locks.erase(it);
+  if (table_locks.empty()) {
+    shard.locks_.erase(locks);
+  }
+  return lock_mode;
+}
+
+auto LockManager::FindFastPathLock(txn_id_t txn_id, table_oid_t oid) -> std::optional<LockMode> {
+  auto &shard = GetFastPathShard(txn_id);
+  std::scoped_lock lock(shard.latch_);
+  auto locks = shard.locks_.find(txn_id);
+  if (locks == shard.locks_.end()) {
+    return std::nullopt;
+  }
+  for (auto [locked_oid, lock_mode] : locks->second) {
+    if (locked_oid == oid) {
+      return lock_mode;
+    }
+  }
+  return std::nullopt;
+}
+
+void LockManager::ReleaseFastPathLock(LockRequestQueue *queue, LockMode lock_mode) {
+  auto one = lock_mode == LockMode::INTENTION_SHARED ? FAST_PATH_IS : FAST_PATH_IX;
+  // A closed fast path has requests waiting for the intention locks to go.
+  if ((queue->fast_path_.fetch_sub(one) & FAST_PATH_CLOSED) != 0) {
+    std::scoped_lock lock(queue->latch_);
+    GrantNewLocksIfPossible(queue);
+  }
+}
+
+auto LockManager::TableLockCoversRows(LockMode table_lock_mode, LockMode row_lock_mode) -> bool {
+  switch (table_lock_mode) {
+    case LockMode::EXCLUSIVE:
+      return true;
+    case LockMode::SHARED:
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      return row_lock_mode == LockMode::SHARED;
+    default:
+      return false;
+  }
+}
+
+auto LockManager::IsEscalated(Transaction *txn, table_oid_t oid) -> bool {
+  txn->LockTxn();
+  bool escalated = txn->GetEscalatedTableSet()->count(oid) != 0;
+  txn->UnlockTxn();
+  return escalated;
+}
+
+void LockManager::EscalateRowLocks(Transaction *txn, table_oid_t oid) {
+  std::vector<RID> s_rows;
+  std::vector<RID> x_rows;
+  txn->LockTxn();
+  if (auto rows = txn->GetSharedRowLockSet()->find(oid); rows != txn->GetSharedRowLockSet()->end()) {
+    s_rows.assign(rows->second.begin(), rows->second.end());
+  }
+  if (auto rows = txn->GetExclusiveRowLockSet()->find(oid); rows != txn->GetExclusiveRowLockSet()->end()) {
+    x_rows.assign(rows->second.begin(), rows->second.end());
+  }
+  txn->UnlockTxn();
+
+  // Shared rows under an intention exclusive lock keep it, as SIX.
+  auto held = *GetTableLockMode(txn, oid);
+  auto row_lock_mode = x_rows.empty() ? LockMode::SHARED : LockMode::EXCLUSIVE;
+  auto table_lock_mode = row_lock_mode;
+  if (row_lock_mode == LockMode::SHARED && held == LockMode::INTENTION_EXCLUSIVE) {
+    table_lock_mode = LockMode::SHARED_INTENTION_EXCLUSIVE;
+  }
+  if (!TableLockCoversRows(held, row_lock_mode) && !TryUpgradeLockTable(txn, table_lock_mode, oid)) {
+    return;
+  }
+  for (const auto &rows : {s_rows, x_rows}) {
+    for (const auto &rid : rows) {
+      UnlockRow(txn, oid, rid, true);
+    }
+  }
+  txn->LockTxn();
+  txn->GetEscalatedTableSet()->insert(oid);
+  txn->UnlockTxn();
+}
+
+auto LockManager::TryUpgradeLockTable(Transaction *txn, LockMode lock_mode, table_oid_t oid) -> bool {
+  auto queue = GetTableQueue(oid);
+  std::scoped_lock lock(queue->latch_);
+  auto held = GetTableLockMode(txn, oid);
+  if (queue->upgrading_ != INVALID_TXN_ID || !held.has_value() || !CanLockUpgrade(*held, lock_mode)) {
+    return false;
+  }
+  // Close the fast path first, so that no intention lock is granted past the check.
+  auto txn_id = txn->GetTransactionId();
+  CountStrongRequest(queue.get(), lock_mode, true);
+  auto fast_held = FindFastPathLock(txn_id, oid);
+  auto fast = queue->fast_path_.load();
+  auto fast_is = (fast & FAST_PATH_COUNT_MASK) - (fast_held == LockMode::INTENTION_SHARED ? 1 : 0);
+  auto fast_ix = ((fast >> 32) & FAST_PATH_COUNT_MASK) - (fast_held == LockMode::INTENTION_EXCLUSIVE ? 1 : 0);
+  bool compatible = (fast_is == 0 || AreLocksCompatible(LockMode::INTENTION_SHARED, lock_mode)) &&
+                    (fast_ix == 0 || AreLocksCompatible(LockMode::INTENTION_EXCLUSIVE, lock_mode)) &&
+                    std::all_of(queue->request_queue_.begin(), queue->request_queue_.end(), [&](LockRequest *request) {
+                      return !request->granted_ || request->txn_id_ == txn_id ||
+                             AreLocksCompatible(request->lock_mode_, lock_mode);
+                    });
+  if (!compatible) {
+    CountStrongRequest(queue.get(), lock_mode, false);
+    // Grant the intention locks queued while the fast path was closed.
+    GrantNewLocksIfPossible(queue.get());
+    return false;
+  }
+
+  std::scoped_lock pool_lock(table_request_pool_latch_);
+  if (fast_held.has_value()) {
+    RemoveFastPathLock(txn_id, oid);
+    queue->fast_path_.fetch_sub(*fast_held == LockMode::INTENTION_SHARED ? FAST_PATH_IS : FAST_PATH_IX);
+  } else {
+    auto it = std::find_if(queue->request_queue_.begin(), queue->request_queue_.end(),
+                           [&](LockRequest *request) { return request->txn_id_ == txn_id; });
+    table_request_pool_.Release(*it);
+    queue->request_queue_.erase(it);
+    CountStrongRequest(queue.get(), *held, false);
+  }
+  auto *request = table_request_pool_.Acquire(txn_id, lock_mode, oid, RID());
+  request->granted_ = true;
+  auto first_waiting = std::find_if(queue->request_queue_.begin(), queue->request_queue_.end(),
+                                    [](LockRequest *request) { return !request->granted_; });
+  queue->request_queue_.insert(first_waiting, request);
+  BookKeepTableLock(txn, *held, oid, false);
+  BookKeepTableLock(txn, lock_mode, oid, true);
+  return true;
+}
+
+void LockManager::CountStrongRequest(LockRequestQueue *queue, LockMode lock_mode, bool enter) {
+  if (IsIntention(lock_mode)) {
+    return;
+  }
+  if (enter) {
+    if (queue->num_strong_++ == 0) {
+      queue->fast_path_.fetch_or(FAST_PATH_CLOSED);
+    }
+  } else if (--queue->num_strong_ == 0) {
+    queue->fast_path_.fetch_and(~FAST_PATH_CLOSED);
+  }
+}
+
+auto LockManager::WaitForGrant(Transaction *txn, const std::shared_ptr<LockRequestQueue> &queue,
+                               LockRequest *request, std::unique_lock<std::mutex> *lock,
+                               std::atomic<uint32_t> *num_waiting) -> bool {
+  if (request->granted_) {
+    return true;
+  }
+  num_waiting->fetch_add(1);
+  // The policy is applied again on every wake-up, as the transactions waited for change.
+  while (!request->granted_ && txn->GetState() != TransactionState::ABORTED) {
+    std::vector<txn_id_t> wounded;
+    if (!MayWait(txn, queue, GetBlockers(queue.get(), request), &wounded)) {
+      txn->SetState(TransactionState::ABORTED);
+      break;
+    }
+    if (wounded.empty()) {
+      queue->cv_.wait(*lock);
+      continue;
+    }
+    lock->unlock();
+    WakeUp(wounded);
+    lock->lock();
+  }
+  num_waiting->fetch_sub(1);
+  {
+    std::scoped_lock waiters_lock(waiters_latch_);
+    waiters_.erase(txn->GetTransactionId());
+  }
+  // A transaction aborted while waiting gives the lock back even if it was granted meanwhile.
+  return txn->GetState() != TransactionState::ABORTED;
+}
+
+auto LockManager::GetBlockers(LockRequestQueue *queue, LockRequest *request) -> std::vector<txn_id_t> {
+  std::vector<txn_id_t> blockers;
+  for (auto *other : queue->request_queue_) {
+    if (other == request) {
+      break;
+    }
+    if (other->txn_id_ != request->txn_id_ &&
+        (!other->granted_ || !AreLocksCompatible(other->lock_mode_, request->lock_mode_))) {
+      blockers.push_back(other->txn_id_);
+    }
+  }
+  if ((queue->fast_path_.load() & ~FAST_PATH_CLOSED) == 0) {
+    return blockers;
+  }
+  // The intention locks granted on the fast path are found through the transactions holding them.
+  for (auto &shard : fast_path_shards_) {
+    std::scoped_lock lock(shard.latch_);
+    for (const auto &[txn_id, table_locks] : shard.locks_) {
+      for (auto [oid, lock_mode] : table_locks) {
+        if (oid == request->oid_ && txn_id != request->txn_id_ && !AreLocksCompatible(lock_mode, request->lock_mode_)) {
+          blockers.push_back(txn_id);
+        }
+      }
+    }
+  }
+  return blockers;
+}
+
+auto LockManager::MayWait(Transaction *txn, const std::shared_ptr<LockRequestQueue> &queue,
+                          std::vector<txn_id_t> blockers, std::vector<txn_id_t> *wounded) -> bool {
+  auto txn_id = txn->GetTransactionId();
+  if (txn->IsWounded()) {
+    return false;
+  }
+  std::scoped_lock lock(waiters_latch_);
+  switch (deadlock_policy) {
+    case DeadlockPolicy::DETECTION:
+      if (deadlock_check_on_wait && ClosesCycle(txn_id, blockers)) {
+        return false;
+      }
+      break;
+    case DeadlockPolicy::WAIT_DIE:
+      if (std::any_of(blockers.begin(), blockers.end(), [&](txn_id_t blocker) { return blocker < txn_id; })) {
+        return false;
+      }
+      break;
+    case DeadlockPolicy::WOUND_WAIT:
+      // The blockers hold or wait in this queue, whose latch is held, so they are not gone yet.
+      BUSTUB_ENSURE(txn_manager_ != nullptr, "txn_manager_ is not set.");
+      for (auto blocker : blockers) {
+        auto *blocker_txn = blocker > txn_id ? txn_manager_->GetTransaction(blocker) : nullptr;
+        if (blocker_txn != nullptr && !blocker_txn->IsWounded()) {
+          blocker_txn->SetWounded();
+          wounded->push_back(blocker);
+        }
+      }
+      break;
+  }
+  auto &waiter = waiters_[txn_id];
+  waiter.queue_ = queue;
+  waiter.blockers_ = std::move(blockers);
+  return true;
+}
+
+auto LockManager::ClosesCycle(txn_id_t txn_id, const std::vector<txn_id_t> &blockers) -> bool {
+  std::vector<txn_id_t> stack(blockers.begin(), blockers.end());
+  std::unordered_set<txn_id_t> visited;
+  while (!stack.empty()) {
+    auto next = stack.back();
+    stack.pop_back();
+    if (next == txn_id) {
+      return true;
+    }
+    if (!visited.insert(next).second) {
+      continue;
+    }
+    if (auto waiter = waiters_.find(next); waiter != waiters_.end()) {
+      stack.insert(stack.end(), waiter->second.blockers_.begin(), waiter->second.blockers_.end());
+    }
+  }
+  return false;
+}
+
+void LockManager::WakeUp(const std::vector<txn_id_t> &txn_ids) {
+  for (auto txn_id : txn_ids) {
+    std::shared_ptr<LockRequestQueue> queue;
+    {
+      std::scoped_lock lock(waiters_latch_);
+      if (auto waiter = waiters_.find(txn_id); waiter != waiters_.end()) {
+        queue = waiter->second.queue_;
+      }
+    }
+    if (queue != nullptr) {
+      std::scoped_lock lock(queue->latch_);
+      queue->cv_.notify_all();
+    }
+  }
+}
+
+void LockManager::AddEdge(txn_id_t t1, txn_id_t t2) {
+  std::scoped_lock lock(waits_for_latch_);
+  auto &edges = waits_for_[t1];
+  auto it = std::lower_bound(edges.begin(), edges.end(), t2);
+  if (it == edges.end() || *it != t2) {
+    edges.insert(it, t2);
+  }
+}
+
+void LockManager::RemoveEdge(txn_id_t t1, txn_id_t t2) {
+  std::scoped_lock lock(waits_for_latch_);
+  auto edges = waits_for_.find(t1);
+  if (edges == waits_for_.end()) {
+    return;
+  }
+  auto it = std::lower_bound(edges->second.begin(), edges->second.end(), t2);
+  if (it != edges->second.end() && *it == t2) {
+    edges->second.erase(it);
+  }
+  if (edges->second.empty()) {
+    waits_for_.erase(edges);
+  }
+}
+
+auto LockManager::FindCycle(txn_id_t source_txn, std::vector<txn_id_t> &path, std::unordered_set<txn_id_t> &on_path,
+                            std::unordered_set<txn_id_t> &visited, txn_id_t *abort_txn_id) -> bool {
+  path.push_back(source_txn);
+  on_path.insert(source_txn);
+  if (auto edges = waits_for_.find(source_txn); edges != waits_for_.end()) {
+    for (auto next : edges->second) {
+      if (on_path.count(next) != 0) {
+        auto cycle_start = std::find(path.begin(), path.end(), next);
+        *abort_txn_id = *std::max_element(cycle_start, path.end());
+        return true;
+      }
+      if (visited.count(next) == 0 && FindCycle(next, path, on_path, visited, abort_txn_id)) {
+        return true;
+      }
+    }
+  }
+  path.pop_back();
+  on_path.erase(source_txn);
+  visited.insert(source_txn);
+  return false;
+}
+
+auto LockManager::HasCycle(txn_id_t *txn_id) -> bool {
+  std::scoped_lock lock(waits_for_latch_);
+  // Searching from the oldest transaction first finds the same cycle every time.
+  std::vector<txn_id_t> sources;
+  sources.reserve(waits_for_.size());
+  for (const auto &[source, edges] : waits_for_) {
+    sources.push_back(source);
+  }
+  std::sort(sources.begin(), sources.end());
+  std::unordered_set<txn_id_t> visited;
+  for (auto source : sources) {
+    std::vector<txn_id_t> path;
+    std::unordered_set<txn_id_t> on_path;
+    if (visited.count(source) == 0 && FindCycle(source, path, on_path, visited, txn_id)) {
+      return true;
+    }
+  }
+  return false;
+}
 
 auto LockManager::GetEdgeList() -> std::vector<std::pair<txn_id_t, txn_id_t>> {
+  std::scoped_lock lock(waits_for_latch_);
   std::vector<std::pair<txn_id_t, txn_id_t>> edges(0);
+  for (const auto &[t1, waits_for] : waits_for_) {
+    for (auto t2 : waits_for) {
+      edges.emplace_back(t1, t2);
+    }
+  }
   return edges;
 }
 
+void LockManager::AddWaitsForEdges(const std::shared_ptr<LockRequestQueue> &queue,
+                                   std::unordered_map<txn_id_t, std::shared_ptr<LockRequestQueue>> *waits_in) {
+  for (auto *waiting : queue->request_queue_) {
+    if (waiting->granted_) {
+      continue;
+    }
+    (*waits_in)[waiting->txn_id_] = queue;
+    for (auto blocker : GetBlockers(queue.get(), waiting)) {
+      AddEdge(waiting->txn_id_, blocker);
+    }
+  }
+}
+
 void LockManager::RunCycleDetection() {
   while (enable_cycle_detection_) {
     std::this_thread::sleep_for(cycle_detection_interval);
-    {  // TODO(students): detect deadlock
+    // The other policies do not let deadlocks form.
+    if (deadlock_policy == DeadlockPolicy::DETECTION) {
+      std::unordered_map<txn_id_t, std::shared_ptr<LockRequestQueue>> waits_in;
+      if (num_table_waiting_ > 0) {
+        std::vector<std::shared_ptr<LockRequestQueue>> queues;
+        {
+          std::shared_lock lock(table_lock_map_latch_);
+          for (const auto &[oid, queue] : table_lock_map_) {
+            queues.push_back(queue);
+          }
+        }
+        for (const auto &queue : queues) {
+          std::scoped_lock lock(queue->latch_);
+          AddWaitsForEdges(queue, &waits_in);
+        }
+      }
+      // Only the partitions with waiting requests are visited.
+      for (auto &shard : row_lock_shards_) {
+        if (shard.num_waiting_ == 0) {
+          continue;
+        }
+        std::scoped_lock shard_lock(shard.latch_);
+        for (const auto &[rid, queue] : shard.lock_map_) {
+          std::scoped_lock lock(queue->latch_);
+          AddWaitsForEdges(queue, &waits_in);
+        }
+      }
+
+      // Abort the newest transaction of each cycle, and wake it up to leave its queue.
+      txn_id_t victim;
+      while (HasCycle(&victim)) {
+        txn_manager_->GetTransaction(victim)->SetState(TransactionState::ABORTED);
+        {
+          std::scoped_lock lock(waits_for_latch_);
+          waits_for_.erase(victim);
+        }
+        for (const auto &[t1, t2] : GetEdgeList()) {
+          if (t2 == victim) {
+            RemoveEdge(t1, t2);
+          }
+        }
+        if (auto &queue = waits_in[victim]; queue != nullptr) {
+          std::scoped_lock lock(queue->latch_);
+          queue->cv_.notify_all();
+        }
+      }
+      std::scoped_lock lock(waits_for_latch_);
+      waits_for_.clear();
     }
   }
 }
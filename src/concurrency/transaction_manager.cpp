@@ -12,33 +12,416 @@
 
 #include "concurrency/transaction_manager.h"
 
+#include <algorithm>
 #include <mutex>  // NOLINT
+#include <set>
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "catalog/catalog.h"
+#include "common/exception.h"
 #include "common/macros.h"
 #include "storage/table/table_heap.h"
 namespace bustub {
 
-void TransactionManager::Commit(Transaction *txn) {
+/** @return the transaction that wrote the version of a tuple described by `meta` */
+static auto WriterOf(const TupleMeta &meta) -> txn_id_t {
+  return meta.is_deleted_ ? meta.delete_txn_id_ : meta.insert_txn_id_;
+}
+
+auto TransactionManager::Commit(Transaction *txn) -> bool {
+  // The index entries of the deleted tuples stay until the tuples are vacuumed. Their keys are taken now, while the
+  // catalog is at hand.
+  CommittedWrites writes{txn->GetTransactionId(), INVALID_TS, txn->GetWriteSet(), {}};
+  for (auto &record : *txn->GetIndexWriteSet()) {
+    if (record.wtype_ != WType::DELETE) {
+      continue;
+    }
+    auto *table_info = record.catalog_->GetTable(record.table_oid_);
+    auto *index_info = record.catalog_->GetIndex(record.index_oid_);
+    auto *index = index_info->index_.get();
+    writes.index_entries_.emplace_back(
+        index, record.tuple_.KeyFromTuple(table_info->schema_, index_info->key_schema_, index->GetKeyAttrs()),
+        record.rid_);
+  }
+
+  {
+    std::unique_lock<std::mutex> commit_lck(commit_mutex_);
+    if (txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC && !txn->GetWriteSet()->empty() && !Validate(txn)) {
+      commit_lck.unlock();
+      Abort(txn);
+      return false;
+    }
+    auto commit_ts = last_commit_ts_.load() + 1;
+    {
+      std::unique_lock<std::shared_mutex> l(commit_log_mutex_);
+      commit_log_[txn->GetTransactionId()] = commit_ts;
+      if (txn->ReadsSnapshot()) {
+        active_read_ts_.erase(active_read_ts_.find(txn->GetReadTs()));
+      }
+    }
+    txn->SetCommitTs(commit_ts);
+    writes.commit_ts_ = commit_ts;
+    // The commit records are appended in commit order.
+    if (enable_logging) {
+      LogRecord record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+      txn->SetPrevLSN(log_manager_->AppendLogRecord(&record));
+      std::scoped_lock l(begin_lsns_mutex_);
+      begin_lsns_.erase(txn->GetTransactionId());
+    }
+    {
+      std::scoped_lock gc_lck(gc_mutex_);
+      committed_writes_.push_back(std::move(writes));
+    }
+    // The transactions that begin from now on see the versions written by this one.
+    last_commit_ts_.store(commit_ts);
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
 
+  // The transaction is durable once its commit record is. The transactions that see its writes commit after it,
+  // so their commit records come later in the log, and the locks need not be held while waiting.
+  if (enable_logging) {
+    log_manager_->Flush(txn->GetPrevLSN());
+  }
+
   txn->SetState(TransactionState::COMMITTED);
+  return true;
 }
 
 void TransactionManager::Abort(Transaction *txn) {
-  /* TODO: revert all the changes in write set */
+  // Revert the index entries, newest first.
+  auto index_write_set = txn->GetIndexWriteSet();
+  for (auto record = index_write_set->rbegin(); record != index_write_set->rend(); ++record) {
+    auto *table_info = record->catalog_->GetTable(record->table_oid_);
+    auto *index_info = record->catalog_->GetIndex(record->index_oid_);
+    auto *index = index_info->index_.get();
+    auto key_of = [&](Tuple &tuple) {
+      return tuple.KeyFromTuple(table_info->schema_, index_info->key_schema_, index->GetKeyAttrs());
+    };
+    if (record->wtype_ == WType::INSERT || record->wtype_ == WType::UPDATE) {
+      index->DeleteEntry(record->is_key_ ? record->tuple_ : key_of(record->tuple_), record->rid_, txn);
+    }
+    if (record->wtype_ == WType::UPDATE) {
+      index->InsertEntry(key_of(record->old_tuple_), record->rid_, txn);
+    }
+  }
+
+  // Restore every tuple written to the version before the first write of the transaction. No other transaction
+  // writes a tuple after this one, so that version heads the version chain of the tuple.
+  std::unordered_set<RID> restored;
+  for (const auto &record : *txn->GetWriteSet()) {
+    if (!restored.insert(record.rid_).second) {
+      continue;
+    }
+    if (record.wtype_ == WType::INSERT) {
+      record.table_heap_->UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, record.rid_);
+      continue;
+    }
+    auto undo_log = GetUndoLog(record.rid_);
+    BUSTUB_ASSERT(undo_log != nullptr, "an overwritten tuple has an undo log");
+    auto pop = [&](const TupleMeta &, const Tuple &, RID rid) {
+      std::unique_lock<std::shared_mutex> l(version_chains_mutex_);
+      // Vacuum may have rebuilt the chain behind the saved version since, so pop the current head.
+      auto head = version_chains_.find(rid);
+      if (head->second->prev_ == nullptr) {
+        version_chains_.erase(head);
+      } else {
+        head->second = head->second->prev_;
+      }
+      return true;
+    };
+    if (record.wtype_ == WType::DELETE) {
+      record.table_heap_->UpdateTupleMeta(undo_log->meta_, record.rid_, pop);
+    } else {
+      // The versions written by the transaction kept the bytes of the one restored, see UpdateTupleInPlace().
+      BUSTUB_ENSURE(record.table_heap_->UpdateTupleInPlace(undo_log->meta_, undo_log->tuple_, record.rid_, pop),
+                    "the version restored by an abort does not fit into its slot");
+    }
+  }
+
+  {
+    std::unique_lock<std::shared_mutex> l(commit_log_mutex_);
+    if (txn->ReadsSnapshot()) {
+      active_read_ts_.erase(active_read_ts_.find(txn->GetReadTs()));
+    }
+  }
+  AbortedTxn aborted{last_commit_ts_.load(), txn->GetTransactionId(), {}};
+  for (const auto &record : *txn->GetWriteSet()) {
+    if (record.wtype_ == WType::UPDATE) {
+      aborted.updated_tables_.insert(record.table_heap_);
+    }
+  }
+  {
+    std::scoped_lock gc_lck(gc_mutex_);
+    aborted_txns_.push_back(std::move(aborted));
+  }
+
+  if (enable_logging) {
+    LogRecord record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&record));
+    std::scoped_lock l(begin_lsns_mutex_);
+    begin_lsns_.erase(txn->GetTransactionId());
+  }
 
   ReleaseLocks(txn);
 
   txn->SetState(TransactionState::ABORTED);
 }
 
-void TransactionManager::BlockAllTransactions() { UNIMPLEMENTED("block is not supported now!"); }
+auto TransactionManager::Validate(Transaction *txn) -> bool {
+  // The transaction holds back the watermark, so Vacuum() keeps the writes committed since it began.
+  std::vector<std::pair<txn_id_t, std::shared_ptr<std::deque<TableWriteRecord>>>> newer_writes;
+  {
+    std::scoped_lock gc_lck(gc_mutex_);
+    for (auto it = committed_writes_.rbegin(); it != committed_writes_.rend() && it->commit_ts_ > txn->GetReadTs();
+         ++it) {
+      newer_writes.emplace_back(it->txn_id_, it->table_writes_);
+    }
+  }
+  auto read_set = txn->GetReadSet();
+  auto scan_set = txn->GetScanSet();
+  for (const auto &[writer, table_writes] : newer_writes) {
+    for (const auto &record : *table_writes) {
+      if (read_set->count(record.rid_) > 0) {
+        return false;
+      }
+      // Deleting a tuple that was not read changes nothing read. Another version may be read by a scan though.
+      auto scanned = [&](const ScanRecord &scan) { return scan.table_heap_ == record.table_heap_; };
+      if (record.wtype_ == WType::DELETE || std::none_of(scan_set->begin(), scan_set->end(), scanned)) {
+        continue;
+      }
+      auto version = FindVersion(writer, record.table_heap_, record.rid_);
+      if (!version.has_value()) {
+        return false;
+      }
+      if (version->first.is_deleted_) {
+        continue;
+      }
+      for (const auto &scan : *scan_set) {
+        if (scanned(scan) && scan.matches_(version->second)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+auto TransactionManager::FindVersion(txn_id_t writer, TableHeap *table_heap, RID rid)
+    -> std::optional<std::pair<TupleMeta, Tuple>> {
+  auto version = table_heap->GetTuple(rid);
+  if (WriterOf(version.first) == writer) {
+    return version;
+  }
+  for (auto undo_log = GetUndoLog(rid); undo_log != nullptr; undo_log = undo_log->prev_) {
+    if (WriterOf(undo_log->meta_) == writer) {
+      return std::make_pair(undo_log->meta_, undo_log->tuple_);
+    }
+  }
+  return std::nullopt;
+}
 
-void TransactionManager::ResumeTransactions() { UNIMPLEMENTED("resume is not supported now!"); }
+auto TransactionManager::GetCommitTs(txn_id_t txn_id) -> timestamp_t {
+  std::shared_lock<std::shared_mutex> l(commit_log_mutex_);
+  auto it = commit_log_.find(txn_id);
+  // Transactions not begun here are taken as committed before all others.
+  return it == commit_log_.end() ? 0 : it->second;
+}
+
+auto TransactionManager::SeesVersion(const Transaction *txn, const TupleMeta &meta) -> bool {
+  auto writer = WriterOf(meta);
+  if (writer == INVALID_TXN_ID || writer == txn->GetTransactionId() || !txn->ReadsSnapshot()) {
+    return true;
+  }
+  auto commit_ts = GetCommitTs(writer);
+  return commit_ts != INVALID_TS && commit_ts <= txn->GetReadTs();
+}
+
+auto TransactionManager::GetVersion(const Transaction *txn, RID rid) -> std::optional<Tuple> {
+  for (auto undo_log = GetUndoLog(rid); undo_log != nullptr; undo_log = undo_log->prev_) {
+    if (SeesVersion(txn, undo_log->meta_)) {
+      if (undo_log->meta_.is_deleted_) {
+        return std::nullopt;
+      }
+      return undo_log->tuple_;
+    }
+  }
+  return std::nullopt;
+}
+
+auto TransactionManager::PrepareWrite(Transaction *txn, const TupleMeta &meta, const Tuple &tuple, RID rid) -> bool {
+  auto writer = WriterOf(meta);
+  if (writer == txn->GetTransactionId()) {
+    // The version before the first write of the transaction is saved already.
+    return !meta.is_deleted_;
+  }
+  if (writer != INVALID_TXN_ID) {
+    auto commit_ts = GetCommitTs(writer);
+    if (commit_ts == INVALID_TS || (txn->ReadsSnapshot() && commit_ts > txn->GetReadTs())) {
+      txn->SetState(TransactionState::ABORTED);
+      throw ExecutionException(fmt::format("transaction {} aborted: write-write conflict with transaction {} on {}",
+                                           txn->GetTransactionId(), writer, rid.ToString()));
+    }
+  }
+  if (meta.is_deleted_) {
+    return false;
+  }
+  std::unique_lock<std::shared_mutex> l(version_chains_mutex_);
+  auto &head = version_chains_[rid];
+  head = std::make_shared<const UndoLog>(UndoLog{meta, tuple, head});
+  return true;
+}
+
+auto TransactionManager::GetUndoLog(RID rid) -> std::shared_ptr<const UndoLog> {
+  std::shared_lock<std::shared_mutex> l(version_chains_mutex_);
+  auto it = version_chains_.find(rid);
+  return it == version_chains_.end() ? nullptr : it->second;
+}
+
+auto TransactionManager::GetWatermark() -> timestamp_t {
+  std::shared_lock<std::shared_mutex> l(commit_log_mutex_);
+  return active_read_ts_.empty() ? last_commit_ts_.load() : *active_read_ts_.begin();
+}
+
+auto TransactionManager::IsVisibleToAll(txn_id_t txn_id, timestamp_t watermark) -> bool {
+  if (txn_id == INVALID_TXN_ID) {
+    return true;
+  }
+  auto commit_ts = GetCommitTs(txn_id);
+  return commit_ts != INVALID_TS && commit_ts <= watermark;
+}
+
+void TransactionManager::PruneVersionChain(RID rid, txn_id_t writer, timestamp_t watermark) {
+  auto head = GetUndoLog(rid);
+  // A version is read by no transaction once every transaction sees the version that overwrote it, and neither are
+  // the older ones then.
+  std::vector<const UndoLog *> kept;
+  auto overwriter = writer;
+  const auto *undo_log = head.get();
+  for (; undo_log != nullptr && !IsVisibleToAll(overwriter, watermark); undo_log = undo_log->prev_.get()) {
+    kept.push_back(undo_log);
+    overwriter = WriterOf(undo_log->meta_);
+  }
+  if (undo_log == nullptr) {
+    return;
+  }
+  // The undo logs are shared with the readers, so the versions kept are copied into a new chain.
+  std::shared_ptr<const UndoLog> pruned;
+  for (auto it = kept.rbegin(); it != kept.rend(); ++it) {
+    pruned = std::make_shared<const UndoLog>(UndoLog{(*it)->meta_, (*it)->tuple_, pruned});
+  }
+  std::unique_lock<std::shared_mutex> l(version_chains_mutex_);
+  if (pruned == nullptr) {
+    version_chains_.erase(rid);
+  } else {
+    version_chains_[rid] = pruned;
+  }
+}
+
+void TransactionManager::VacuumWrites(const CommittedWrites &writes, timestamp_t watermark) {
+  // The index entries of the deleted tuples go first, as their slots are free for new tuples once they are frozen.
+  std::vector<RID> rids;
+  for (const auto &[index, key, rid] : writes.index_entries_) {
+    rids.clear();
+    index->ScanKey(key, &rids, nullptr);
+    if (std::find(rids.begin(), rids.end(), rid) != rids.end()) {
+      index->DeleteEntry(key, rid, nullptr);
+    }
+  }
+
+  std::set<std::pair<TableHeap *, page_id_t>> pages;
+  for (const auto &record : *writes.table_writes_) {
+    TupleMeta frozen{INVALID_TXN_ID, INVALID_TXN_ID, false};
+    auto freeze = [&](const TupleMeta &meta, const Tuple &, RID rid) {
+      PruneVersionChain(rid, WriterOf(meta), watermark);
+      // A tuple overwritten since is frozen with the writes of its last writer.
+      if (WriterOf(meta) != writes.txn_id_ || GetUndoLog(rid) != nullptr) {
+        return false;
+      }
+      frozen.is_deleted_ = meta.is_deleted_;
+      return true;
+    };
+    if (!record.table_heap_->UpdateTupleMeta(frozen, record.rid_, freeze)) {
+      continue;
+    }
+    if (frozen.is_deleted_) {
+      pages.emplace(record.table_heap_, record.rid_.GetPageId());
+    } else if (record.wtype_ == WType::UPDATE) {
+      record.table_heap_->TrimTuple(record.rid_);
+    }
+  }
+  for (auto [table_heap, page_id] : pages) {
+    table_heap->CompactPage(page_id);
+  }
+  // The versions the transaction overwrote in place are not read anymore either.
+  auto can_free = [&](txn_id_t txn_id) { return IsVisibleToAll(txn_id, watermark); };
+  std::set<TableHeap *> updated_tables;
+  for (const auto &record : *writes.table_writes_) {
+    if (record.wtype_ == WType::UPDATE && updated_tables.insert(record.table_heap_).second) {
+      record.table_heap_->FreeRetiredChains(can_free);
+    }
+  }
+
+  // The transaction is now seen by all as one committed before all others.
+  std::unique_lock<std::shared_mutex> l(commit_log_mutex_);
+  commit_log_.erase(writes.txn_id_);
+}
+
+void TransactionManager::Vacuum() {
+  std::scoped_lock vacuum_lck(vacuum_mutex_);
+  auto watermark = GetWatermark();
+  while (true) {
+    CommittedWrites writes;
+    {
+      std::scoped_lock gc_lck(gc_mutex_);
+      if (committed_writes_.empty() || committed_writes_.front().commit_ts_ > watermark) {
+        break;
+      }
+      writes = std::move(committed_writes_.front());
+      committed_writes_.pop_front();
+    }
+    VacuumWrites(writes, watermark);
+  }
+
+  // An aborted transaction is forgotten, so that it counts as committed before all others, only once it wrote no
+  // version left anywhere: Abort() marks the tuples it inserted as deleted by nobody, and puts back the version before
+  // it into every tuple it overwrote, which no other transaction wrote over since, see PrepareWrite(). The tuples it
+  // wrote are in its write set, but for the ones it inserted and could not lock, which the table heap marks the same
+  // way at once, see TableHeap::AbandonInsertedTuples(). A restore that fails throws before the transaction is queued
+  // here, which leaves it in the commit log as uncommitted for good.
+  // Until then, the transactions that ran when it aborted may still look it up for a version they read before.
+  std::vector<AbortedTxn> forgotten;
+  {
+    std::scoped_lock gc_lck(gc_mutex_);
+    while (!aborted_txns_.empty() && aborted_txns_.front().last_commit_ts_ < watermark) {
+      forgotten.push_back(std::move(aborted_txns_.front()));
+      aborted_txns_.pop_front();
+    }
+  }
+  {
+    std::unique_lock<std::shared_mutex> l(commit_log_mutex_);
+    for (const auto &aborted : forgotten) {
+      commit_log_.erase(aborted.txn_id_);
+    }
+  }
+  // The versions an aborted transaction overwrote were restored from copies, and nobody reads the originals anymore.
+  auto can_free = [&](txn_id_t txn_id) { return IsVisibleToAll(txn_id, watermark); };
+  for (const auto &aborted : forgotten) {
+    for (auto *table_heap : aborted.updated_tables_) {
+      table_heap->FreeRetiredChains(can_free);
+    }
+  }
+}
+
+void TransactionManager::RunVacuum() {
+  while (enable_vacuum_) {
+    std::this_thread::sleep_for(vacuum_interval);
+    Vacuum();
+  }
+}
 
 }  // namespace bustub
@@ -1,29 +1,474 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// aggregation_executor.cpp
-//
-// Identification: src/execution/aggregation_executor.cpp
-//
-// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include <memory>
-#include <vector>
-
-#include "execution/executors/aggregation_executor.h"
-
-namespace bustub {
-
-AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
-                                         std::unique_ptr<AbstractExecutor> &&child)
-    : AbstractExecutor(exec_ctx) {}
-
-void AggregationExecutor::Init() {}
-
-auto AggregationExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
-
-auto AggregationExecutor::GetChildExecutor() const -> const AbstractExecutor * { return child_.get(); }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_executor.cpp
+//
+// Identification: src/execution/aggregation_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "execution/executors/aggregation_executor.h"
+#include "execution/expressions/column_value_expression.h"
+#include "murmur3/MurmurHash3.h"
+
+namespace bustub {
+
+namespace {
+
+/** Number of child tuples handed to a worker at once. */
+constexpr size_t AGGREGATION_BATCH_SIZE = 1024;
+
+/** Maximum number of spill partitions per level. Every partition keeps one page pinned while it is written. */
+constexpr size_t AGGREGATION_MAX_PARTITIONS = 16;
+
+/** Partitions deeper than this are aggregated in memory regardless of the budget, e.g. a single huge group. */
+constexpr size_t AGGREGATION_MAX_SPILL_DEPTH = 4;
+
+auto HashKey(std::string_view key, uint32_t seed) -> hash_t {
+  uint64_t hash[2];
+  murmur3::MurmurHash3_x64_128(key.data(), static_cast<int>(key.size()), seed, reinterpret_cast<void *>(&hash));
+  return hash[0];
+}
+
+/** Fold `input` into a running aggregate. NULL inputs are ignored. */
+void FoldValue(AggregationType agg_type, Value *result, const Value &input) {
+  if (input.IsNull()) {
+    return;
+  }
+  if (result->IsNull()) {
+    *result = input;
+    return;
+  }
+  switch (agg_type) {
+    case AggregationType::CountStarAggregate:
+    case AggregationType::CountAggregate:
+    case AggregationType::SumAggregate:
+      *result = result->Add(input);
+      break;
+    case AggregationType::MinAggregate:
+      if (input.CompareLessThan(*result) == CmpBool::CmpTrue) {
+        *result = input;
+      }
+      break;
+    case AggregationType::MaxAggregate:
+      if (input.CompareGreaterThan(*result) == CmpBool::CmpTrue) {
+        *result = input;
+      }
+      break;
+  }
+}
+
+}  // namespace
+
+/*
+ * AggregationHashTable
+ */
+auto AggregationHashTable::GenerateInitialAggregateValue() const -> AggregateValue {
+  std::vector<Value> values{};
+  for (const auto &agg_type : agg_types_) {
+    switch (agg_type) {
+      case AggregationType::CountStarAggregate:
+        // Count start starts at zero.
+        values.emplace_back(ValueFactory::GetIntegerValue(0));
+        break;
+      case AggregationType::CountAggregate:
+      case AggregationType::SumAggregate:
+      case AggregationType::MinAggregate:
+      case AggregationType::MaxAggregate:
+        // Others starts at null.
+        values.emplace_back(ValueFactory::GetNullValueByType(TypeId::INTEGER));
+        break;
+    }
+  }
+  return {values};
+}
+
+auto AggregationHashTable::FindOrInsert(std::string_view key, hash_t hash, const Value *group_bys) -> size_t {
+  if (slots_.empty()) {
+    slots_.assign(64, Slot{EMPTY_SLOT, 0});
+  }
+  auto tag = static_cast<uint32_t>(hash >> 32);
+  auto mask = slots_.size() - 1;
+  auto idx = hash & mask;
+  while (slots_[idx].group_ != EMPTY_SLOT) {
+    if (slots_[idx].tag_ == tag && GetKey(slots_[idx].group_) == key) {
+      return slots_[idx].group_;
+    }
+    idx = (idx + 1) & mask;
+  }
+
+  auto group = Size();
+  slots_[idx] = Slot{static_cast<uint32_t>(group), tag};
+  key_arena_.append(key);
+  key_offsets_.push_back(key_arena_.size());
+  hashes_.push_back(hash);
+  group_bys_.insert(group_bys_.end(), group_bys, group_bys + num_group_bys_);
+  auto initial = GenerateInitialAggregateValue();
+  aggregates_.insert(aggregates_.end(), initial.aggregates_.begin(), initial.aggregates_.end());
+  if (Size() * 2 > slots_.size()) {
+    Grow();
+  }
+  return group;
+}
+
+void AggregationHashTable::Grow() {
+  slots_.assign(slots_.size() * 2, Slot{EMPTY_SLOT, 0});
+  auto mask = slots_.size() - 1;
+  for (size_t group = 0; group < Size(); group++) {
+    auto idx = hashes_[group] & mask;
+    while (slots_[idx].group_ != EMPTY_SLOT) {
+      idx = (idx + 1) & mask;
+    }
+    slots_[idx] = Slot{static_cast<uint32_t>(group), static_cast<uint32_t>(hashes_[group] >> 32)};
+  }
+}
+
+void AggregationHashTable::Combine(size_t group, const std::vector<Value> &inputs) {
+  auto *result = aggregates_.data() + group * agg_types_.size();
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    switch (agg_types_[i]) {
+      case AggregationType::CountStarAggregate:
+        result[i] = result[i].Add(ValueFactory::GetIntegerValue(1));
+        break;
+      case AggregationType::CountAggregate:
+        if (!inputs[i].IsNull()) {
+          FoldValue(agg_types_[i], &result[i], ValueFactory::GetIntegerValue(1));
+        }
+        break;
+      case AggregationType::SumAggregate:
+      case AggregationType::MinAggregate:
+      case AggregationType::MaxAggregate:
+        FoldValue(agg_types_[i], &result[i], inputs[i]);
+        break;
+    }
+  }
+}
+
+void AggregationHashTable::Merge(size_t group, const Value *partials) {
+  auto *result = aggregates_.data() + group * agg_types_.size();
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    // Partial counts add up like sums, so every aggregate merges by folding its partial result.
+    FoldValue(agg_types_[i], &result[i], partials[i]);
+  }
+}
+
+void AggregationHashTable::MergeTable(const AggregationHashTable &other) {
+  for (size_t group = 0; group < other.Size(); group++) {
+    Merge(FindOrInsert(other.GetKey(group), other.GetHash(group), other.GetGroupBys(group)),
+          other.GetAggregates(group));
+  }
+}
+
+void AggregationHashTable::Clear() {
+  // Give the memory back too: GetMemoryUsage() counts capacities, so a table keeping them would stay over budget.
+  std::vector<Slot>().swap(slots_);
+  std::string().swap(key_arena_);
+  std::vector<uint32_t>{0}.swap(key_offsets_);
+  std::vector<hash_t>().swap(hashes_);
+  std::vector<Value>().swap(group_bys_);
+  std::vector<Value>().swap(aggregates_);
+}
+
+/*
+ * AggregationExecutor
+ */
+AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
+                                         std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx), plan_(plan), child_(std::move(child)) {}
+
+void AggregationExecutor::Init() {
+  // Group by codes if the child can hand them out for every group-by column.
+  coded_child_ = nullptr;
+  auto *scan = dynamic_cast<SeqScanExecutor *>(child_.get());
+  std::vector<uint32_t> columns;
+  for (const auto &group_by : plan_->GetGroupBys()) {
+    if (const auto *column = dynamic_cast<const ColumnValueExpression *>(group_by.get()); column != nullptr) {
+      columns.push_back(column->GetColIdx());
+    }
+  }
+  if (scan != nullptr && !columns.empty() && columns.size() == plan_->GetGroupBys().size() &&
+      scan->EnableCodes(columns)) {
+    coded_child_ = scan;
+  }
+
+  child_->Init();
+  partitions_.clear();
+  num_spills_ = 0;
+  pending_.clear();
+  result_ = nullptr;
+  group_idx_ = 0;
+
+  auto next_batch = [this](Batch *batch) {
+    batch->tuples_.clear();
+    batch->keys_.clear();
+    while (batch->tuples_.size() < AGGREGATION_BATCH_SIZE) {
+      if (!NextChild(batch)) {
+        break;
+      }
+    }
+    return !batch->tuples_.empty();
+  };
+
+  Batch batch;
+  next_batch(&batch);
+  // Only inputs larger than one batch are worth starting threads for.
+  if (batch.tuples_.size() == AGGREGATION_BATCH_SIZE && aggregation_num_threads > 1) {
+    AggregateParallel(std::move(batch), aggregation_num_threads);
+  } else {
+    result_ = MakeTable();
+    do {
+      AggregateBatch(batch, result_.get(), aggregation_memory_budget);
+    } while (next_batch(&batch));
+  }
+
+  if (!partitions_.empty()) {
+    SpillTable(result_.get(), &partitions_, 0);
+    result_ = nullptr;
+    for (auto &partition : partitions_) {
+      partition->FinishWrite();
+      pending_.emplace_back(std::move(partition), 1);
+    }
+    partitions_.clear();
+    return;
+  }
+  if (result_->Size() == 0 && plan_->GetGroupBys().empty()) {
+    // An aggregation without group-bys outputs its initial values over an empty input.
+    result_->FindOrInsert("", HashKey("", 0), nullptr);
+  }
+}
+
+auto AggregationExecutor::NextChild(Batch *batch) -> bool {
+  Tuple tuple;
+  RID rid;
+  if (!child_->Next(&tuple, &rid)) {
+    return false;
+  }
+  batch->tuples_.push_back(std::move(tuple));
+  if (coded_child_ != nullptr) {
+    auto &key = batch->keys_.emplace_back();
+    for (auto code : coded_child_->GetCodes()) {
+      key.append(reinterpret_cast<const char *>(&code), sizeof(code));
+    }
+  }
+  return true;
+}
+
+void AggregationExecutor::AggregateBatch(const Batch &batch, AggregationHashTable *table, size_t budget) {
+  const auto &schema = child_->GetOutputSchema();
+  std::vector<Value> group_bys(plan_->GetGroupBys().size());
+  std::vector<Value> inputs(plan_->GetAggregates().size());
+  std::string key;
+  for (size_t t = 0; t < batch.tuples_.size(); t++) {
+    const auto &tuple = batch.tuples_[t];
+    key.clear();
+    for (size_t i = 0; i < group_bys.size(); i++) {
+      group_bys[i] = plan_->GetGroupByAt(i)->Evaluate(&tuple, schema);
+      if (batch.keys_.empty()) {
+        SortKeyEncoder::AppendValue(group_bys[i], false, &key);
+      }
+    }
+    if (!batch.keys_.empty()) {
+      // Equal codes mean equal values, so the codes key the group without encoding the values.
+      key = batch.keys_[t];
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+      inputs[i] = plan_->GetAggregateAt(i)->Evaluate(&tuple, schema);
+    }
+    table->Combine(table->FindOrInsert(key, HashKey(key, 0), group_bys.data()), inputs);
+    if (table->GetMemoryUsage() > budget) {
+      SpillTable(table, &partitions_, 0);
+    }
+  }
+}
+
+void AggregationExecutor::AggregateParallel(Batch first_batch, size_t num_threads) {
+  std::mutex latch;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+  std::deque<Batch> queue;
+  bool input_done = false;
+  bool aborted = false;
+  std::exception_ptr error;
+
+  auto budget = std::max<size_t>(aggregation_memory_budget / num_threads, 1);
+  std::vector<std::unique_ptr<AggregationHashTable>> tables;
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < num_threads; i++) {
+    tables.emplace_back(MakeTable());
+  }
+  for (size_t i = 0; i < num_threads; i++) {
+    workers.emplace_back([&, table = tables[i].get()] {
+      while (true) {
+        Batch batch;
+        {
+          std::unique_lock lock(latch);
+          not_empty.wait(lock, [&] { return !queue.empty() || input_done || aborted; });
+          if (queue.empty() || aborted) {
+            return;
+          }
+          batch = std::move(queue.front());
+          queue.pop_front();
+        }
+        not_full.notify_one();
+        try {
+          AggregateBatch(batch, table, budget);
+        } catch (...) {
+          std::scoped_lock lock(latch);
+          if (error == nullptr) {
+            error = std::current_exception();
+          }
+          aborted = true;
+          not_empty.notify_all();
+          not_full.notify_all();
+          return;
+        }
+      }
+    });
+  }
+
+  // The child is not thread-safe, so this thread stays the only one pulling from it.
+  auto push = [&](Batch batch) {
+    std::unique_lock lock(latch);
+    not_full.wait(lock, [&] { return queue.size() < 2 * num_threads || aborted; });
+    if (aborted) {
+      return false;
+    }
+    queue.emplace_back(std::move(batch));
+    not_empty.notify_one();
+    return true;
+  };
+  try {
+    if (push(std::move(first_batch))) {
+      Batch batch;
+      while (NextChild(&batch)) {
+        if (batch.tuples_.size() == AGGREGATION_BATCH_SIZE) {
+          if (!push(std::move(batch))) {
+            break;
+          }
+          batch = {};
+        }
+      }
+      if (!batch.tuples_.empty()) {
+        push(std::move(batch));
+      }
+    }
+  } catch (...) {
+    std::scoped_lock lock(latch);
+    error = std::current_exception();
+    aborted = true;
+  }
+  {
+    std::scoped_lock lock(latch);
+    input_done = true;
+  }
+  not_empty.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+
+  if (!partitions_.empty()) {
+    // Once anything spilled, the partitions are the only consistent place to merge the partial results.
+    for (size_t i = 1; i < num_threads; i++) {
+      SpillTable(tables[i].get(), &partitions_, 0);
+    }
+  } else {
+    for (size_t i = 1; i < num_threads; i++) {
+      tables[0]->MergeTable(*tables[i]);
+    }
+  }
+  result_ = std::move(tables[0]);
+}
+
+void AggregationExecutor::SpillTable(AggregationHashTable *table, std::vector<std::unique_ptr<SortRun>> *partitions,
+                                     size_t depth) {
+  auto *bpm = exec_ctx_->GetBufferPoolManager();
+  std::scoped_lock lock(spill_latch_);
+  if (partitions->empty()) {
+    auto num_partitions = std::clamp<size_t>(bpm->GetPoolSize() / 4, 2, AGGREGATION_MAX_PARTITIONS);
+    for (size_t i = 0; i < num_partitions; i++) {
+      partitions->emplace_back(std::make_unique<SortRun>(bpm));
+    }
+  }
+  const auto &schema = GetOutputSchema();
+  auto num_group_bys = plan_->GetGroupBys().size();
+  auto num_aggregates = plan_->GetAggregates().size();
+  std::vector<Value> values;
+  for (size_t group = 0; group < table->Size(); group++) {
+    // A partial aggregate is spilled as the output row of its group, keyed by the normalized group key.
+    values.assign(table->GetGroupBys(group), table->GetGroupBys(group) + num_group_bys);
+    values.insert(values.end(), table->GetAggregates(group), table->GetAggregates(group) + num_aggregates);
+    auto key = table->GetKey(group);
+    auto partition = HashKey(key, depth + 1) % partitions->size();
+    (*partitions)[partition]->Append(SortEntry{std::string(key), Tuple{values, &schema}});
+  }
+  table->Clear();
+  num_spills_++;
+}
+
+auto AggregationExecutor::AggregatePartition(const SortRun &run, size_t depth)
+    -> std::unique_ptr<AggregationHashTable> {
+  const auto &schema = GetOutputSchema();
+  auto num_group_bys = plan_->GetGroupBys().size();
+  auto table = MakeTable();
+  std::vector<std::unique_ptr<SortRun>> partitions;
+  std::vector<Value> values(schema.GetColumnCount());
+  SortRunCursor cursor(exec_ctx_->GetBufferPoolManager(), &run);
+  SortEntry entry;
+  while (cursor.Next(&entry)) {
+    for (uint32_t i = 0; i < values.size(); i++) {
+      values[i] = entry.tuple_.GetValue(&schema, i);
+    }
+    table->Merge(table->FindOrInsert(entry.key_, HashKey(entry.key_, 0), values.data()),
+                 values.data() + num_group_bys);
+    if (depth < AGGREGATION_MAX_SPILL_DEPTH && table->GetMemoryUsage() > aggregation_memory_budget) {
+      SpillTable(table.get(), &partitions, depth);
+    }
+  }
+  if (partitions.empty()) {
+    return table;
+  }
+  SpillTable(table.get(), &partitions, depth);
+  for (auto &partition : partitions) {
+    partition->FinishWrite();
+    pending_.emplace_back(std::move(partition), depth + 1);
+  }
+  return nullptr;
+}
+
+auto AggregationExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (result_ == nullptr || group_idx_ == result_->Size()) {
+    if (pending_.empty()) {
+      return false;
+    }
+    auto [run, depth] = std::move(pending_.back());
+    pending_.pop_back();
+    result_ = AggregatePartition(*run, depth);
+    group_idx_ = 0;
+  }
+  std::vector<Value> values(result_->GetGroupBys(group_idx_),
+                            result_->GetGroupBys(group_idx_) + plan_->GetGroupBys().size());
+  values.insert(values.end(), result_->GetAggregates(group_idx_),
+                result_->GetAggregates(group_idx_) + plan_->GetAggregates().size());
+  *tuple = Tuple{values, &GetOutputSchema()};
+  *rid = tuple->GetRid();
+  group_idx_++;
+  return true;
+}
+
+auto AggregationExecutor::GetChildExecutor() const -> const AbstractExecutor * { return child_.get(); }
+
+}  // namespace bustub
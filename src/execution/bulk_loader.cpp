@@ -0,0 +1,472 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bulk_loader.cpp
+//
+// Identification: src/execution/bulk_loader.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/bulk_loader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
+#include "common/exception.h"
+#include "common/util/string_util.h"
+#include "fmt/format.h"
+#include "type/limits.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** Parse an integer that must fill `field` and lie in [min, max]. */
+template <typename T>
+auto ParseInteger(std::string_view field, T min, T max, T *result) -> bool {
+  int64_t value = 0;
+  auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+  if (ec != std::errc() || end != field.data() + field.size() || value < min || value > max) {
+    return false;
+  }
+  *result = static_cast<T>(value);
+  return true;
+}
+
+}  // namespace
+
+BulkLoader::BulkLoader(Catalog *catalog, const TableInfo *table_info, std::vector<IndexInfo *> indexes,
+                       Transaction *txn, CopyOptions options, size_t num_threads)
+    : catalog_(catalog),
+      table_info_(table_info),
+      indexes_(std::move(indexes)),
+      txn_(txn),
+      options_(std::move(options)),
+      num_threads_(std::max<size_t>(num_threads, 1)) {
+  if (options_.delimiter_ == '\n' || options_.quote_ == '\n' || options_.delimiter_ == options_.quote_) {
+    throw ExecutionException("COPY delimiter and quote must be different characters other than newline");
+  }
+}
+
+auto BulkLoader::Load(std::istream &input) -> size_t {
+  std::mutex latch;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+  std::deque<Chunk> queue;
+  bool input_done = false;
+  bool aborted = false;
+  std::exception_ptr error;
+
+  std::vector<LoadResult> results(num_threads_);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < num_threads_; i++) {
+    results[i].index_entries_.resize(indexes_.size());
+    workers.emplace_back([&, result = &results[i]] {
+      std::vector<Tuple> batch;
+      try {
+        while (true) {
+          Chunk chunk;
+          {
+            std::unique_lock lock(latch);
+            not_empty.wait(lock, [&] { return !queue.empty() || input_done || aborted; });
+            if (queue.empty() || aborted) {
+              break;
+            }
+            chunk = std::move(queue.front());
+            queue.pop_front();
+          }
+          not_full.notify_one();
+          LoadChunk(chunk, &batch, result);
+        }
+        Flush(&batch, result);
+      } catch (...) {
+        std::scoped_lock lock(latch);
+        if (error == nullptr) {
+          error = std::current_exception();
+        }
+        aborted = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+      }
+    });
+  }
+
+  auto push = [&](Chunk chunk) {
+    std::unique_lock lock(latch);
+    not_full.wait(lock, [&] { return queue.size() < 2 * num_threads_ || aborted; });
+    if (aborted) {
+      return false;
+    }
+    queue.emplace_back(std::move(chunk));
+    not_empty.notify_one();
+    return true;
+  };
+  try {
+    // Read the input a block at a time and hand out its complete records; the incomplete tail waits for the next
+    // block.
+    std::string buffer;
+    size_t scanned = 0;
+    bool in_quote = false;
+    size_t next_record = 1;
+    while (true) {
+      auto size = buffer.size();
+      buffer.resize(size + copy_chunk_size);
+      input.read(buffer.data() + size, static_cast<std::streamsize>(copy_chunk_size));
+      buffer.resize(size + input.gcount());
+      auto eof = !input;
+      if (input.bad()) {
+        throw ExecutionException("COPY failed to read its input");
+      }
+
+      auto end = CompleteRecords(buffer, &scanned, &in_quote);
+      if (eof && end != buffer.size()) {
+        if (options_.format_ == CopyFormat::BINARY) {
+          throw ExecutionException(fmt::format("COPY {} record {}: truncated record", table_info_->name_,
+                                               next_record + CountRecords(std::string_view(buffer).substr(0, end))));
+        }
+        if (in_quote) {
+          throw ExecutionException(fmt::format("COPY {}: unterminated quoted field", table_info_->name_));
+        }
+        // The last line does not need a newline.
+        end = buffer.size();
+      }
+      if (end > 0) {
+        Chunk chunk{buffer.substr(0, end), next_record};
+        next_record += CountRecords(chunk.data_);
+        buffer.erase(0, end);
+        scanned -= end;
+        if (!push(std::move(chunk))) {
+          break;
+        }
+      }
+      if (eof) {
+        break;
+      }
+    }
+  } catch (...) {
+    std::scoped_lock lock(latch);
+    if (error == nullptr) {
+      error = std::current_exception();
+    }
+    aborted = true;
+  }
+  {
+    std::scoped_lock lock(latch);
+    input_done = true;
+  }
+  not_empty.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  // Whatever reached the table belongs to the transaction, even if the load failed.
+  size_t num_rows = 0;
+  for (const auto &result : results) {
+    num_rows += result.num_rows_;
+    for (const auto &rid : result.rids_) {
+      TableWriteRecord write_record{table_info_->oid_, rid, table_info_->table_.get()};
+      write_record.wtype_ = WType::INSERT;
+      txn_->AppendTableWriteRecord(write_record);
+    }
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+
+  // Build the indexes from the collected entries, inserted in key order.
+  for (size_t i = 0; i < indexes_.size(); i++) {
+    std::vector<std::pair<Tuple, RID>> entries;
+    entries.reserve(num_rows);
+    for (auto &result : results) {
+      auto &worker_entries = result.index_entries_[i];
+      std::move(worker_entries.begin(), worker_entries.end(), std::back_inserter(entries));
+      worker_entries = {};
+    }
+    // Aborting removes the entries again. The records keep the keys, the rows are not kept around for them.
+    if (txn_ != nullptr) {
+      for (const auto &[key, rid] : entries) {
+        IndexWriteRecord write_record{rid, table_info_->oid_, WType::INSERT, key, indexes_[i]->index_oid_, catalog_};
+        write_record.is_key_ = true;
+        txn_->AppendIndexWriteRecord(write_record);
+      }
+    }
+    indexes_[i]->index_->InsertEntries(&entries, txn_);
+  }
+  return num_rows;
+}
+
+auto BulkLoader::CompleteRecords(const std::string &buffer, size_t *scanned, bool *in_quote) const -> size_t {
+  size_t end = 0;
+  if (options_.format_ == CopyFormat::BINARY) {
+    while (end + sizeof(uint32_t) <= buffer.size()) {
+      uint32_t size;
+      memcpy(&size, buffer.data() + end, sizeof(uint32_t));
+      if (size > BUSTUB_PAGE_SIZE) {
+        throw ExecutionException(fmt::format("COPY {}: record of {} bytes is larger than a page", table_info_->name_,
+                                             size));
+      }
+      if (end + sizeof(uint32_t) + size > buffer.size()) {
+        break;
+      }
+      end += sizeof(uint32_t) + size;
+    }
+    return end;
+  }
+
+  // Everything before the last newline outside of quotes is complete. Quotes toggle the state wherever they appear;
+  // an escaped quote toggles it twice.
+  for (; *scanned < buffer.size(); (*scanned)++) {
+    auto c = buffer[*scanned];
+    if (c == options_.quote_) {
+      *in_quote = !*in_quote;
+    } else if (c == '\n' && !*in_quote) {
+      end = *scanned + 1;
+    }
+  }
+  return end;
+}
+
+auto BulkLoader::CountRecords(std::string_view data) const -> size_t {
+  if (options_.format_ == CopyFormat::CSV) {
+    return std::count(data.begin(), data.end(), '\n');
+  }
+  size_t count = 0;
+  for (size_t offset = 0; offset < data.size(); count++) {
+    uint32_t size;
+    memcpy(&size, data.data() + offset, sizeof(uint32_t));
+    offset += sizeof(uint32_t) + size;
+  }
+  return count;
+}
+
+void BulkLoader::LoadChunk(const Chunk &chunk, std::vector<Tuple> *batch, LoadResult *result) const {
+  std::string_view data = chunk.data_;
+  auto line_number = chunk.first_record_;
+
+  if (options_.format_ == CopyFormat::BINARY) {
+    for (size_t offset = 0; offset < data.size(); line_number++) {
+      uint32_t size;
+      memcpy(&size, data.data() + offset, sizeof(uint32_t));
+      CheckRecord(data.substr(offset + sizeof(uint32_t), size), line_number);
+      batch->emplace_back();
+      batch->back().DeserializeFrom(data.data() + offset);
+      offset += sizeof(uint32_t) + size;
+      if (batch->size() >= insert_batch_size) {
+        Flush(batch, result);
+      }
+    }
+    return;
+  }
+
+  auto skip_header = options_.header_ && chunk.first_record_ == 1;
+  std::vector<Value> values;
+  std::string scratch;
+  size_t offset = 0;
+  while (offset < data.size()) {
+    // Find the end of the line, skipping newlines inside quoted fields.
+    auto end = offset;
+    auto in_quote = false;
+    size_t num_lines = 1;
+    for (; end < data.size() && (in_quote || data[end] != '\n'); end++) {
+      if (data[end] == options_.quote_) {
+        in_quote = !in_quote;
+      } else if (data[end] == '\n') {
+        num_lines++;
+      }
+    }
+    auto line = data.substr(offset, end - offset);
+    offset = end + 1;
+    if (skip_header) {
+      skip_header = false;
+    } else {
+      batch->emplace_back(ParseLine(line, line_number, &values, &scratch));
+      if (batch->size() >= insert_batch_size) {
+        Flush(batch, result);
+      }
+    }
+    line_number += num_lines;
+  }
+}
+
+auto BulkLoader::ParseLine(std::string_view line, size_t line_number, std::vector<Value> *values,
+                           std::string *scratch) const -> Tuple {
+  const auto &schema = table_info_->schema_;
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+
+  values->clear();
+  size_t pos = 0;
+  while (true) {
+    if (values->size() == schema.GetColumnCount()) {
+      throw ExecutionException(fmt::format("COPY {} line {}: more than {} fields", table_info_->name_, line_number,
+                                           schema.GetColumnCount()));
+    }
+    // Most fields have no quotes and are parsed in place.
+    auto end = pos;
+    while (end < line.size() && line[end] != options_.delimiter_ && line[end] != options_.quote_) {
+      end++;
+    }
+    if (end == line.size() || line[end] == options_.delimiter_) {
+      values->push_back(ParseField(line.substr(pos, end - pos), false, values->size(), line_number));
+    } else {
+      // A quote anywhere in the field starts a quoted part, inside which a doubled quote is a literal quote.
+      scratch->assign(line.substr(pos, end - pos));
+      auto in_quote = false;
+      for (; end < line.size() && (in_quote || line[end] != options_.delimiter_); end++) {
+        if (line[end] != options_.quote_) {
+          scratch->push_back(line[end]);
+        } else if (in_quote && end + 1 < line.size() && line[end + 1] == options_.quote_) {
+          scratch->push_back(options_.quote_);
+          end++;
+        } else {
+          in_quote = !in_quote;
+        }
+      }
+      values->push_back(ParseField(*scratch, true, values->size(), line_number));
+    }
+    if (end == line.size()) {
+      break;
+    }
+    pos = end + 1;
+  }
+
+  if (values->size() != schema.GetColumnCount()) {
+    throw ExecutionException(fmt::format("COPY {} line {}: expected {} fields, got {}", table_info_->name_,
+                                         line_number, schema.GetColumnCount(), values->size()));
+  }
+  return {*values, &schema};
+}
+
+auto BulkLoader::ParseField(std::string_view field, bool quoted, uint32_t column_idx, size_t line_number) const
+    -> Value {
+  const auto &column = table_info_->schema_.GetColumn(column_idx);
+  auto type = column.GetType();
+  if (!quoted && field == options_.null_string_) {
+    return ValueFactory::GetNullValueByType(type);
+  }
+  auto invalid = [&]() {
+    return ExecutionException(fmt::format("COPY {} line {}: invalid input for column {}: \"{}\"", table_info_->name_,
+                                          line_number, column.GetName(), field));
+  };
+
+  switch (type) {
+    case TypeId::BOOLEAN: {
+      auto lower = StringUtil::Lower(std::string(field));
+      if (lower == "true" || lower == "t" || lower == "1") {
+        return ValueFactory::GetBooleanValue(true);
+      }
+      if (lower == "false" || lower == "f" || lower == "0") {
+        return ValueFactory::GetBooleanValue(false);
+      }
+      throw invalid();
+    }
+    case TypeId::TINYINT: {
+      int8_t value;
+      if (!ParseInteger<int8_t>(field, BUSTUB_INT8_MIN, BUSTUB_INT8_MAX, &value)) {
+        throw invalid();
+      }
+      return ValueFactory::GetTinyIntValue(value);
+    }
+    case TypeId::SMALLINT: {
+      int16_t value;
+      if (!ParseInteger<int16_t>(field, BUSTUB_INT16_MIN, BUSTUB_INT16_MAX, &value)) {
+        throw invalid();
+      }
+      return ValueFactory::GetSmallIntValue(value);
+    }
+    case TypeId::INTEGER: {
+      int32_t value;
+      if (!ParseInteger<int32_t>(field, BUSTUB_INT32_MIN, BUSTUB_INT32_MAX, &value)) {
+        throw invalid();
+      }
+      return ValueFactory::GetIntegerValue(value);
+    }
+    case TypeId::BIGINT: {
+      int64_t value;
+      if (!ParseInteger<int64_t>(field, BUSTUB_INT64_MIN, BUSTUB_INT64_MAX, &value)) {
+        throw invalid();
+      }
+      return ValueFactory::GetBigIntValue(value);
+    }
+    case TypeId::TIMESTAMP: {
+      int64_t value;
+      if (!ParseInteger<int64_t>(field, 0, BUSTUB_INT64_MAX, &value)) {
+        throw invalid();
+      }
+      return ValueFactory::GetTimestampValue(value);
+    }
+    case TypeId::DECIMAL: {
+      double value = 0;
+      auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+      if (ec != std::errc() || end != field.data() + field.size() || value < BUSTUB_DECIMAL_MIN) {
+        throw invalid();
+      }
+      return ValueFactory::GetDecimalValue(value);
+    }
+    case TypeId::VARCHAR:
+      return ValueFactory::GetVarcharValue(std::string(field));
+    default:
+      throw NotImplementedException(fmt::format("COPY does not support column type {}", Type::TypeIdToString(type)));
+  }
+}
+
+void BulkLoader::CheckRecord(std::string_view record, size_t record_number) const {
+  const auto &schema = table_info_->schema_;
+  auto malformed = [&]() {
+    return ExecutionException(
+        fmt::format("COPY {} record {}: not a tuple of the table's schema", table_info_->name_, record_number));
+  };
+  if (record.size() < schema.GetLength() || record.size() > TUPLE_MAX_SIZE) {
+    throw malformed();
+  }
+  // The varchars must end in order within the record, the last one at its end.
+  uint32_t end = schema.GetLength();
+  for (auto i : schema.GetUnlinedColumns()) {
+    uint16_t varchar_end;
+    memcpy(&varchar_end, record.data() + schema.GetColumn(i).GetOffset(), sizeof(uint16_t));
+    if (varchar_end < end) {
+      throw malformed();
+    }
+    end = varchar_end;
+  }
+  if (end != record.size()) {
+    throw malformed();
+  }
+}
+
+void BulkLoader::Flush(std::vector<Tuple> *batch, LoadResult *result) const {
+  if (batch->empty()) {
+    return;
+  }
+  // The transaction holds the table exclusively, so the rows need no locks of their own. They are still stamped with
+  // it, so that snapshot readers do not see them before it commits.
+  TupleMeta meta{txn_ != nullptr ? txn_->GetTransactionId() : INVALID_TXN_ID, INVALID_TXN_ID, false};
+  auto rids = table_info_->table_->InsertTuples(meta, *batch);
+  for (size_t i = 0; i < indexes_.size(); i++) {
+    auto *index = indexes_[i]->index_.get();
+    auto &entries = result->index_entries_[i];
+    for (size_t j = 0; j < batch->size(); j++) {
+      entries.emplace_back(
+          (*batch)[j].KeyFromTuple(table_info_->schema_, indexes_[i]->key_schema_, index->GetKeyAttrs()), rids[j]);
+    }
+  }
+  result->num_rows_ += rids.size();
+  if (txn_ != nullptr) {
+    result->rids_.insert(result->rids_.end(), rids.begin(), rids.end());
+  }
+  batch->clear();
+}
+
+}  // namespace bustub
@@ -12,16 +12,61 @@
 
 #include <memory>
 
+#include "concurrency/transaction_manager.h"
 #include "execution/executors/delete_executor.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
 DeleteExecutor::DeleteExecutor(ExecutorContext *exec_ctx, const DeletePlanNode *plan,
                                std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
 
-void DeleteExecutor::Init() { throw NotImplementedException("DeleteExecutor is not implemented"); }
+void DeleteExecutor::Init() {
+  child_executor_->Init();
+  auto *catalog = exec_ctx_->GetCatalog();
+  table_info_ = catalog->GetTable(plan_->TableOid());
+  indexes_ = catalog->GetTableIndexes(table_info_->name_);
+  done_ = false;
+}
 
-auto DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool { return false; }
+auto DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
+  if (done_) {
+    return false;
+  }
+  auto *txn = exec_ctx_->GetTransaction();
+  auto *txn_mgr = exec_ctx_->GetTransactionManager();
+  int32_t num_deleted = 0;
+  Tuple child_tuple;
+  RID child_rid;
+  while (child_executor_->Next(&child_tuple, &child_rid)) {
+    TupleMeta meta{INVALID_TXN_ID, txn != nullptr ? txn->GetTransactionId() : INVALID_TXN_ID, true};
+    auto check = [&](const TupleMeta &current_meta, const Tuple &current_tuple, RID current_rid) {
+      // The deleted version keeps the inserter of the version it replaces.
+      meta.insert_txn_id_ = current_meta.insert_txn_id_;
+      if (txn == nullptr || txn_mgr == nullptr) {
+        return !current_meta.is_deleted_;
+      }
+      return txn_mgr->PrepareWrite(txn, current_meta, current_tuple, current_rid);
+    };
+    if (!table_info_->table_->UpdateTupleMeta(meta, child_rid, check)) {
+      continue;
+    }
+    num_deleted++;
+    if (txn != nullptr) {
+      TableWriteRecord write_record{table_info_->oid_, child_rid, table_info_->table_.get()};
+      write_record.wtype_ = WType::DELETE;
+      txn->AppendTableWriteRecord(write_record);
+      // The index entries are removed by the vacuum, once no transaction reads the tuple.
+      for (auto *index_info : indexes_) {
+        txn->AppendIndexWriteRecord(IndexWriteRecord{child_rid, table_info_->oid_, WType::DELETE, child_tuple,
+                                                     index_info->index_oid_, exec_ctx_->GetCatalog()});
+      }
+    }
+  }
+  *tuple = Tuple({ValueFactory::GetIntegerValue(num_deleted)}, &GetOutputSchema());
+  done_ = true;
+  return true;
+}
 
 }  // namespace bustub
@@ -24,6 +24,7 @@
 #include "execution/executors/init_check_executor.h"
 #include "execution/executors/insert_executor.h"
 #include "execution/executors/limit_executor.h"
+#include "execution/executors/merge_join_executor.h"
 #include "execution/executors/mock_scan_executor.h"
 #include "execution/executors/nested_index_join_executor.h"
 #include "execution/executors/nested_loop_join_executor.h"
@@ -103,9 +104,12 @@ auto ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx, const AbstractPl
             std::make_unique<InitCheckExecutor>(exec_ctx, nested_loop_join_plan->GetLeftPlan(), std::move(left));
         auto right_check =
             std::make_unique<InitCheckExecutor>(exec_ctx, nested_loop_join_plan->GetRightPlan(), std::move(right));
-        exec_ctx->AddCheckExecutor(left_check.get(), right_check.get());
-        return std::make_unique<NestedLoopJoinExecutor>(exec_ctx, nested_loop_join_plan, std::move(left_check),
-                                                        std::move(right_check));
+        auto *left_check_ptr = left_check.get();
+        auto *right_check_ptr = right_check.get();
+        auto join = std::make_unique<NestedLoopJoinExecutor>(exec_ctx, nested_loop_join_plan, std::move(left_check),
+                                                             std::move(right_check));
+        exec_ctx->AddCheckExecutor(left_check_ptr, right_check_ptr, join.get());
+        return join;
       }
       return std::make_unique<NestedLoopJoinExecutor>(exec_ctx, nested_loop_join_plan, std::move(left),
                                                       std::move(right));
@@ -126,6 +130,14 @@ auto ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx, const AbstractPl
       return std::make_unique<HashJoinExecutor>(exec_ctx, hash_join_plan, std::move(left), std::move(right));
     }
 
+    // Create a new merge join executor
+    case PlanType::MergeJoin: {
+      auto merge_join_plan = dynamic_cast<const MergeJoinPlanNode *>(plan.get());
+      auto left = ExecutorFactory::CreateExecutor(exec_ctx, merge_join_plan->GetLeftPlan());
+      auto right = ExecutorFactory::CreateExecutor(exec_ctx, merge_join_plan->GetRightPlan());
+      return std::make_unique<MergeJoinExecutor>(exec_ctx, merge_join_plan, std::move(left), std::move(right));
+    }
+
     // Create a new mock scan executor
     case PlanType::MockScan: {
       const auto *mock_scan_plan = dynamic_cast<const MockScanPlanNode *>(plan.get());
@@ -0,0 +1,348 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort.cpp
+//
+// Identification: src/execution/external_sort.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/external_sort.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+/** Fixed-size prefix of every record of a spilled run, followed by the key and the tuple bytes. */
+struct SortRecordHeader {
+  uint32_t key_size_;
+  uint32_t tuple_size_;
+  int64_t rid_;
+  /** The store of the out-of-line varchars of the tuple; runs live no longer than the query, so it stays valid */
+  const ToastStore *toast_;
+};
+
+template <class T>
+void AppendBigEndian(T bits, std::string *key) {
+  for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8) {
+    key->push_back(static_cast<char>((bits >> shift) & 0xFF));
+  }
+}
+
+}  // namespace
+
+/*
+ * SortKeyEncoder
+ */
+auto SortKeyEncoder::Encode(const Tuple &tuple, const Schema &schema) const -> std::string {
+  std::string key;
+  for (const auto &[order_by_type, expr] : order_bys_) {
+    AppendValue(expr->Evaluate(&tuple, schema), order_by_type == OrderByType::DESC, &key);
+  }
+  return key;
+}
+
+void SortKeyEncoder::AppendValue(const Value &value, bool descending, std::string *key) {
+  auto begin = key->size();
+  // NULLs are the smallest value of every type in BusTub, keep them first in ascending order.
+  if (value.IsNull()) {
+    key->push_back(0);
+  } else {
+    key->push_back(1);
+    switch (value.GetTypeId()) {
+      case TypeId::BOOLEAN:
+        key->push_back(static_cast<char>(value.GetAs<int8_t>()));
+        break;
+      case TypeId::TINYINT:
+        AppendBigEndian(static_cast<uint8_t>(static_cast<uint8_t>(value.GetAs<int8_t>()) ^ 0x80U), key);
+        break;
+      case TypeId::SMALLINT:
+        AppendBigEndian(static_cast<uint16_t>(static_cast<uint16_t>(value.GetAs<int16_t>()) ^ 0x8000U), key);
+        break;
+      case TypeId::INTEGER:
+        AppendBigEndian(static_cast<uint32_t>(value.GetAs<int32_t>()) ^ 0x80000000U, key);
+        break;
+      case TypeId::BIGINT:
+        AppendBigEndian(static_cast<uint64_t>(value.GetAs<int64_t>()) ^ 0x8000000000000000ULL, key);
+        break;
+      case TypeId::TIMESTAMP:
+        AppendBigEndian(value.GetAs<uint64_t>(), key);
+        break;
+      case TypeId::DECIMAL: {
+        auto decimal = value.GetAs<double>();
+        uint64_t bits;
+        memcpy(&bits, &decimal, sizeof(bits));
+        // Negative numbers order inversely to their bit pattern, so flip all of their bits.
+        bits = (bits & 0x8000000000000000ULL) != 0 ? ~bits : bits ^ 0x8000000000000000ULL;
+        AppendBigEndian(bits, key);
+        break;
+      }
+      case TypeId::VARCHAR: {
+        // The stored length includes the trailing '\0'.
+        const char *data = value.GetData();
+        uint32_t len = value.GetLength() - 1;
+        for (uint32_t i = 0; i < len; i++) {
+          key->push_back(data[i]);
+          if (data[i] == 0) {
+            key->push_back(static_cast<char>(0xFF));
+          }
+        }
+        key->push_back(0);
+        key->push_back(0);
+        break;
+      }
+      default:
+        throw ExecutionException(
+            fmt::format("cannot sort on value of type {}", Type::TypeIdToString(value.GetTypeId())));
+    }
+  }
+  if (descending) {
+    for (auto i = begin; i < key->size(); i++) {
+      (*key)[i] = static_cast<char>(~(*key)[i]);
+    }
+  }
+}
+
+/*
+ * SortRun
+ */
+void SortRun::Append(const SortEntry &entry) {
+  SortRecordHeader header{static_cast<uint32_t>(entry.key_.size()), entry.tuple_.GetLength(),
+                          entry.tuple_.GetRid().Get(), entry.tuple_.GetToastStore()};
+  WriteBytes(reinterpret_cast<const char *>(&header), sizeof(header));
+  WriteBytes(entry.key_.data(), header.key_size_);
+  WriteBytes(entry.tuple_.GetData(), header.tuple_size_);
+}
+
+void SortRun::WriteBytes(const char *src, uint32_t len) {
+  while (len > 0) {
+    if (tail_ == nullptr || reinterpret_cast<SortRunPage *>(tail_->GetData())->GetFreeSpace() == 0) {
+      if (tail_ != nullptr) {
+        bpm_->UnpinPage(tail_->GetPageId(), true);
+      }
+      page_id_t page_id = INVALID_PAGE_ID;
+      tail_ = bpm_->NewPage(&page_id);
+      if (tail_ == nullptr) {
+        throw ExecutionException("sort: no free frame in the buffer pool to spill a run");
+      }
+      reinterpret_cast<SortRunPage *>(tail_->GetData())->Init();
+      page_ids_.push_back(page_id);
+    }
+    auto written = reinterpret_cast<SortRunPage *>(tail_->GetData())->Append(src, len);
+    src += written;
+    len -= written;
+  }
+}
+
+void SortRun::FinishWrite() {
+  if (tail_ != nullptr) {
+    bpm_->UnpinPage(tail_->GetPageId(), true);
+    tail_ = nullptr;
+  }
+}
+
+void SortRun::Release() {
+  FinishWrite();
+  // The cursors reading the run are gone by now, so no page of it is pinned and every one is freed.
+  for (auto page_id : page_ids_) {
+    BUSTUB_ENSURE(bpm_->DeletePage(page_id), "sort run page still pinned when released");
+  }
+  page_ids_.clear();
+}
+
+/*
+ * SortRunCursor
+ */
+SortRunCursor::~SortRunCursor() {
+  if (page_ != nullptr) {
+    bpm_->UnpinPage(page_->GetPageId(), false);
+  }
+}
+
+auto SortRunCursor::ReadBytes(char *dst, uint32_t len) -> bool {
+  const auto &page_ids = run_->GetPageIds();
+  while (len > 0) {
+    if (page_ == nullptr) {
+      if (page_idx_ >= page_ids.size()) {
+        return false;
+      }
+      page_ = bpm_->FetchPage(page_ids[page_idx_]);
+      if (page_ == nullptr) {
+        throw ExecutionException("sort: no free frame in the buffer pool to read a run");
+      }
+      offset_ = 0;
+    }
+    auto run_page = reinterpret_cast<const SortRunPage *>(page_->GetData());
+    auto read = run_page->Read(offset_, dst, len);
+    dst += read;
+    len -= read;
+    offset_ += read;
+    if (offset_ == run_page->GetSize()) {
+      bpm_->UnpinPage(page_->GetPageId(), false);
+      page_ = nullptr;
+      page_idx_++;
+    }
+  }
+  return true;
+}
+
+auto SortRunCursor::Next(SortEntry *entry) -> bool {
+  SortRecordHeader header;
+  if (!ReadBytes(reinterpret_cast<char *>(&header), sizeof(header))) {
+    return false;
+  }
+  entry->key_.resize(header.key_size_);
+  BUSTUB_ENSURE(ReadBytes(entry->key_.data(), header.key_size_), "truncated sort run");
+  // Tuple::DeserializeFrom expects the size to precede the data.
+  scratch_.resize(sizeof(uint32_t) + header.tuple_size_);
+  memcpy(scratch_.data(), &header.tuple_size_, sizeof(uint32_t));
+  BUSTUB_ENSURE(ReadBytes(scratch_.data() + sizeof(uint32_t), header.tuple_size_), "truncated sort run");
+  entry->tuple_ = Tuple{RID{header.rid_}, header.toast_};
+  entry->tuple_.DeserializeFrom(scratch_.data());
+  return true;
+}
+
+/*
+ * LoserTree
+ */
+LoserTree::LoserTree(std::vector<std::unique_ptr<SortRunCursor>> cursors)
+    : cursors_(std::move(cursors)), heads_(cursors_.size()), exhausted_(cursors_.size(), false) {
+  auto k = cursors_.size();
+  for (size_t i = 0; i < k; i++) {
+    exhausted_[i] = !cursors_[i]->Next(&heads_[i]);
+  }
+  // Leaf k is a virtual leaf that beats everyone. Replaying every real leaf pushes it out of the tree.
+  tree_.assign(std::max<size_t>(k, 1), k);
+  for (size_t i = k; i > 0; i--) {
+    Adjust(i - 1);
+  }
+}
+
+auto LoserTree::Beats(size_t a, size_t b) const -> bool {
+  auto k = cursors_.size();
+  if (a == k || b == k) {
+    return a == k;
+  }
+  if (exhausted_[a] || exhausted_[b]) {
+    return !exhausted_[a];
+  }
+  auto cmp = heads_[a].key_.compare(heads_[b].key_);
+  // Break ties by run index so that the merge is stable.
+  return cmp < 0 || (cmp == 0 && a < b);
+}
+
+void LoserTree::Adjust(size_t leaf) {
+  auto winner = leaf;
+  for (auto node = (leaf + cursors_.size()) / 2; node > 0; node /= 2) {
+    if (Beats(tree_[node], winner)) {
+      std::swap(tree_[node], winner);
+    }
+  }
+  tree_[0] = winner;
+}
+
+auto LoserTree::Next(SortEntry *entry) -> bool {
+  if (cursors_.empty()) {
+    return false;
+  }
+  auto winner = tree_[0];
+  if (exhausted_[winner]) {
+    return false;
+  }
+  *entry = std::move(heads_[winner]);
+  exhausted_[winner] = !cursors_[winner]->Next(&heads_[winner]);
+  Adjust(winner);
+  return true;
+}
+
+/*
+ * ExternalSorter
+ */
+void ExternalSorter::Add(std::string key, Tuple tuple) {
+  buffered_bytes_ += key.size() + tuple.GetLength() + sizeof(SortEntry);
+  buffer_.push_back({std::move(key), std::move(tuple)});
+  if (bpm_ != nullptr && buffered_bytes_ > memory_budget_) {
+    SpillBuffer();
+  }
+}
+
+void ExternalSorter::SortBuffer() {
+  std::stable_sort(buffer_.begin(), buffer_.end(),
+                   [](const SortEntry &a, const SortEntry &b) { return a.key_ < b.key_; });
+}
+
+void ExternalSorter::SpillBuffer() {
+  SortBuffer();
+  auto run = std::make_unique<SortRun>(bpm_);
+  for (const auto &entry : buffer_) {
+    run->Append(entry);
+  }
+  run->FinishWrite();
+  runs_.emplace_back(std::move(run));
+  num_spilled_runs_++;
+  buffer_.clear();
+  buffered_bytes_ = 0;
+}
+
+auto ExternalSorter::MergeRuns(size_t begin, size_t end) -> std::unique_ptr<LoserTree> {
+  std::vector<std::unique_ptr<SortRunCursor>> cursors;
+  for (auto i = begin; i < end; i++) {
+    cursors.emplace_back(std::make_unique<SortRunCursor>(bpm_, runs_[i].get()));
+  }
+  return std::make_unique<LoserTree>(std::move(cursors));
+}
+
+void ExternalSorter::Finish() {
+  if (runs_.empty()) {
+    SortBuffer();
+    buffer_cursor_ = 0;
+    return;
+  }
+  if (!buffer_.empty()) {
+    SpillBuffer();
+  }
+  // Every input run keeps one page pinned while merging, and the output run one more.
+  auto fan_in = std::max<size_t>(2, bpm_->GetPoolSize() / 2);
+  while (runs_.size() > fan_in) {
+    auto merged = std::make_unique<SortRun>(bpm_);
+    {
+      auto merger = MergeRuns(0, fan_in);
+      SortEntry entry;
+      while (merger->Next(&entry)) {
+        merged->Append(entry);
+      }
+    }
+    merged->FinishWrite();
+    num_spilled_runs_++;
+    // The merged run replaces its inputs at the front, which keeps equal keys in input order.
+    runs_.erase(runs_.begin(), runs_.begin() + fan_in);
+    runs_.insert(runs_.begin(), std::move(merged));
+  }
+  merger_ = MergeRuns(0, runs_.size());
+}
+
+auto ExternalSorter::Next(Tuple *tuple) -> bool {
+  if (merger_ != nullptr) {
+    SortEntry entry;
+    if (!merger_->Next(&entry)) {
+      return false;
+    }
+    *tuple = std::move(entry.tuple_);
+    return true;
+  }
+  if (buffer_cursor_ == buffer_.size()) {
+    return false;
+  }
+  *tuple = std::move(buffer_[buffer_cursor_++].tuple_);
+  return true;
+}
+
+}  // namespace bustub
@@ -11,12 +11,84 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
 
+#include "concurrency/transaction_manager.h"
+
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  auto *catalog = exec_ctx_->GetCatalog();
+  auto *index_info = catalog->GetIndex(plan_->GetIndexOid());
+  table_heap_ = catalog->GetTable(index_info->table_name_)->table_.get();
+  auto *tree = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index_info->index_.get());
+  BUSTUB_ENSURE(tree != nullptr, "index scan only supports b+ tree indexes");
+  iter_ = tree->GetBeginIterator();
+  page_guard_.Drop();
+  txn_ = exec_ctx_->GetTransaction();
+  txn_mgr_ = exec_ctx_->GetTransactionManager();
+  snapshot_ = txn_ != nullptr && txn_mgr_ != nullptr && txn_->ReadsSnapshot();
+  optimistic_ = snapshot_ && txn_->GetIsolationLevel() == IsolationLevel::OPTIMISTIC;
+  if (optimistic_ && !scan_recorded_) {
+    // The scan walks the whole index, so it reads the tuples of the table that match the filter.
+    auto matches = [predicate = plan_->filter_predicate_, output_schema = plan_->output_schema_](const Tuple &tuple) {
+      if (predicate == nullptr) {
+        return true;
+      }
+      auto value = predicate->Evaluate(&tuple, *output_schema);
+      return !value.IsNull() && value.GetAs<bool>();
+    };
+    txn_->AppendScanRecord(ScanRecord{table_heap_, std::move(matches)});
+    scan_recorded_ = true;
+  }
+}
 
-void IndexScanExecutor::Init() { throw NotImplementedException("IndexScanExecutor is not implemented"); }
+auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (!iter_.IsEnd()) {
+    auto tuple_rid = (*iter_).second;
+    ++iter_;
+    auto [meta, tuple_ref] = table_heap_->GetTupleRef(tuple_rid, &page_guard_, &pax_tuple_);
+    if (snapshot_ && !txn_mgr_->SeesVersion(txn_, meta)) {
+      auto version = txn_mgr_->GetVersion(txn_, tuple_rid);
+      if (!version.has_value() || !MatchesFilter(*version)) {
+        continue;
+      }
+      *tuple = std::move(*version);
+      *rid = tuple_rid;
+      page_guard_.Drop();
+      if (optimistic_) {
+        txn_->AddIntoReadSet(tuple_rid);
+      }
+      return true;
+    }
+    if (meta.is_deleted_) {
+      continue;
+    }
+    if (plan_->filter_predicate_ != nullptr) {
+      auto value = plan_->filter_predicate_->Evaluate(tuple_ref, GetOutputSchema());
+      if (value.IsNull() || !value.GetAs<bool>()) {
+        continue;
+      }
+    }
+    tuple_ref.CopyTo(tuple);
+    *rid = tuple_rid;
+    // Do not keep the page latched across calls, the parent may write to this table.
+    page_guard_.Drop();
+    if (optimistic_) {
+      txn_->AddIntoReadSet(tuple_rid);
+    }
+    return true;
+  }
+  page_guard_.Drop();
+  return false;
+}
 
-auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+auto IndexScanExecutor::MatchesFilter(const Tuple &tuple) const -> bool {
+  if (plan_->filter_predicate_ == nullptr) {
+    return true;
+  }
+  auto value = plan_->filter_predicate_->Evaluate(&tuple, GetOutputSchema());
+  return !value.IsNull() && value.GetAs<bool>();
+}
 
 }  // namespace bustub
@@ -12,16 +12,140 @@
 
 #include <memory>
 
+#include "common/exception.h"
 #include "execution/executors/insert_executor.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "fmt/format.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
+/** @return whether executing `plan` reads the table `table_info` */
+static auto ReadsTable(const AbstractPlanNode &plan, const TableInfo &table_info, Catalog *catalog) -> bool {
+  switch (plan.GetType()) {
+    case PlanType::SeqScan:
+      if (dynamic_cast<const SeqScanPlanNode &>(plan).GetTableOid() == table_info.oid_) {
+        return true;
+      }
+      break;
+    case PlanType::IndexScan: {
+      auto index_oid = dynamic_cast<const IndexScanPlanNode &>(plan).GetIndexOid();
+      if (catalog->GetIndex(index_oid)->table_name_ == table_info.name_) {
+        return true;
+      }
+      break;
+    }
+    case PlanType::NestedIndexJoin:
+      if (dynamic_cast<const NestedIndexJoinPlanNode &>(plan).GetInnerTableOid() == table_info.oid_) {
+        return true;
+      }
+      break;
+    default:
+      break;
+  }
+  for (const auto &child : plan.GetChildren()) {
+    if (ReadsTable(*child, table_info, catalog)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 InsertExecutor::InsertExecutor(ExecutorContext *exec_ctx, const InsertPlanNode *plan,
                                std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void InsertExecutor::Init() {
+  child_executor_->Init();
+  auto *catalog = exec_ctx_->GetCatalog();
+  table_info_ = catalog->GetTable(plan_->TableOid());
+  indexes_ = catalog->GetTableIndexes(table_info_->name_);
+  reads_target_ = ReadsTable(*plan_->GetChildPlan(), *table_info_, catalog);
+  // The table heap locks the rows it inserts exclusively, under an intention lock on the table. Optimistic
+  // transactions take no locks.
+  auto *txn = exec_ctx_->GetTransaction();
+  bool optimistic = txn != nullptr && txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC;
+  lock_mgr_ = optimistic ? nullptr : exec_ctx_->GetLockManager();
+  auto oid = table_info_->oid_;
+  if (txn != nullptr && lock_mgr_ != nullptr && !txn->IsTableExclusiveLocked(oid) &&
+      !txn->IsTableSharedIntentionExclusiveLocked(oid) &&
+      !lock_mgr_->LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, oid)) {
+    throw ExecutionException(
+        fmt::format("transaction {} aborted: cannot lock table {}", txn->GetTransactionId(), table_info_->name_));
+  }
+  batch_.clear();
+  batch_.reserve(insert_batch_size);
+  num_inserted_ = 0;
+  done_ = false;
+}
+
+auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
+  if (done_) {
+    return false;
+  }
+  Tuple child_tuple;
+  RID child_rid;
+  if (reads_target_) {
+    // The inserts may reuse free space ahead of the scan of the same table, which would then read the new tuples
+    // again (the Halloween problem). Read the whole input before inserting any of it.
+    std::vector<Tuple> input;
+    while (child_executor_->Next(&child_tuple, &child_rid)) {
+      input.push_back(std::move(child_tuple));
+    }
+    for (auto &input_tuple : input) {
+      batch_.push_back(std::move(input_tuple));
+      if (batch_.size() >= insert_batch_size) {
+        InsertBatch();
+      }
+    }
+  } else {
+    while (child_executor_->Next(&child_tuple, &child_rid)) {
+      batch_.push_back(std::move(child_tuple));
+      if (batch_.size() >= insert_batch_size) {
+        InsertBatch();
+      }
+    }
+  }
+  InsertBatch();
+  *tuple = Tuple({ValueFactory::GetIntegerValue(num_inserted_)}, &GetOutputSchema());
+  done_ = true;
+  return true;
+}
+
+void InsertExecutor::InsertBatch() {
+  if (batch_.empty()) {
+    return;
+  }
+  auto *txn = exec_ctx_->GetTransaction();
+  // The tuples are seen by the transactions that begin after this one commits.
+  TupleMeta meta{txn != nullptr ? txn->GetTransactionId() : INVALID_TXN_ID, INVALID_TXN_ID, false};
+  auto rids = table_info_->table_->InsertTuples(meta, batch_, lock_mgr_, txn, table_info_->oid_);
+  if (txn != nullptr) {
+    for (const auto &rid : rids) {
+      TableWriteRecord write_record{table_info_->oid_, rid, table_info_->table_.get()};
+      write_record.wtype_ = WType::INSERT;
+      txn->AppendTableWriteRecord(write_record);
+    }
+  }
 
-void InsertExecutor::Init() { throw NotImplementedException("InsertExecutor is not implemented"); }
+  for (auto *index_info : indexes_) {
+    auto *index = index_info->index_.get();
+    index_entries_.clear();
+    for (size_t i = 0; i < batch_.size(); i++) {
+      index_entries_.emplace_back(
+          batch_[i].KeyFromTuple(table_info_->schema_, index_info->key_schema_, index->GetKeyAttrs()), rids[i]);
+      if (txn != nullptr) {
+        txn->AppendIndexWriteRecord(IndexWriteRecord{rids[i], table_info_->oid_, WType::INSERT, batch_[i],
+                                                     index_info->index_oid_, exec_ctx_->GetCatalog()});
+      }
+    }
+    index->InsertEntries(&index_entries_, txn);
+  }
 
-auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool { return false; }
+  num_inserted_ += static_cast<int32_t>(rids.size());
+  batch_.clear();
+}
 
 }  // namespace bustub
@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// merge_join_executor.cpp
+//
+// Identification: src/execution/merge_join_executor.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/merge_join_executor.h"
+
+#include <algorithm>
+
+#include "binder/table_ref/bound_join_ref.h"
+#include "common/exception.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+MergeJoinExecutor::MergeJoinExecutor(ExecutorContext *exec_ctx, const MergeJoinPlanNode *plan,
+                                     std::unique_ptr<AbstractExecutor> &&left_child,
+                                     std::unique_ptr<AbstractExecutor> &&right_child)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_child_(std::move(left_child)),
+      right_child_(std::move(right_child)) {
+  if (!(plan->GetJoinType() == JoinType::LEFT || plan->GetJoinType() == JoinType::INNER)) {
+    throw bustub::NotImplementedException(fmt::format("join type {} not supported", plan->GetJoinType()));
+  }
+}
+
+void MergeJoinExecutor::Init() {
+  left_child_->Init();
+  right_child_->Init();
+  left_active_ = false;
+  group_.clear();
+  group_keys_.clear();
+  AdvanceRight();
+}
+
+auto MergeJoinExecutor::CompareKeys(const std::vector<Value> &a, const std::vector<Value> &b) -> int {
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].CompareLessThan(b[i]) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (a[i].CompareGreaterThan(b[i]) == CmpBool::CmpTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+auto MergeJoinExecutor::HasNull(const std::vector<Value> &keys) -> bool {
+  return std::any_of(keys.begin(), keys.end(), [](const Value &key) { return key.IsNull(); });
+}
+
+void MergeJoinExecutor::AdvanceRight() {
+  RID rid;
+  right_valid_ = right_child_->Next(&right_tuple_, &rid);
+  if (!right_valid_) {
+    return;
+  }
+  const auto &schema = right_child_->GetOutputSchema();
+  right_keys_.clear();
+  for (const auto &expr : plan_->RightJoinKeyExpressions()) {
+    right_keys_.emplace_back(expr->Evaluate(&right_tuple_, schema));
+  }
+}
+
+void MergeJoinExecutor::BuildGroup(const std::vector<Value> &keys) {
+  group_.clear();
+  group_keys_ = keys;
+  // Right keys below the left key can match no later left tuple either, since the left input is sorted too.
+  while (right_valid_ && (HasNull(right_keys_) || CompareKeys(right_keys_, keys) < 0)) {
+    AdvanceRight();
+  }
+  while (right_valid_ && CompareKeys(right_keys_, keys) == 0) {
+    group_.push_back(right_tuple_);
+    AdvanceRight();
+  }
+}
+
+auto MergeJoinExecutor::MakeOutputTuple(const Tuple *right) const -> Tuple {
+  const auto &left_schema = left_child_->GetOutputSchema();
+  const auto &right_schema = right_child_->GetOutputSchema();
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema().GetColumnCount());
+  for (uint32_t i = 0; i < left_schema.GetColumnCount(); i++) {
+    values.emplace_back(left_tuple_.GetValue(&left_schema, i));
+  }
+  for (uint32_t i = 0; i < right_schema.GetColumnCount(); i++) {
+    values.emplace_back(right != nullptr ? right->GetValue(&right_schema, i)
+                                         : ValueFactory::GetNullValueByType(right_schema.GetColumn(i).GetType()));
+  }
+  return {values, &GetOutputSchema()};
+}
+
+auto MergeJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (true) {
+    if (left_active_) {
+      if (left_matched_ && group_idx_ < group_.size()) {
+        *tuple = MakeOutputTuple(&group_[group_idx_++]);
+        return true;
+      }
+      left_active_ = false;
+      if (!left_matched_ && plan_->GetJoinType() == JoinType::LEFT) {
+        *tuple = MakeOutputTuple(nullptr);
+        return true;
+      }
+    }
+
+    RID left_rid;
+    if (!left_child_->Next(&left_tuple_, &left_rid)) {
+      return false;
+    }
+    const auto &schema = left_child_->GetOutputSchema();
+    left_keys_.clear();
+    for (const auto &expr : plan_->LeftJoinKeyExpressions()) {
+      left_keys_.emplace_back(expr->Evaluate(&left_tuple_, schema));
+    }
+    left_active_ = true;
+    group_idx_ = 0;
+    if (HasNull(left_keys_)) {
+      left_matched_ = false;
+      continue;
+    }
+    // Duplicate left keys reuse the group buffered for the previous left tuple.
+    if (group_keys_.empty() || CompareKeys(group_keys_, left_keys_) != 0) {
+      BuildGroup(left_keys_);
+    }
+    left_matched_ = !group_.empty();
+  }
+}
+
+}  // namespace bustub
@@ -12,22 +12,151 @@
 
 #include "execution/executors/nested_loop_join_executor.h"
 #include "binder/table_ref/bound_join_ref.h"
+#include "common/config.h"
 #include "common/exception.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
 NestedLoopJoinExecutor::NestedLoopJoinExecutor(ExecutorContext *exec_ctx, const NestedLoopJoinPlanNode *plan,
                                                std::unique_ptr<AbstractExecutor> &&left_executor,
                                                std::unique_ptr<AbstractExecutor> &&right_executor)
-    : AbstractExecutor(exec_ctx) {
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_executor_(std::move(left_executor)),
+      right_executor_(std::move(right_executor)) {
   if (!(plan->GetJoinType() == JoinType::LEFT || plan->GetJoinType() == JoinType::INNER)) {
     // Note for 2023 Spring: You ONLY need to implement left join and inner join.
     throw bustub::NotImplementedException(fmt::format("join type {} not supported", plan->GetJoinType()));
   }
 }
 
-void NestedLoopJoinExecutor::Init() { throw NotImplementedException("NestedLoopJoinExecutor is not implemented"); }
+void NestedLoopJoinExecutor::Init() {
+  left_executor_->Init();
+  right_executor_->Init();
+  block_.clear();
+  left_done_ = false;
+  inner_valid_ = false;
+  inner_tuples_.clear();
+  collecting_inner_ = true;
+  inner_materialized_ = false;
+}
+
+auto NestedLoopJoinExecutor::NextBlock() -> bool {
+  if (left_done_) {
+    return false;
+  }
+  Tuple tuple;
+  RID rid;
+  while (block_.size() < nlj_block_size) {
+    if (!left_executor_->Next(&tuple, &rid)) {
+      left_done_ = true;
+      break;
+    }
+    block_.push_back(tuple);
+  }
+  if (block_.empty()) {
+    return false;
+  }
+  block_matched_.assign(block_.size(), false);
+  block_idx_ = 0;
+  unmatched_idx_ = 0;
 
-auto NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+  // The inner side was initialized by Init for the first block; later blocks rescan it unless it is in memory.
+  if (!collecting_inner_) {
+    if (inner_materialized_) {
+      inner_idx_ = 0;
+    } else {
+      right_executor_->Init();
+    }
+  }
+  inner_valid_ = NextInner();
+  return true;
+}
+
+auto NestedLoopJoinExecutor::NextInner() -> bool {
+  if (inner_materialized_) {
+    if (inner_idx_ == inner_tuples_.size()) {
+      return false;
+    }
+    inner_tuple_ = inner_tuples_[inner_idx_++];
+    return true;
+  }
+  RID rid;
+  if (!right_executor_->Next(&inner_tuple_, &rid)) {
+    if (collecting_inner_) {
+      collecting_inner_ = false;
+      inner_materialized_ = true;
+      inner_idx_ = inner_tuples_.size();
+    }
+    return false;
+  }
+  if (collecting_inner_) {
+    if (inner_tuples_.size() < nlj_inner_materialize_threshold) {
+      inner_tuples_.push_back(inner_tuple_);
+    } else {
+      // Too large to keep, it will be rescanned for every block.
+      collecting_inner_ = false;
+      inner_tuples_.clear();
+      inner_tuples_.shrink_to_fit();
+    }
+  }
+  return true;
+}
+
+auto NestedLoopJoinExecutor::MakeOutputTuple(const Tuple &left, bool matched) const -> Tuple {
+  const auto &left_schema = left_executor_->GetOutputSchema();
+  const auto &right_schema = right_executor_->GetOutputSchema();
+  std::vector<Value> values;
+  values.reserve(GetOutputSchema().GetColumnCount());
+  for (uint32_t i = 0; i < left_schema.GetColumnCount(); i++) {
+    values.emplace_back(left.GetValue(&left_schema, i));
+  }
+  for (uint32_t i = 0; i < right_schema.GetColumnCount(); i++) {
+    values.emplace_back(matched ? inner_tuple_.GetValue(&right_schema, i)
+                                : ValueFactory::GetNullValueByType(right_schema.GetColumn(i).GetType()));
+  }
+  return {values, &GetOutputSchema()};
+}
+
+auto NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  const auto &left_schema = left_executor_->GetOutputSchema();
+  const auto &right_schema = right_executor_->GetOutputSchema();
+  while (true) {
+    if (block_.empty()) {
+      if (!NextBlock()) {
+        return false;
+      }
+      continue;
+    }
+
+    if (inner_valid_) {
+      while (block_idx_ < block_.size()) {
+        auto idx = block_idx_++;
+        auto value = plan_->Predicate()->EvaluateJoin(&block_[idx], left_schema, &inner_tuple_, right_schema);
+        if (!value.IsNull() && value.GetAs<bool>()) {
+          block_matched_[idx] = true;
+          *tuple = MakeOutputTuple(block_[idx], true);
+          return true;
+        }
+      }
+      inner_valid_ = NextInner();
+      block_idx_ = 0;
+      continue;
+    }
+
+    // The inner side is exhausted for this block, pad the outer tuples that found no match.
+    if (plan_->GetJoinType() == JoinType::LEFT) {
+      while (unmatched_idx_ < block_.size()) {
+        auto idx = unmatched_idx_++;
+        if (!block_matched_[idx]) {
+          *tuple = MakeOutputTuple(block_[idx], false);
+          return true;
+        }
+      }
+    }
+    block_.clear();
+  }
+}
 
 }  // namespace bustub
@@ -1,23 +1,360 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// seq_scan_executor.cpp
-//
-// Identification: src/execution/seq_scan_executor.cpp
-//
-// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-
-#include "execution/executors/seq_scan_executor.h"
-
-namespace bustub {
-
-SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : AbstractExecutor(exec_ctx) {}
-
-void SeqScanExecutor::Init() { throw NotImplementedException("SeqScanExecutor is not implemented"); }
-
-auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// seq_scan_executor.cpp
+//
+// Identification: src/execution/seq_scan_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/seq_scan_executor.h"
+
+#include "concurrency/transaction_manager.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+
+namespace bustub {
+
+SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan)
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void SeqScanExecutor::Init() {
+  table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
+  iter_ = std::make_unique<TableIterator>(table_info_->table_->MakeIterator());
+  column_ids_ = plan_->column_ids_;
+  if (column_ids_.empty() && table_info_->table_->GetStorage() == TableStorage::PAX) {
+    for (uint32_t i = 0; i < table_info_->schema_.GetColumnCount(); i++) {
+      column_ids_.push_back(i);
+    }
+  }
+  zone_map_ = plan_->filter_predicate_ != nullptr ? table_info_->table_->GetZoneMap() : nullptr;
+  checked_page_id_ = INVALID_PAGE_ID;
+
+  code_filters_.clear();
+  if (plan_->filter_predicate_ != nullptr && table_info_->table_->GetStorage() == TableStorage::PAX) {
+    CollectCodeFilters(*plan_->filter_predicate_);
+  }
+  matched_page_id_ = INVALID_PAGE_ID;
+  scan_codes_.clear();
+  coded_page_id_ = INVALID_PAGE_ID;
+
+  txn_ = exec_ctx_->GetTransaction();
+  txn_mgr_ = exec_ctx_->GetTransactionManager();
+  snapshot_ = txn_ != nullptr && txn_mgr_ != nullptr && txn_->ReadsSnapshot();
+  optimistic_ = snapshot_ && txn_->GetIsolationLevel() == IsolationLevel::OPTIMISTIC;
+  // A scan run again, as the inner side of a join, reads the same tuples.
+  if (optimistic_ && !scan_recorded_) {
+    txn_->AppendScanRecord(MakeScanRecord());
+    scan_recorded_ = true;
+  }
+}
+
+auto SeqScanExecutor::MakeScanRecord() const -> ScanRecord {
+  auto predicate = plan_->filter_predicate_;
+  if (predicate == nullptr) {
+    return ScanRecord{table_info_->table_.get(), [](const Tuple &) { return true; }};
+  }
+  // The record outlives the plan, so it keeps what it needs of it.
+  auto output_schema = plan_->output_schema_;
+  const auto *schema = &table_info_->schema_;
+  auto matches = [predicate, output_schema, schema, column_ids = column_ids_](const Tuple &tuple) {
+    Value value;
+    if (column_ids.empty()) {
+      value = predicate->Evaluate(&tuple, *output_schema);
+    } else {
+      std::vector<Value> values;
+      for (auto column_idx : column_ids) {
+        values.emplace_back(tuple.GetValue(schema, column_idx));
+      }
+      Tuple output(values, output_schema.get());
+      value = predicate->Evaluate(&output, *output_schema);
+    }
+    return !value.IsNull() && value.GetAs<bool>();
+  };
+  return ScanRecord{table_info_->table_.get(), std::move(matches)};
+}
+
+auto SeqScanExecutor::EnableCodes(const std::vector<uint32_t> &output_columns) -> bool {
+  const auto *table_info = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
+  if (table_info->table_->GetStorage() != TableStorage::PAX) {
+    return false;
+  }
+  for (auto column_idx : output_columns) {
+    if (GetOutputSchema().GetColumn(column_idx).GetType() != TypeId::VARCHAR) {
+      return false;
+    }
+  }
+  coded_columns_ = output_columns;
+  return true;
+}
+
+auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  bool found = column_ids_.empty() ? NextTuple(tuple, rid) : NextColumns(tuple, rid);
+  if (found && optimistic_) {
+    txn_->AddIntoReadSet(*rid);
+  }
+  return found;
+}
+
+auto SeqScanExecutor::NextTuple(Tuple *tuple, RID *rid) -> bool {
+  while (HasCandidate()) {
+    auto [meta, tuple_ref] = iter_->GetTupleRef();
+    if (snapshot_ && !txn_mgr_->SeesVersion(txn_, meta)) {
+      auto version = txn_mgr_->GetVersion(txn_, tuple_ref.GetRid());
+      auto version_rid = tuple_ref.GetRid();
+      ++(*iter_);
+      if (version.has_value() && MatchesFilter(*version)) {
+        *tuple = std::move(*version);
+        *rid = version_rid;
+        iter_->ReleasePage();
+        return true;
+      }
+      continue;
+    }
+    bool emit = !meta.is_deleted_;
+    if (emit && plan_->filter_predicate_ != nullptr) {
+      auto value = plan_->filter_predicate_->Evaluate(tuple_ref, GetOutputSchema());
+      emit = !value.IsNull() && value.GetAs<bool>();
+    }
+    // Copy before advancing: moving to the next page releases the one the view points into.
+    if (emit) {
+      tuple_ref.CopyTo(tuple);
+      *rid = tuple_ref.GetRid();
+    }
+    ++(*iter_);
+    if (emit) {
+      // Do not keep the page latched across calls, the parent may write to this table.
+      iter_->ReleasePage();
+      return true;
+    }
+  }
+  return false;
+}
+
+auto SeqScanExecutor::NextColumns(Tuple *tuple, RID *rid) -> bool {
+  bool is_pax = table_info_->table_->GetStorage() == TableStorage::PAX;
+  while (HasCandidate()) {
+    auto tuple_rid = iter_->GetRID();
+    // The codes are those of the version in the page, so they only rule out the tuples read in that version.
+    if (!code_filters_.empty() && !MatchesCodes() &&
+        (!snapshot_ || txn_mgr_->SeesVersion(txn_, iter_->GetTupleMeta()))) {
+      ++(*iter_);
+      continue;
+    }
+    TupleMeta meta;
+    if (is_pax) {
+      meta = iter_->GetValues(column_ids_, &values_);
+    } else {
+      auto [tuple_meta, tuple_ref] = iter_->GetTupleRef();
+      meta = tuple_meta;
+      values_.clear();
+      for (auto column_idx : column_ids_) {
+        values_.emplace_back(tuple_ref.GetValue(&table_info_->schema_, column_idx));
+      }
+    }
+    bool in_page = !snapshot_ || txn_mgr_->SeesVersion(txn_, meta);
+    if (!in_page) {
+      auto version = txn_mgr_->GetVersion(txn_, tuple_rid);
+      if (!version.has_value()) {
+        ++(*iter_);
+        continue;
+      }
+      meta.is_deleted_ = false;
+      values_.clear();
+      for (auto column_idx : column_ids_) {
+        values_.emplace_back(version->GetValue(&table_info_->schema_, column_idx));
+      }
+    }
+    if (!coded_columns_.empty()) {
+      ComputeCodes(in_page);
+    }
+    ++(*iter_);
+    if (meta.is_deleted_) {
+      continue;
+    }
+    Tuple output(values_, &GetOutputSchema());
+    if (!MatchesFilter(output)) {
+      continue;
+    }
+    *tuple = std::move(output);
+    *rid = tuple_rid;
+    iter_->ReleasePage();
+    return true;
+  }
+  return false;
+}
+
+void SeqScanExecutor::CollectCodeFilters(const AbstractExpression &expr) {
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(&expr); logic != nullptr) {
+    if (logic->logic_type_ == LogicType::And) {
+      CollectCodeFilters(*logic->GetChildAt(0));
+      CollectCodeFilters(*logic->GetChildAt(1));
+    }
+    return;
+  }
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(&expr);
+  if (comparison == nullptr || comparison->comp_type_ != ComparisonType::Equal) {
+    return;
+  }
+  const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0).get());
+  const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1).get());
+  if (column == nullptr || constant == nullptr) {
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1).get());
+    constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0).get());
+  }
+  if (column != nullptr && constant != nullptr) {
+    code_filters_.emplace_back(column_ids_[column->GetColIdx()], constant->val_);
+  }
+}
+
+auto SeqScanExecutor::MatchesCodes() -> bool {
+  auto tuple_rid = iter_->GetRID();
+  if (tuple_rid.GetPageId() != matched_page_id_) {
+    matched_page_id_ = tuple_rid.GetPageId();
+    matches_.clear();
+    std::vector<bool> matches;
+    for (const auto &[column_idx, value] : code_filters_) {
+      if (!iter_->MatchEqual(column_idx, value, &matches)) {
+        continue;
+      }
+      if (matches_.empty()) {
+        matches_ = std::move(matches);
+      } else {
+        for (size_t slot = 0; slot < matches_.size(); slot++) {
+          matches_[slot] = matches_[slot] && matches[slot];
+        }
+      }
+    }
+  }
+  // Tuples inserted after the codes were read are left to the filter predicate.
+  return tuple_rid.GetSlotNum() >= matches_.size() || matches_[tuple_rid.GetSlotNum()];
+}
+
+auto SeqScanExecutor::MatchesFilter(const Tuple &tuple) const -> bool {
+  if (plan_->filter_predicate_ == nullptr) {
+    return true;
+  }
+  auto value = plan_->filter_predicate_->Evaluate(&tuple, GetOutputSchema());
+  return !value.IsNull() && value.GetAs<bool>();
+}
+
+void SeqScanExecutor::ComputeCodes(bool in_page) {
+  auto tuple_rid = iter_->GetRID();
+  codes_.resize(coded_columns_.size());
+  // Map the codes of each page to codes of the scan once per page, so that the values are looked up once per page.
+  if (tuple_rid.GetPageId() != coded_page_id_) {
+    coded_page_id_ = tuple_rid.GetPageId();
+    page_codes_.resize(coded_columns_.size());
+    std::vector<uint32_t> codes;
+    std::vector<Value> dictionary;
+    std::vector<uint32_t> scan_codes;
+    for (size_t i = 0; i < coded_columns_.size(); i++) {
+      page_codes_[i].clear();
+      if (!iter_->GetCodes(column_ids_[coded_columns_[i]], &codes, &dictionary)) {
+        continue;
+      }
+      scan_codes.clear();
+      for (const auto &value : dictionary) {
+        scan_codes.push_back(value.IsNull() ? 0 : scan_codes_.emplace(value.ToString(), scan_codes_.size() + 1)
+                                                      .first->second);
+      }
+      for (auto code : codes) {
+        page_codes_[i].push_back(scan_codes[code]);
+      }
+    }
+  }
+  for (size_t i = 0; i < coded_columns_.size(); i++) {
+    if (in_page && tuple_rid.GetSlotNum() < page_codes_[i].size()) {
+      codes_[i] = page_codes_[i][tuple_rid.GetSlotNum()];
+      continue;
+    }
+    // Tuples inserted after the codes were read, and older versions, are looked up by value.
+    const auto &value = values_[coded_columns_[i]];
+    codes_[i] = value.IsNull() ? 0 : scan_codes_.emplace(value.ToString(), scan_codes_.size() + 1).first->second;
+  }
+}
+
+auto SeqScanExecutor::HasCandidate() -> bool {
+  while (zone_map_ != nullptr && !iter_->IsEnd() && iter_->GetRID().GetPageId() != checked_page_id_) {
+    checked_page_id_ = iter_->GetRID().GetPageId();
+    if (!zone_map_->GetPageZone(checked_page_id_, &zone_) || MayMatch(*plan_->filter_predicate_)) {
+      break;
+    }
+    iter_->SkipPage();
+  }
+  return !iter_->IsEnd();
+}
+
+/** @return the comparison with its operands swapped, such that `a op b` equals `b Flip(op) a` */
+static auto Flip(ComparisonType comp_type) -> ComparisonType {
+  switch (comp_type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return comp_type;
+  }
+}
+
+auto SeqScanExecutor::MayMatch(const AbstractExpression &expr) const -> bool {
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(&expr); logic != nullptr) {
+    bool left = MayMatch(*logic->GetChildAt(0));
+    bool right = MayMatch(*logic->GetChildAt(1));
+    return logic->logic_type_ == LogicType::And ? left && right : left || right;
+  }
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(&expr);
+  if (comparison == nullptr) {
+    return true;
+  }
+  // Only `column op constant` and `constant op column` are checked against the zones.
+  auto comp_type = comparison->comp_type_;
+  const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0).get());
+  const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1).get());
+  if (column == nullptr || constant == nullptr) {
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1).get());
+    constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0).get());
+    comp_type = Flip(comp_type);
+  }
+  if (column == nullptr || constant == nullptr) {
+    return true;
+  }
+  auto column_idx = column_ids_.empty() ? column->GetColIdx() : column_ids_[column->GetColIdx()];
+  if (!zone_map_->IsTracked(column_idx)) {
+    return true;
+  }
+  const auto &zone = zone_.columns_[column_idx];
+  const auto &value = constant->val_;
+  // A comparison with null is never true, and a page without non-null values has no min and max.
+  if (value.IsNull() || zone.min_.IsNull()) {
+    return false;
+  }
+  switch (comp_type) {
+    case ComparisonType::Equal:
+      return zone.min_.CompareLessThanEquals(value) == CmpBool::CmpTrue &&
+             zone.max_.CompareGreaterThanEquals(value) == CmpBool::CmpTrue;
+    case ComparisonType::NotEqual:
+      return zone.min_.CompareNotEquals(value) == CmpBool::CmpTrue ||
+             zone.max_.CompareNotEquals(value) == CmpBool::CmpTrue;
+    case ComparisonType::LessThan:
+      return zone.min_.CompareLessThan(value) == CmpBool::CmpTrue;
+    case ComparisonType::LessThanOrEqual:
+      return zone.min_.CompareLessThanEquals(value) == CmpBool::CmpTrue;
+    case ComparisonType::GreaterThan:
+      return zone.max_.CompareGreaterThan(value) == CmpBool::CmpTrue;
+    case ComparisonType::GreaterThanOrEqual:
+      return zone.max_.CompareGreaterThanEquals(value) == CmpBool::CmpTrue;
+  }
+  return true;
+}
+
+}  // namespace bustub
@@ -4,10 +4,30 @@ namespace bustub {
 
 SortExecutor::SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan,
                            std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_executor_(std::move(child_executor)),
+      encoder_(plan->GetOrderBy()) {}
 
-void SortExecutor::Init() { throw NotImplementedException("SortExecutor is not implemented"); }
+void SortExecutor::Init() {
+  child_executor_->Init();
+  sorter_ = std::make_unique<ExternalSorter>(exec_ctx_->GetBufferPoolManager(), sort_memory_budget);
 
-auto SortExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+  Tuple child_tuple;
+  RID child_rid;
+  while (child_executor_->Next(&child_tuple, &child_rid)) {
+    auto key = encoder_.Encode(child_tuple, child_executor_->GetOutputSchema());
+    sorter_->Add(std::move(key), std::move(child_tuple));
+  }
+  sorter_->Finish();
+}
+
+auto SortExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (!sorter_->Next(tuple)) {
+    return false;
+  }
+  *rid = tuple->GetRid();
+  return true;
+}
 
 }  // namespace bustub
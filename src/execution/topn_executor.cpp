@@ -4,12 +4,47 @@ namespace bustub {
 
 TopNExecutor::TopNExecutor(ExecutorContext *exec_ctx, const TopNPlanNode *plan,
                            std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_executor_(std::move(child_executor)),
+      encoder_(plan->GetOrderBy()) {}
 
-void TopNExecutor::Init() { throw NotImplementedException("TopNExecutor is not implemented"); }
+void TopNExecutor::Init() {
+  child_executor_->Init();
+  while (!top_entries_.empty()) {
+    top_entries_.pop();
+  }
+  output_.clear();
+  cursor_ = 0;
 
-auto TopNExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+  Tuple child_tuple;
+  RID child_rid;
+  while (child_executor_->Next(&child_tuple, &child_rid)) {
+    auto key = encoder_.Encode(child_tuple, child_executor_->GetOutputSchema());
+    if (top_entries_.size() < plan_->GetN()) {
+      top_entries_.push({std::move(key), std::move(child_tuple)});
+    } else if (plan_->GetN() > 0 && key < top_entries_.top().key_) {
+      top_entries_.pop();
+      top_entries_.push({std::move(key), std::move(child_tuple)});
+    }
+  }
 
-auto TopNExecutor::GetNumInHeap() -> size_t { throw NotImplementedException("TopNExecutor is not implemented"); };
+  output_.resize(top_entries_.size());
+  for (auto i = output_.size(); i > 0; i--) {
+    output_[i - 1] = top_entries_.top().tuple_;
+    top_entries_.pop();
+  }
+}
+
+auto TopNExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (cursor_ == output_.size()) {
+    return false;
+  }
+  *tuple = output_[cursor_++];
+  *rid = tuple->GetRid();
+  return true;
+}
+
+auto TopNExecutor::GetNumInHeap() -> size_t { return top_entries_.size(); };
 
 }  // namespace bustub
@@ -10,19 +10,142 @@
 //
 //===----------------------------------------------------------------------===//
 #include <memory>
+#include <string_view>
 
+#include "common/exception.h"
+#include "concurrency/transaction_manager.h"
 #include "execution/executors/update_executor.h"
+#include "fmt/format.h"
 
 namespace bustub {
 
 UpdateExecutor::UpdateExecutor(ExecutorContext *exec_ctx, const UpdatePlanNode *plan,
                                std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {
-  // As of Fall 2022, you DON'T need to implement update executor to have perfect score in project 3 / project 4.
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void UpdateExecutor::Init() {
+  child_executor_->Init();
+  auto *catalog = exec_ctx_->GetCatalog();
+  table_info_ = catalog->GetTable(plan_->TableOid());
+  indexes_ = catalog->GetTableIndexes(table_info_->name_);
+  // The table heap locks the rows it inserts exclusively, under an intention lock on the table. Optimistic
+  // transactions take no locks.
+  auto *txn = exec_ctx_->GetTransaction();
+  bool optimistic = txn != nullptr && txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC;
+  lock_mgr_ = optimistic ? nullptr : exec_ctx_->GetLockManager();
+  auto oid = table_info_->oid_;
+  if (txn != nullptr && lock_mgr_ != nullptr && !txn->IsTableExclusiveLocked(oid) &&
+      !txn->IsTableSharedIntentionExclusiveLocked(oid) &&
+      !lock_mgr_->LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, oid)) {
+    throw ExecutionException(
+        fmt::format("transaction {} aborted: cannot lock table {}", txn->GetTransactionId(), table_info_->name_));
+  }
+  moved_.clear();
+  done_ = false;
 }
 
-void UpdateExecutor::Init() { throw NotImplementedException("UpdateExecutor is not implemented"); }
+auto UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
+  if (done_) {
+    return false;
+  }
+  auto *txn = exec_ctx_->GetTransaction();
+  auto *txn_mgr = exec_ctx_->GetTransactionManager();
+  auto txn_id = txn != nullptr ? txn->GetTransactionId() : INVALID_TXN_ID;
+  TupleMeta meta{txn_id, INVALID_TXN_ID, false};
+  TupleMeta delete_meta{INVALID_TXN_ID, txn_id, true};
+  bool checked = false;
+  auto check = [&](const TupleMeta &current_meta, const Tuple &current_tuple, RID current_rid) {
+    checked = true;
+    delete_meta.insert_txn_id_ = current_meta.insert_txn_id_;
+    if (txn == nullptr || txn_mgr == nullptr) {
+      return !current_meta.is_deleted_;
+    }
+    return txn_mgr->PrepareWrite(txn, current_meta, current_tuple, current_rid);
+  };
+
+  int32_t num_updated = 0;
+  Tuple child_tuple;
+  RID child_rid;
+  std::vector<Value> values;
+  while (child_executor_->Next(&child_tuple, &child_rid)) {
+    // A tuple moved by this update may be scanned again.
+    if (moved_.count(child_rid) > 0) {
+      continue;
+    }
+    values.clear();
+    for (const auto &expr : plan_->target_expressions_) {
+      values.push_back(expr->Evaluate(&child_tuple, child_executor_->GetOutputSchema()));
+    }
+    Tuple updated{values, &table_info_->schema_};
+    RID new_rid = child_rid;
+    checked = false;
+    if (table_info_->table_->UpdateTupleInPlace(meta, updated, child_rid, check)) {
+      AppendTableWriteRecord(txn, child_rid, WType::UPDATE);
+    } else if (checked) {
+      continue;
+    } else {
+      // The new version does not fit into the page of the old one, so the old version is deleted and the new one
+      // inserted elsewhere.
+      if (!table_info_->table_->UpdateTupleMeta(delete_meta, child_rid, check)) {
+        continue;
+      }
+      AppendTableWriteRecord(txn, child_rid, WType::DELETE);
+      auto inserted = table_info_->table_->InsertTuple(meta, updated, lock_mgr_, txn, table_info_->oid_);
+      if (!inserted.has_value()) {
+        throw ExecutionException("tuple too large for a table page");
+      }
+      new_rid = *inserted;
+      moved_.insert(new_rid);
+      AppendTableWriteRecord(txn, new_rid, WType::INSERT);
+    }
+    num_updated++;
+
+    for (auto *index_info : indexes_) {
+      auto *index = index_info->index_.get();
+      auto old_key = child_tuple.KeyFromTuple(table_info_->schema_, index_info->key_schema_, index->GetKeyAttrs());
+      auto new_key = updated.KeyFromTuple(table_info_->schema_, index_info->key_schema_, index->GetKeyAttrs());
+      bool same_key = std::string_view(old_key.GetData(), old_key.GetLength()) ==
+                      std::string_view(new_key.GetData(), new_key.GetLength());
+      if (new_rid == child_rid && same_key) {
+        continue;
+      }
+      if (new_rid == child_rid || same_key) {
+        // The entry is replaced, as the index keeps one rid per key. Aborting puts the old key back, pointing at the
+        // old rid.
+        index->DeleteEntry(old_key, child_rid, txn);
+        index->InsertEntry(new_key, new_rid, txn);
+        AppendIndexWriteRecord(txn, index_info, child_rid, WType::UPDATE, updated, child_tuple);
+        continue;
+      }
+      // The old version keeps its entry for the transactions that read it, and the vacuum removes the entry as it
+      // does for a delete. Aborting only removes the new entry.
+      index->InsertEntry(new_key, new_rid, txn);
+      AppendIndexWriteRecord(txn, index_info, new_rid, WType::INSERT, updated);
+      AppendIndexWriteRecord(txn, index_info, child_rid, WType::DELETE, child_tuple);
+    }
+  }
+  *tuple = Tuple({ValueFactory::GetIntegerValue(num_updated)}, &GetOutputSchema());
+  done_ = true;
+  return true;
+}
 
-auto UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool { return false; }
+void UpdateExecutor::AppendTableWriteRecord(Transaction *txn, RID rid, WType wtype) {
+  if (txn == nullptr) {
+    return;
+  }
+  TableWriteRecord write_record{table_info_->oid_, rid, table_info_->table_.get()};
+  write_record.wtype_ = wtype;
+  txn->AppendTableWriteRecord(write_record);
+}
+
+void UpdateExecutor::AppendIndexWriteRecord(Transaction *txn, const IndexInfo *index_info, RID rid, WType wtype,
+                                            const Tuple &tuple, const Tuple &old_tuple) {
+  if (txn == nullptr) {
+    return;
+  }
+  IndexWriteRecord write_record{rid, table_info_->oid_, wtype, tuple, index_info->index_oid_, exec_ctx_->GetCatalog()};
+  write_record.old_tuple_ = old_tuple;
+  txn->AppendIndexWriteRecord(write_record);
+}
 
 }  // namespace bustub
@@ -76,6 +76,7 @@ class BoundExpression;
 class BoundExpressionListRef;
 class BoundOrderBy;
 class BoundSubqueryRef;
+class CopyStatement;
 class CreateStatement;
 class ExplainStatement;
 class IndexStatement;
@@ -198,6 +199,8 @@ class Binder {
 
   auto BindUpdate(duckdb_libpgquery::PGUpdateStmt *stmt) -> std::unique_ptr<UpdateStatement>;
 
+  auto BindCopy(duckdb_libpgquery::PGCopyStmt *stmt) -> std::unique_ptr<CopyStatement>;
+
   auto BindCTE(duckdb_libpgquery::PGWithClause *node) -> std::vector<std::unique_ptr<BoundSubqueryRef>>;
 
   auto BindVariableSet(duckdb_libpgquery::PGVariableSetStmt *stmt) -> std::unique_ptr<VariableSetStatement>;
@@ -0,0 +1,37 @@
+//===----------------------------------------------------------------------===//
+//                         BusTub
+//
+// binder/copy_statement.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binder/bound_statement.h"
+#include "binder/table_ref/bound_base_table_ref.h"
+
+namespace bustub {
+
+class CopyStatement : public BoundStatement {
+ public:
+  explicit CopyStatement(std::unique_ptr<BoundBaseTableRef> table, std::string file_path,
+                         std::vector<std::pair<std::string, std::string>> options);
+
+  /** The table to load */
+  std::unique_ptr<BoundBaseTableRef> table_;
+
+  /** The file to load from */
+  std::string file_path_;
+
+  /** The `(name value, ...)` options, names in lower case */
+  std::vector<std::pair<std::string, std::string>> options_;
+
+  auto ToString() const -> std::string override;
+};
+
+}  // namespace bustub
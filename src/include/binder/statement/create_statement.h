@@ -8,6 +8,7 @@
 #pragma once
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "binder/bound_statement.h"
@@ -21,10 +22,13 @@ namespace bustub {
 
 class CreateStatement : public BoundStatement {
  public:
-  explicit CreateStatement(std::string table, std::vector<Column> columns);
+  explicit CreateStatement(std::string table, std::vector<Column> columns,
+                           std::vector<std::pair<std::string, std::string>> options = {});
 
   std::string table_;
   std::vector<Column> columns_;
+  /** The `WITH (name = value, ...)` options, names in lower case */
+  std::vector<std::pair<std::string, std::string>> options_;
 
   auto ToString() const -> std::string override;
 };
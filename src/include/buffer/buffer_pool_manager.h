@@ -54,8 +54,6 @@ class BufferPoolManager {
   auto GetPages() -> Page * { return pages_; }
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Create a new page in the buffer pool. Set page_id to the new page's id, or nullptr if all frames
    * are currently in use and not evictable (in another word, pinned).
    *
@@ -73,8 +71,6 @@ class BufferPoolManager {
   auto NewPage(page_id_t *page_id) -> Page *;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief PageGuard wrapper for NewPage
    *
    * Functionality should be the same as NewPage, except that
@@ -87,8 +83,6 @@ class BufferPoolManager {
   auto NewPageGuarded(page_id_t *page_id) -> BasicPageGuard;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Fetch the requested page from the buffer pool. Return nullptr if page_id needs to be fetched from the disk
    * but all frames are currently in use and not evictable (in another word, pinned).
    *
@@ -106,8 +100,6 @@ class BufferPoolManager {
   auto FetchPage(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> Page *;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief PageGuard wrappers for FetchPage
    *
    * Functionality should be the same as FetchPage, except
@@ -123,8 +115,6 @@ class BufferPoolManager {
   auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Unpin the target page from the buffer pool. If page_id is not in the buffer pool or its pin count is already
    * 0, return false.
    *
@@ -139,12 +129,11 @@ class BufferPoolManager {
   auto UnpinPage(page_id_t page_id, bool is_dirty, AccessType access_type = AccessType::Unknown) -> bool;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Flush the target page to disk.
    *
    * Use the DiskManager::WritePage() method to flush a page to disk, REGARDLESS of the dirty flag.
-   * Unset the dirty flag of the page after flushing.
+   * Unset the dirty flag of the page after flushing. A pinned page is written too: the caller latches
+   * it if its content must not change while it is written.
    *
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
@@ -152,17 +141,13 @@ class BufferPoolManager {
   auto FlushPage(page_id_t page_id) -> bool;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Flush all the pages in the buffer pool to disk.
    */
   void FlushAllPages();
 
   /**
-   * TODO(P1): Add implementation
-   *
-   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, do nothing and return true. If the
-   * page is pinned and cannot be deleted, return false immediately.
+   * @brief Delete a page from the buffer pool and deallocate it on disk. If page_id is not in the buffer pool, only
+   * deallocate it and return true. If the page is pinned and cannot be deleted, return false immediately.
    *
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
    * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
@@ -182,9 +167,9 @@ class BufferPoolManager {
   /** Array of buffer pool pages. */
   Page *pages_;
   /** Pointer to the disk manager. */
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  /** Pointer to the log manager. Please ignore this for P1. */
-  LogManager *log_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
+  /** Pointer to the log manager, which writes out the log records of a page before the page is written. */
+  LogManager *log_manager_;
   /** Page table for keeping track of buffer pool pages. */
   std::unordered_map<page_id_t, frame_id_t> page_table_;
   /** Replacer to find unpinned pages for replacement. */
@@ -192,7 +177,7 @@ class BufferPoolManager {
   /** List of free frames that don't have any pages on them. */
   // insert from tail, pop from head.
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** This latch protects the page table, the free list, the replacer and the book-keeping of the frames. */
   std::recursive_mutex latch_;
 
   /**
@@ -205,12 +190,24 @@ class BufferPoolManager {
    * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
+
+  /**
+   * @return the LSN of the last record changing the page, if the page keeps one and the record is not on disk yet,
+   * INVALID_LSN otherwise. Caller should hold the latch.
+   */
+  auto PageLSN(Page *page) -> lsn_t;
 
-  // TODO(student): You may add additional private members and helper functions
+  /** Write a page out after the log records of its changes, and unset its dirty flag. Caller should hold the latch. */
+  void WritePage(Page *page);
 
-  auto AllocateFrameForPage(page_id_t page_id) -> frame_id_t;
+  /**
+   * @brief Take a frame from the free list, or else evict the victim of the replacer, writing its page out if it is
+   * dirty. The frame is reset, pinned in the replacer and not in the page table. Caller should acquire the latch.
+   * @param[out] flush_lsn the LSN the log has to be written out to, without the latch, before the victim can be, or
+   * INVALID_LSN
+   * @return the frame, or INVALID_FRAME_ID if every frame is pinned or the log has to be written out first
+   */
+  auto AllocateFrame(lsn_t *flush_lsn) -> frame_id_t;
 };
 }  // namespace bustub
\ No newline at end of file
@@ -26,35 +26,12 @@ namespace bustub {
 
 enum class AccessType { Unknown = 0, Get, Scan };
 
-class ListNode {
+/** The access history of a frame tracked by the LRUKReplacer. */
+class LRUKNode {
  public:
-  explicit ListNode(size_t frame_id, bool is_evictable, size_t k);
-  auto ExceedK(size_t k) -> bool;
-  auto K() -> size_t;
-  auto IsEvictable() -> bool;
-  auto GetFrameID() -> frame_id_t;
-
- private:
-  frame_id_t fid_{INVALID_FRAME_ID};
-  bool is_evictable_{false};
-  size_t k_{0};
-};
-
-class MapNode {
   /** History of last seen K timestamps of this page. Least recent timestamp stored in front. */
-  // Remove maybe_unused if you start using them. Feel free to change the member variables as you want.
- public:
-  frame_id_t fid_;
-  std::list<ListNode>::iterator it_;
+  std::list<size_t> history_;
   bool is_evictable_{false};
-  size_t k_;
-
-  // explicit MapNode(size_t frame_id);
-  explicit MapNode(size_t frame_id, std::list<ListNode>::iterator it, bool is_evictable, size_t k);
-  auto ExceedK(size_t k) -> bool;
-  auto K() -> size_t;
-
-  ~MapNode() = default;
 };
 
 /**
@@ -71,9 +48,6 @@ class MapNode {
 class LRUKReplacer {
  public:
   /**
-   *
-   * TODO(P1): Add implementation
-   *
    * @brief a new LRUKReplacer.
    * @param num_frames the maximum number of frames the LRUReplacer will be required to store
    */
@@ -82,15 +56,11 @@ class LRUKReplacer {
   DISALLOW_COPY_AND_MOVE(LRUKReplacer);
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Destroys the LRUReplacer.
    */
   ~LRUKReplacer() = default;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Find the frame with largest backward k-distance and evict that frame. Only frames
    * that are marked as 'evictable' are candidates for eviction.
    *
@@ -107,8 +77,6 @@ class LRUKReplacer {
   auto Evict(frame_id_t *frame_id) -> bool;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Record the event that the given frame id is accessed at current timestamp.
    * Create a new entry for access history if frame id has not been seen before.
    *
@@ -122,8 +90,6 @@ class LRUKReplacer {
   void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown);
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Toggle whether a frame is evictable or non-evictable. This function also
    * controls replacer's size. Note that size is equal to number of evictable entries.
    *
@@ -141,8 +107,6 @@ class LRUKReplacer {
   void SetEvictable(frame_id_t frame_id, bool set_evictable);
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Remove an evictable frame from replacer, along with its access history.
    * This function should also decrement replacer's size if removal is successful.
    *
@@ -160,41 +124,26 @@ class LRUKReplacer {
   void Remove(frame_id_t frame_id);
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Return replacer's size, which tracks the number of evictable frames.
    *
    * @return size_t
    */
   auto Size() -> size_t;
+
+  /** @brief Log the access history of every frame. */
   auto Debug() -> void;
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  //
+  /** @return whether frame `a`, which is evictable, is a better victim than frame `b` */
+  auto EvictsBefore(const LRUKNode &a, const LRUKNode &b) const -> bool;
 
-  // capaacity of replacer
-  size_t replacer_size_;
-  // evictable size
+  std::unordered_map<frame_id_t, LRUKNode> node_store_;
+  size_t current_timestamp_{0};
+  /** The number of evictable frames */
   size_t curr_size_{0};
-  std::unordered_map<frame_id_t, std::list<ListNode>::iterator> node_store_;
-  // push from head, pop from back
-  std::list<ListNode> cache_list_;
-  std::list<ListNode> hist_list_;
-  std::list<ListNode> pinned_list_;
-  [[maybe_unused]] size_t k_;
-
-  auto FrameIDOverK(MapNode node) -> bool;
-
-  /*
-  [[maybe_unused]] std::unordered_map<frame_id_t, LRUKNode> node_store_;
-  [[maybe_unused]] size_t current_timestamp_{0};
-  [[maybe_unused]] size_t curr_size_{0};
-  [[maybe_unused]] size_t replacer_size_;
-  [[maybe_unused]] size_t k_;
-  [[maybe_unused]] std::mutex latch_;
-  */
+  size_t replacer_size_;
+  size_t k_;
+  std::mutex latch_;
 };
 
 }  // namespace bustub
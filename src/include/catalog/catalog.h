@@ -121,10 +121,11 @@ class Catalog {
    * @param table_name The name of the new table, note that all tables beginning with `__` are reserved for the system.
    * @param schema The schema of the new table
    * @param create_table_heap whether to create a table heap for the new table
+   * @param storage The page layout of the table heap
    * @return A (non-owning) pointer to the metadata for the table
    */
-  auto CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema, bool create_table_heap = true)
-      -> TableInfo * {
+  auto CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema, bool create_table_heap = true,
+                   TableStorage storage = TableStorage::ROW) -> TableInfo * {
     if (table_names_.count(table_name) != 0) {
       return NULL_TABLE_INFO;
     }
@@ -136,7 +137,7 @@ class Catalog {
     // When create_table_heap == false, it means that we're running binder tests (where no txn will be provided) or
     // we are running shell without buffer pool. We don't need to create TableHeap in this case.
     if (create_table_heap) {
-      table = std::make_unique<TableHeap>(bpm_);
+      table = std::make_unique<TableHeap>(bpm_, schema, storage, log_manager_);
     }
 
     // Fetch the table OID for the new table
@@ -298,7 +299,7 @@ class Catalog {
    * @param index_oid The OID of the index for which to query
    * @return A (non-owning) pointer to the metadata for the index
    */
-  auto GetIndex(index_oid_t index_oid) -> IndexInfo * {
+  auto GetIndex(index_oid_t index_oid) const -> IndexInfo * {
     auto index = indexes_.find(index_oid);
     if (index == indexes_.end()) {
       return NULL_INDEX_INFO;
@@ -344,7 +345,7 @@ class Catalog {
  private:
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
-  [[maybe_unused]] LogManager *log_manager_;
+  LogManager *log_manager_;
 
   /**
    * Map table identifier -> table metadata.
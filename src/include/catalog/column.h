@@ -136,7 +136,7 @@ class Column {
   /** For an inlined column, 0. Otherwise, the length of the variable length column. */
   uint32_t variable_length_{0};
 
-  /** Column offset in the tuple. */
+  /** Column offset in the tuple; for a varchar, the offset of the end offset of its bytes. */
   uint32_t column_offset_{0};
 };
 
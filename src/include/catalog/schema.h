@@ -90,9 +90,15 @@ class Schema {
   /** @return the number of non-inlined columns */
   auto GetUnlinedColumnCount() const -> uint32_t { return static_cast<uint32_t>(uninlined_columns_.size()); }
 
-  /** @return the number of bytes used by one tuple */
+  /** @return the number of bytes used by one tuple before its varchar bytes */
   inline auto GetLength() const -> uint32_t { return length_; }
 
+  /** @return the number of bytes of the null bitmap that starts every tuple */
+  inline auto GetNullBitmapSize() const -> uint32_t { return null_bitmap_size_; }
+
+  /** @return the offset of the end offset of the first varchar in a tuple */
+  inline auto GetVarlenOffsetsStart() const -> uint32_t { return varlen_offsets_start_; }
+
   /** @return true if all columns are inlined, false otherwise */
   inline auto IsInlined() const -> bool { return tuple_is_inlined_; }
 
@@ -100,9 +106,15 @@ class Schema {
   auto ToString(bool simplified = true) const -> std::string;
 
  private:
-  /** Fixed-length column size, i.e. the number of bytes used by one tuple. */
+  /** Size of the null bitmap, the fixed-width columns and the varchar end offsets of a tuple. */
   uint32_t length_;
 
+  /** Size of the null bitmap, one bit per column. */
+  uint32_t null_bitmap_size_;
+
+  /** Offset of the first varchar end offset. */
+  uint32_t varlen_offsets_start_;
+
   /** All the columns in the schema, inlined and uninlined. */
   std::vector<Column> columns_;
 
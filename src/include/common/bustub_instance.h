@@ -42,6 +42,7 @@ class CheckpointManager;
 class Catalog;
 class ExecutionEngine;
 
+class CopyStatement;
 class CreateStatement;
 class IndexStatement;
 class VariableSetStatement;
@@ -62,6 +63,13 @@ class ResultWriter {
   virtual void BeginTable(bool simplified_output) = 0;
   virtual void EndTable() = 0;
 
+  /**
+   * Rows are written while the query is still running. A writer that has seen enough (e.g. a pager that was
+   * closed) returns `false` here to stop the query instead of having it run to completion.
+   * @return `true` if the writer accepts more rows
+   */
+  virtual auto WantsMoreRows() -> bool { return true; }
+
   bool simplified_output_{false};
 };
 
@@ -278,11 +286,13 @@ class BustubInstance {
  private:
   void CmdDisplayTables(ResultWriter &writer);
   void CmdDisplayIndices(ResultWriter &writer);
+  void CmdDisplayCompression(ResultWriter &writer);
   void CmdDisplayHelp(ResultWriter &writer);
   void WriteOneCell(const std::string &cell, ResultWriter &writer);
 
   void HandleCreateStatement(Transaction *txn, const CreateStatement &stmt, ResultWriter &writer);
   void HandleIndexStatement(Transaction *txn, const IndexStatement &stmt, ResultWriter &writer);
+  void HandleCopyStatement(Transaction *txn, const CopyStatement &stmt, ResultWriter &writer);
   void HandleExplainStatement(Transaction *txn, const ExplainStatement &stmt, ResultWriter &writer);
   void HandleVariableShowStatement(Transaction *txn, const VariableShowStatement &stmt, ResultWriter &writer);
   void HandleVariableSetStatement(Transaction *txn, const VariableSetStatement &stmt, ResultWriter &writer);
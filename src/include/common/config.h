@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 
 namespace bustub {
@@ -21,16 +22,81 @@ namespace bustub {
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
 extern std::chrono::milliseconds cycle_detection_interval;
 
+/** The background vacuum garbage-collects the old tuple versions every VACUUM_INTERVAL milliseconds. */
+extern std::chrono::milliseconds vacuum_interval;
+
+/** A transaction holding more than this many row locks on a table trades them for a table lock; 0 never does. */
+extern size_t lock_escalation_threshold;
+
+/**
+ * How the lock manager deals with deadlocks. DETECTION lets transactions wait and aborts the newest transaction of
+ * each cycle the background cycle detection finds. The others prevent deadlocks by transaction age, the oldest
+ * transaction having the smallest id: under WAIT_DIE a transaction waits only for younger ones and aborts instead of
+ * waiting for an older one, under WOUND_WAIT it waits only for older ones and wounds the younger ones, which abort
+ * instead of waiting for any lock from then on.
+ */
+enum class DeadlockPolicy { DETECTION, WAIT_DIE, WOUND_WAIT };
+extern DeadlockPolicy deadlock_policy;
+
+/** Under DeadlockPolicy::DETECTION, whether a transaction aborts at once if waiting for a lock closes a cycle. */
+extern bool deadlock_check_on_wait;
+
 /** True if logging should be enabled, false otherwise. */
 extern std::atomic<bool> enable_logging;
 
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** Number of threads the redo pass of recovery applies the log records with, each to its own share of the pages. */
+extern size_t recovery_num_threads;
+
+/** The checkpoint thread takes a checkpoint every CHECKPOINT_INTERVAL, see CheckpointManager. */
+extern std::chrono::duration<int64_t> checkpoint_interval;
+
+/** True if a BustubInstance backed by a file should compress its pages on disk, see CompressedDiskManager. */
+extern bool enable_page_compression;
+
+/** True if the log manager should compress the log buffers it writes out, see LogManager. */
+extern bool enable_log_compression;
+
+/** Bytes of tuples a sort may buffer in memory before spilling a sorted run to temporary pages. */
+extern size_t sort_memory_budget;
+
+/** Bytes a hash aggregation may use for its hash tables before spilling partial aggregates to temporary pages. */
+extern size_t aggregation_memory_budget;
+
+/** Number of threads a hash aggregation uses to aggregate its input. */
+extern size_t aggregation_num_threads;
+
+/** Number of outer tuples a nested loop join buffers per scan of its inner side. */
+extern size_t nlj_block_size;
+
+/** A nested loop join keeps an inner side of at most this many tuples in memory instead of rescanning it. */
+extern size_t nlj_inner_materialize_threshold;
+
+/** Number of tuples an insert buffers before writing them to the table and its indexes as one batch. */
+extern size_t insert_batch_size;
+
+/** Number of threads a COPY FROM uses to parse its input and insert the rows. */
+extern size_t copy_num_threads;
+
+/** Number of bytes a COPY FROM reads from its input at a time and hands to a parser thread. */
+extern size_t copy_chunk_size;
+
+/** Row tables move the largest varchars of a tuple to overflow pages until it takes at most this many bytes. */
+extern size_t toast_tuple_threshold;
+
+/** Whether varchars moved to overflow pages are compressed, when that makes them smaller. */
+extern bool toast_compression;
+
+/** Whether PAX pages encode their minipages once they are full, see PaxTablePage::Seal. */
+extern bool pax_column_encoding;
+
 static constexpr int INVALID_FRAME_ID = -1;                                          // invalid frame id
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
+static constexpr int64_t INVALID_TS = -1;                                            // invalid commit timestamp
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
 static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
@@ -42,6 +108,7 @@ using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
 using txn_id_t = int32_t;      // transaction id type
 using lsn_t = int32_t;         // log sequence number type
+using timestamp_t = int64_t;   // commit timestamp type
 using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
 
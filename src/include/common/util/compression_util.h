@@ -0,0 +1,43 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util.h
+//
+// Identification: src/include/common/util/compression_util.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace bustub {
+
+/**
+ * CompressionUtil is a small LZ77 codec in the spirit of LZ4: it is built for speed rather than ratio and only
+ * finds repeats within the last 64 KiB of its input.
+ *
+ * The compressed bytes are a list of sequences. Each sequence starts with a token byte whose high nibble is the
+ * number of literal bytes and whose low nibble is the length of the match minus 4; a nibble of 15 is followed by
+ * more length bytes, which are added up until one is not 255. The literal bytes follow, then the 2-byte offset of
+ * the match, then the extra match length bytes. The last sequence has literals only.
+ */
+class CompressionUtil {
+ public:
+  /** @return the compressed bytes of `input` */
+  static auto Compress(std::string_view input) -> std::string;
+
+  /**
+   * Decompress `input` into `output`.
+   * @param size the number of bytes `input` decompresses to
+   * @return false if `input` is not the compressed form of exactly `size` bytes
+   */
+  static auto Decompress(std::string_view input, char *output, size_t size) -> bool;
+};
+
+}  // namespace bustub
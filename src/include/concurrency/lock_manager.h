@@ -13,10 +13,14 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <condition_variable>  // NOLINT
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <optional>
+#include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -33,6 +37,25 @@ class TransactionManager;
 
 /**
  * LockManager handles transactions asking for locks on records.
+ *
+ * The row lock table is split into partitions by the hash of the RID, each with its own latch and padded to a cache
+ * line, so that transactions locking different rows rarely wait for each other's latches. A row's queue lives in
+ * its partition while requests for the row are in it, and the lock requests are recycled through per-partition pools.
+ *
+ * Intention locks on tables, which nearly every transaction takes on the same few tables, are granted on a fast
+ * path while no S, SIX or X request is queued on the table: a compare-and-swap on counters in the table's queue,
+ * without taking its latch. The fast-path grants are kept per transaction, for unlocking and for cycle detection.
+ * The first S, SIX or X request closes the fast path until the last one leaves, and waits for the intention locks
+ * granted on it like for any other granted lock.
+ *
+ * A transaction that locks more than `lock_escalation_threshold` rows of a table trades them for a table lock
+ * covering them, S for shared rows and X once a row is exclusive, and later row locks on the table are covered by it.
+ * Row locks are taken with page latches held, so escalation never waits: it upgrades the table lock only if nothing
+ * conflicts right away, and otherwise tries again after as many more row locks.
+ *
+ * A transaction about to wait for a lock is checked against the transactions it waits for, according to
+ * `deadlock_policy`. The waiting transactions are registered with what they wait for, so that the wounded ones can
+ * be woken up to abort, and so that a waiter can look for a cycle through the other waiters when it starts waiting.
  */
 class LockManager {
  public:
@@ -72,6 +95,42 @@ class LockManager {
     txn_id_t upgrading_ = INVALID_TXN_ID;
     /** coordination */
     std::mutex latch_;
+    /**
+     * Table locks only: the IS and IX locks granted on the fast path, and whether the fast path is closed, see
+     * FAST_PATH_IS, FAST_PATH_IX and FAST_PATH_CLOSED. Changed without the latch while the fast path is open.
+     */
+    std::atomic<uint64_t> fast_path_{0};
+    /** Table locks only: the S, SIX and X requests in the queue, which keep the fast path closed */
+    uint32_t num_strong_{0};
+  };
+
+  /** A free list of lock requests, so that locking does not allocate once warm. Not thread-safe. */
+  class LockRequestPool {
+   public:
+    LockRequestPool() = default;
+    DISALLOW_COPY_AND_MOVE(LockRequestPool);
+    ~LockRequestPool() {
+      for (auto *request : free_) {
+        delete request;
+      }
+    }
+
+    /** @return a lock request, not granted */
+    auto Acquire(txn_id_t txn_id, LockMode lock_mode, table_oid_t oid, RID rid) -> LockRequest * {
+      if (free_.empty()) {
+        return new LockRequest(txn_id, lock_mode, oid, rid);
+      }
+      auto *request = free_.back();
+      free_.pop_back();
+      *request = LockRequest(txn_id, lock_mode, oid, rid);
+      return request;
+    }
+
+    /** Give back a request taken out of its queue. */
+    void Release(LockRequest *request) { free_.push_back(request); }
+
+   private:
+    std::vector<LockRequest *> free_;
   };
 
   /**
@@ -86,14 +145,14 @@ class LockManager {
   }
 
   ~LockManager() {
-    UnlockAll();
-
     enable_cycle_detection_ = false;
 
     if (cycle_detection_thread_ != nullptr) {
       cycle_detection_thread_->join();
       delete cycle_detection_thread_;
     }
+
+    UnlockAll();
   }
 
   /**
@@ -310,10 +369,42 @@ class LockManager {
   TransactionManager *txn_manager_;
 
  private:
+  /** Number of partitions of the row lock table */
+  static constexpr size_t ROW_LOCK_SHARDS = 64;
+  /** Number of partitions of the fast-path grants, by transaction */
+  static constexpr size_t FAST_PATH_SHARDS = 64;
+  /** One IS lock granted on the fast path, counted in the bits 0 to 30 of LockRequestQueue::fast_path_ */
+  static constexpr uint64_t FAST_PATH_IS = 1;
+  /** One IX lock granted on the fast path, counted in the bits 32 to 62 */
+  static constexpr uint64_t FAST_PATH_IX = uint64_t{1} << 32;
+  static constexpr uint64_t FAST_PATH_COUNT_MASK = (uint64_t{1} << 31) - 1;
+  /** Set while S, SIX or X requests are queued on the table */
+  static constexpr uint64_t FAST_PATH_CLOSED = uint64_t{1} << 63;
+
+  /** A partition of the row lock table, on cache lines of its own. */
+  struct alignas(64) RowLockShard {
+    std::mutex latch_;
+    std::unordered_map<RID, std::shared_ptr<LockRequestQueue>> lock_map_;
+    LockRequestPool pool_;
+    /** The requests waiting in the queues of the partition, so that cycle detection skips idle partitions */
+    std::atomic<uint32_t> num_waiting_{0};
+  };
+
+  /** A transaction waiting for a lock: the queue it waits in and the transactions it waits for. */
+  struct Waiter {
+    std::shared_ptr<LockRequestQueue> queue_;
+    std::vector<txn_id_t> blockers_;
+  };
+
+  /** A partition of the table locks granted on the fast path, by transaction. */
+  struct alignas(64) FastPathShard {
+    std::mutex latch_;
+    std::unordered_map<txn_id_t, std::vector<std::pair<table_oid_t, LockMode>>> locks_;
+  };
+
   /** Spring 2023 */
   /* You are allowed to modify all functions below. */
   auto UpgradeLockTable(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool;
-  auto UpgradeLockRow(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, const RID &rid) -> bool;
   auto AreLocksCompatible(LockMode l1, LockMode l2) -> bool;
   auto CanTxnTakeLock(Transaction *txn, LockMode lock_mode) -> bool;
   void GrantNewLocksIfPossible(LockRequestQueue *lock_request_queue);
@@ -323,18 +414,92 @@ class LockManager {
                  std::unordered_set<txn_id_t> &visited, txn_id_t *abort_txn_id) -> bool;
   void UnlockAll();
 
-  /** Structure that holds lock requests for a given table oid */
-  std::unordered_map<table_oid_t, std::shared_ptr<LockRequestQueue>> table_lock_map_;
-  /** Coordination */
-  std::mutex table_lock_map_latch_;
+  /** Set the transaction ABORTED and throw a TransactionAbortException. */
+  [[noreturn]] void AbortTxn(Transaction *txn, AbortReason reason);
+  /** @return the mode in which `txn` holds the table `oid`, std::nullopt if it does not */
+  auto GetTableLockMode(Transaction *txn, table_oid_t oid) -> std::optional<LockMode>;
+  /** @return the mode in which `txn` holds the row `rid`, std::nullopt if it does not */
+  auto GetRowLockMode(Transaction *txn, table_oid_t oid, const RID &rid) -> std::optional<LockMode>;
+  /** Add a lock to the lock sets of `txn`, or remove it. */
+  void BookKeepTableLock(Transaction *txn, LockMode lock_mode, table_oid_t oid, bool add);
+  void BookKeepRowLock(Transaction *txn, LockMode lock_mode, table_oid_t oid, const RID &rid, bool add);
+  /** Move `txn` to SHRINKING if releasing a lock in `lock_mode` ends its growing phase. */
+  void UpdateStateOnUnlock(Transaction *txn, LockMode lock_mode);
+  /** @return the queue of the table `oid`, created if missing */
+  auto GetTableQueue(table_oid_t oid) -> std::shared_ptr<LockRequestQueue>;
+  auto GetRowShard(const RID &rid) -> RowLockShard & {
+    return row_lock_shards_[std::hash<RID>()(rid) % ROW_LOCK_SHARDS];
+  }
+  auto GetFastPathShard(txn_id_t txn_id) -> FastPathShard & {
+    return fast_path_shards_[static_cast<size_t>(txn_id) % FAST_PATH_SHARDS];
+  }
+  /** Grant an IS or IX table lock on the fast path if it is open. */
+  auto TryFastPathLock(Transaction *txn, LockRequestQueue *queue, LockMode lock_mode, table_oid_t oid) -> bool;
+  /** Forget the fast-path grant of the table `oid` to a transaction. @return its mode, if there was one */
+  auto RemoveFastPathLock(txn_id_t txn_id, table_oid_t oid) -> std::optional<LockMode>;
+  /** @return the mode of the fast-path grant of the table `oid` to a transaction, if there is one */
+  auto FindFastPathLock(txn_id_t txn_id, table_oid_t oid) -> std::optional<LockMode>;
+  /** Release an IS or IX lock granted on the fast path, granting the requests waiting for it. */
+  void ReleaseFastPathLock(LockRequestQueue *queue, LockMode lock_mode);
+  /** @return whether a table lock in `table_lock_mode` covers a lock in `row_lock_mode` on each row */
+  auto TableLockCoversRows(LockMode table_lock_mode, LockMode row_lock_mode) -> bool;
+  /** @return whether the row locks of `txn` on the table `oid` were escalated */
+  auto IsEscalated(Transaction *txn, table_oid_t oid) -> bool;
+  /** Trade the row locks of `txn` on the table `oid` for a table lock, if it can be had without waiting. */
+  void EscalateRowLocks(Transaction *txn, table_oid_t oid);
+  /** Upgrade a table lock if that is granted without waiting. @return whether it was upgraded */
+  auto TryUpgradeLockTable(Transaction *txn, LockMode lock_mode, table_oid_t oid) -> bool;
+  /** Count an S, SIX or X table request entering or leaving the queue, closing and opening the fast path. */
+  void CountStrongRequest(LockRequestQueue *queue, LockMode lock_mode, bool enter);
+  /**
+   * Wait with the queue latch held until the request is granted or the transaction is aborted.
+   * @param num_waiting the counter of waiting requests to keep up to date
+   * @return whether the lock was granted, false if the transaction was aborted even if the request was granted
+   */
+  auto WaitForGrant(Transaction *txn, const std::shared_ptr<LockRequestQueue> &queue, LockRequest *request,
+                    std::unique_lock<std::mutex> *lock, std::atomic<uint32_t> *num_waiting) -> bool;
+  /**
+   * @return the transactions a request waits for: those ahead of it in the queue that hold an incompatible lock or
+   * wait themselves, and those holding an incompatible intention lock on the fast path
+   */
+  auto GetBlockers(LockRequestQueue *queue, LockRequest *request) -> std::vector<txn_id_t>;
+  /**
+   * Apply the deadlock policy to a transaction about to wait for `blockers`, with the queue latch held.
+   * @param[out] wounded the transactions it wounded, to be woken up
+   * @return whether it may wait, false if it must abort
+   */
+  auto MayWait(Transaction *txn, const std::shared_ptr<LockRequestQueue> &queue, std::vector<txn_id_t> blockers,
+               std::vector<txn_id_t> *wounded) -> bool;
+  /** @return whether waiting for `blockers` closes a cycle through the waiters back to `txn_id` */
+  auto ClosesCycle(txn_id_t txn_id, const std::vector<txn_id_t> &blockers) -> bool;
+  /** Wake up the wounded transactions that wait for a lock, so that they abort. */
+  void WakeUp(const std::vector<txn_id_t> &txn_ids);
+  /**
+   * Add the edges from the requests waiting in a queue to the transactions they wait for.
+   * @param[out] waits_in the queue each waiting transaction waits in
+   */
+  void AddWaitsForEdges(const std::shared_ptr<LockRequestQueue> &queue,
+                        std::unordered_map<txn_id_t, std::shared_ptr<LockRequestQueue>> *waits_in);
 
-  /** Structure that holds lock requests for a given RID */
-  std::unordered_map<RID, std::shared_ptr<LockRequestQueue>> row_lock_map_;
+  /** Structure that holds lock requests for a given table oid; the queues are never removed */
+  std::unordered_map<table_oid_t, std::shared_ptr<LockRequestQueue>> table_lock_map_;
   /** Coordination */
-  std::mutex row_lock_map_latch_;
-
-  std::atomic<bool> enable_cycle_detection_;
-  std::thread *cycle_detection_thread_;
+  std::shared_mutex table_lock_map_latch_;
+  /** The table lock requests not in use, protected by table_request_pool_latch_ */
+  LockRequestPool table_request_pool_;
+  std::mutex table_request_pool_latch_;
+  std::atomic<uint32_t> num_table_waiting_{0};
+
+  /** The row lock table, partitioned by RID */
+  std::array<RowLockShard, ROW_LOCK_SHARDS> row_lock_shards_;
+  /** The table locks granted on the fast path, partitioned by transaction */
+  std::array<FastPathShard, FAST_PATH_SHARDS> fast_path_shards_;
+  /** The transactions waiting for a lock */
+  std::unordered_map<txn_id_t, Waiter> waiters_;
+  std::mutex waiters_latch_;
+
+  std::atomic<bool> enable_cycle_detection_{false};
+  std::thread *cycle_detection_thread_{nullptr};
   /** Waits-for graph representation. */
   std::unordered_map<txn_id_t, std::vector<txn_id_t>> waits_for_;
   std::mutex waits_for_latch_;
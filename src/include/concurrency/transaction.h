@@ -15,11 +15,13 @@
 #include <fmt/format.h>
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <string>
 #include <thread>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 #include "common/config.h"
 #include "common/logger.h"
@@ -46,9 +48,12 @@ namespace bustub {
 enum class TransactionState { GROWING, SHRINKING, COMMITTED, ABORTED };
 
 /**
- * Transaction isolation level.
+ * Transaction isolation level. The levels but SNAPSHOT_ISOLATION and OPTIMISTIC rely on locks and read the newest
+ * version of every tuple; under SNAPSHOT_ISOLATION, a transaction reads the versions committed before it began,
+ * without locking. OPTIMISTIC transactions read like snapshot ones and take no locks at all, but record what they
+ * read and are validated when they commit, see TransactionManager.
  */
-enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED };
+enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED, SNAPSHOT_ISOLATION, OPTIMISTIC };
 
 /**
  * Type of write operation.
@@ -100,6 +105,8 @@ class IndexWriteRecord {
   WType wtype_;
   /** The tuple is used to construct an index key. */
   Tuple tuple_;
+  /** Whether the tuple is the index key already rather than a row of the table, as COPY records it. */
+  bool is_key_{false};
   /** The old tuple is only used for the update operation. */
   Tuple old_tuple_;
   /** Each table has an index list, this is the identifier of an index into the list. */
@@ -108,6 +115,30 @@ class IndexWriteRecord {
   Catalog *catalog_;
 };
 
+/**
+ * UndoLog is an older version of a tuple, kept for the transactions that do not see the newer ones. The versions of
+ * a tuple form a chain, from the version in the table heap to the oldest one kept.
+ */
+struct UndoLog {
+  /** The meta of the version, naming the transaction that wrote it */
+  TupleMeta meta_;
+  /** The tuple of the version */
+  Tuple tuple_;
+  /** The next older version, nullptr if there is none */
+  std::shared_ptr<const UndoLog> prev_;
+};
+
+/**
+ * ScanRecord is a scan of a table by an optimistic transaction. The transaction read the tuples of the table that
+ * match the scan, so a newer version of a tuple it would match changes what it read.
+ */
+struct ScanRecord {
+  /** The table scanned */
+  TableHeap *table_heap_;
+  /** @return whether the scan reads a tuple of the table */
+  std::function<bool(const Tuple &)> matches_;
+};
+
 /**
  * Reason to a transaction abortion
  */
@@ -177,7 +208,10 @@ class Transaction {
         ix_table_lock_set_{new std::unordered_set<table_oid_t>},
         six_table_lock_set_{new std::unordered_set<table_oid_t>},
         s_row_lock_set_{new std::unordered_map<table_oid_t, std::unordered_set<RID>>},
-        x_row_lock_set_{new std::unordered_map<table_oid_t, std::unordered_set<RID>>} {
+        x_row_lock_set_{new std::unordered_map<table_oid_t, std::unordered_set<RID>>},
+        escalated_table_set_{new std::unordered_set<table_oid_t>},
+        read_set_{new std::unordered_set<RID>},
+        scan_set_{new std::deque<ScanRecord>} {
     // Initialize the sets that will be tracked.
     table_write_set_ = std::make_shared<std::deque<TableWriteRecord>>();
     index_write_set_ = std::make_shared<std::deque<IndexWriteRecord>>();
@@ -198,12 +232,47 @@ class Transaction {
   /** @return the isolation level of this transaction */
   inline auto GetIsolationLevel() const -> IsolationLevel { return isolation_level_; }
 
+  /** @return whether the transaction reads the versions committed before it began, rather than the newest ones */
+  inline auto ReadsSnapshot() const -> bool {
+    return isolation_level_ == IsolationLevel::SNAPSHOT_ISOLATION || isolation_level_ == IsolationLevel::OPTIMISTIC;
+  }
+
+  /** @return the timestamp of the last commit this transaction sees under snapshot isolation */
+  inline auto GetReadTs() const -> timestamp_t { return read_ts_; }
+
+  /** @return the commit timestamp of this transaction, INVALID_TS until it commits */
+  inline auto GetCommitTs() const -> timestamp_t { return commit_ts_; }
+
+  /** Set the read timestamp, done by TransactionManager::Begin. */
+  inline void SetReadTs(timestamp_t read_ts) { read_ts_ = read_ts; }
+
+  /** Set the commit timestamp, done by TransactionManager::Commit. */
+  inline void SetCommitTs(timestamp_t commit_ts) { commit_ts_ = commit_ts; }
+
   /** @return the list of table write records of this transaction */
   inline auto GetWriteSet() -> std::shared_ptr<std::deque<TableWriteRecord>> { return table_write_set_; }
 
   /** @return the list of index write records of this transaction */
   inline auto GetIndexWriteSet() -> std::shared_ptr<std::deque<IndexWriteRecord>> { return index_write_set_; }
 
+  /** @return the tuples read by this transaction, recorded under OPTIMISTIC */
+  inline auto GetReadSet() -> std::shared_ptr<std::unordered_set<RID>> { return read_set_; }
+
+  /** @return the scans run by this transaction, recorded under OPTIMISTIC */
+  inline auto GetScanSet() -> std::shared_ptr<std::deque<ScanRecord>> { return scan_set_; }
+
+  /**
+   * Adds a tuple into the read set.
+   * @param rid the rid of the tuple read
+   */
+  inline void AddIntoReadSet(RID rid) { read_set_->insert(rid); }
+
+  /**
+   * Adds a scan record into the scan set.
+   * @param scan_record scan record to be added
+   */
+  inline void AppendScanRecord(ScanRecord scan_record) { scan_set_->push_back(std::move(scan_record)); }
+
   /** @return the page set */
   inline auto GetPageSet() -> std::shared_ptr<std::deque<Page *>> { return page_set_; }
 
@@ -263,6 +332,11 @@ class Transaction {
     return six_table_lock_set_;
   }
 
+  /** @return the tables whose row locks were traded for a table lock */
+  inline auto GetEscalatedTableSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> {
+    return escalated_table_set_;
+  }
+
   /** @return true if rid (belong to table oid) is shared locked by this transaction */
   auto IsRowSharedLocked(const table_oid_t &oid, const RID &rid) -> bool {
     auto row_lock_set = s_row_lock_set_->find(oid);
@@ -314,6 +388,12 @@ class Transaction {
    */
   inline void SetState(TransactionState state) { state_ = state; }
 
+  /** @return whether an older transaction waiting for a lock of this one wounded it, see DeadlockPolicy */
+  inline auto IsWounded() -> bool { return wounded_; }
+
+  /** Wound the transaction: it aborts rather than wait for a lock from now on. */
+  inline void SetWounded() { wounded_ = true; }
+
   /** @return the previous LSN */
   inline auto GetPrevLSN() -> lsn_t { return prev_lsn_; }
 
@@ -326,12 +406,18 @@ class Transaction {
  private:
   /** The current transaction state. */
   TransactionState state_{TransactionState::GROWING};
+  /** Whether the transaction was wounded under DeadlockPolicy::WOUND_WAIT. */
+  std::atomic<bool> wounded_{false};
   /** The isolation level of the transaction. */
   IsolationLevel isolation_level_;
   /** The thread ID, used in single-threaded transactions. */
   std::thread::id thread_id_;
   /** The ID of this transaction. */
   txn_id_t txn_id_;
+  /** The timestamp of the last commit seen under snapshot isolation. */
+  timestamp_t read_ts_{0};
+  /** The commit timestamp, INVALID_TS until the transaction commits. */
+  timestamp_t commit_ts_{INVALID_TS};
 
   /** The undo set of table tuples. */
   std::shared_ptr<std::deque<TableWriteRecord>> table_write_set_;
@@ -357,6 +443,12 @@ class Transaction {
   /** LockManager: the set of row locks held by this transaction. */
   std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> s_row_lock_set_;
   std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> x_row_lock_set_;
+  /** LockManager: the tables whose row locks were escalated; their table lock covers the rows locked since. */
+  std::shared_ptr<std::unordered_set<table_oid_t>> escalated_table_set_;
+
+  /** OPTIMISTIC: the tuples read, and the scans run, validated at commit. */
+  std::shared_ptr<std::unordered_set<RID>> read_set_;
+  std::shared_ptr<std::deque<ScanRecord>> scan_set_;
 };
 
 }  // namespace bustub
@@ -378,6 +470,12 @@ struct fmt::formatter<bustub::IsolationLevel> : formatter<std::string_view> {
       case IsolationLevel::REPEATABLE_READ:
         name = "REPEATABLE_READ";
         break;
+      case IsolationLevel::SNAPSHOT_ISOLATION:
+        name = "SNAPSHOT_ISOLATION";
+        break;
+      case IsolationLevel::OPTIMISTIC:
+        name = "OPTIMISTIC";
+        break;
     }
     return formatter<string_view>::format(name, ctx);
   }
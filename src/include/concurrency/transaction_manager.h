@@ -13,9 +13,18 @@
 #pragma once
 
 #include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <optional>
+#include <set>
 #include <shared_mutex>
+#include <thread>  // NOLINT
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
@@ -23,17 +32,38 @@
 #include "recovery/log_manager.h"
 
 namespace bustub {
+class Index;
 class LockManager;
 
 /**
  * TransactionManager keeps track of all the transactions running in the system.
+ *
+ * It also keeps the versions of the tuples for multi-version concurrency control. The table heap holds the newest
+ * version of every tuple, and its meta names the transaction that wrote it. Overwriting a tuple first saves the
+ * version it replaces as an UndoLog in the version chain of the tuple. Every commit gets the next commit timestamp,
+ * and a transaction sees the versions written by itself and by the transactions committed when it began, at its
+ * read timestamp. Under snapshot isolation, scans therefore walk the version chain of a tuple whose newest version
+ * they do not see, instead of taking locks. Writers never wait: a transaction overwriting a version it does not see
+ * is aborted, so the first of two concurrent writers of a tuple wins.
+ *
+ * The watermark is the oldest read timestamp of the running snapshot transactions. A version overwritten by a commit
+ * at or before the watermark is read by no transaction anymore, so Vacuum() drops it from its version chain, freezes
+ * the meta of the tuple (its transaction ids become INVALID_TXN_ID, which every transaction sees), and gives back the
+ * space and the index entries of the tuples whose deletion every transaction sees. It works through the write sets
+ * of the committed transactions in commit order, and runs in the background once StartVacuum() is called.
+ *
+ * Optimistic transactions read like snapshot ones, and record the tuples they read and the scans they run. Commit
+ * validates them backward, against the writes of the transactions committed since they began: a transaction aborts
+ * if one of those wrote a tuple it read, or a version of a tuple one of its scans would read. Validation happens under
+ * the commit mutex, so the optimistic transactions serialize in commit order. A transaction that wrote nothing
+ * serializes at its read timestamp instead, and is not validated.
  */
 class TransactionManager {
  public:
   explicit TransactionManager(LockManager *lock_manager, LogManager *log_manager = nullptr)
       : lock_manager_(lock_manager), log_manager_(log_manager) {}
 
-  ~TransactionManager() = default;
+  ~TransactionManager() { StopVacuum(); }
 
   /**
    * Begins a new transaction.
@@ -46,11 +76,22 @@ class TransactionManager {
     if (txn == nullptr) {
       txn = new Transaction(next_txn_id_++, isolation_level);
     }
+    {
+      std::unique_lock<std::shared_mutex> l(commit_log_mutex_);
+      txn->SetReadTs(last_commit_ts_.load());
+      if (txn->ReadsSnapshot()) {
+        active_read_ts_.insert(txn->GetReadTs());
+      }
+      commit_log_[txn->GetTransactionId()] = INVALID_TS;
+    }
 
     if (enable_logging) {
+      // A checkpoint taken once the record is appended finds the transaction running.
+      std::scoped_lock l(begin_lsns_mutex_);
       LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
       lsn_t lsn = log_manager_->AppendLogRecord(&record);
       txn->SetPrevLSN(lsn);
+      begin_lsns_[txn->GetTransactionId()] = lsn;
     }
 
     std::unique_lock<std::shared_mutex> l(txn_map_mutex_);
@@ -61,8 +102,9 @@ class TransactionManager {
   /**
    * Commits a transaction.
    * @param txn the transaction to commit
+   * @return false if the transaction failed validation under OPTIMISTIC, and was aborted instead
    */
-  void Commit(Transaction *txn);
+  auto Commit(Transaction *txn) -> bool;
 
   /**
    * Aborts a transaction
@@ -70,6 +112,24 @@ class TransactionManager {
    */
   void Abort(Transaction *txn);
 
+  /**
+   * Hand out the transaction ids from `txn_id` on. After recovery, the ids have to stay above the ones of the log and
+   * of the tuples, see LogRecovery::GetNextTxnId().
+   */
+  void SetNextTxnId(txn_id_t txn_id) { next_txn_id_ = txn_id; }
+
+  /** @return the id the next transaction begun gets */
+  auto GetNextTxnId() const -> txn_id_t { return next_txn_id_.load(); }
+
+  /**
+   * @return the transactions whose BEGIN record is logged, and whose COMMIT or ABORT record is not yet, with the LSN
+   * of their BEGIN record, see CheckpointManager
+   */
+  auto GetLoggedTransactions() -> std::vector<std::pair<txn_id_t, lsn_t>> {
+    std::scoped_lock l(begin_lsns_mutex_);
+    return {begin_lsns_.begin(), begin_lsns_.end()};
+  }
+
   /**
    * Global list of running transactions
    */
@@ -91,11 +151,60 @@ class TransactionManager {
     return res;
   }
 
-  /** Prevents all transactions from performing operations, used for checkpointing. */
-  void BlockAllTransactions();
+  /** @return the timestamp of the last commit */
+  auto GetLastCommitTs() const -> timestamp_t { return last_commit_ts_.load(); }
+
+  /**
+   * @return whether `txn` reads the version of a tuple described by `meta`, the one in the table heap. Transactions
+   * not under snapshot isolation always read the newest version.
+   */
+  auto SeesVersion(const Transaction *txn, const TupleMeta &meta) -> bool;
+
+  /**
+   * Find the version of a tuple that `txn` reads in the version chain of the tuple, for a tuple whose version in the
+   * table heap it does not see. Call with the page of the tuple latched.
+   * @return the tuple, std::nullopt if the tuple did not exist yet or was deleted in that version
+   */
+  auto GetVersion(const Transaction *txn, RID rid) -> std::optional<Tuple>;
+
+  /**
+   * Prepare `txn` to overwrite the version of a tuple in the table heap, by saving that version to the version chain
+   * of the tuple unless `txn` wrote it. Call with the page of the tuple write-latched, see TableHeap::WriteCheck.
+   * @param meta the meta of the version in the table heap
+   * @param tuple the tuple of that version
+   * @param rid the rid of the tuple
+   * @return false if the tuple is deleted in that version, and must be left alone
+   * @throws ExecutionException on a write-write conflict, after setting `txn` to ABORTED
+   */
+  auto PrepareWrite(Transaction *txn, const TupleMeta &meta, const Tuple &tuple, RID rid) -> bool;
+
+  /** @return the newest version saved of a tuple, nullptr if there is none */
+  auto GetUndoLog(RID rid) -> std::shared_ptr<const UndoLog>;
+
+  /** @return the oldest read timestamp of the running snapshot transactions, the last commit if there is none */
+  auto GetWatermark() -> timestamp_t;
+
+  /**
+   * Garbage-collect the versions of the tuples written by the transactions committed at or before the watermark,
+   * and forget those transactions.
+   */
+  void Vacuum();
+
+  /** Start running Vacuum() every `vacuum_interval` in a background thread. */
+  void StartVacuum() {
+    enable_vacuum_ = true;
+    vacuum_thread_ = new std::thread(&TransactionManager::RunVacuum, this);
+  }
 
-  /** Resumes all transactions, used for checkpointing. */
-  void ResumeTransactions();
+  /** Stop the background vacuum, waiting for a running Vacuum() to finish. */
+  void StopVacuum() {
+    enable_vacuum_ = false;
+    if (vacuum_thread_ != nullptr) {
+      vacuum_thread_->join();
+      delete vacuum_thread_;
+      vacuum_thread_ = nullptr;
+    }
+  }
 
  private:
   /**
@@ -148,9 +257,90 @@ class TransactionManager {
     }
   }
 
+  /** The writes of a committed transaction, kept until Vacuum() processes them. */
+  struct CommittedWrites {
+    txn_id_t txn_id_;
+    timestamp_t commit_ts_;
+    std::shared_ptr<std::deque<TableWriteRecord>> table_writes_;
+    /** The index entries of the tuples the transaction deleted, with their keys */
+    std::vector<std::tuple<Index *, Tuple, RID>> index_entries_;
+  };
+
+  /** An aborted transaction, kept until no transaction that ran when it aborted is left. */
+  struct AbortedTxn {
+    /** The last commit timestamp when the transaction aborted */
+    timestamp_t last_commit_ts_;
+    txn_id_t txn_id_;
+    /** The tables the transaction updated tuples of in place, which may keep the overwritten overflow chains */
+    std::set<TableHeap *> updated_tables_;
+  };
+
+  /**
+   * Validate an optimistic transaction against the transactions committed since it began. Call with the commit mutex
+   * held.
+   * @return whether none of them wrote what the transaction read
+   */
+  auto Validate(Transaction *txn) -> bool;
+
+  /**
+   * Find the version of a tuple written by the transaction `writer`, in the table heap or in the version chain.
+   * @return the meta and the tuple of the version, std::nullopt if it was overwritten and is not kept anymore
+   */
+  auto FindVersion(txn_id_t writer, TableHeap *table_heap, RID rid) -> std::optional<std::pair<TupleMeta, Tuple>>;
+
+  /** @return the commit timestamp of the transaction `txn_id`, INVALID_TS if it has not committed */
+  auto GetCommitTs(txn_id_t txn_id) -> timestamp_t;
+
+  /** @return whether every running and future transaction sees the versions written by `txn_id` */
+  auto IsVisibleToAll(txn_id_t txn_id, timestamp_t watermark) -> bool;
+
+  /**
+   * Drop the versions from the version chain of a tuple that no transaction reads anymore. Call with the page of the
+   * tuple write-latched.
+   * @param writer the transaction that wrote the version of the tuple in the table heap
+   */
+  void PruneVersionChain(RID rid, txn_id_t writer, timestamp_t watermark);
+
+  /** Garbage-collect the versions written by a committed transaction, see Vacuum(). */
+  void VacuumWrites(const CommittedWrites &writes, timestamp_t watermark);
+
+  /** Runs Vacuum() until StopVacuum() is called. */
+  void RunVacuum();
+
   std::atomic<txn_id_t> next_txn_id_{0};
+
+  /** The LSN of the BEGIN record of each transaction logged and not finished yet */
+  std::unordered_map<txn_id_t, lsn_t> begin_lsns_;
+  std::mutex begin_lsns_mutex_;
+
+  /** Serializes the commits, so that commit timestamps are published in order */
+  std::mutex commit_mutex_;
+  std::atomic<timestamp_t> last_commit_ts_{0};
+  /**
+   * The commit timestamp of every transaction begun, INVALID_TS while it runs or once it aborted, until Vacuum()
+   * forgets it. A transaction not in the log is taken as committed before all others.
+   */
+  std::unordered_map<txn_id_t, timestamp_t> commit_log_;
+  /** The read timestamps of the running snapshot transactions; protected by commit_log_mutex_ */
+  std::multiset<timestamp_t> active_read_ts_;
+  std::shared_mutex commit_log_mutex_;
+
+  /** The writes of the committed transactions not vacuumed yet, in commit order */
+  std::deque<CommittedWrites> committed_writes_;
+  /** The aborted transactions not forgotten yet, in abort order */
+  std::deque<AbortedTxn> aborted_txns_;
+  std::mutex gc_mutex_;
+  /** Serializes the vacuums */
+  std::mutex vacuum_mutex_;
+  std::atomic<bool> enable_vacuum_{false};
+  std::thread *vacuum_thread_{nullptr};
+
+  /** The newest saved version of the tuples that were overwritten, heading their version chains */
+  std::unordered_map<RID, std::shared_ptr<const UndoLog>> version_chains_;
+  std::shared_mutex version_chains_mutex_;
+
   LockManager *lock_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bulk_loader.h
+//
+// Identification: src/include/execution/bulk_loader.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <istream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "common/macros.h"
+#include "concurrency/transaction.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** The input formats of COPY FROM. */
+enum class CopyFormat : uint8_t {
+  /** One record per line, fields separated by a delimiter and optionally quoted. */
+  CSV,
+  /** A concatenation of tuples as written by Tuple::SerializeTo, in the layout of the table's schema. */
+  BINARY,
+};
+
+/** The options of a COPY FROM. */
+struct CopyOptions {
+  CopyFormat format_{CopyFormat::CSV};
+  /** The field separator of CSV */
+  char delimiter_{','};
+  /** The quote character of CSV; a quote inside a quoted field is written twice */
+  char quote_{'"'};
+  /** Whether the first CSV line is a header to skip */
+  bool header_{false};
+  /** The unquoted CSV field that stands for NULL */
+  std::string null_string_;
+};
+
+/**
+ * BulkLoader loads a stream of rows into a table without going through the planner. The calling thread reads the
+ * input in chunks of `copy_chunk_size` bytes cut at record boundaries, and a pool of parser threads turns every chunk
+ * into tuples and writes them into the table pages in batches through TableHeap::InsertTuples.
+ *
+ * The indexes of the table are not maintained row by row: their entries are collected while loading and inserted
+ * in key order once all the rows are in the table.
+ */
+class BulkLoader {
+ public:
+  /**
+   * @param catalog the catalog of the table, which the index write records of the transaction refer to
+   * @param table_info the table to load
+   * @param indexes the indexes of the table
+   * @param txn the loading transaction, which must hold an exclusive lock on the table; may be nullptr
+   * @param options the format of the input
+   * @param num_threads number of parser threads
+   */
+  BulkLoader(Catalog *catalog, const TableInfo *table_info, std::vector<IndexInfo *> indexes, Transaction *txn,
+             CopyOptions options, size_t num_threads);
+
+  DISALLOW_COPY_AND_MOVE(BulkLoader);
+
+  /**
+   * Load every row of `input` into the table. Rows loaded before an error are not removed, but are recorded in the
+   * write set of the transaction.
+   * @return the number of rows loaded
+   */
+  auto Load(std::istream &input) -> size_t;
+
+ private:
+  /** A run of complete records of the input. */
+  struct Chunk {
+    std::string data_;
+    /** The line (CSV) or record (binary) number of the first record in the chunk, counting from 1 */
+    size_t first_record_;
+  };
+
+  /** The rows a parser thread loaded. */
+  struct LoadResult {
+    size_t num_rows_{0};
+    /** The rids of the rows, kept only for the write set of a transaction */
+    std::vector<RID> rids_;
+    /** The entries of every index, in the order of indexes_ */
+    std::vector<std::vector<std::pair<Tuple, RID>>> index_entries_;
+  };
+
+  /**
+   * @return the length of the longest prefix of `buffer` made of complete records; `scanned` and `in_quote` carry the
+   * CSV scan state over calls, so every byte is scanned once
+   */
+  auto CompleteRecords(const std::string &buffer, size_t *scanned, bool *in_quote) const -> size_t;
+
+  /** @return the number of lines (CSV) or records (binary) in the complete records `data` */
+  auto CountRecords(std::string_view data) const -> size_t;
+
+  /** Parse a chunk and insert its rows, flushing every `insert_batch_size` rows. */
+  void LoadChunk(const Chunk &chunk, std::vector<Tuple> *batch, LoadResult *result) const;
+
+  /** Parse one CSV line into a tuple. */
+  auto ParseLine(std::string_view line, size_t line_number, std::vector<Value> *values, std::string *scratch) const
+      -> Tuple;
+
+  /** Parse one CSV field into a value of column `column_idx`. */
+  auto ParseField(std::string_view field, bool quoted, uint32_t column_idx, size_t line_number) const -> Value;
+
+  /** Check that a binary record is a tuple of the table's schema. */
+  void CheckRecord(std::string_view record, size_t record_number) const;
+
+  /** Write a batch of tuples into the table and collect their index entries. */
+  void Flush(std::vector<Tuple> *batch, LoadResult *result) const;
+
+  Catalog *catalog_;
+  const TableInfo *table_info_;
+  std::vector<IndexInfo *> indexes_;
+  Transaction *txn_;
+  CopyOptions options_;
+  size_t num_threads_;
+};
+
+}  // namespace bustub
@@ -12,15 +12,18 @@
 
 #pragma once
 
+#include <functional>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
+#include "common/config.h"
 #include "concurrency/transaction.h"
 #include "concurrency/transaction_manager.h"
 #include "execution/executor_context.h"
 #include "execution/executor_factory.h"
 #include "execution/executors/init_check_executor.h"
+#include "execution/executors/nested_loop_join_executor.h"
 #include "execution/plans/abstract_plan.h"
 #include "storage/table/tuple.h"
 
@@ -43,16 +46,19 @@ class ExecutionEngine {
   DISALLOW_COPY_AND_MOVE(ExecutionEngine);
 
   /**
-   * Execute a query plan.
+   * Execute a query plan, streaming every output tuple to `on_tuple` as soon as the root executor produces it.
+   * The next tuple is only pulled once `on_tuple` returns, so a slow consumer holds the whole pipeline back
+   * instead of letting results pile up in memory.
    * @param plan The query plan to execute
-   * @param result_set The set of tuples produced by executing the plan
+   * @param on_tuple Called for every output tuple; returning `false` stops the execution early
    * @param txn The transaction context in which the query executes
    * @param exec_ctx The executor context in which the query executes
-   * @return `true` if execution of the query plan succeeds, `false` otherwise
+   * @return `true` if execution of the query plan succeeds, `false` otherwise. Tuples streamed before a
+   * failure are not retracted.
    */
   // NOLINTNEXTLINE
-  auto Execute(const AbstractPlanNodeRef &plan, std::vector<Tuple> *result_set, Transaction *txn,
-               ExecutorContext *exec_ctx) -> bool {
+  auto Execute(const AbstractPlanNodeRef &plan, const std::function<bool(const Tuple &)> &on_tuple,
+               Transaction *txn, ExecutorContext *exec_ctx) -> bool {
     BUSTUB_ASSERT((txn == exec_ctx->GetTransaction()), "Broken Invariant");
 
     // Construct the executor for the abstract plan node
@@ -63,42 +69,74 @@ class ExecutionEngine {
 
     try {
       executor->Init();
-      PollExecutor(executor.get(), plan, result_set);
+      PollExecutor(executor.get(), plan, on_tuple);
       PerformChecks(exec_ctx);
     } catch (const ExecutionException &ex) {
       executor_succeeded = false;
-      if (result_set != nullptr) {
-        result_set->clear();
-      }
     }
 
     return executor_succeeded;
   }
 
+  /**
+   * Execute a query plan.
+   * @param plan The query plan to execute
+   * @param result_set The set of tuples produced by executing the plan
+   * @param txn The transaction context in which the query executes
+   * @param exec_ctx The executor context in which the query executes
+   * @return `true` if execution of the query plan succeeds, `false` otherwise
+   */
+  // NOLINTNEXTLINE
+  auto Execute(const AbstractPlanNodeRef &plan, std::vector<Tuple> *result_set, Transaction *txn,
+               ExecutorContext *exec_ctx) -> bool {
+    auto executor_succeeded = Execute(
+        plan,
+        [result_set](const Tuple &tuple) {
+          if (result_set != nullptr) {
+            result_set->push_back(tuple);
+          }
+          return true;
+        },
+        txn, exec_ctx);
+    if (!executor_succeeded && result_set != nullptr) {
+      result_set->clear();
+    }
+    return executor_succeeded;
+  }
+
   void PerformChecks(ExecutorContext *exec_ctx) {
-    for (const auto &[left_executor, right_executor] : exec_ctx->GetNLJCheckExecutorSet()) {
+    for (const auto &[left_executor, right_executor, join_executor] : exec_ctx->GetNLJCheckExecutorSet()) {
       auto casted_left_executor = dynamic_cast<const InitCheckExecutor *>(left_executor);
       auto casted_right_executor = dynamic_cast<const InitCheckExecutor *>(right_executor);
-      BUSTUB_ASSERT(casted_right_executor->GetInitCount() + 1 >= casted_left_executor->GetNextCount(),
-                    "nlj check failed, are you initialising the right executor every time when there is a left tuple? "
+      auto casted_join_executor = dynamic_cast<const NestedLoopJoinExecutor *>(join_executor);
+      // The join rescans its inner side once per block of outer tuples, or scans it only once if it is small
+      // enough to be kept in memory.
+      if (casted_join_executor->IsInnerMaterialized()) {
+        BUSTUB_ASSERT(casted_right_executor->GetInitCount() == 1,
+                      "nlj check failed, the materialized right executor was initialised more than once");
+        continue;
+      }
+      BUSTUB_ASSERT((casted_right_executor->GetInitCount() + 1) * nlj_block_size >=
+                        casted_left_executor->GetNextCount(),
+                    "nlj check failed, are you initialising the right executor for every block of left tuples? "
                     "(off-by-one is okay)");
     }
   }
 
  private:
   /**
-   * Poll the executor until exhausted, or exception escapes.
+   * Poll the executor until exhausted, the consumer stops it, or exception escapes.
    * @param executor The root executor
    * @param plan The plan to execute
-   * @param result_set The tuple result set
+   * @param on_tuple The consumer of the output tuples
    */
   static void PollExecutor(AbstractExecutor *executor, const AbstractPlanNodeRef &plan,
-                           std::vector<Tuple> *result_set) {
+                           const std::function<bool(const Tuple &)> &on_tuple) {
     RID rid{};
     Tuple tuple{};
     while (executor->Next(&tuple, &rid)) {
-      if (result_set != nullptr) {
-        result_set->push_back(tuple);
+      if (!on_tuple(tuple)) {
+        break;
       }
     }
   }
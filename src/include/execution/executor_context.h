@@ -14,6 +14,7 @@
 
 #include <deque>
 #include <memory>
+#include <tuple>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -47,8 +48,8 @@ class ExecutorContext {
         txn_mgr_(txn_mgr),
         lock_mgr_(lock_mgr),
         is_delete_(is_delete) {
-    nlj_check_exec_set_ = std::deque<std::pair<AbstractExecutor *, AbstractExecutor *>>(
-        std::deque<std::pair<AbstractExecutor *, AbstractExecutor *>>{});
+    nlj_check_exec_set_ = std::deque<std::tuple<AbstractExecutor *, AbstractExecutor *, AbstractExecutor *>>(
+        std::deque<std::tuple<AbstractExecutor *, AbstractExecutor *, AbstractExecutor *>>{});
     check_options_ = std::make_shared<CheckOptions>();
   }
 
@@ -74,16 +75,17 @@ class ExecutorContext {
   /** @return the transaction manager */
   auto GetTransactionManager() -> TransactionManager * { return txn_mgr_; }
 
-  /** @return the set of nlj check executors */
-  auto GetNLJCheckExecutorSet() -> std::deque<std::pair<AbstractExecutor *, AbstractExecutor *>> & {
+  /** @return the set of nlj check executors, as (left child, right child, join) */
+  auto GetNLJCheckExecutorSet()
+      -> std::deque<std::tuple<AbstractExecutor *, AbstractExecutor *, AbstractExecutor *>> & {
     return nlj_check_exec_set_;
   }
 
   /** @return the check options */
   auto GetCheckOptions() -> std::shared_ptr<CheckOptions> { return check_options_; }
 
-  void AddCheckExecutor(AbstractExecutor *left_exec, AbstractExecutor *right_exec) {
-    nlj_check_exec_set_.emplace_back(left_exec, right_exec);
+  void AddCheckExecutor(AbstractExecutor *left_exec, AbstractExecutor *right_exec, AbstractExecutor *join_exec) {
+    nlj_check_exec_set_.emplace_back(left_exec, right_exec, join_exec);
   }
 
   void InitCheckOptions(std::shared_ptr<CheckOptions> &&check_options) {
@@ -105,7 +107,7 @@ class ExecutorContext {
   /** The lock manager associated with this executor context */
   LockManager *lock_mgr_;
   /** The set of NLJ check executors associated with this executor context */
-  std::deque<std::pair<AbstractExecutor *, AbstractExecutor *>> nlj_check_exec_set_;
+  std::deque<std::tuple<AbstractExecutor *, AbstractExecutor *, AbstractExecutor *>> nlj_check_exec_set_;
   /** The set of check options associated with this executor context */
   std::shared_ptr<CheckOptions> check_options_;
   bool is_delete_;
@@ -13,15 +13,18 @@
 #pragma once
 
 #include <memory>
-#include <unordered_map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "common/util/hash_util.h"
-#include "container/hash/hash_function.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/executors/seq_scan_executor.h"
 #include "execution/expressions/abstract_expression.h"
+#include "execution/external_sort.h"
 #include "execution/plans/aggregation_plan.h"
 #include "storage/table/tuple.h"
 #include "type/value_factory.h"
@@ -29,124 +32,100 @@
 namespace bustub {
 
 /**
- * A simplified hash table that has all the necessary functionality for aggregations.
+ * A flat, open-addressing hash table for aggregations.
+ *
+ * Group keys are normalized byte strings (see SortKeyEncoder) packed back to back in one arena, and the
+ * group-by values and running aggregates of all groups live in two flat arrays indexed by group id. A lookup
+ * is a single linear probe over the slot array, slots cache part of the hash so that most mismatches never
+ * touch the arena, and a new group costs no allocation of its own.
  */
-class SimpleAggregationHashTable {
+class AggregationHashTable {
  public:
   /**
-   * Construct a new SimpleAggregationHashTable instance.
-   * @param agg_exprs the aggregation expressions
+   * Construct a new AggregationHashTable instance.
    * @param agg_types the types of aggregations
+   * @param num_group_bys the number of group-by values of every group
    */
-  SimpleAggregationHashTable(const std::vector<AbstractExpressionRef> &agg_exprs,
-                             const std::vector<AggregationType> &agg_types)
-      : agg_exprs_{agg_exprs}, agg_types_{agg_types} {}
-
-  /** @return The initial aggregate value for this aggregation executor */
-  auto GenerateInitialAggregateValue() -> AggregateValue {
-    std::vector<Value> values{};
-    for (const auto &agg_type : agg_types_) {
-      switch (agg_type) {
-        case AggregationType::CountStarAggregate:
-          // Count start starts at zero.
-          values.emplace_back(ValueFactory::GetIntegerValue(0));
-          break;
-        case AggregationType::CountAggregate:
-        case AggregationType::SumAggregate:
-        case AggregationType::MinAggregate:
-        case AggregationType::MaxAggregate:
-          // Others starts at null.
-          values.emplace_back(ValueFactory::GetNullValueByType(TypeId::INTEGER));
-          break;
-      }
-    }
-    return {values};
-  }
+  AggregationHashTable(const std::vector<AggregationType> &agg_types, size_t num_group_bys)
+      : agg_types_{agg_types}, num_group_bys_{num_group_bys} {}
 
-  /**
-   * TODO(Student)
-   *
-   * Combines the input into the aggregation result.
-   * @param[out] result The output aggregate value
-   * @param input The input value
-   */
-  void CombineAggregateValues(AggregateValue *result, const AggregateValue &input) {
-    for (uint32_t i = 0; i < agg_exprs_.size(); i++) {
-      switch (agg_types_[i]) {
-        case AggregationType::CountStarAggregate:
-        case AggregationType::CountAggregate:
-        case AggregationType::SumAggregate:
-        case AggregationType::MinAggregate:
-        case AggregationType::MaxAggregate:
-          break;
-      }
-    }
-  }
+  /** @return The initial aggregate values for this aggregation executor */
+  auto GenerateInitialAggregateValue() const -> AggregateValue;
 
   /**
-   * Inserts a value into the hash table and then combines it with the current aggregation.
-   * @param agg_key the key to be inserted
-   * @param agg_val the value to be inserted
+   * Look up a group, inserting it with initial aggregates if it does not exist yet.
+   * @param key the normalized group key
+   * @param hash the hash of the key
+   * @param group_bys the group-by values, only read when the group is inserted
+   * @return the id of the group
    */
-  void InsertCombine(const AggregateKey &agg_key, const AggregateValue &agg_val) {
-    if (ht_.count(agg_key) == 0) {
-      ht_.insert({agg_key, GenerateInitialAggregateValue()});
-    }
-    CombineAggregateValues(&ht_[agg_key], agg_val);
-  }
+  auto FindOrInsert(std::string_view key, hash_t hash, const Value *group_bys) -> size_t;
 
-  /**
-   * Clear the hash table
-   */
-  void Clear() { ht_.clear(); }
+  /** Fold the aggregate inputs of one tuple into a group. */
+  void Combine(size_t group, const std::vector<Value> &inputs);
 
-  /** An iterator over the aggregation hash table */
-  class Iterator {
-   public:
-    /** Creates an iterator for the aggregate map. */
-    explicit Iterator(std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter) : iter_{iter} {}
+  /** Fold partial aggregates, as produced by another table, into a group. */
+  void Merge(size_t group, const Value *partials);
 
-    /** @return The key of the iterator */
-    auto Key() -> const AggregateKey & { return iter_->first; }
+  /** Fold every group of another table into this one. */
+  void MergeTable(const AggregationHashTable &other);
 
-    /** @return The value of the iterator */
-    auto Val() -> const AggregateValue & { return iter_->second; }
+  /** @return the number of groups */
+  auto Size() const -> size_t { return hashes_.size(); }
 
-    /** @return The iterator before it is incremented */
-    auto operator++() -> Iterator & {
-      ++iter_;
-      return *this;
-    }
+  /** @return approximate number of bytes used by the table */
+  auto GetMemoryUsage() const -> size_t {
+    return slots_.capacity() * sizeof(Slot) + key_arena_.capacity() + key_offsets_.capacity() * sizeof(uint32_t) +
+           hashes_.capacity() * sizeof(hash_t) + (group_bys_.capacity() + aggregates_.capacity()) * sizeof(Value);
+  }
 
-    /** @return `true` if both iterators are identical */
-    auto operator==(const Iterator &other) -> bool { return this->iter_ == other.iter_; }
+  auto GetKey(size_t group) const -> std::string_view {
+    return {key_arena_.data() + key_offsets_[group], key_offsets_[group + 1] - key_offsets_[group]};
+  }
+  auto GetHash(size_t group) const -> hash_t { return hashes_[group]; }
+  auto GetGroupBys(size_t group) const -> const Value * { return group_bys_.data() + group * num_group_bys_; }
+  auto GetAggregates(size_t group) const -> const Value * { return aggregates_.data() + group * agg_types_.size(); }
 
-    /** @return `true` if both iterators are different */
-    auto operator!=(const Iterator &other) -> bool { return this->iter_ != other.iter_; }
+  /** Clear the hash table */
+  void Clear();
 
-   private:
-    /** Aggregates map */
-    std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter_;
+ private:
+  /** A slot of the open-addressing array. */
+  struct Slot {
+    uint32_t group_;
+    /** The upper half of the key hash */
+    uint32_t tag_;
   };
+  static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
 
-  /** @return Iterator to the start of the hash table */
-  auto Begin() -> Iterator { return Iterator{ht_.cbegin()}; }
-
-  /** @return Iterator to the end of the hash table */
-  auto End() -> Iterator { return Iterator{ht_.cend()}; }
+  void Grow();
 
- private:
-  /** The hash table is just a map from aggregate keys to aggregate values */
-  std::unordered_map<AggregateKey, AggregateValue> ht_{};
-  /** The aggregate expressions that we have */
-  const std::vector<AbstractExpressionRef> &agg_exprs_;
   /** The types of aggregations that we have */
   const std::vector<AggregationType> &agg_types_;
+  size_t num_group_bys_;
+
+  /** Slot array, its size is always a power of two and at most half full */
+  std::vector<Slot> slots_;
+  /** The keys of all groups, key i is [key_offsets_[i], key_offsets_[i + 1]) */
+  std::string key_arena_;
+  std::vector<uint32_t> key_offsets_{0};
+  std::vector<hash_t> hashes_;
+  /** num_group_bys_ values per group */
+  std::vector<Value> group_bys_;
+  /** agg_types_.size() running aggregates per group */
+  std::vector<Value> aggregates_;
 };
 
 /**
  * AggregationExecutor executes an aggregation operation (e.g. COUNT, SUM, MIN, MAX)
  * over the tuples produced by a child executor.
+ *
+ * Large inputs are aggregated by `aggregation_num_threads` workers into thread-local tables that are merged
+ * at the end. A table that outgrows its share of `aggregation_memory_budget` is spilled as partial aggregates
+ * into hash partitions on temporary pages, and every partition is merged on its own afterwards.
+ *
+ * When the child is a scan of a PAX table and every group-by is a varchar column, the groups are keyed by the
+ * dictionary codes the scan hands out instead of by the values, see SeqScanExecutor::EnableCodes.
  */
 class AggregationExecutor : public AbstractExecutor {
  public:
@@ -176,23 +155,40 @@ class AggregationExecutor : public AbstractExecutor {
   /** Do not use or remove this function, otherwise you will get zero points. */
   auto GetChildExecutor() const -> const AbstractExecutor *;
 
+  /** @return the number of times a table was spilled into partitions since Init, at any depth */
+  auto GetNumSpills() const -> size_t { return num_spills_; }
+
  private:
-  /** @return The tuple as an AggregateKey */
-  auto MakeAggregateKey(const Tuple *tuple) -> AggregateKey {
-    std::vector<Value> keys;
-    for (const auto &expr : plan_->GetGroupBys()) {
-      keys.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
-    }
-    return {keys};
-  }
+  /** Child tuples handed to a worker at once, with their group keys if the child hands out codes. */
+  struct Batch {
+    std::vector<Tuple> tuples_;
+    /** The group key of each tuple, made of the codes of its group-bys; empty if the child hands out no codes */
+    std::vector<std::string> keys_;
+  };
+
+  /** Pull the next child tuple into `batch`. @return `false` if the child has no tuples left */
+  auto NextChild(Batch *batch) -> bool;
+
+  /** Aggregate a batch of child tuples into a table, spilling the table when it outgrows its budget. */
+  void AggregateBatch(const Batch &batch, AggregationHashTable *table, size_t budget);
+
+  /** Aggregate the child with several workers, each owning a thread-local table. */
+  void AggregateParallel(Batch first_batch, size_t num_threads);
+
+  /**
+   * Write every group of `table` as a partial aggregate into the hash partitions of level `depth`, then clear it.
+   * The partitions are created on the first spill.
+   */
+  void SpillTable(AggregationHashTable *table, std::vector<std::unique_ptr<SortRun>> *partitions, size_t depth);
+
+  /**
+   * Merge the partial aggregates of a spilled partition. If they still do not fit in memory they are
+   * partitioned again one level deeper, the new partitions are queued and nullptr is returned.
+   */
+  auto AggregatePartition(const SortRun &run, size_t depth) -> std::unique_ptr<AggregationHashTable>;
 
-  /** @return The tuple as an AggregateValue */
-  auto MakeAggregateValue(const Tuple *tuple) -> AggregateValue {
-    std::vector<Value> vals;
-    for (const auto &expr : plan_->GetAggregates()) {
-      vals.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
-    }
-    return {vals};
+  auto MakeTable() const -> std::unique_ptr<AggregationHashTable> {
+    return std::make_unique<AggregationHashTable>(plan_->GetAggregateTypes(), plan_->GetGroupBys().size());
   }
 
  private:
@@ -200,9 +196,18 @@ class AggregationExecutor : public AbstractExecutor {
   const AggregationPlanNode *plan_;
   /** The child executor that produces tuples over which the aggregation is computed */
   std::unique_ptr<AbstractExecutor> child_;
-  /** Simple aggregation hash table */
-  // TODO(Student): Uncomment SimpleAggregationHashTable aht_;
-  /** Simple aggregation hash table iterator */
-  // TODO(Student): Uncomment SimpleAggregationHashTable::Iterator aht_iterator_;
+  /** The child if it hands out the codes of the group-bys, nullptr otherwise */
+  SeqScanExecutor *coded_child_{nullptr};
+  /** Spill partitions of the first level, shared by all workers and guarded by spill_latch_ */
+  std::vector<std::unique_ptr<SortRun>> partitions_;
+  std::mutex spill_latch_;
+  /** Guarded by spill_latch_ */
+  size_t num_spills_{0};
+  /** Spilled partitions still to be aggregated, with their partitioning depth */
+  std::vector<std::pair<std::unique_ptr<SortRun>, size_t>> pending_;
+  /** The fully aggregated table being emitted */
+  std::unique_ptr<AggregationHashTable> result_;
+  /** Id of the next group of result_ to emit */
+  size_t group_idx_{0};
 };
 }  // namespace bustub
@@ -26,6 +26,11 @@ namespace bustub {
 /**
  * DeletedExecutor executes a delete on a table.
  * Deleted values are always pulled from a child.
+ *
+ * A deleted tuple stays in the table heap, marked deleted by the transaction, and so do its index entries: the
+ * transactions that do not see the deletion still read the tuple, through its version chain. Both are removed by
+ * TransactionManager::Vacuum() once every transaction sees the deletion. Deleting a tuple last
+ * written by a transaction that the deleter does not see aborts the deleter, see TransactionManager::PrepareWrite.
  */
 class DeleteExecutor : public AbstractExecutor {
  public:
@@ -60,5 +65,11 @@ class DeleteExecutor : public AbstractExecutor {
   const DeletePlanNode *plan_;
   /** The child executor from which RIDs for deleted tuples are pulled */
   std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The table deleted from */
+  const TableInfo *table_info_{nullptr};
+  /** The indexes of the table */
+  std::vector<IndexInfo *> indexes_;
+  /** Whether the number of deleted rows was produced */
+  bool done_{false};
 };
 }  // namespace bustub
@@ -18,14 +18,20 @@
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/index_scan_plan.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/page/page_guard.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
  * IndexScanExecutor executes an index scan over a table.
+ *
+ * Like the sequential scan, the filter predicate is evaluated on tuples in place in their table page,
+ * so only tuples that are returned get copied. Under snapshot isolation, the tuples are read as by the
+ * sequential scan, from their version chain when the transaction does not see their version in the page.
+ * Optimistic transactions record the scan and the tuples it produces, as the sequential scan does.
  */
-
 class IndexScanExecutor : public AbstractExecutor {
  public:
   /**
@@ -42,7 +48,31 @@ class IndexScanExecutor : public AbstractExecutor {
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
  private:
+  /** @return whether the filter predicate is true for `tuple` */
+  auto MatchesFilter(const Tuple &tuple) const -> bool;
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+
+  /** The table the index points into */
+  TableHeap *table_heap_{nullptr};
+
+  /** The position of the scan in the index */
+  BPlusTreeIndexIteratorForTwoIntegerColumn iter_;
+
+  /** The table page read last, kept while consecutive index entries point into it */
+  ReadPageGuard page_guard_;
+  /** The tuple read last if the table is PAX, see TableHeap::GetTupleRef */
+  Tuple pax_tuple_;
+
+  /** The transaction of the scan and its manager */
+  Transaction *txn_{nullptr};
+  TransactionManager *txn_mgr_{nullptr};
+  /** Whether the scan reads a snapshot, set if the transaction is under snapshot isolation */
+  bool snapshot_{false};
+  /** Whether the scan records what it reads, set if the transaction is optimistic */
+  bool optimistic_{false};
+  /** Whether the scan was added to the scan set of the transaction already */
+  bool scan_recorded_{false};
 };
 }  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
@@ -25,6 +26,9 @@ namespace bustub {
 /**
  * InsertExecutor executes an insert on a table.
  * Inserted values are always pulled from a child executor.
+ *
+ * Tuples are buffered into batches of `insert_batch_size`. Each batch is written to the table with one latch of
+ * every page it fills, and to each index in key order.
  */
 class InsertExecutor : public AbstractExecutor {
  public:
@@ -55,8 +59,38 @@ class InsertExecutor : public AbstractExecutor {
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
  private:
+  /** Insert the tuples of batch_ into the table and its indexes, then clear it. */
+  void InsertBatch();
+
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
+
+  /** The child executor from which inserted tuples are pulled */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+
+  /** The table inserted into */
+  const TableInfo *table_info_{nullptr};
+
+  /** The indexes of the table */
+  std::vector<IndexInfo *> indexes_;
+
+  /** Whether the child reads the table inserted into, in which case its output is read completely first */
+  bool reads_target_{false};
+
+  /** The lock manager to lock the inserted rows with, nullptr if the transaction takes no locks */
+  LockManager *lock_mgr_{nullptr};
+
+  /** The tuples not inserted yet */
+  std::vector<Tuple> batch_;
+
+  /** The keys and rids of the current batch for one index */
+  std::vector<std::pair<Tuple, RID>> index_entries_;
+
+  /** The number of tuples inserted */
+  int32_t num_inserted_{0};
+
+  /** Whether the count has been produced */
+  bool done_{false};
 };
 
 }  // namespace bustub
@@ -0,0 +1,98 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// merge_join_executor.h
+//
+// Identification: src/include/execution/executors/merge_join_executor.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/merge_join_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * MergeJoinExecutor executes an equi-JOIN over two inputs sorted ascending on their join keys.
+ *
+ * Both inputs are read once. The right tuples sharing the key of the current left tuple are buffered
+ * as a group, so duplicate left keys are joined against the buffered group instead of rescanning the
+ * right input. Tuples with a NULL join key never match.
+ */
+class MergeJoinExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new MergeJoinExecutor instance.
+   * @param exec_ctx The executor context
+   * @param plan The MergeJoin plan to be executed
+   * @param left_child The child executor that produces tuples for the left side of join
+   * @param right_child The child executor that produces tuples for the right side of join
+   */
+  MergeJoinExecutor(ExecutorContext *exec_ctx, const MergeJoinPlanNode *plan,
+                    std::unique_ptr<AbstractExecutor> &&left_child, std::unique_ptr<AbstractExecutor> &&right_child);
+
+  /** Initialize the join */
+  void Init() override;
+
+  /**
+   * Yield the next tuple from the join.
+   * @param[out] tuple The next tuple produced by the join.
+   * @param[out] rid The next tuple RID, not used by merge join.
+   * @return `true` if a tuple was produced, `false` if there are no more tuples.
+   */
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  /** @return The output schema for the join */
+  auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
+
+ private:
+  /** @return negative, zero or positive as `a` sorts before, equal to or after `b` */
+  static auto CompareKeys(const std::vector<Value> &a, const std::vector<Value> &b) -> int;
+
+  static auto HasNull(const std::vector<Value> &keys) -> bool;
+
+  /** Read the next right tuple and its keys into the lookahead. */
+  void AdvanceRight();
+
+  /** Skip the right input up to `keys` and buffer the right tuples equal to it. */
+  void BuildGroup(const std::vector<Value> &keys);
+
+  /** @return the output tuple of the current left tuple joined with `right`, or padded with NULLs if nullptr */
+  auto MakeOutputTuple(const Tuple *right) const -> Tuple;
+
+  /** The MergeJoin plan node to be executed. */
+  const MergeJoinPlanNode *plan_;
+  std::unique_ptr<AbstractExecutor> left_child_;
+  std::unique_ptr<AbstractExecutor> right_child_;
+
+  /** The current left tuple and its keys */
+  Tuple left_tuple_;
+  std::vector<Value> left_keys_;
+  bool left_active_{false};
+  /** Whether the current left tuple matches group_ */
+  bool left_matched_{false};
+
+  /** The next right tuple that is not in group_ yet */
+  Tuple right_tuple_;
+  std::vector<Value> right_keys_;
+  bool right_valid_{false};
+
+  /** The right tuples whose keys equal group_keys_ */
+  std::vector<Tuple> group_;
+  std::vector<Value> group_keys_;
+  /** Position in group_ of the next match of the current left tuple */
+  size_t group_idx_{0};
+};
+
+}  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
@@ -23,7 +24,11 @@
 namespace bustub {
 
 /**
- * NestedLoopJoinExecutor executes a nested-loop JOIN on two tables.
+ * NestedLoopJoinExecutor executes a block nested-loop JOIN on two tables.
+ *
+ * The left (outer) side is read in blocks of `nlj_block_size` tuples and the right (inner) side is scanned
+ * once per block rather than once per outer tuple. An inner side of at most `nlj_inner_materialize_threshold`
+ * tuples is kept in memory during the first scan and never rescanned.
  */
 class NestedLoopJoinExecutor : public AbstractExecutor {
  public:
@@ -52,9 +57,45 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
   /** @return The output schema for the insert */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
+  /** @return `true` if the inner side has been read completely into memory and is not rescanned */
+  auto IsInnerMaterialized() const -> bool { return inner_materialized_; }
+
  private:
+  /** Buffer the next block of outer tuples and rewind the inner side. */
+  auto NextBlock() -> bool;
+
+  /** Read the next inner tuple into inner_tuple_, from the materialized inner side if there is one. */
+  auto NextInner() -> bool;
+
+  /** @return the output tuple of `left` joined with the current inner tuple, or padded with NULLs if not `matched` */
+  auto MakeOutputTuple(const Tuple &left, bool matched) const -> Tuple;
+
   /** The NestedLoopJoin plan node to be executed. */
   const NestedLoopJoinPlanNode *plan_;
+  std::unique_ptr<AbstractExecutor> left_executor_;
+  std::unique_ptr<AbstractExecutor> right_executor_;
+
+  /** The current block of outer tuples and whether each of them matched an inner tuple */
+  std::vector<Tuple> block_;
+  std::vector<bool> block_matched_;
+  /** Position in block_ of the next outer tuple to join with inner_tuple_ */
+  size_t block_idx_{0};
+  /** Whether the left input is exhausted */
+  bool left_done_{false};
+
+  Tuple inner_tuple_;
+  /** Whether inner_tuple_ is valid; once false, the unmatched outer tuples of a LEFT join are emitted */
+  bool inner_valid_{false};
+  /** Position in block_ of the next outer tuple to check for a LEFT join padding */
+  size_t unmatched_idx_{0};
+
+  /** The inner side while it is being read for the first time, as long as it stays below the threshold */
+  std::vector<Tuple> inner_tuples_;
+  /** Whether the first scan of the inner side is in progress and still buffered in inner_tuples_ */
+  bool collecting_inner_{false};
+  /** Whether inner_tuples_ holds the complete inner side */
+  bool inner_materialized_{false};
+  size_t inner_idx_{0};
 };
 
 }  // namespace bustub
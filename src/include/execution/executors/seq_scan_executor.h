@@ -12,17 +12,34 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
 /**
  * The SeqScanExecutor executor executes a sequential table scan.
+ *
+ * Tuples are read in place from the pinned table page and the filter predicate is evaluated on that view,
+ * so only tuples that are returned get copied out of the page. Scans of PAX tables, and scans that output
+ * only some columns, read just those columns and assemble the output tuple from them. Pages whose zone map
+ * proves that the filter predicate cannot hold are skipped without being read. On PAX tables, the
+ * `column = constant` conjuncts of the filter are first evaluated for a whole page on the codes of the
+ * columns, and only the tuples they match are read.
+ *
+ * The scan takes no locks. Under snapshot isolation, a tuple whose version in the page the transaction does not
+ * see is read from its version chain instead, see TransactionManager::GetVersion. Optimistic transactions also record
+ * the scan and the tuples it produces, for validation at commit.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -47,8 +64,103 @@ class SeqScanExecutor : public AbstractExecutor {
   /** @return The output schema for the sequential scan */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
+  /**
+   * Make the scan hand out codes of some varchar output columns with every tuple, see GetCodes(). Call before
+   * Init().
+   * @param output_columns the output columns to hand out codes of
+   * @return false if the scan cannot hand out codes of these columns, e.g. because it does not read a PAX table
+   */
+  auto EnableCodes(const std::vector<uint32_t> &output_columns) -> bool;
+
+  /**
+   * @return the codes of the columns passed to EnableCodes() for the last tuple produced, in that order. Two
+   * tuples of the scan have equal codes exactly if they have equal values in these columns.
+   */
+  auto GetCodes() const -> const std::vector<uint32_t> & { return codes_; }
+
  private:
+  /** Yield the next tuple of a row table by copying it out of the page. */
+  auto NextTuple(Tuple *tuple, RID *rid) -> bool;
+
+  /** Yield the next tuple assembled from the values of column_ids_. */
+  auto NextColumns(Tuple *tuple, RID *rid) -> bool;
+
+  /**
+   * Skip the pages, starting at the current one, whose zones rule out the filter predicate.
+   * @return `true` if the scan has tuples left
+   */
+  auto HasCandidate() -> bool;
+
+  /** @return `false` if the zones of the current page prove that `expr` is not true for any tuple in it */
+  auto MayMatch(const AbstractExpression &expr) const -> bool;
+
+  /** Collect the `column = constant` conjuncts of `expr` into code_filters_. */
+  void CollectCodeFilters(const AbstractExpression &expr);
+
+  /** @return `false` if the codes of the current page prove that the filter predicate is not true for the tuple */
+  auto MatchesCodes() -> bool;
+
+  /** @return the scan record of the scan, matching the table tuples the scan produces */
+  auto MakeScanRecord() const -> ScanRecord;
+
+  /** @return whether the filter predicate is true for `tuple`, a tuple of the output schema */
+  auto MatchesFilter(const Tuple &tuple) const -> bool;
+
+  /**
+   * Compute codes_ for the current tuple, reading the codes of its page if it is the first tuple read from it.
+   * @param in_page whether values_ are those of the version in the page, otherwise they are looked up by value
+   */
+  void ComputeCodes(bool in_page);
+
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
+
+  /** The table being scanned */
+  const TableInfo *table_info_{nullptr};
+
+  /** The table columns to output, empty if whole tuples are copied */
+  std::vector<uint32_t> column_ids_;
+
+  /** The values of column_ids_ of the current tuple */
+  std::vector<Value> values_;
+
+  /** The zone map to prune pages with, nullptr if the scan has no filter or the table has no zone map */
+  const ZoneMap *zone_map_{nullptr};
+
+  /** The zones of the last page checked against the filter */
+  PageZone zone_;
+  page_id_t checked_page_id_{INVALID_PAGE_ID};
+
+  /** The table columns and constants of the `column = constant` conjuncts of the filter, for PAX tables */
+  std::vector<std::pair<uint32_t, Value>> code_filters_;
+
+  /** Whether each slot of the page matches code_filters_ */
+  std::vector<bool> matches_;
+  page_id_t matched_page_id_{INVALID_PAGE_ID};
+
+  /** The output columns passed to EnableCodes() */
+  std::vector<uint32_t> coded_columns_;
+
+  /** The codes of coded_columns_ for the last tuple produced */
+  std::vector<uint32_t> codes_;
+
+  /** The codes of the scan for each distinct value of coded_columns_ seen, null values have code 0 */
+  std::unordered_map<std::string, uint32_t> scan_codes_;
+
+  /** The codes of the scan of each slot of the page, for each column of coded_columns_ */
+  std::vector<std::vector<uint32_t>> page_codes_;
+  page_id_t coded_page_id_{INVALID_PAGE_ID};
+
+  /** The transaction of the scan and its manager */
+  Transaction *txn_{nullptr};
+  TransactionManager *txn_mgr_{nullptr};
+  /** Whether the scan reads a snapshot, set if the transaction is under snapshot isolation */
+  bool snapshot_{false};
+  /** Whether the scan records what it reads, set if the transaction is optimistic */
+  bool optimistic_{false};
+  /** Whether the scan was added to the scan set of the transaction already */
+  bool scan_recorded_{false};
+  /** The position of the scan, nullptr before Init() */
+  std::unique_ptr<TableIterator> iter_;
 };
 }  // namespace bustub
@@ -17,6 +17,7 @@
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/external_sort.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/sort_plan.h"
 #include "storage/table/tuple.h"
@@ -24,7 +25,8 @@
 namespace bustub {
 
 /**
- * The SortExecutor executor executes a sort.
+ * The SortExecutor executor executes a sort. Tuples are buffered up to `sort_memory_budget`
+ * bytes and spilled as sorted runs to temporary pages beyond that, see ExternalSorter.
  */
 class SortExecutor : public AbstractExecutor {
  public:
@@ -52,5 +54,11 @@ class SortExecutor : public AbstractExecutor {
  private:
   /** The sort plan node to be executed */
   const SortPlanNode *plan_;
+  /** The child executor from which tuples are obtained */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  /** Normalizes the ORDER BY values of a tuple into a memcmp-able key */
+  SortKeyEncoder encoder_;
+  /** The sorter, rebuilt on every Init */
+  std::unique_ptr<ExternalSorter> sorter_;
 };
 }  // namespace bustub
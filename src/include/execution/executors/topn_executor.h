@@ -12,12 +12,16 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <queue>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/external_sort.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/topn_plan.h"
 #include "storage/table/tuple.h"
@@ -25,7 +29,8 @@
 namespace bustub {
 
 /**
- * The TopNExecutor executor executes a topn.
+ * The TopNExecutor executor executes a topn. Only the best N tuples are kept in memory, in a
+ * max-heap ordered by their normalized sort key.
  */
 class TopNExecutor : public AbstractExecutor {
  public:
@@ -63,5 +68,13 @@ class TopNExecutor : public AbstractExecutor {
   const TopNPlanNode *plan_;
   /** The child executor from which tuples are obtained */
   std::unique_ptr<AbstractExecutor> child_executor_;
+  /** Normalizes the ORDER BY values of a tuple into a memcmp-able key */
+  SortKeyEncoder encoder_;
+  /** Max-heap of the best N entries seen so far, the worst one on top */
+  std::priority_queue<SortEntry, std::vector<SortEntry>, std::function<bool(const SortEntry &, const SortEntry &)>>
+      top_entries_{[](const SortEntry &a, const SortEntry &b) { return a.key_ < b.key_; }};
+  /** The top entries in output order, filled once the child is drained */
+  std::vector<Tuple> output_;
+  size_t cursor_{0};
 };
 }  // namespace bustub
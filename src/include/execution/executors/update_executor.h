@@ -13,6 +13,7 @@
 #pragma once
 
 #include <memory>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -27,6 +28,11 @@ namespace bustub {
 /**
  * UpdateExecutor executes an update on a table.
  * Updated values are always pulled from a child.
+ *
+ * Tuples are updated in place, after their version is saved to their version chain. A tuple that grows past the
+ * room in its page is deleted and inserted again elsewhere instead. An index entry whose key or rid changes is
+ * moved. Updating a tuple last written by a transaction that the updater does not see
+ * aborts the updater, see TransactionManager::PrepareWrite.
  */
 class UpdateExecutor : public AbstractExecutor {
   friend class UpdatePlanNode;
@@ -58,11 +64,26 @@ class UpdateExecutor : public AbstractExecutor {
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
  private:
+  /** Record a write to the table in the write set of `txn`, if there is one. */
+  void AppendTableWriteRecord(Transaction *txn, RID rid, WType wtype);
+
+  /** Record a write to an index in the write set of `txn`, if there is one; `old_tuple` is for WType::UPDATE. */
+  void AppendIndexWriteRecord(Transaction *txn, const IndexInfo *index_info, RID rid, WType wtype, const Tuple &tuple,
+                              const Tuple &old_tuple = {});
+
   /** The update plan node to be executed */
   const UpdatePlanNode *plan_;
   /** Metadata identifying the table that should be updated */
   const TableInfo *table_info_;
   /** The child executor to obtain value from */
   std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The indexes of the table */
+  std::vector<IndexInfo *> indexes_;
+  /** The lock manager to lock the moved rows with, nullptr if the transaction takes no locks */
+  LockManager *lock_mgr_{nullptr};
+  /** The rids of the tuples moved to another slot, so they are not updated twice */
+  std::unordered_set<RID> moved_;
+  /** Whether the number of updated rows was produced */
+  bool done_{false};
 };
 }  // namespace bustub
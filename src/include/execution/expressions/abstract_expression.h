@@ -54,6 +54,15 @@ class AbstractExpression {
   /** @return The value obtained by evaluating the tuple with the given schema */
   virtual auto Evaluate(const Tuple *tuple, const Schema &schema) const -> Value = 0;
 
+  /**
+   * Returns the value obtained by evaluating a tuple that is only viewed, e.g. in place in a table page.
+   * The default copies the tuple out of the view; expressions override it to read the view directly.
+   */
+  virtual auto Evaluate(const TupleRef &tuple, const Schema &schema) const -> Value {
+    auto copy = tuple.ToTuple();
+    return Evaluate(&copy, schema);
+  }
+
   /**
    * Returns the value obtained by evaluating a JOIN.
    * @param left_tuple The left tuple
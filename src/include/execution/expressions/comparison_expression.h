@@ -42,6 +42,12 @@ class ComparisonExpression : public AbstractExpression {
     return ValueFactory::GetBooleanValue(PerformComparison(lhs, rhs));
   }
 
+  auto Evaluate(const TupleRef &tuple, const Schema &schema) const -> Value override {
+    Value lhs = GetChildAt(0)->Evaluate(tuple, schema);
+    Value rhs = GetChildAt(1)->Evaluate(tuple, schema);
+    return ValueFactory::GetBooleanValue(PerformComparison(lhs, rhs));
+  }
+
   auto EvaluateJoin(const Tuple *left_tuple, const Schema &left_schema, const Tuple *right_tuple,
                     const Schema &right_schema) const -> Value override {
     Value lhs = GetChildAt(0)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
@@ -29,6 +29,8 @@ class ConstantValueExpression : public AbstractExpression {
 
   auto Evaluate(const Tuple *tuple, const Schema &schema) const -> Value override { return val_; }
 
+  auto Evaluate(const TupleRef &tuple, const Schema &schema) const -> Value override { return val_; }
+
   auto EvaluateJoin(const Tuple *left_tuple, const Schema &left_schema, const Tuple *right_tuple,
                     const Schema &right_schema) const -> Value override {
     return val_;
@@ -0,0 +1,204 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort.h
+//
+// Identification: src/include/execution/external_sort.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binder/bound_order_by.h"
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "common/macros.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/page/sort_run_page.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * SortKeyEncoder normalizes the ORDER BY values of a tuple into a binary key whose
+ * memcmp order is the requested sort order, so that sorting and merging compare plain
+ * byte strings instead of dispatching through Value for every comparison.
+ *
+ * Every column is a null marker byte followed by an order-preserving body: integers are
+ * big-endian with the sign bit flipped, decimals use the IEEE-754 total order, and varchars
+ * escape 0x00 and end with a two-byte terminator so that each column encoding is prefix-free.
+ * DESC columns invert every byte of their encoding.
+ */
+class SortKeyEncoder {
+ public:
+  explicit SortKeyEncoder(const std::vector<std::pair<OrderByType, AbstractExpressionRef>> &order_bys)
+      : order_bys_(order_bys) {}
+
+  /** @return the normalized sort key of the tuple */
+  auto Encode(const Tuple &tuple, const Schema &schema) const -> std::string;
+
+  /** Append the normalized form of `value` to `key`. */
+  static void AppendValue(const Value &value, bool descending, std::string *key);
+
+ private:
+  const std::vector<std::pair<OrderByType, AbstractExpressionRef>> &order_bys_;
+};
+
+/** A tuple paired with its normalized sort key. */
+struct SortEntry {
+  std::string key_;
+  Tuple tuple_;
+};
+
+/**
+ * A sorted run spilled to temporary pages through the buffer pool. Only the page being
+ * written is pinned; full pages are unpinned dirty and may be evicted to disk.
+ */
+class SortRun {
+ public:
+  explicit SortRun(BufferPoolManager *bpm) : bpm_(bpm) {}
+
+  ~SortRun() { Release(); }
+
+  DISALLOW_COPY_AND_MOVE(SortRun);
+
+  /** Append an entry at the end of the run. Entries must be appended in sort order. */
+  void Append(const SortEntry &entry);
+
+  /** Unpin the tail page. No entry may be appended afterwards. */
+  void FinishWrite();
+
+  /** Give the pages of this run back to the buffer pool. */
+  void Release();
+
+  /** @return the pages of this run, in order */
+  auto GetPageIds() const -> const std::vector<page_id_t> & { return page_ids_; }
+
+ private:
+  void WriteBytes(const char *src, uint32_t len);
+
+  BufferPoolManager *bpm_;
+  std::vector<page_id_t> page_ids_;
+  /** The pinned page currently being written, nullptr once the run is finished */
+  Page *tail_{nullptr};
+};
+
+/** Reads the entries of a finished SortRun in order, keeping a single page pinned. */
+class SortRunCursor {
+ public:
+  SortRunCursor(BufferPoolManager *bpm, const SortRun *run) : bpm_(bpm), run_(run) {}
+
+  ~SortRunCursor();
+
+  DISALLOW_COPY_AND_MOVE(SortRunCursor);
+
+  /**
+   * Read the next entry of the run.
+   * @param[out] entry the entry read
+   * @return `false` once the run is exhausted
+   */
+  auto Next(SortEntry *entry) -> bool;
+
+ private:
+  auto ReadBytes(char *dst, uint32_t len) -> bool;
+
+  BufferPoolManager *bpm_;
+  const SortRun *run_;
+  /** Index into the run's page list of the pinned page */
+  size_t page_idx_{0};
+  /** Read offset inside the pinned page */
+  uint32_t offset_{0};
+  Page *page_{nullptr};
+  std::vector<char> scratch_;
+};
+
+/**
+ * LoserTree merges k sorted runs. Internal nodes remember the loser of the match played
+ * there, so replacing the winner only replays the matches on its leaf-to-root path:
+ * ceil(log2 k) key comparisons per output entry, versus ~2 log2 k for a binary heap.
+ */
+class LoserTree {
+ public:
+  explicit LoserTree(std::vector<std::unique_ptr<SortRunCursor>> cursors);
+
+  /**
+   * Pop the smallest entry across all runs.
+   * @param[out] entry the entry popped
+   * @return `false` once every run is exhausted
+   */
+  auto Next(SortEntry *entry) -> bool;
+
+ private:
+  /** @return `true` if leaf `a` should be output before leaf `b` */
+  auto Beats(size_t a, size_t b) const -> bool;
+
+  /** Replay the matches from leaf `leaf` up to the root. */
+  void Adjust(size_t leaf);
+
+  std::vector<std::unique_ptr<SortRunCursor>> cursors_;
+  /** Current head entry of every run */
+  std::vector<SortEntry> heads_;
+  /** Whether the run of every leaf is exhausted */
+  std::vector<bool> exhausted_;
+  /** tree_[0] is the overall winner, tree_[1..k-1] the losers of the internal matches */
+  std::vector<size_t> tree_;
+};
+
+/**
+ * ExternalSorter sorts entries under a memory budget. Entries are buffered until the budget
+ * is exceeded, then the buffer is sorted and spilled as a run. If nothing spilled the result
+ * is served from memory; otherwise the runs are merged through loser trees, in multiple
+ * passes when there are more runs than the buffer pool can keep pinned at once.
+ */
+class ExternalSorter {
+ public:
+  /**
+   * @param bpm buffer pool used for the spilled runs; if nullptr the sort never spills
+   * @param memory_budget number of bytes that may be buffered before a run is spilled
+   */
+  ExternalSorter(BufferPoolManager *bpm, size_t memory_budget) : bpm_(bpm), memory_budget_(memory_budget) {}
+
+  DISALLOW_COPY_AND_MOVE(ExternalSorter);
+
+  /** Add an entry to be sorted. */
+  void Add(std::string key, Tuple tuple);
+
+  /** Finish the input. Must be called once before Next. */
+  void Finish();
+
+  /**
+   * @param[out] tuple the next tuple in sort order
+   * @return `false` once all tuples have been produced
+   */
+  auto Next(Tuple *tuple) -> bool;
+
+  /** @return the number of runs spilled to the buffer pool, including merge passes */
+  auto GetNumSpilledRuns() const -> size_t { return num_spilled_runs_; }
+
+ private:
+  void SortBuffer();
+  void SpillBuffer();
+  auto MergeRuns(size_t begin, size_t end) -> std::unique_ptr<LoserTree>;
+
+  BufferPoolManager *bpm_;
+  size_t memory_budget_;
+
+  std::vector<SortEntry> buffer_;
+  size_t buffered_bytes_{0};
+  size_t buffer_cursor_{0};
+
+  std::vector<std::unique_ptr<SortRun>> runs_;
+  size_t num_spilled_runs_{0};
+  /** Declared after runs_ so that its cursors are destroyed before the runs they read */
+  std::unique_ptr<LoserTree> merger_;
+};
+
+}  // namespace bustub
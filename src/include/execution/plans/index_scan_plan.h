@@ -29,9 +29,12 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
    * @param table_oid the identifier of table to be scanned
+   * @param filter_predicate the predicate the scanned tuples must satisfy, nullptr to return all of them
    */
-  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid)
-      : AbstractPlanNode(std::move(output), {}), index_oid_(index_oid) {}
+  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, AbstractExpressionRef filter_predicate = nullptr)
+      : AbstractPlanNode(std::move(output), {}),
+        index_oid_(index_oid),
+        filter_predicate_(std::move(filter_predicate)) {}
 
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
@@ -43,10 +46,14 @@ class IndexScanPlanNode : public AbstractPlanNode {
   /** The table whose tuples should be scanned. */
   index_oid_t index_oid_;
 
-  // Add anything you want here for index lookup
+  /** The predicate to filter in index scan, set by the MergeFilterScan rule */
+  AbstractExpressionRef filter_predicate_;
 
  protected:
   auto PlanNodeToString() const -> std::string override {
+    if (filter_predicate_) {
+      return fmt::format("IndexScan {{ index_oid={}, filter={} }}", index_oid_, filter_predicate_);
+    }
     return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
   }
 };
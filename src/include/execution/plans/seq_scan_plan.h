@@ -15,12 +15,14 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "binder/table_ref/bound_base_table_ref.h"
 #include "catalog/catalog.h"
 #include "catalog/schema.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
+#include "fmt/ranges.h"
 
 namespace bustub {
 
@@ -33,13 +35,16 @@ class SeqScanPlanNode : public AbstractPlanNode {
    * Construct a new SeqScanPlanNode instance.
    * @param output The output schema of this sequential scan plan node
    * @param table_oid The identifier of table to be scanned
+   * @param filter_predicate The predicate the scanned tuples must satisfy, nullptr to return all of them
+   * @param column_ids The table columns to output, in order; empty to output every column
    */
   SeqScanPlanNode(SchemaRef output, table_oid_t table_oid, std::string table_name,
-                  AbstractExpressionRef filter_predicate = nullptr)
+                  AbstractExpressionRef filter_predicate = nullptr, std::vector<uint32_t> column_ids = {})
       : AbstractPlanNode(std::move(output), {}),
         table_oid_{table_oid},
         table_name_(std::move(table_name)),
-        filter_predicate_(std::move(filter_predicate)) {}
+        filter_predicate_(std::move(filter_predicate)),
+        column_ids_(std::move(column_ids)) {}
 
   /** @return The type of the plan node */
   auto GetType() const -> PlanType override { return PlanType::SeqScan; }
@@ -62,12 +67,17 @@ class SeqScanPlanNode : public AbstractPlanNode {
   */
   AbstractExpressionRef filter_predicate_;
 
+  /** The table columns the scan outputs, set by the ColumnPruning rule. The filter predicate is evaluated on
+      the output columns. Empty if the scan outputs every column. */
+  std::vector<uint32_t> column_ids_;
+
  protected:
   auto PlanNodeToString() const -> std::string override {
+    auto columns = column_ids_.empty() ? std::string() : fmt::format(", columns={}", column_ids_);
     if (filter_predicate_) {
-      return fmt::format("SeqScan {{ table={}, filter={} }}", table_name_, filter_predicate_);
+      return fmt::format("SeqScan {{ table={}, filter={}{} }}", table_name_, filter_predicate_, columns);
     }
-    return fmt::format("SeqScan {{ table={} }}", table_name_);
+    return fmt::format("SeqScan {{ table={}{} }}", table_name_, columns);
   }
 };
 
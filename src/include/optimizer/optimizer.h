@@ -48,6 +48,13 @@ class Optimizer {
    */
   auto OptimizeNLJAsHashJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief optimize equi nested loop join into merge join.
+   * A join is merged when a sort on the join keys sits right above it: sorting the inputs replaces that sort. The
+   * inputs are always sorted explicitly, as the B+ tree index cannot be iterated in key order yet.
+   */
+  auto OptimizeNLJAsMergeJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   /**
    * @brief optimize nested loop join into index join.
    */
@@ -87,6 +94,11 @@ class Optimizer {
   auto MatchIndex(const std::string &table_name, uint32_t index_key_idx)
       -> std::optional<std::tuple<index_oid_t, std::string>>;
 
+  /**
+   * @brief make scans of PAX tables below a projection or aggregation read only the columns used above them
+   */
+  auto OptimizeColumnPruning(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   /**
    * @brief optimize sort + limit as top N
    */
@@ -12,6 +12,10 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction_manager.h"
 #include "recovery/log_manager.h"
@@ -19,25 +23,62 @@
 namespace bustub {
 
 /**
- * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily.
+ * CheckpointManager takes fuzzy checkpoints, which bound the log read by recovery without stopping the transactions.
+ *
+ * A checkpoint appends a BEGINCHECKPOINT record, then an ENDCHECKPOINT record with the transactions running and the
+ * dirty page table, each read under the latch guarding it only. Once the end record is on disk, the master record
+ * points recovery at the checkpoint: the analysis pass starts at the oldest of the checkpoint, the BEGIN records of
+ * the transactions running and the recLSNs of the dirty pages, and takes the dirty pages from the checkpoint rather
+ * than from the records before it. The log before that record is not read again, and its disk space is given back.
+ * The records of no transaction, such as the ones of the vacuum, are only kept by the recLSNs: a page enters the dirty
+ * page table before the record changing it is appended, so a checkpoint never finds the record without the page.
+ *
+ * The checkpoint thread writes out, one page at a time, the pages dirty since before the previous checkpoint, so
+ * that the recLSNs, and with them the log kept, move forward from one checkpoint to the next.
  */
 class CheckpointManager {
  public:
   CheckpointManager(TransactionManager *transaction_manager, LogManager *log_manager,
-                    BufferPoolManager *buffer_pool_manager)
+                    BufferPoolManager *buffer_pool_manager, DiskManager *disk_manager)
       : transaction_manager_(transaction_manager),
         log_manager_(log_manager),
-        buffer_pool_manager_(buffer_pool_manager) {}
+        buffer_pool_manager_(buffer_pool_manager),
+        disk_manager_(disk_manager) {}
+
+  ~CheckpointManager() { StopCheckpointThread(); }
+
+  /** Start taking a checkpoint every `checkpoint_interval` in a background thread. */
+  void RunCheckpointThread();
 
-  ~CheckpointManager() = default;
+  /** Stop the checkpoint thread, waiting for a checkpoint being taken to finish. */
+  void StopCheckpointThread();
 
-  void BeginCheckpoint();
-  void EndCheckpoint();
+  /**
+   * Take a checkpoint, see above. Logging must be enabled.
+   * @return the LSN of its BEGINCHECKPOINT record
+   */
+  auto Checkpoint() -> lsn_t;
+
+  /**
+   * Write out the pages whose first change not written out is older than the record `lsn`.
+   * @param lsn the LSN of a record, usually the BEGINCHECKPOINT record of the previous checkpoint
+   */
+  void FlushDirtyPages(lsn_t lsn);
 
  private:
-  TransactionManager *transaction_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** Write out a page of the dirty page table, whose recLSN is `rec_lsn`, forcing the log up to its last change. */
+  void FlushPage(page_id_t page_id, lsn_t rec_lsn);
+
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  DiskManager *disk_manager_;
+
+  /** Protects the flag below, and wakes the checkpoint thread to stop */
+  std::mutex latch_;
+  bool enable_checkpoint_{false};
+  std::condition_variable cv_;
+  std::thread *checkpoint_thread_{nullptr};
 };
 
 }  // namespace bustub
@@ -13,9 +13,15 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
 #include <future>              // NOLINT
-#include <mutex>               // NOLINT
+#include <map>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
@@ -25,50 +31,151 @@ namespace bustub {
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * Records are appended to one of two buffers while the flush thread writes out the other one. An append reserves
+ * its LSN and its bytes in the buffer with one compare-and-swap on append_state_, and copies the record without any
+ * latch; the flush thread switches the buffers the same way, then waits until the records reserved in the old buffer
+ * are copied before writing and syncing it. A transaction committing waits in Flush() until its commit record is on
+ * disk, and wakes the flush thread for it. The commits arriving while the thread syncs a buffer gather in the other
+ * one, so they are made durable together by its next sync: one sync per group of commits rather than per commit.
+ *
+ * Without the flush thread, as during recovery, the appends that fill the buffer and Flush() write it out themselves.
+ *
+ * With enable_log_compression, a buffer is written out as a compressed block: the negated size of the compressed
+ * bytes, the size of the records, then the compressed bytes. A buffer that does not shrink is written as it is. A
+ * record starts with its size, which is positive, so the reader tells the two apart.
+ *
+ * For the checkpoints, the log manager also keeps the dirty page table, the first record changing each page since it
+ * was written out, and the offset in the log file of each buffer written out since it started.
  */
 class LogManager {
  public:
-  explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+  /** The bytes before the compressed bytes of a block, see above */
+  static constexpr int BLOCK_HEADER_SIZE = 2 * sizeof(int32_t);
+
+  explicit LogManager(DiskManager *disk_manager) : persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+    for (int i = 0; i < 2; i++) {
+      buffers_[i] = new char[LOG_BUFFER_SIZE];
+      blocks_[i] = new char[LOG_BUFFER_SIZE];
+    }
   }
 
   ~LogManager() {
-    delete[] log_buffer_;
-    delete[] flush_buffer_;
-    log_buffer_ = nullptr;
-    flush_buffer_ = nullptr;
+    StopFlushThread();
+    for (int i = 0; i < 2; i++) {
+      delete[] buffers_[i];
+      delete[] blocks_[i];
+    }
   }
 
+  /** Set enable_logging and start the flush thread. */
   void RunFlushThread();
+
+  /** Stop the flush thread after it wrote out the records appended, and unset enable_logging. */
   void StopFlushThread();
 
+  /**
+   * Append a record to the log buffer, waiting for the flush thread if the buffer is full.
+   * @param log_record the record, whose LSN is set
+   * @return the LSN of the record
+   */
   auto AppendLogRecord(LogRecord *log_record) -> lsn_t;
 
-  inline auto GetNextLSN() -> lsn_t { return next_lsn_; }
+  /**
+   * Wait until the records up to `lsn` are on disk, waking the flush thread.
+   * @param lsn the LSN of the last record to wait for
+   */
+  void Flush(lsn_t lsn);
+
+  /**
+   * Continue the log after the records found on disk, before appending any record. See LogRecovery.
+   * @param lsn the LSN of the next record appended
+   */
+  void SetNextLSN(lsn_t lsn);
+
+  /**
+   * Note that `page_id` is changed by a record at or after `lsn`, unless an earlier change to the page is not written
+   * out yet. Called with the page latched for writing, before the record is appended.
+   */
+  void MarkDirty(page_id_t page_id, lsn_t lsn);
+
+  /** Note that `page_id` is about to be written out, called with the page latched. */
+  void MarkClean(page_id_t page_id);
+
+  /** @return whether records were appended for changes to `page_id` that are not written out */
+  auto IsDirty(page_id_t page_id) -> bool;
+
+  /** @return the dirty page table: each page with changes not written out, and the LSN of the first change */
+  auto GetDirtyPages() -> std::vector<std::pair<page_id_t, lsn_t>>;
+
+  /**
+   * @param lsn a record on disk, appended since the log manager started
+   * @return the offset in the log file of a record at or shortly before the record `lsn`
+   */
+  auto GetLogOffset(lsn_t lsn) -> int;
+
+  /** Give back the disk space of the records before the record `lsn`, see GetLogOffset(). */
+  void TruncateLog(lsn_t lsn);
+
+  inline auto GetNextLSN() -> lsn_t { return LsnOf(append_state_.load()); }
   inline auto GetPersistentLSN() -> lsn_t { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
-  inline auto GetLogBuffer() -> char * { return log_buffer_; }
+  inline auto GetLogBuffer() -> char * { return buffers_[BufferOf(append_state_.load())]; }
 
  private:
-  // TODO(students): you may add your own member variables
+  /** The bits of append_state_ holding the bytes used in the buffer appended to */
+  static constexpr uint64_t OFFSET_MASK = (uint64_t{1} << 31) - 1;
+  /** The bit of append_state_ telling the buffer appended to */
+  static constexpr uint64_t BUFFER_BIT = uint64_t{1} << 31;
+  /** append_state_ holds the next LSN above its lower 32 bits */
+  static constexpr int LSN_SHIFT = 32;
+
+  static auto LsnOf(uint64_t state) -> lsn_t { return static_cast<lsn_t>(state >> LSN_SHIFT); }
+  static auto BufferOf(uint64_t state) -> int { return (state & BUFFER_BIT) != 0 ? 1 : 0; }
+  static auto OffsetOf(uint64_t state) -> uint64_t { return state & OFFSET_MASK; }
+
+  /** Write `log_record` to `data`, in the layout described in log_record.h. */
+  static void SerializeLogRecord(const LogRecord &log_record, char *data);
+
+  /** Switch the appends to the other buffer, then write out and sync the records appended to this one. */
+  void FlushBuffer();
 
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  /** The next LSN to hand out, the buffer appended to and the bytes reserved in it, see the masks above */
+  std::atomic<uint64_t> append_state_{0};
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
-  char *log_buffer_;
-  char *flush_buffer_;
+  /** The two log buffers, appended to in turn */
+  char *buffers_[2];
+  /** The compressed block of each buffer, written out in its place */
+  char *blocks_[2];
+  /** The bytes of each buffer copied by their appends, so far */
+  std::atomic<uint64_t> filled_[2]{};
 
+  /** Serializes FlushBuffer(), so that a buffer is not switched to while it is still written out */
+  std::mutex flush_latch_;
+  /** Protects the flags below, and the waits for the flush thread */
   std::mutex latch_;
+  /** Whether a transaction waits in Flush() or an append waits for room */
+  bool flush_requested_{false};
+  /** Wakes the flush thread */
+  std::condition_variable cv_;
+  /** Signalled once the buffers are switched, or records are on disk */
+  std::condition_variable flushed_cv_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_{nullptr};
 
-  std::condition_variable cv_;
+  DiskManager *disk_manager_;
+
+  /** The LSN of the first record of each buffer written out, and its offset in the log file, protected by latch_ */
+  std::map<lsn_t, int> buffer_offsets_;
+  /** The bytes of the log file, protected by latch_ */
+  int log_size_{disk_manager_->GetLogSize()};
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  /** Protects the dirty page table */
+  std::mutex dirty_pages_latch_;
+  /** The recLSN of each page with changes not written out */
+  std::unordered_map<page_id_t, lsn_t> dirty_pages_;
 };
 
 }  // namespace bustub
@@ -12,8 +12,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "storage/table/tuple.h"
@@ -23,8 +28,11 @@ namespace bustub {
 enum class LogRecordType {
   INVALID = 0,
   INSERT,
+  /** Changing the meta of a tuple to mark it deleted. */
   MARKDELETE,
+  /** Compacting a table page, which gives back the bytes of the tuples whose deletion is complete. */
   APPLYDELETE,
+  /** Changing the meta of a deleted tuple to mark it live again. */
   ROLLBACKDELETE,
   UPDATE,
   BEGIN,
@@ -32,6 +40,12 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** Changing the meta of a live tuple, keeping it live. */
+  UPDATEMETA,
+  /** The start of a checkpoint, see CheckpointManager. */
+  BEGINCHECKPOINT,
+  /** The end of a checkpoint, with the transactions and the dirty pages at its start. */
+  ENDCHECKPOINT,
 };
 
 /**
@@ -42,21 +56,36 @@ enum class LogRecordType {
  * | size | LSN | transID | prevLSN | LogType |
  *---------------------------------------------
  * For insert type log record
- *---------------------------------------------------------------
- * | HEADER | tuple_rid | tuple_size | tuple_data(char[] array) |
- *---------------------------------------------------------------
- * For delete type (including markdelete, rollbackdelete, applydelete)
- *----------------------------------------------------------------
- * | HEADER | tuple_rid | tuple_size | tuple_data(char[] array) |
- *---------------------------------------------------------------
- * For update type log record
- *-----------------------------------------------------------------------------------
- * | HEADER | tuple_rid | tuple_size | old_tuple_data | tuple_size | new_tuple_data |
- *-----------------------------------------------------------------------------------
+ *---------------------------------------------------------------------------
+ * | HEADER | tuple_rid | tuple_meta | tuple_size | tuple_data(char[] array) |
+ *---------------------------------------------------------------------------
+ * For the types changing the meta of a tuple (markdelete, rollbackdelete, updatemeta)
+ *--------------------------------------------
+ * | HEADER | tuple_rid | old_meta | new_meta |
+ *--------------------------------------------
+ * For update type log record, with the bytes of the tuple that differ between the versions only: the versions share
+ * their first prefix_size and their last suffix_size bytes
+ *---------------------------------------------------------------------------------------------------------------
+ * | HEADER | tuple_rid | old_meta | new_meta | prefix_size | suffix_size | size | old_bytes | size | new_bytes |
+ *---------------------------------------------------------------------------------------------------------------
  * For new page type log record
- *--------------------------
- * | HEADER | prev_page_id |
- *--------------------------
+ *-----------------------------------
+ * | HEADER | prev_page_id | page_id |
+ *-----------------------------------
+ * For applydelete type log record
+ *--------------------
+ * | HEADER | page_id |
+ *--------------------
+ * For endcheckpoint type log record, with the LSN of the BEGIN record of each running transaction and the recLSN of
+ * each dirty page
+ *---------------------------------------------------------------------------------------------
+ * | HEADER | next_txn_id | num_txns | (txn_id, lsn) ... | num_pages | (page_id, rec_lsn) ... |
+ *---------------------------------------------------------------------------------------------
+ *
+ * The records of tuples carry both the versions before and after the change, so a change is redone by writing the
+ * version after it into the page and undone by writing the version before it, however often either is repeated. An
+ * update carries the bytes it changes only, so it is redone to the tuple as it was before it, which the LSN of the
+ * page ensures, and undone to the tuple as it was after it, which is checked.
  */
 class LogRecord {
   friend class LogManager;
@@ -69,33 +98,60 @@ class LogRecord {
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type)
       : size_(HEADER_SIZE), txn_id_(txn_id), prev_lsn_(prev_lsn), log_record_type_(log_record_type) {}
 
-  // constructor for INSERT/DELETE type
-  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &rid, const Tuple &tuple)
-      : txn_id_(txn_id), prev_lsn_(prev_lsn), log_record_type_(log_record_type) {
-    if (log_record_type == LogRecordType::INSERT) {
-      insert_rid_ = rid;
-      insert_tuple_ = tuple;
-    } else {
-      assert(log_record_type == LogRecordType::APPLYDELETE || log_record_type == LogRecordType::MARKDELETE ||
-             log_record_type == LogRecordType::ROLLBACKDELETE);
-      delete_rid_ = rid;
-      delete_tuple_ = tuple;
-    }
+  // constructor for INSERT type
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &rid, const TupleMeta &meta,
+            const Tuple &tuple)
+      : txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(log_record_type),
+        rid_(rid),
+        new_meta_(meta),
+        new_tuple_(tuple) {
+    assert(log_record_type == LogRecordType::INSERT);
+    // calculate log record size
+    size_ = HEADER_SIZE + sizeof(RID) + TUPLE_META_SIZE + sizeof(int32_t) + tuple.GetLength();
+  }
+
+  // constructor for MARKDELETE/ROLLBACKDELETE/UPDATEMETA type
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &rid,
+            const TupleMeta &old_meta, const TupleMeta &new_meta)
+      : txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(log_record_type),
+        rid_(rid),
+        old_meta_(old_meta),
+        new_meta_(new_meta) {
+    assert(log_record_type == LogRecordType::MARKDELETE || log_record_type == LogRecordType::ROLLBACKDELETE ||
+           log_record_type == LogRecordType::UPDATEMETA);
     // calculate log record size
-    size_ = HEADER_SIZE + sizeof(RID) + sizeof(int32_t) + tuple.GetLength();
+    size_ = HEADER_SIZE + sizeof(RID) + 2 * TUPLE_META_SIZE;
   }
 
   // constructor for UPDATE type
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &update_rid,
-            const Tuple &old_tuple, const Tuple &new_tuple)
+            const TupleMeta &old_meta, const Tuple &old_tuple, const TupleMeta &new_meta, const Tuple &new_tuple)
       : txn_id_(txn_id),
         prev_lsn_(prev_lsn),
         log_record_type_(log_record_type),
-        update_rid_(update_rid),
-        old_tuple_(old_tuple),
-        new_tuple_(new_tuple) {
+        rid_(update_rid),
+        old_meta_(old_meta),
+        new_meta_(new_meta) {
+    assert(log_record_type == LogRecordType::UPDATE);
+    auto old_data = old_tuple.GetData();
+    auto new_data = new_tuple.GetData();
+    auto shared_size = std::min(old_tuple.GetLength(), new_tuple.GetLength());
+    while (prefix_size_ < shared_size && old_data[prefix_size_] == new_data[prefix_size_]) {
+      prefix_size_++;
+    }
+    while (prefix_size_ + suffix_size_ < shared_size &&
+           old_data[old_tuple.GetLength() - suffix_size_ - 1] == new_data[new_tuple.GetLength() - suffix_size_ - 1]) {
+      suffix_size_++;
+    }
+    old_bytes_.assign(old_data + prefix_size_, old_data + old_tuple.GetLength() - suffix_size_);
+    new_bytes_.assign(new_data + prefix_size_, new_data + new_tuple.GetLength() - suffix_size_);
     // calculate log record size
-    size_ = HEADER_SIZE + sizeof(RID) + old_tuple.GetLength() + new_tuple.GetLength() + 2 * sizeof(int32_t);
+    size_ = HEADER_SIZE + sizeof(RID) + 2 * TUPLE_META_SIZE + 4 * sizeof(int32_t) + old_bytes_.size() +
+            new_bytes_.size();
   }
 
   // constructor for NEWPAGE type
@@ -110,24 +166,64 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
   }
 
+  // constructor for APPLYDELETE type
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, page_id_t page_id)
+      : size_(HEADER_SIZE + sizeof(page_id_t)),
+        txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(log_record_type),
+        page_id_(page_id) {
+    assert(log_record_type == LogRecordType::APPLYDELETE);
+  }
+
+  // constructor for ENDCHECKPOINT type
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, txn_id_t next_txn_id,
+            std::vector<std::pair<txn_id_t, lsn_t>> active_txns, std::vector<std::pair<page_id_t, lsn_t>> dirty_pages)
+      : txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(log_record_type),
+        next_txn_id_(next_txn_id),
+        active_txns_(std::move(active_txns)),
+        dirty_pages_(std::move(dirty_pages)) {
+    assert(log_record_type == LogRecordType::ENDCHECKPOINT);
+    size_ = HEADER_SIZE + sizeof(txn_id_t) + 2 * sizeof(int32_t) + active_txns_.size() * sizeof(active_txns_[0]) +
+            dirty_pages_.size() * sizeof(dirty_pages_[0]);
+  }
+
   ~LogRecord() = default;
 
-  inline auto GetDeleteTuple() -> Tuple & { return delete_tuple_; }
+  /** @return the type of the record changing the meta of a tuple from `old_meta` to `new_meta` */
+  static auto MetaChangeType(const TupleMeta &old_meta, const TupleMeta &new_meta) -> LogRecordType {
+    if (new_meta.is_deleted_) {
+      return LogRecordType::MARKDELETE;
+    }
+    return old_meta.is_deleted_ ? LogRecordType::ROLLBACKDELETE : LogRecordType::UPDATEMETA;
+  }
 
-  inline auto GetDeleteRID() -> RID & { return delete_rid_; }
+  inline auto GetRID() -> RID & { return rid_; }
 
-  inline auto GetInsertTuple() -> Tuple & { return insert_tuple_; }
+  inline auto GetOldMeta() -> TupleMeta & { return old_meta_; }
 
-  inline auto GetInsertRID() -> RID & { return insert_rid_; }
+  inline auto GetNewMeta() -> TupleMeta & { return new_meta_; }
 
-  inline auto GetOriginalTuple() -> Tuple & { return old_tuple_; }
+  inline auto GetInsertTuple() -> Tuple & { return new_tuple_; }
 
-  inline auto GetUpdateTuple() -> Tuple & { return new_tuple_; }
+  /** @return the version after an update, made from `tuple`; std::nullopt if `tuple` is not the version before it */
+  auto RedoUpdate(const Tuple &tuple) const -> std::optional<Tuple> { return Splice(tuple, old_bytes_, new_bytes_); }
 
-  inline auto GetUpdateRID() -> RID & { return update_rid_; }
+  /** @return the version before an update, made from `tuple`; std::nullopt if `tuple` is not the version after it */
+  auto UndoUpdate(const Tuple &tuple) const -> std::optional<Tuple> { return Splice(tuple, new_bytes_, old_bytes_); }
 
   inline auto GetNewPageRecord() -> page_id_t { return prev_page_id_; }
 
+  inline auto GetPageId() -> page_id_t { return page_id_; }
+
+  inline auto GetNextTxnId() -> txn_id_t { return next_txn_id_; }
+
+  inline auto GetActiveTxns() -> std::vector<std::pair<txn_id_t, lsn_t>> & { return active_txns_; }
+
+  inline auto GetDirtyPages() -> std::vector<std::pair<page_id_t, lsn_t>> & { return dirty_pages_; }
+
   inline auto GetSize() -> int32_t { return size_; }
 
   inline auto GetLSN() -> lsn_t { return lsn_; }
@@ -152,6 +248,23 @@ class LogRecord {
   }
 
  private:
+  /** @return `tuple` with the bytes `from` after the prefix replaced by `to`, if `tuple` has them there */
+  auto Splice(const Tuple &tuple, const std::string &from, const std::string &to) const -> std::optional<Tuple> {
+    if (tuple.GetLength() != prefix_size_ + from.size() + suffix_size_ ||
+        memcmp(tuple.GetData() + prefix_size_, from.data(), from.size()) != 0) {
+      return std::nullopt;
+    }
+    std::string data(sizeof(int32_t), '\0');
+    data.append(tuple.GetData(), prefix_size_);
+    data.append(to);
+    data.append(tuple.GetData() + tuple.GetLength() - suffix_size_, suffix_size_);
+    auto size = static_cast<int32_t>(data.size() - sizeof(int32_t));
+    memcpy(data.data(), &size, sizeof(int32_t));
+    Tuple spliced;
+    spliced.DeserializeFrom(data.data());
+    return spliced;
+  }
+
   // the length of log record(for serialization, in bytes)
   int32_t size_{0};
   // must have fields
@@ -160,22 +273,25 @@ class LogRecord {
   lsn_t prev_lsn_{INVALID_LSN};
   LogRecordType log_record_type_{LogRecordType::INVALID};
 
-  // case1: for delete operation, delete_tuple_ for UNDO operation
-  RID delete_rid_;
-  Tuple delete_tuple_;
-
-  // case2: for insert operation
-  RID insert_rid_;
-  Tuple insert_tuple_;
-
-  // case3: for update operation
-  RID update_rid_;
-  Tuple old_tuple_;
+  // for the operations on a tuple: the tuple, and its versions before and after the operation. Inserts only have
+  // the version after, updates the bytes they change, and the operations on the meta leave the tuple data alone.
+  RID rid_;
+  TupleMeta old_meta_{};
+  TupleMeta new_meta_{};
   Tuple new_tuple_;
+  uint32_t prefix_size_{0};
+  uint32_t suffix_size_{0};
+  std::string old_bytes_;
+  std::string new_bytes_;
 
-  // case4: for new page operation
+  // for the operations on pages
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
+
+  // for the end of a checkpoint
+  txn_id_t next_txn_id_{INVALID_TXN_ID};
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns_;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages_;
   static const int HEADER_SIZE = 20;
 };  // namespace bustub
 
@@ -13,45 +13,110 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
 #include "recovery/log_record.h"
 
 namespace bustub {
 
+class TablePage;
+
 /**
- * Read log file from disk, redo and undo.
+ * Read log file from disk, redo and undo, in the passes of ARIES.
+ *
+ * The analysis pass scans the log once. It finds the transactions that began but neither committed nor aborted, the
+ * losers, with the LSNs of their records, and the dirty page table: the first record of each page changed in the
+ * log. The redo pass repeats history, applying every record of a page past the LSN of the page, whichever transaction
+ * wrote it. The records are handed out to `recovery_num_threads` threads by page id, each applying the records of its
+ * pages in the order of the log, so the pages are rebuilt in parallel. The undo pass writes back the versions before
+ * the changes of the losers, newest first, reading only their records. The table heap logs no prevLSN, so the LSNs
+ * collected by the analysis stand in for the chains.
+ *
+ * With a log manager, the log is continued after the records found, the writes of the undo pass are logged as
+ * records of no transaction, which are only ever redone, and every loser ends with an ABORT record, so that no later
+ * recovery undoes it again.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager = nullptr)
+      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), log_manager_(log_manager) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
+    block_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
   ~LogRecovery() {
     delete[] log_buffer_;
+    delete[] block_buffer_;
     log_buffer_ = nullptr;
+    block_buffer_ = nullptr;
   }
 
+  /** Run the analysis pass, then the redo pass. */
   void Redo();
+
+  /** Run the undo pass, after Redo(). */
   void Undo();
-  auto DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool;
+
+  /**
+   * Read a log record, see log_record.h.
+   * @param data the log from the start of the record
+   * @param size the number of bytes of `data`
+   * @param[out] log_record the record
+   * @return false if `data` does not start with a whole record
+   */
+  auto DeserializeLogRecord(const char *data, int size, LogRecord *log_record) -> bool;
+
+  /** @return an id above the ones of all the transactions in the log, see TransactionManager::SetNextTxnId() */
+  auto GetNextTxnId() const -> txn_id_t { return next_txn_id_; }
 
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** Find the losers and the dirty pages, see above. */
+  void Analyze();
+
+  /**
+   * Read the records of the log in order from `offset` on, until the log ends or `visit` returns false.
+   * @param visit called with each record and its offset, the one of its block if it is compressed; it may move the
+   * record away
+   */
+  void ScanLog(int offset, const std::function<bool(LogRecord *, int)> &visit);
+
+  /** Apply a batch of consecutive records, in parallel by page. */
+  void RedoBatch(std::vector<LogRecord> *batch);
+
+  /** Apply `log_record` to `page`, one of the pages it changes, unless the page reflects it already. */
+  static void RedoRecord(LogRecord *log_record, page_id_t page_id, TablePage *page);
+
+  /** Write back the version before the change of `log_record` to its page. */
+  void UndoRecord(LogRecord *log_record, TablePage *page);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  /** The log manager to continue the log with, nullptr to only read the log */
+  LogManager *log_manager_;
 
-  /** Maintain active transactions and its corresponding latest lsn. */
-  std::unordered_map<txn_id_t, lsn_t> active_txn_;
+  /** Maintain active transactions and the LSNs of their records, oldest first. */
+  std::unordered_map<txn_id_t, std::vector<lsn_t>> active_txn_;
   /** Mapping the log sequence number to log file offset for undos. */
   std::unordered_map<lsn_t, int> lsn_mapping_;
+  /** The dirty page table: the LSN of the first record that may have changed each page since it was written out. */
+  std::unordered_map<page_id_t, lsn_t> dirty_pages_;
 
-  int offset_ __attribute__((__unused__));  // NOLINT
+  /** The offset of the first record the redo pass applies */
+  int offset_{0};
+  /** The LSN after the last record of the log */
+  lsn_t next_lsn_{0};
+  /** The id after the largest id of a transaction in the log */
+  txn_id_t next_txn_id_{0};
   char *log_buffer_;
+  /** The records of a compressed block of the log, see LogManager */
+  char *block_buffer_;
 };
 
 }  // namespace bustub
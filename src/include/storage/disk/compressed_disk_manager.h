@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_disk_manager.h
+//
+// Identification: src/include/storage/disk/compressed_disk_manager.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/** The counters of a CompressedDiskManager. */
+struct PageCompressionStats {
+  /** Number of pages written */
+  uint64_t pages_written_{0};
+  /** Number of pages written uncompressed, because compressing them saved less than a sector */
+  uint64_t pages_stored_raw_{0};
+  /** Bytes of the pages written, BUSTUB_PAGE_SIZE each */
+  uint64_t page_bytes_{0};
+  /** Bytes written to the database file for them, in whole sectors */
+  uint64_t stored_bytes_{0};
+  /** Time spent compressing pages, in nanoseconds */
+  uint64_t compress_ns_{0};
+  /** Time spent decompressing pages, in nanoseconds */
+  uint64_t decompress_ns_{0};
+
+  /** @return how many times smaller the pages are on disk */
+  auto Ratio() const -> double {
+    return stored_bytes_ == 0 ? 1.0 : static_cast<double>(page_bytes_) / static_cast<double>(stored_bytes_);
+  }
+};
+
+/**
+ * CompressedDiskManager compresses every page it writes with CompressionUtil and packs the compressed pages densely
+ * into the database file, in extents of whole sectors. Pages that do not shrink by at least a sector are written as
+ * they are. The buffer pool and everything above it keep seeing pages of BUSTUB_PAGE_SIZE bytes.
+ *
+ * Where a page lives is kept in an indirection table, mirrored in a `.pagemap` file next to the database file: one
+ * entry per page id with the offset and the stored size of its extent. Pages are written copy-on-write: every write
+ * goes to a free extent, and the map entry is switched to it only after the data, so a torn write leaves the entry
+ * pointing at the previous version of the page. The old extent is freed then, and merged with the free extents next
+ * to it. Deallocating a page clears its entry and frees its extent the same way. The free extents are rebuilt from
+ * the map when the file is opened.
+ */
+class CompressedDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes compressed pages to the specified database file.
+   * @param db_file the file name of the database file to write to
+   */
+  explicit CompressedDiskManager(const std::string &db_file);
+
+  /**
+   * Compress a page and write it to the database file.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /**
+   * Read a page from the database file and decompress it.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /**
+   * Clear the entry of a page and free its extent.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id) override;
+
+  /** @return a snapshot of the compression counters */
+  auto GetStats() const -> PageCompressionStats;
+
+  /** @return the bytes of the database file in use, counting the free extents between pages */
+  auto GetDataSize() -> uint64_t;
+
+  /** The unit of allocation in the database file */
+  static constexpr uint64_t SECTOR_SIZE = 512;
+
+ private:
+  static constexpr uint64_t SECTORS_PER_PAGE = BUSTUB_PAGE_SIZE / SECTOR_SIZE;
+
+  /** An entry of the indirection table. */
+  struct PageLocation {
+    /** The offset of the extent in the database file */
+    uint64_t offset_;
+    /** The bytes stored in the extent, BUSTUB_PAGE_SIZE for an uncompressed page, 0 for a page never written */
+    uint32_t size_;
+    uint32_t padding_;
+  };
+
+  static_assert(sizeof(PageLocation) == 16);
+
+  /** @return the number of sectors of an extent storing `size` bytes */
+  static auto NumSectors(uint32_t size) -> uint64_t { return (size + SECTOR_SIZE - 1) / SECTOR_SIZE; }
+
+  /** Read the page map file and rebuild the free extents from it. */
+  void LoadPageMap();
+
+  /** @return the offset of a free extent of `num_sectors` sectors, splitting a larger one or growing the file */
+  auto AllocateExtent(uint64_t num_sectors) -> uint64_t;
+
+  /** Give an extent back, merging it with the free extents around it. */
+  void FreeExtent(uint64_t offset, uint64_t num_sectors);
+
+  std::string map_name_;
+  std::fstream map_io_;
+  /** The indirection table, indexed by page id; protected by db_io_latch_ */
+  std::vector<PageLocation> locations_;
+  /** The number of sectors of every free extent, by offset; protected by db_io_latch_ */
+  std::map<uint64_t, uint64_t> free_extents_;
+  /** The free extents as (number of sectors, offset), to find the smallest that fits; protected by db_io_latch_ */
+  std::set<std::pair<uint64_t, uint64_t>> free_extents_by_size_;
+  /** The end of the last extent; protected by db_io_latch_ */
+  uint64_t file_end_{0};
+
+  std::atomic<uint64_t> pages_written_{0};
+  std::atomic<uint64_t> pages_stored_raw_{0};
+  std::atomic<uint64_t> stored_bytes_{0};
+  std::atomic<uint64_t> compress_ns_{0};
+  std::atomic<uint64_t> decompress_ns_{0};
+};
+
+}  // namespace bustub
@@ -59,7 +59,13 @@ class DiskManager {
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
   /**
-   * Flush the entire log buffer into disk.
+   * Give back the disk space of a page that is not used anymore. Page ids are never handed out again.
+   * @param page_id id of the page
+   */
+  virtual void DeallocatePage(page_id_t page_id);
+
+  /**
+   * Flush the entire log buffer into disk, returning once the log file is synced.
    * @param log_data raw log data
    * @param size size of log entry
    */
@@ -74,6 +80,29 @@ class DiskManager {
    */
   auto ReadLog(char *log_data, int size, int offset) -> bool;
 
+  /** @return the size of the log file, in bytes */
+  auto GetLogSize() -> int;
+
+  /**
+   * Give back the disk space of the log before `offset`, which is not read again. The offsets of the records after it
+   * are left as they are.
+   * @param offset the offset of the first record kept
+   */
+  void TruncateLog(int offset);
+
+  /**
+   * Write the master record, telling recovery the last checkpoint, and return once it is synced.
+   * @param checkpoint_lsn the LSN of the BEGINCHECKPOINT record of the checkpoint
+   * @param offset the offset in the log of the first record recovery reads
+   */
+  void WriteMasterRecord(lsn_t checkpoint_lsn, int offset);
+
+  /**
+   * Read the master record, see WriteMasterRecord().
+   * @return false if no checkpoint was taken since the log was created
+   */
+  auto ReadMasterRecord(lsn_t *checkpoint_lsn, int *offset) -> bool;
+
   /** @return the number of disk flushes */
   auto GetNumFlushes() const -> int;
 
@@ -97,6 +126,10 @@ class DiskManager {
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
+  // file of the master record, next to the log
+  std::string master_name_;
+  // descriptor of the log file, to sync it with
+  int log_fd_{-1};
   // stream to write db file
   std::fstream db_io_;
   std::string file_name_;
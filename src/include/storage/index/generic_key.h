@@ -12,10 +12,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
+#include <string>
 
 #include "storage/table/tuple.h"
 #include "type/value.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -25,14 +28,18 @@ namespace bustub {
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * The key holds the key tuple without its null bitmap, so the fields start at offset 0. A NULL fixed-size field
+ * keeps its type's null value; a NULL varchar reads back as an empty string.
  */
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
+  inline void SetFromKey(const Tuple &tuple, const Schema &key_schema) {
     // intialize to 0
     memset(data_, 0, KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+    auto skip = key_schema.GetNullBitmapSize();
+    memcpy(data_, tuple.GetData() + skip, std::min<size_t>(tuple.GetLength() - skip, KeySize));
   }
 
   // NOTE: for test purpose only
@@ -42,17 +49,20 @@ class GenericKey {
   }
 
   inline auto ToValue(Schema *schema, uint32_t column_idx) const -> Value {
-    const char *data_ptr;
     const auto &col = schema->GetColumn(column_idx);
     const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
+    const auto skip = schema->GetNullBitmapSize();
+    if (col.IsInlined()) {
+      return Value::DeserializeFrom(data_ + col.GetOffset() - skip, column_type);
     }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    // Varchar end offsets are relative to the tuple, which started `skip` bytes earlier.
+    uint32_t begin = col.GetOffset() == schema->GetVarlenOffsetsStart()
+                         ? schema->GetLength()
+                         : *reinterpret_cast<const uint16_t *>(data_ + col.GetOffset() - skip - sizeof(uint16_t));
+    uint32_t end = *reinterpret_cast<const uint16_t *>(data_ + col.GetOffset() - skip);
+    begin = std::min<uint32_t>(begin - skip, KeySize);
+    end = std::min<uint32_t>(end - skip, KeySize);
+    return ValueFactory::GetVarcharValue(std::string(data_ + begin, end - begin));
   }
 
   // NOTE: for test purpose only
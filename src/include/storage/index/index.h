@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -160,6 +161,42 @@ class Index {
    */
   virtual auto InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool = 0;
 
+  /**
+   * Insert a batch of entries into the index. The entries are inserted in key order, so that consecutive
+   * insertions land in the same part of the index.
+   * @param[in,out] entries The keys and RIDs to insert, sorted by key by this call
+   * @param transaction The transaction context
+   * @returns the number of entries inserted
+   */
+  virtual auto InsertEntries(std::vector<std::pair<Tuple, RID>> *entries, Transaction *transaction) -> size_t {
+    const auto *key_schema = GetKeySchema();
+    std::sort(entries->begin(), entries->end(), [key_schema](const auto &lhs, const auto &rhs) {
+      for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+        auto lhs_value = lhs.first.GetValue(key_schema, i);
+        auto rhs_value = rhs.first.GetValue(key_schema, i);
+        if (lhs_value.IsNull() || rhs_value.IsNull()) {
+          // Nulls sort first.
+          if (lhs_value.IsNull() != rhs_value.IsNull()) {
+            return lhs_value.IsNull();
+          }
+          continue;
+        }
+        if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
+          return true;
+        }
+        if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
+          return false;
+        }
+      }
+      return false;
+    });
+    size_t inserted = 0;
+    for (const auto &[key, rid] : *entries) {
+      inserted += InsertEntry(key, rid, transaction) ? 1 : 0;
+    }
+    return inserted;
+  }
+
   /**
    * Delete an index entry by key.
    * @param key The index key
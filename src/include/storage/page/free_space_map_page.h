@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.h
+//
+// Identification: src/include/storage/page/free_space_map_page.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <optional>
+
+#include "common/config.h"
+
+namespace bustub {
+
+static constexpr uint64_t FREE_SPACE_MAP_PAGE_HEADER_SIZE = 8;
+static constexpr uint32_t FREE_SPACE_MAP_PAGE_CAPACITY =
+    (BUSTUB_PAGE_SIZE - FREE_SPACE_MAP_PAGE_HEADER_SIZE) / (sizeof(page_id_t) + sizeof(uint8_t));
+
+/** The free space of a page is recorded in units of this many bytes, rounded down. */
+static constexpr uint32_t FREE_SPACE_UNIT = BUSTUB_PAGE_SIZE / 256;
+
+/**
+ * A page of a free-space map. It records, for up to FREE_SPACE_MAP_PAGE_CAPACITY table pages, roughly how many
+ * bytes are free in each, as a one-byte category of FREE_SPACE_UNIT bytes.
+ *
+ *  Page format (size in bytes):
+ *  ------------------------------------------------------------------------------------------
+ *  | NumEntries (4) | MaxCategory (1) | Unused (3) | PageId[capacity] | Category[capacity] |
+ *  ------------------------------------------------------------------------------------------
+ *
+ * MaxCategory is an upper bound of the categories in the page: it is raised on every update and lowered to the
+ * exact maximum whenever a search of the page fails, so searches can skip pages that cannot satisfy them.
+ */
+class FreeSpaceMapPage {
+ public:
+  /** Initialize an empty page. */
+  void Init() {
+    num_entries_ = 0;
+    max_category_ = 0;
+  }
+
+  /** @return number of table pages recorded in this page */
+  auto GetNumEntries() const -> uint32_t { return num_entries_; }
+
+  /** @return the table page of entry `idx` */
+  auto GetPageId(uint32_t idx) const -> page_id_t { return PageIds()[idx]; }
+
+  /** Record a table page with `free_bytes` free. @return the index of its entry */
+  auto Append(page_id_t page_id, uint32_t free_bytes) -> uint32_t {
+    PageIds()[num_entries_] = page_id;
+    Set(num_entries_, free_bytes);
+    return num_entries_++;
+  }
+
+  /** Set the free space of entry `idx`. */
+  void Set(uint32_t idx, uint32_t free_bytes) {
+    auto category = ToCategory(free_bytes);
+    Categories()[idx] = category;
+    max_category_ = std::max(max_category_, category);
+  }
+
+  /**
+   * Find an entry with at least `needed` bytes free, starting at `start` and wrapping around.
+   * @return the index of the entry, or std::nullopt if no table page of this map page has room
+   */
+  auto Find(uint32_t needed, uint32_t start) const -> std::optional<uint32_t> {
+    auto category = ToNeededCategory(needed);
+    if (!MayFit(needed)) {
+      return std::nullopt;
+    }
+    for (uint32_t i = 0; i < num_entries_; i++) {
+      auto idx = (start + i) % num_entries_;
+      if (Categories()[idx] >= category) {
+        return idx;
+      }
+    }
+    return std::nullopt;
+  }
+
+  /** @return false if no table page of this map page has `needed` bytes free */
+  auto MayFit(uint32_t needed) const -> bool { return num_entries_ > 0 && ToNeededCategory(needed) <= max_category_; }
+
+  /** Lower MaxCategory to the largest category recorded, after a failed Find(). */
+  void RefreshMaxCategory() { max_category_ = *std::max_element(Categories(), Categories() + num_entries_); }
+
+ private:
+  static auto ToCategory(uint32_t free_bytes) -> uint8_t {
+    return std::min<uint32_t>(free_bytes / FREE_SPACE_UNIT, UINT8_MAX);
+  }
+
+  static auto ToNeededCategory(uint32_t needed) -> uint32_t { return (needed + FREE_SPACE_UNIT - 1) / FREE_SPACE_UNIT; }
+
+  auto PageIds() const -> const page_id_t * {
+    return reinterpret_cast<const page_id_t *>(page_start_ + FREE_SPACE_MAP_PAGE_HEADER_SIZE);
+  }
+  auto PageIds() -> page_id_t * { return reinterpret_cast<page_id_t *>(page_start_ + FREE_SPACE_MAP_PAGE_HEADER_SIZE); }
+  auto Categories() const -> const uint8_t * {
+    return reinterpret_cast<const uint8_t *>(PageIds() + FREE_SPACE_MAP_PAGE_CAPACITY);
+  }
+  auto Categories() -> uint8_t * { return reinterpret_cast<uint8_t *>(PageIds() + FREE_SPACE_MAP_PAGE_CAPACITY); }
+
+  char page_start_[0];
+  uint32_t num_entries_;
+  uint8_t max_category_;
+  uint8_t unused_[3];
+};
+
+static_assert(sizeof(FreeSpaceMapPage) == FREE_SPACE_MAP_PAGE_HEADER_SIZE);
+
+}  // namespace bustub
@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_page.h
+//
+// Identification: src/include/storage/page/overflow_page.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/config.h"
+
+namespace bustub {
+
+static constexpr uint64_t OVERFLOW_PAGE_HEADER_SIZE = 8;
+static constexpr uint64_t OVERFLOW_PAGE_DATA_SIZE = BUSTUB_PAGE_SIZE - OVERFLOW_PAGE_HEADER_SIZE;
+
+/**
+ * A page of an out-of-line value, see ToastStore. A value too large to stay in its tuple is cut into a chain of
+ * overflow pages, each of which knows the next one.
+ *
+ *  Page format (size in bytes):
+ *  ---------------------------------------------------------------
+ *  | NextPageId (4) | DataSize (4) | ... DATA ... | (free space) |
+ *  ---------------------------------------------------------------
+ */
+class OverflowPage {
+ public:
+  /** Initialize an empty overflow page that ends its chain. */
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    size_ = 0;
+  }
+
+  /** @return the next page of the chain, INVALID_PAGE_ID for the last one */
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /** @return number of data bytes stored in this page */
+  auto GetSize() const -> uint32_t { return size_; }
+
+  /** @return the data bytes stored in this page */
+  auto GetData() const -> const char * { return data_; }
+
+  /**
+   * Fill the page with as many bytes as fit.
+   * @return the number of bytes actually stored
+   */
+  auto Write(const char *src, uint32_t len) -> uint32_t {
+    size_ = std::min<uint32_t>(len, OVERFLOW_PAGE_DATA_SIZE);
+    memcpy(data_, src, size_);
+    return size_;
+  }
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t size_;
+  char data_[0];
+};
+
+static_assert(sizeof(OverflowPage) == OVERFLOW_PAGE_HEADER_SIZE);
+
+}  // namespace bustub
@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_page.h
+//
+// Identification: src/include/storage/page/pax_table_page.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+static constexpr uint64_t PAX_TABLE_PAGE_HEADER_SIZE = 16;
+
+/** Heap bytes budgeted for each varchar value when deciding how many tuples a PAX page holds. */
+static constexpr uint32_t PAX_VARCHAR_RESERVE = 32;
+
+/** How the minipage of a column is stored. */
+enum class ColumnEncoding : uint8_t {
+  /** `capacity` entries of the column's fixed length */
+  PLAIN = 0,
+  /** Integers stored as bit-packed differences from the smallest one */
+  FRAME_OF_REFERENCE,
+  /** Integers stored as runs of equal values */
+  RUN_LENGTH,
+  /** Varchars stored as bit-packed indexes into the list of the distinct heap offsets */
+  DICTIONARY,
+};
+
+/**
+ * PAX (partition attributes across) page format. A page holds a fixed number of tuples, decided by the
+ * schema, and stores each column contiguously in its own minipage, so a scan touches only the bytes of
+ * the columns it reads:
+ *  ------------------------------------------------------------------------------------------------
+ *  | HEADER | TupleMeta[capacity] | col 0 minipage | col 1 minipage | ... | FREE | VARCHAR HEAP  |
+ *  ------------------------------------------------------------------------------------------------
+ *                                                                               ^
+ *                                                                               heap start
+ *
+ *  Header format (size in bytes):
+ *  ---------------------------------------------------------------------------------------------
+ *  | NextPageId (4) | NumTuples(2) | NumDeletedTuples(2) | Capacity(2) | HeapStart(2) | EncodedColumns(4) |
+ *  ---------------------------------------------------------------------------------------------------
+ *
+ * A minipage holds `capacity` entries of the column's fixed length. A varchar entry is the 4-byte page
+ * offset of the value in the varchar heap, which stores it as | length (4) | bytes |, growing down from
+ * the end of the page. Equal varchars share one heap value, so the heap is the dictionary of the page and
+ * the offsets are codes: tuples with equal codes have equal values. The page does not know its schema:
+ * every accessor takes the table's schema.
+ *
+ * Once a page takes no more tuples it may be sealed, which re-encodes each minipage of the first 32 columns
+ * in place when that makes it smaller, see ColumnEncoding, and zeroes the bytes it no longer needs. Bit i of
+ * EncodedColumns is set if the minipage of column i is encoded, its first byte then tells how. An encoded
+ * minipage starts at the same offset as the plain one, so the layout of the page does not change.
+ */
+class PaxTablePage {
+ public:
+  /** Initialize the page header for tuples of `schema`. */
+  void Init(const Schema &schema);
+
+  /** @return number of tuples in this page */
+  auto GetNumTuples() const -> uint32_t { return num_tuples_; }
+
+  /** @return the page ID of the next table page */
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  /** Set the page id of the next page in the table. */
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /**
+   * Insert a tuple into the page.
+   * @return the slot of the tuple, or std::nullopt if the page is full
+   */
+  auto InsertTuple(const Schema &schema, const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t>;
+
+  /** Update the meta of a tuple. */
+  void UpdateTupleMeta(const TupleMeta &meta, const RID &rid);
+
+  /** Read a tuple, reassembling it from the minipages. */
+  auto GetTuple(const Schema &schema, const RID &rid) const -> std::pair<TupleMeta, Tuple>;
+
+  /** Read a tuple meta. */
+  auto GetTupleMeta(const RID &rid) const -> TupleMeta;
+
+  /** Read one column of a tuple, touching only that column's minipage. */
+  auto GetValue(const Schema &schema, const RID &rid, uint32_t column_idx) const -> Value;
+
+  /** @return whether the heap has room for the varchars of `tuple` that it does not hold yet */
+  auto FitsUpdate(const Schema &schema, const Tuple &tuple) const -> bool;
+
+  /**
+   * Update a tuple in place. A varchar that changes is pointed at an equal value in the heap, or written to
+   * the heap, so an encoded page is decoded first.
+   * @throws Exception if the tuple does not fit into the page, see FitsUpdate()
+   */
+  void UpdateTupleInPlaceUnsafe(const Schema &schema, const TupleMeta &meta, const Tuple &tuple, RID rid);
+
+  /**
+   * Encode each minipage with the encoding that takes the fewest bytes for the tuples in the page. A sealed
+   * page takes no more tuples, so only full pages should be sealed.
+   */
+  void Seal(const Schema &schema);
+
+  /** @return the encoding of the minipage of column `column_idx` */
+  auto GetEncoding(const Schema &schema, uint32_t column_idx) const -> ColumnEncoding;
+
+  /**
+   * Evaluate `column = value` for every tuple in the page on the codes of an integer or varchar column, without
+   * reading the values: the value is looked up in the dictionary once, a run is compared once for all its tuples.
+   * @param[out] matches whether the column of each slot equals `value`, false for nulls
+   * @return false if the comparison cannot be done on the codes of the column, e.g. for a value of another type
+   */
+  auto MatchEqual(const Schema &schema, uint32_t column_idx, const Value &value, std::vector<bool> *matches) const
+      -> bool;
+
+  /**
+   * Read the dictionary codes of a varchar column.
+   * @param[out] codes the index into `dictionary` of the value of each slot
+   * @param[out] dictionary the distinct values of the column in this page
+   * @return false if the column is not a varchar
+   */
+  auto GetCodes(const Schema &schema, uint32_t column_idx, std::vector<uint32_t> *codes,
+                std::vector<Value> *dictionary) const -> bool;
+
+  /** @return how many tuples of `schema` a PAX page holds */
+  static auto ComputeCapacity(const Schema &schema) -> uint16_t;
+
+ private:
+  /** @return the size of one entry in the minipage of `column` */
+  static auto EntrySize(const Column &column) -> uint32_t;
+
+  /** @return the page offset of the entry of `slot` in the minipage of column `column_idx` */
+  auto EntryOffset(const Schema &schema, uint32_t column_idx, uint16_t slot) const -> uint32_t;
+
+  /** @return the serialized value of column `column_idx` of `slot`, whose minipage must be plain */
+  auto ValueData(const Schema &schema, uint32_t column_idx, uint16_t slot) const -> const char *;
+
+  /** @return the value of column `column_idx` of `slot`, decoding it if its minipage is encoded */
+  auto ReadValue(const Schema &schema, uint32_t column_idx, uint16_t slot) const -> Value;
+
+  /** @return the entries of the minipage of column `column_idx` for all tuples, decoded into plain entries */
+  auto DecodeEntries(const Schema &schema, uint32_t column_idx) const -> std::vector<uint64_t>;
+
+  /** @return the heap offset of a varchar equal to `value`, or std::nullopt if the heap has none */
+  auto FindInHeap(const Value &value) const -> std::optional<uint32_t>;
+
+  /** Decode every encoded minipage back to plain entries. */
+  void Unseal(const Schema &schema);
+
+  auto IsEncoded(uint32_t column_idx) const -> bool {
+    return column_idx < 32 && (encoded_columns_ >> column_idx & 1) != 0;
+  }
+
+  auto TupleMetas() const -> const TupleMeta * {
+    return reinterpret_cast<const TupleMeta *>(page_start_ + PAX_TABLE_PAGE_HEADER_SIZE);
+  }
+
+  auto TupleMetas() -> TupleMeta * { return reinterpret_cast<TupleMeta *>(page_start_ + PAX_TABLE_PAGE_HEADER_SIZE); }
+
+  char page_start_[0];
+  page_id_t next_page_id_;
+  uint16_t num_tuples_;
+  uint16_t num_deleted_tuples_;
+  uint16_t capacity_;
+  uint16_t heap_start_;
+  uint32_t encoded_columns_;
+};
+
+static_assert(sizeof(PaxTablePage) == PAX_TABLE_PAGE_HEADER_SIZE);
+
+}  // namespace bustub
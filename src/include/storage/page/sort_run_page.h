@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_run_page.h
+//
+// Identification: src/include/storage/page/sort_run_page.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/config.h"
+
+namespace bustub {
+
+static constexpr uint64_t SORT_RUN_PAGE_HEADER_SIZE = 4;
+static constexpr uint64_t SORT_RUN_PAGE_DATA_SIZE = BUSTUB_PAGE_SIZE - SORT_RUN_PAGE_HEADER_SIZE;
+
+/**
+ * A page of a sorted run spilled by the external sort. A run is a byte stream of
+ * records cut into pages, so a record may straddle two pages. The run itself keeps
+ * the ordered list of its page ids; the page only knows how many bytes it holds.
+ *
+ *  Page format (size in bytes):
+ *  ------------------------------------------------
+ *  | DataSize (4) | ... DATA ... | (free space) |
+ *  ------------------------------------------------
+ */
+class SortRunPage {
+ public:
+  /** Initialize an empty run page. */
+  void Init() { size_ = 0; }
+
+  /** @return number of data bytes stored in this page */
+  auto GetSize() const -> uint32_t { return size_; }
+
+  /** @return number of data bytes that can still be appended */
+  auto GetFreeSpace() const -> uint32_t { return SORT_RUN_PAGE_DATA_SIZE - size_; }
+
+  /**
+   * Append as many bytes as fit into the page.
+   * @return the number of bytes actually appended
+   */
+  auto Append(const char *src, uint32_t len) -> uint32_t {
+    auto n = std::min(len, GetFreeSpace());
+    memcpy(data_ + size_, src, n);
+    size_ += n;
+    return n;
+  }
+
+  /**
+   * Copy up to `len` bytes starting at `offset` out of the page.
+   * @return the number of bytes actually copied
+   */
+  auto Read(uint32_t offset, char *dst, uint32_t len) const -> uint32_t {
+    if (offset >= size_) {
+      return 0;
+    }
+    auto n = std::min(len, size_ - offset);
+    memcpy(dst, data_ + offset, n);
+    return n;
+  }
+
+ private:
+  uint32_t size_;
+  char data_[0];
+};
+
+static_assert(sizeof(SortRunPage) == SORT_RUN_PAGE_HEADER_SIZE);
+
+}  // namespace bustub
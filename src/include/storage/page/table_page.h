@@ -27,7 +27,7 @@
 
 namespace bustub {
 
-static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
+static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 16;
 
 /**
  * Slotted page format:
@@ -38,15 +38,22 @@ static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
  *                                free space pointer
  *
  *  Header format (size in bytes):
- *  ----------------------------------------------------------------------------
- *  | NextPageId (4)| NumTuples(2) | NumDeletedTuples(2) |
- *  ----------------------------------------------------------------------------
+ *  ---------------------------------------------------------------------------------------------------
+ *  | NextPageId (4)| LSN (4) | NumTuples(2) | NumDeletedTuples(2) | TupleStart(2) | NumFreeSlots(2) |
+ *  ---------------------------------------------------------------------------------------------------
  *  ----------------------------------------------------------------
  *  | Tuple_1 offset+size (4) | Tuple_2 offset+size (4) | ... |
  *  ----------------------------------------------------------------
  *
  * Tuple format:
  * | meta | data |
+ *
+ * TupleStart is the free space pointer. Compact() gives back the bytes of tuples whose deletion is complete,
+ * leaving their slots free (deleted, with size 0) for later insertions to reuse, and the bytes left behind by
+ * tuples that grew. The slots of live tuples do not move, so compaction keeps their RIDs.
+ *
+ * The LSN is the one of the last log record of a change to the page, at the offset Page::GetLSN() reads. The
+ * changes are deterministic given the page, so replaying the records past it in order rebuilds the page.
  */
 
 class TablePage {
@@ -65,9 +72,31 @@ class TablePage {
   /** Set the page id of the next page in the table. */
   void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
 
+  /** @return the LSN of the last log record of a change to this page */
+  auto GetLSN() const -> lsn_t { return lsn_; }
+
+  /** Set the LSN of the last log record of a change to this page. */
+  void SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
   /** Get the next offset to insert, return nullopt if this tuple cannot fit in this page */
   auto GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t>;
 
+  /** @return the bytes available to insert a tuple, including the bytes of a new slot */
+  auto GetFreeSpace() const -> uint32_t;
+
+  /** @return the bytes Compact() would give back */
+  auto GetReclaimableSpace() const -> uint32_t;
+
+  /** @return the bytes a tuple takes in a page, including its slot */
+  static auto GetRequiredSpace(const Tuple &tuple) -> uint32_t { return tuple.GetLength() + TUPLE_INFO_SIZE; }
+
+  /**
+   * Give back the bytes of tuples whose deletion is complete (deleted with no deleting transaction), freeing their
+   * slots, and pack the remaining tuples at the end of the page.
+   * @return the number of bytes given back
+   */
+  auto Compact() -> uint32_t;
+
   /**
    * Insert a tuple into the table.
    * @param tuple tuple to insert
@@ -85,24 +114,39 @@ class TablePage {
    */
   auto GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple>;
 
+  /**
+   * Read a tuple from a table without copying it. The returned view points into this page.
+   */
+  auto GetTupleRef(const RID &rid) const -> std::pair<TupleMeta, TupleRef>;
+
   /**
    * Read a tuple meta from a table.
    */
   auto GetTupleMeta(const RID &rid) const -> TupleMeta;
 
+  /** @return whether UpdateTupleInPlaceUnsafe() finds room for `tuple` in the slot `rid`, compacting if it must */
+  auto FitsUpdate(const Tuple &tuple, RID rid) const -> bool;
+
   /**
-   * Update a tuple in place.
+   * Update a tuple in place. A tuple that grows is moved to the free space of the page, keeping its slot; the
+   * bytes it leaves behind are given back by the next Compact(). The page is compacted first if that is the only
+   * way to make room.
+   * @throws Exception if the tuple does not fit into the page, see FitsUpdate()
    */
   void UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid);
 
   static_assert(sizeof(page_id_t) == 4);
+  static_assert(sizeof(lsn_t) == 4);
 
  private:
   using TupleInfo = std::tuple<uint16_t, uint16_t, TupleMeta>;
   char page_start_[0];
   page_id_t next_page_id_;
+  lsn_t lsn_;
   uint16_t num_tuples_;
   uint16_t num_deleted_tuples_;
+  uint16_t tuple_start_;
+  uint16_t num_free_slots_;
   TupleInfo tuple_info_[0];
 
   static constexpr size_t TUPLE_INFO_SIZE = 16;
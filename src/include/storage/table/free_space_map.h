@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/table/free_space_map.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "storage/page/free_space_map_page.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap records roughly how many bytes are free in each page of a table heap, so that inserters can find a
+ * page with room instead of all appending to the last one. The entries live in FreeSpaceMapPages of the buffer pool;
+ * only the list of those pages and the position of each table page are kept in memory.
+ *
+ * The recorded space is a hint: it may be stale in either direction, and the inserter that picks a page corrects
+ * the entry after latching it. Searches start where the previous one stopped, so concurrent inserters spread over
+ * the pages with room.
+ */
+class FreeSpaceMap {
+ public:
+  explicit FreeSpaceMap(BufferPoolManager *bpm) : bpm_(bpm) {}
+
+  /** Record a new table page with `free_bytes` free. */
+  void AddPage(page_id_t page_id, uint32_t free_bytes);
+
+  /** Update the free space recorded for `page_id`. */
+  void Update(page_id_t page_id, uint32_t free_bytes);
+
+  /** @return a table page that has at least `needed` bytes free, std::nullopt if there is none */
+  auto FindPage(uint32_t needed) -> std::optional<page_id_t>;
+
+ private:
+  /** @return the map page and entry index of `page_id` */
+  auto Locate(page_id_t page_id) -> std::pair<page_id_t, uint32_t>;
+
+  BufferPoolManager *bpm_;
+
+  /** Protects map_pages_ and entries_ */
+  std::mutex latch_;
+  /** The pages of the map, in order */
+  std::vector<page_id_t> map_pages_;
+  /** The entry index of every table page, entry i lives in map page i / FREE_SPACE_MAP_PAGE_CAPACITY */
+  std::unordered_map<page_id_t, uint32_t> entries_;
+
+  /** The entry after the last one handed out, where the next search starts */
+  std::atomic<uint32_t> next_entry_{0};
+};
+
+}  // namespace bustub
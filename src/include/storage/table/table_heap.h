@@ -12,47 +12,104 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
 #include "recovery/log_manager.h"
+#include "storage/page/pax_table_page.h"
 #include "storage/page/table_page.h"
+#include "storage/table/free_space_map.h"
 #include "storage/table/table_iterator.h"
+#include "storage/table/toast_store.h"
 #include "storage/table/tuple.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
+class TablePage;
+
+/** The layout of the pages of a table heap */
+enum class TableStorage {
+  /** Slotted pages storing whole tuples, see TablePage */
+  ROW,
+  /** Pages storing each column in its own minipage, see PaxTablePage */
+  PAX,
+};
+
 /**
  * TableHeap represents a physical table on disk.
  * This is just a doubly-linked list of pages.
+ *
+ * Row tables also keep a free-space map of their pages. Insertions go to any page the map says has room, so
+ * concurrent inserters work on different pages and the space of completed deletions is reused; the last page is
+ * only extended when no page has room. PAX tables only insert into their last page, and seal it when they append the
+ * next one, see PaxTablePage::Seal.
+ *
+ * With a log manager and logging enabled, every change to a row page is logged while the page is latched, and the
+ * page is stamped with the LSN of its record, see LogRecovery. The records are attributed to the transaction that
+ * wrote the version of the tuple after the change, and carry no prevLSN. PAX pages and overflow pages are not logged.
  */
 class TableHeap {
   friend class TableIterator;
 
  public:
+  /**
+   * Called with the current meta and tuple of a tuple, while its page is write-latched, before the tuple is
+   * overwritten. Returns false to leave the tuple alone.
+   */
+  using WriteCheck = std::function<bool(const TupleMeta &meta, const Tuple &tuple, RID rid)>;
+
   ~TableHeap() = default;
 
   /**
    * Create a table heap without a transaction. (open table)
    * @param buffer_pool_manager the buffer pool manager
-   * @param first_page_id the id of the first page
+   * @param log_manager the log manager to log the changes to the pages with, nullptr to not log them
+   */
+  explicit TableHeap(BufferPoolManager *bpm, LogManager *log_manager = nullptr);
+
+  /**
+   * Create a table heap with the given page layout.
+   * @param buffer_pool_manager the buffer pool manager
+   * @param schema the schema of the tuples in the table, PAX pages are laid out by column and zone maps are kept
+   * for its fixed-length columns
+   * @param storage the page layout
+   * @param log_manager the log manager to log the changes to the pages with, nullptr to not log them
    */
-  explicit TableHeap(BufferPoolManager *bpm);
+  TableHeap(BufferPoolManager *bpm, const Schema &schema, TableStorage storage, LogManager *log_manager = nullptr);
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return std::nullopt.
+   * Insert a tuple into the table. Row tables created with a schema move the largest varchars of a tuple to
+   * overflow pages when the tuple takes more than `toast_tuple_threshold` bytes, see ToastStore. If the tuple is
+   * still too large (>= page_size), return std::nullopt. With `lock_mgr`, the tuple is locked exclusively for `txn`
+   * before it is unlatched; if it cannot be, it is deleted again and the transaction aborted.
    * @param meta tuple meta
    * @param tuple tuple to insert
    * @return rid of the inserted tuple
+   * @throws ExecutionException if the tuple cannot be locked
    */
   auto InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr = nullptr,
                    Transaction *txn = nullptr, table_oid_t oid = 0) -> std::optional<RID>;
 
+  /**
+   * Insert a batch of tuples into the table. Each page is latched once for all the tuples that fit into it. The tuples
+   * are locked as by InsertTuple(), and all of them are deleted again if one cannot be.
+   * @param meta tuple meta of every tuple
+   * @param tuples tuples to insert
+   * @return the rids of the inserted tuples, in the order of `tuples`
+   * @throws ExecutionException if a tuple cannot be locked
+   */
+  auto InsertTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples, LockManager *lock_mgr = nullptr,
+                    Transaction *txn = nullptr, table_oid_t oid = 0) -> std::vector<RID>;
+
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
    * @param meta new tuple meta
@@ -60,6 +117,15 @@ class TableHeap {
    */
   void UpdateTupleMeta(const TupleMeta &meta, RID rid);
 
+  /**
+   * Update the meta of a tuple if `check` accepts its current version, atomically with the check.
+   * @param meta new tuple meta
+   * @param rid the rid of the tuple to be updated
+   * @param check the check of the current version, nullptr to always update
+   * @return whether the tuple was updated
+   */
+  auto UpdateTupleMeta(const TupleMeta &meta, RID rid, const WriteCheck &check) -> bool;
+
   /**
    * Read a tuple from the table.
    * @param rid rid of the tuple to read
@@ -67,6 +133,52 @@ class TableHeap {
    */
   auto GetTuple(RID rid) -> std::pair<TupleMeta, Tuple>;
 
+  /**
+   * Read a tuple from the table without copying it.
+   * @param rid rid of the tuple to read
+   * @param[in,out] guard the guard of the page to read from. It is reused if it already guards the page of `rid`,
+   * and replaced otherwise. The returned view is only valid until the guard is dropped or replaced.
+   * @param[out] pax_tuple PAX pages do not store a tuple contiguously, so it is assembled here and the view points
+   * into it instead, valid until `pax_tuple` is modified. Unused for row tables.
+   * @return the meta and a view of the tuple in the page
+   */
+  auto GetTupleRef(RID rid, ReadPageGuard *guard, Tuple *pax_tuple) -> std::pair<TupleMeta, TupleRef>;
+
+  /**
+   * Read some columns of a tuple of a PAX table, touching only the minipages of those columns.
+   * @param rid rid of the tuple to read
+   * @param column_ids the columns to read
+   * @param[in,out] guard the guard of the page to read from, reused and replaced as in GetTupleRef
+   * @param[out] values the values of `column_ids`, in that order
+   * @return the meta of the tuple
+   */
+  auto GetValues(RID rid, const std::vector<uint32_t> &column_ids, ReadPageGuard *guard, std::vector<Value> *values)
+      -> TupleMeta;
+
+  /**
+   * Evaluate `column = value` on the codes of a column of a page of a PAX table, see PaxTablePage::MatchEqual.
+   * @param page_id the page to evaluate the comparison for
+   * @param column_idx the column to compare
+   * @param value the value to compare with
+   * @param[in,out] guard the guard of the page to read from, reused and replaced as in GetTupleRef
+   * @param[out] matches whether the column of each slot of the page equals `value`
+   * @return false if the comparison cannot be done on the codes of the column
+   */
+  auto MatchEqual(page_id_t page_id, uint32_t column_idx, const Value &value, ReadPageGuard *guard,
+                  std::vector<bool> *matches) -> bool;
+
+  /**
+   * Read the dictionary codes of a varchar column of a page of a PAX table, see PaxTablePage::GetCodes.
+   * @param page_id the page to read the codes of
+   * @param column_idx the column to read the codes of
+   * @param[in,out] guard the guard of the page to read from, reused and replaced as in GetTupleRef
+   * @param[out] codes the index into `dictionary` of the value of each slot of the page
+   * @param[out] dictionary the distinct values of the column in the page
+   * @return false if the column has no dictionary codes
+   */
+  auto GetCodes(page_id_t page_id, uint32_t column_idx, ReadPageGuard *guard, std::vector<uint32_t> *codes,
+                std::vector<Value> *dictionary) -> bool;
+
   /**
    * Read a tuple meta from the table. Note: if you want to get tuple and meta together, use `GetTuple` insead
    * to ensure atomicity.
@@ -75,6 +187,14 @@ class TableHeap {
    */
   auto GetTupleMeta(RID rid) -> TupleMeta;
 
+  /**
+   * Read a tuple meta from the table.
+   * @param rid rid of the tuple to read
+   * @param[in,out] guard the guard of the page to read from, reused and replaced as in GetTupleRef
+   * @return the meta
+   */
+  auto GetTupleMeta(RID rid, ReadPageGuard *guard) -> TupleMeta;
+
   /** @return the iterator of this table, use this for project 3 */
   auto MakeIterator() -> TableIterator;
 
@@ -84,6 +204,12 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /** @return the page layout of this table */
+  inline auto GetStorage() const -> TableStorage { return storage_; }
+
+  /** @return the zone map of this table, nullptr if the table was created without a schema */
+  inline auto GetZoneMap() const -> const ZoneMap * { return zone_map_.get(); }
+
   /**
    * Update a tuple in place. SHOULD NOT BE USED UNLESS YOU WANT TO OPTIMIZE FOR PROJECT 4.
    * @param meta new tuple meta
@@ -92,12 +218,121 @@ class TableHeap {
    */
   void UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid);
 
+  /**
+   * Give back the bytes a tuple kept past its values for the version it replaced, see UpdateTupleInPlace(). Only
+   * frozen tuples are trimmed, as nobody restores the version before them anymore.
+   * @param rid the rid of the tuple
+   */
+  void TrimTuple(RID rid);
+
+  /**
+   * Give back the space of the tuples in a page whose deletion is complete, see TablePage::Compact(), and report it
+   * to the free space map. PAX pages keep their deleted tuples.
+   * @param page_id the page of the table to compact
+   */
+  void CompactPage(page_id_t page_id);
+
+  /**
+   * Update a tuple in place if `check` accepts its current version, atomically with the check. A tuple that no
+   * longer fits into its page is left alone without calling `check`; the caller has to move it elsewhere. A version
+   * written by a transaction keeps the bytes of the version it replaces, so that the update can be undone in place,
+   * until TrimTuple().
+   * @param meta new tuple meta
+   * @param tuple new tuple
+   * @param rid the rid of the tuple to be updated
+   * @param check the check of the current version, nullptr to always update
+   * @return whether the tuple was updated
+   */
+  auto UpdateTupleInPlace(const TupleMeta &meta, const Tuple &tuple, RID rid, const WriteCheck &check) -> bool;
+
+  /**
+   * Free the overflow chains of the versions overwritten in place by the transactions nobody reads the old versions
+   * of anymore. A version overwritten by a transaction stays readable by the transactions that began before it
+   * committed, so its chains outlive the update until the vacuum calls this.
+   * @param can_free whether the versions overwritten by a transaction are read by no running or future transaction
+   */
+  void FreeRetiredChains(const std::function<bool(txn_id_t)> &can_free);
+
  private:
+  /** Initialize a new page of this table. */
+  void InitPage(char *data);
+
+  /** @return the number of tuples in a page of this table */
+  auto GetNumTuples(const char *data) const -> uint32_t;
+
+  /** @return the meta and tuple `rid` of a latched page of this table */
+  auto ReadTuple(const char *data, RID rid) const -> std::pair<TupleMeta, Tuple>;
+
+  /** @return the next page id stored in a page of this table */
+  auto GetNextPageId(const char *data) const -> page_id_t;
+
+  /** Insert a tuple into a page the free-space map says has room. @return std::nullopt if no page has room */
+  auto InsertIntoFreeSpace(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr, Transaction *txn,
+                           table_oid_t oid) -> std::optional<RID>;
+
+  /**
+   * Insert tuples[next], tuples[next + 1], ... into a latched page until one does not fit, appending their rids to
+   * `rids`.
+   * @return the index of the first tuple not inserted
+   */
+  auto FillPage(page_id_t page_id, char *data, const TupleMeta &meta, const std::vector<Tuple> &tuples, size_t next,
+                std::vector<RID> *rids) -> size_t;
+
+  /** Encode the minipages of a PAX page the table no longer inserts into, if `pax_column_encoding` is set. */
+  void SealPage(char *data);
+
+  /** Record the space that can be reused in a row page, including the space of completed deletions. */
+  void UpdateFreeSpace(page_id_t page_id, const TablePage *page);
+
+  /** @return whether the changes to the pages are logged */
+  auto IsLogging() const -> bool {
+    return log_manager_ != nullptr && enable_logging && storage_ == TableStorage::ROW;
+  }
+
+  /**
+   * Append `record` of a change to the latched row page `page` to the log, stamp the page with its LSN, and enter the
+   * page into the dirty page table.
+   */
+  void Log(LogRecord *record, page_id_t page_id, TablePage *page);
+
+  /** Compact a latched row page, see TablePage::Compact(), logging it. */
+  void Compact(page_id_t page_id, TablePage *page);
+
+  /**
+   * Delete the tuples `txn` inserted but could not lock, which it has no write records of for the abort to undo, and
+   * abort it. Call with none of their pages latched.
+   * @throws ExecutionException always
+   */
+  [[noreturn]] void AbandonInsertedTuples(const std::vector<RID> &rids, Transaction *txn);
+
+  /** Insert a tuple into a latched row page, logging it. */
+  auto InsertIntoPage(page_id_t page_id, TablePage *page, const TupleMeta &meta, const Tuple &tuple)
+      -> std::optional<uint16_t>;
+
+  /** Initialize the page `page_id` appended after the latched page `prev_page_id`, logging it for row tables. */
+  void InitNewPage(page_id_t prev_page_id, char *prev_data, page_id_t page_id, char *data);
+
   BufferPoolManager *bpm_;
+  /** The log manager to log the changes to row pages with, nullptr if they are not logged */
+  LogManager *log_manager_;
   page_id_t first_page_id_{INVALID_PAGE_ID};
 
+  TableStorage storage_{TableStorage::ROW};
+  /** The schema of the tuples, nullptr if the table was created without one */
+  std::unique_ptr<const Schema> schema_;
+  /** The per-page summaries of the tuples, nullptr if the table was created without a schema */
+  std::unique_ptr<ZoneMap> zone_map_;
+  /** The free space of every page, nullptr for PAX tables */
+  std::unique_ptr<FreeSpaceMap> fsm_;
+  /** The out-of-line varchars of the tuples, nullptr for PAX tables and tables created without a schema */
+  std::unique_ptr<ToastStore> toast_;
+
   std::mutex latch_;
   page_id_t last_page_id_{INVALID_PAGE_ID}; /* protected by latch_ */
+
+  /** The chains of the versions overwritten in place, with the transaction that overwrote them */
+  std::vector<std::pair<txn_id_t, ToastPointer>> retired_chains_;
+  std::mutex retired_chains_latch_;
 };
 
 }  // namespace bustub
@@ -15,10 +15,12 @@
 #include <cassert>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "common/macros.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
+#include "storage/page/page_guard.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -41,6 +43,51 @@ class TableIterator {
 
   auto GetTuple() -> std::pair<TupleMeta, Tuple>;
 
+  /**
+   * Read the current tuple without copying it. The page of the tuple stays read-latched, and the view valid,
+   * until the iterator moves to another page, ReleasePage() is called or the iterator is destroyed. Do not
+   * modify the table while the page is held. Tuples of PAX tables are copied out of the page, and their view is
+   * only valid until the next GetTupleRef().
+   */
+  auto GetTupleRef() -> std::pair<TupleMeta, TupleRef>;
+
+  /** Read the meta of the current tuple. The page is held as by GetTupleRef(). */
+  auto GetTupleMeta() -> TupleMeta;
+
+  /**
+   * Read some columns of the current tuple of a PAX table. The page is held as by GetTupleRef().
+   * @param column_ids the columns to read
+   * @param[out] values the values of `column_ids`, in that order
+   * @return the meta of the tuple
+   */
+  auto GetValues(const std::vector<uint32_t> &column_ids, std::vector<Value> *values) -> TupleMeta;
+
+  /**
+   * Evaluate `column = value` for every tuple in the current page of a PAX table on the codes of the column. The
+   * page is held as by GetTupleRef().
+   * @param[out] matches whether the column of each slot of the page equals `value`
+   * @return false if the comparison cannot be done on the codes of the column
+   */
+  auto MatchEqual(uint32_t column_idx, const Value &value, std::vector<bool> *matches) -> bool;
+
+  /**
+   * Read the dictionary codes of a varchar column for every tuple in the current page of a PAX table. The page is
+   * held as by GetTupleRef().
+   * @param[out] codes the index into `dictionary` of the value of each slot of the page
+   * @param[out] dictionary the distinct values of the column in the page
+   * @return false if the column has no dictionary codes
+   */
+  auto GetCodes(uint32_t column_idx, std::vector<uint32_t> *codes, std::vector<Value> *dictionary) -> bool;
+
+  /** Release the page held since the last GetTupleRef() or GetValues(), invalidating the views into it. */
+  void ReleasePage() { page_guard_.Drop(); }
+
+  /**
+   * Move to the first tuple of the next page without reading the rest of the current one. The next page is found
+   * through the zone map of the table, so the current page is not fetched.
+   */
+  void SkipPage();
+
   auto GetRID() -> RID;
 
   auto IsEnd() -> bool;
@@ -55,6 +102,11 @@ class TableIterator {
   // Otherwise we will have dead loops when updating while scanning. (In project 4, update should be implemented as
   // deletion + insertion.)
   RID stop_at_rid_;
+
+  /** The page of rid_, held only between reading from it and leaving that page */
+  ReadPageGuard page_guard_;
+  /** The current tuple of a PAX table, assembled from the minipages by GetTupleRef() */
+  Tuple pax_tuple_;
 };
 
 }  // namespace bustub
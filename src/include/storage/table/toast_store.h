@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// toast_store.h
+//
+// Identification: src/include/storage/table/toast_store.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** The payload that stands for a varchar stored out of line. */
+struct ToastPointer {
+  /** The first page of the chain holding the value */
+  page_id_t first_page_id_;
+  /** The number of bytes of the value */
+  uint32_t size_;
+  /** The number of bytes in the chain, less than size_ if they are compressed */
+  uint32_t stored_size_;
+};
+
+static_assert(sizeof(ToastPointer) == 12);
+
+/**
+ * ToastStore keeps the varchars that make a tuple too large for the pages of a row table in chains of overflow
+ * pages, after PostgreSQL's TOAST ("The Oversized-Attribute Storage Technique"). A varchar stored out of line is
+ * replaced in its tuple by a ToastPointer and flagged with VARLEN_EXTERNAL in its end offset, which keeps the main
+ * heap dense for scans.
+ *
+ * Tuples read from the table remember their store, and Tuple::GetValue only reads a chain when its column is asked
+ * for: a query that does not reference a large column never touches its overflow pages.
+ */
+class ToastStore {
+ public:
+  explicit ToastStore(BufferPoolManager *bpm) : bpm_(bpm) {}
+
+  /** @return true if `tuple` must go through Toast() before it is written to a page */
+  auto NeedsToast(const Tuple &tuple, const Schema &schema) const -> bool;
+
+  /**
+   * Move the largest varchars of a tuple out of line, until it takes at most `toast_tuple_threshold` bytes. The
+   * values the tuple already keeps out of line are read back and stored again, so no two tuples share a chain.
+   * @return the tuple to write to the page
+   */
+  auto Toast(const Tuple &tuple, const Schema &schema) const -> Tuple;
+
+  /** @return the bytes of the value `pointer` stands for */
+  auto Fetch(const ToastPointer &pointer) const -> std::string;
+
+  /** @return the chains the varchars stored out of line of the serialized tuple `data` point to */
+  static auto GetChains(const char *data, const Schema &schema) -> std::vector<ToastPointer>;
+
+  /** Delete the pages of a chain. No tuple, saved version or reader may point to it anymore. */
+  void Free(const ToastPointer &pointer) const;
+
+ private:
+  /** Write `bytes` into a new chain, compressed if `toast_compression` is set and that makes them smaller. */
+  auto Store(std::string_view bytes) const -> ToastPointer;
+
+  BufferPoolManager *bpm_;
+};
+
+}  // namespace bustub
@@ -25,13 +25,11 @@ static constexpr size_t TUPLE_META_SIZE = 12;
 
 struct TupleMeta {
   /**
-   * @brief txn id that inserts this tuple. INVALID_TXN if the insertion is completed.
-   * No need to use it in project 3 (as of Spring 2023).
+   * @brief txn id that inserted or last updated this tuple. INVALID_TXN if every transaction sees this version.
    */
   txn_id_t insert_txn_id_;
   /**
-   * @brief txn id that deletes this tuple. INVALID_TXN if the deletion is completed.
-   * No need to use it in project 3 (as of Spring 2023).
+   * @brief txn id that deletes this tuple. INVALID_TXN if every transaction sees the deletion.
    */
   txn_id_t delete_txn_id_;
   /**
@@ -42,23 +40,42 @@ struct TupleMeta {
 
 static_assert(sizeof(TupleMeta) == TUPLE_META_SIZE);
 
+/** Set in the end offset of a varchar whose payload is a ToastPointer to its bytes, see ToastStore. */
+static constexpr uint16_t VARLEN_EXTERNAL = 0x8000;
+
+/** The largest tuple, whose end offsets leave their top bit for VARLEN_EXTERNAL. */
+static constexpr uint32_t TUPLE_MAX_SIZE = VARLEN_EXTERNAL - 1;
+
+class ToastStore;
+
 /**
  * Tuple format:
- * ---------------------------------------------------------------------
- * | FIXED-SIZE or VARIED-SIZED OFFSET | PAYLOAD OF VARIED-SIZED FIELD |
- * ---------------------------------------------------------------------
+ * -----------------------------------------------------------------------------------------
+ * | NULL BITMAP | FIXED-SIZE FIELDS, WIDEST FIRST | VARCHAR END OFFSETS | VARCHAR PAYLOADS |
+ * -----------------------------------------------------------------------------------------
+ *
+ * Bit i of the null bitmap is set if column i is NULL; a NULL fixed-size field also holds its type's null value.
+ * The end offsets are 2 bytes each, relative to the start of the tuple. A varchar payload has no length and no
+ * terminator: it starts where the previous one ends, the first one at Schema::GetLength(). The offset of every field
+ * and end offset is precomputed as the column offset in the Schema.
+ *
+ * The tuples of a row table keep their large varchars out of line: the payload is then a ToastPointer and its end
+ * offset has VARLEN_EXTERNAL set. Such a tuple remembers the ToastStore of its table, and GetValue reads the value
+ * back from there.
  */
 class Tuple {
   friend class TablePage;
   friend class TableHeap;
   friend class TableIterator;
+  friend class TupleRef;
+  friend class ToastStore;
 
  public:
   // Default constructor (to create a dummy tuple)
   Tuple() = default;
 
-  // constructor for table heap tuple
-  explicit Tuple(RID rid) : rid_(rid) {}
+  // constructor for table heap tuple, `toast` is the store of its out-of-line varchars
+  explicit Tuple(RID rid, const ToastStore *toast = nullptr) : rid_(rid), toast_(toast) {}
 
   // constructor for creating a new tuple based on input value
   Tuple(std::vector<Value> values, const Schema *schema);
@@ -89,6 +106,9 @@ class Tuple {
   // Get length of the tuple, including varchar legth
   inline auto GetLength() const -> uint32_t { return data_.size(); }
 
+  // Get the store of the out-of-line varchars of this tuple, nullptr if it did not come from a row table
+  inline auto GetToastStore() const -> const ToastStore * { return toast_; }
+
   // Get the value of a specified column (const)
   // checks the schema to see how to return the Value.
   auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
@@ -98,18 +118,53 @@ class Tuple {
 
   // Is the column value null ?
   inline auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
-    Value value = GetValue(schema, column_idx);
-    return value.IsNull();
+    return (data_[column_idx / 8] >> (column_idx % 8) & 1) != 0;
   }
 
   auto ToString(const Schema *schema) const -> std::string;
 
  private:
-  // Get the starting storage address of specific column
-  auto GetDataPtr(const Schema *schema, uint32_t column_idx) const -> const char *;
-
   RID rid_{};  // if pointing to the table heap, the rid is valid
   std::vector<char> data_;
+  const ToastStore *toast_{nullptr};
+};
+
+/**
+ * TupleRef is a read-only view of a tuple's bytes that live somewhere else, usually in a table page pinned
+ * by a ReadPageGuard. It owns nothing, so it is only valid while whatever it was obtained from is alive:
+ * the page guard (or Tuple) must outlive every use of the view. Call ToTuple() to keep a copy.
+ */
+class TupleRef {
+ public:
+  TupleRef() = default;
+
+  TupleRef(const char *data, uint32_t size, RID rid, const ToastStore *toast = nullptr)
+      : data_(data), size_(size), rid_(rid), toast_(toast) {}
+
+  // view of a tuple held in memory; valid as long as `tuple` is not modified or destroyed
+  explicit TupleRef(const Tuple &tuple)
+      : data_(tuple.data_.data()), size_(tuple.GetLength()), rid_(tuple.rid_), toast_(tuple.toast_) {}
+
+  inline auto GetRid() const -> RID { return rid_; }
+
+  inline auto GetData() const -> const char * { return data_; }
+
+  inline auto GetLength() const -> uint32_t { return size_; }
+
+  // Get the value of a specified column, deserialized straight from the referenced bytes
+  auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
+
+  // Copy the referenced bytes into a Tuple that owns them
+  auto ToTuple() const -> Tuple;
+
+  // Copy the referenced bytes into `tuple`, reusing its buffer
+  void CopyTo(Tuple *tuple) const;
+
+ private:
+  const char *data_{nullptr};
+  uint32_t size_{0};
+  RID rid_{};
+  const ToastStore *toast_{nullptr};
 };
 
 }  // namespace bustub
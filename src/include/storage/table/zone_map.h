@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.h
+//
+// Identification: src/include/storage/table/zone_map.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** The range of the values of one column in one page. */
+struct ColumnZone {
+  /** The smallest and largest non-null values, null if the column has only nulls so far */
+  Value min_;
+  Value max_;
+  /** The number of nulls inserted, nulls written by updates are not counted */
+  uint32_t null_count_{0};
+};
+
+/** The summary of one page of a table heap. */
+struct PageZone {
+  /** The number of tuples ever written to the page, including deleted ones */
+  uint32_t num_tuples_{0};
+  /** One zone per column of the schema, only maintained for fixed-length columns */
+  std::vector<ColumnZone> columns_;
+};
+
+/**
+ * ZoneMap keeps a min/max and null count summary of every fixed-length column of every page of a table heap,
+ * so that a scan can skip the pages its predicate cannot match. It also records the order of the pages in the
+ * heap, so a skipped page does not need to be fetched to find the next one.
+ *
+ * Zones only ever widen: deletes and overwritten values are not taken out, so a zone may be wider than the live
+ * tuples of its page, but never narrower. The map is kept in memory beside the heap.
+ */
+class ZoneMap {
+ public:
+  explicit ZoneMap(const Schema &schema);
+
+  /** Append a new, empty page to the end of the heap. */
+  void AddPage(page_id_t page_id);
+
+  /** Widen the zones of `page_id` to include a new tuple. */
+  void Insert(page_id_t page_id, const Tuple &tuple);
+
+  /** Widen the zones of `page_id` to include the new values of a tuple updated in place. */
+  void Update(page_id_t page_id, const Tuple &tuple);
+
+  /**
+   * Copy the zones of a page.
+   * @param[out] zone the zones of `page_id`, its storage is reused across calls
+   * @return false if the page is not in the map
+   */
+  auto GetPageZone(page_id_t page_id, PageZone *zone) const -> bool;
+
+  /** @return the page after `page_id` in the heap, INVALID_PAGE_ID if it is the last one */
+  auto GetNextPageId(page_id_t page_id) const -> page_id_t;
+
+  /** @return whether column `column_idx` has zones */
+  auto IsTracked(uint32_t column_idx) const -> bool { return schema_.GetColumn(column_idx).IsInlined(); }
+
+ private:
+  /** Widen `zone` to include the values of `tuple`. */
+  void Widen(PageZone *zone, const Tuple &tuple, bool count_nulls) const;
+
+  Schema schema_;
+
+  mutable std::mutex latch_;
+  /** The pages in heap order */
+  std::vector<page_id_t> pages_;
+  /** The zones of each page and its position in pages_ */
+  std::unordered_map<page_id_t, std::pair<size_t, PageZone>> zones_;
+};
+
+}  // namespace bustub
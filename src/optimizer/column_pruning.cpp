@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** Mark the columns `expr` reads in `used`. */
+void CollectColumns(const AbstractExpressionRef &expr, std::vector<bool> *used) {
+  if (const auto *column_value_expr = dynamic_cast<const ColumnValueExpression *>(expr.get());
+      column_value_expr != nullptr) {
+    (*used)[column_value_expr->GetColIdx()] = true;
+    return;
+  }
+  for (const auto &child : expr->GetChildren()) {
+    CollectColumns(child, used);
+  }
+}
+
+/** @return `expr` reading column `new_idx[i]` wherever it read column `i` */
+auto RemapColumns(const AbstractExpressionRef &expr, const std::vector<uint32_t> &new_idx) -> AbstractExpressionRef {
+  if (const auto *column_value_expr = dynamic_cast<const ColumnValueExpression *>(expr.get());
+      column_value_expr != nullptr) {
+    return std::make_shared<ColumnValueExpression>(column_value_expr->GetTupleIdx(),
+                                                   new_idx[column_value_expr->GetColIdx()],
+                                                   column_value_expr->GetReturnType());
+  }
+  std::vector<AbstractExpressionRef> children;
+  for (const auto &child : expr->GetChildren()) {
+    children.emplace_back(RemapColumns(child, new_idx));
+  }
+  return expr->CloneWithChildren(std::move(children));
+}
+
+auto RemapColumns(const std::vector<AbstractExpressionRef> &exprs, const std::vector<uint32_t> &new_idx)
+    -> std::vector<AbstractExpressionRef> {
+  std::vector<AbstractExpressionRef> remapped;
+  remapped.reserve(exprs.size());
+  for (const auto &expr : exprs) {
+    remapped.emplace_back(RemapColumns(expr, new_idx));
+  }
+  return remapped;
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeColumnPruning(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeColumnPruning(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  if (optimized_plan->GetType() != PlanType::Projection && optimized_plan->GetType() != PlanType::Aggregation) {
+    return optimized_plan;
+  }
+  const auto &child_plan = optimized_plan->GetChildAt(0);
+  if (child_plan->GetType() != PlanType::SeqScan) {
+    return optimized_plan;
+  }
+  const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*child_plan);
+  // Row pages are read whole anyway, so only PAX tables gain from scanning fewer columns.
+  const auto *table_info = catalog_.GetTable(seq_scan.GetTableOid());
+  if (!seq_scan.column_ids_.empty() || table_info == nullptr || table_info->table_ == nullptr ||
+      table_info->table_->GetStorage() != TableStorage::PAX) {
+    return optimized_plan;
+  }
+
+  std::vector<bool> used(seq_scan.OutputSchema().GetColumnCount(), false);
+  if (seq_scan.filter_predicate_ != nullptr) {
+    CollectColumns(seq_scan.filter_predicate_, &used);
+  }
+  if (optimized_plan->GetType() == PlanType::Projection) {
+    for (const auto &expr : dynamic_cast<const ProjectionPlanNode &>(*optimized_plan).GetExpressions()) {
+      CollectColumns(expr, &used);
+    }
+  } else {
+    const auto &agg_plan = dynamic_cast<const AggregationPlanNode &>(*optimized_plan);
+    for (const auto &expr : agg_plan.GetGroupBys()) {
+      CollectColumns(expr, &used);
+    }
+    for (const auto &expr : agg_plan.GetAggregates()) {
+      CollectColumns(expr, &used);
+    }
+  }
+  if (std::all_of(used.begin(), used.end(), [](bool is_used) { return is_used; })) {
+    return optimized_plan;
+  }
+
+  std::vector<uint32_t> column_ids;
+  std::vector<uint32_t> new_idx(used.size(), 0);
+  for (uint32_t i = 0; i < used.size(); i++) {
+    if (used[i]) {
+      new_idx[i] = column_ids.size();
+      column_ids.push_back(i);
+    }
+  }
+  // Keep at least one column, so scans under COUNT(*) still produce one tuple per row.
+  if (column_ids.empty()) {
+    column_ids.push_back(0);
+  }
+
+  auto pruned_scan = std::make_shared<SeqScanPlanNode>(
+      std::make_shared<Schema>(Schema::CopySchema(&seq_scan.OutputSchema(), column_ids)), seq_scan.table_oid_,
+      seq_scan.table_name_,
+      seq_scan.filter_predicate_ == nullptr ? nullptr : RemapColumns(seq_scan.filter_predicate_, new_idx),
+      column_ids);
+  if (optimized_plan->GetType() == PlanType::Projection) {
+    const auto &projection_plan = dynamic_cast<const ProjectionPlanNode &>(*optimized_plan);
+    return std::make_shared<ProjectionPlanNode>(projection_plan.output_schema_,
+                                                RemapColumns(projection_plan.GetExpressions(), new_idx), pruned_scan);
+  }
+  const auto &agg_plan = dynamic_cast<const AggregationPlanNode &>(*optimized_plan);
+  return std::make_shared<AggregationPlanNode>(agg_plan.output_schema_, pruned_scan,
+                                               RemapColumns(agg_plan.GetGroupBys(), new_idx),
+                                               RemapColumns(agg_plan.GetAggregates(), new_idx),
+                                               agg_plan.GetAggregateTypes());
+}
+
+}  // namespace bustub
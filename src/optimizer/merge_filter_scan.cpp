@@ -1,6 +1,7 @@
 #include <memory>
 #include <vector>
 #include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
 #include "execution/plans/limit_plan.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/sort_plan.h"
@@ -29,6 +30,13 @@ auto Optimizer::OptimizeMergeFilterScan(const AbstractPlanNodeRef &plan) -> Abst
                                                  seq_scan_plan.table_name_, filter_plan.GetPredicate());
       }
     }
+    if (child_plan.GetType() == PlanType::IndexScan) {
+      const auto &index_scan_plan = dynamic_cast<const IndexScanPlanNode &>(child_plan);
+      if (index_scan_plan.filter_predicate_ == nullptr) {
+        return std::make_shared<IndexScanPlanNode>(filter_plan.output_schema_, index_scan_plan.index_oid_,
+                                                   filter_plan.GetPredicate());
+      }
+    }
   }
 
   return optimized_plan;
@@ -0,0 +1,149 @@
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "binder/bound_order_by.h"
+#include "common/macros.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/merge_join_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/**
+ * Collect the column pairs of a predicate of the form `#0.a = #1.b AND #0.c = #1.d ...`.
+ * @return false if the predicate has any other shape
+ */
+auto ExtractEquiJoinKeys(const AbstractExpressionRef &expr, std::vector<uint32_t> *left_cols,
+                         std::vector<uint32_t> *right_cols) -> bool {
+  if (const auto *logic_expr = dynamic_cast<const LogicExpression *>(expr.get()); logic_expr != nullptr) {
+    return logic_expr->logic_type_ == LogicType::And &&
+           ExtractEquiJoinKeys(logic_expr->GetChildAt(0), left_cols, right_cols) &&
+           ExtractEquiJoinKeys(logic_expr->GetChildAt(1), left_cols, right_cols);
+  }
+  const auto *cmp_expr = dynamic_cast<const ComparisonExpression *>(expr.get());
+  if (cmp_expr == nullptr || cmp_expr->comp_type_ != ComparisonType::Equal) {
+    return false;
+  }
+  const auto *lhs = dynamic_cast<const ColumnValueExpression *>(cmp_expr->GetChildAt(0).get());
+  const auto *rhs = dynamic_cast<const ColumnValueExpression *>(cmp_expr->GetChildAt(1).get());
+  if (lhs == nullptr || rhs == nullptr || lhs->GetTupleIdx() == rhs->GetTupleIdx()) {
+    return false;
+  }
+  if (lhs->GetTupleIdx() == 1) {
+    std::swap(lhs, rhs);
+  }
+  left_cols->push_back(lhs->GetColIdx());
+  right_cols->push_back(rhs->GetColIdx());
+  return true;
+}
+
+auto MakeKeyExpressions(const Schema &schema, const std::vector<uint32_t> &cols, uint32_t tuple_idx)
+    -> std::vector<AbstractExpressionRef> {
+  std::vector<AbstractExpressionRef> exprs;
+  for (auto col : cols) {
+    exprs.emplace_back(std::make_shared<ColumnValueExpression>(tuple_idx, col, schema.GetColumn(col).GetType()));
+  }
+  return exprs;
+}
+
+/** @return `plan` sorted ascending on `cols` */
+auto MakeSorted(const AbstractPlanNodeRef &plan, const std::vector<uint32_t> &cols) -> AbstractPlanNodeRef {
+  std::vector<std::pair<OrderByType, AbstractExpressionRef>> order_bys;
+  for (auto &expr : MakeKeyExpressions(plan->OutputSchema(), cols, 0)) {
+    order_bys.emplace_back(OrderByType::ASC, std::move(expr));
+  }
+  return std::make_shared<SortPlanNode>(plan->output_schema_, plan, std::move(order_bys));
+}
+
+/**
+ * @return true if every ORDER BY is an ascending column of the join output that is the same-position
+ * join key, i.e. the ORDER BY is a prefix of the order a merge join produces
+ */
+auto OrderByMatchesJoinKeys(const std::vector<std::pair<OrderByType, AbstractExpressionRef>> &order_bys,
+                            const std::vector<uint32_t> &left_cols, const std::vector<uint32_t> &right_cols,
+                            size_t left_column_cnt, JoinType join_type) -> bool {
+  if (order_bys.empty() || order_bys.size() > left_cols.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < order_bys.size(); i++) {
+    const auto &[order_type, expr] = order_bys[i];
+    const auto *column_value_expr = dynamic_cast<const ColumnValueExpression *>(expr.get());
+    if (!(order_type == OrderByType::ASC || order_type == OrderByType::DEFAULT) || column_value_expr == nullptr) {
+      return false;
+    }
+    auto col = column_value_expr->GetColIdx();
+    // The right keys of a left join are NULL for unmatched rows, so only inner joins are ordered on them.
+    bool on_left_key = col == left_cols[i];
+    bool on_right_key = join_type == JoinType::INNER && col == left_column_cnt + right_cols[i];
+    if (!on_left_key && !on_right_key) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeNLJAsMergeJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeNLJAsMergeJoin(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  // A sort on the join keys above an equi-join is better served by sorting the join inputs and merging them,
+  // which keeps the join keys in order and makes the sort above redundant. A join without such a sort is left to
+  // the hash join rule: sorting both of its inputs would be pure overhead.
+  if (optimized_plan->GetType() == PlanType::Sort) {
+    const auto &sort_plan = dynamic_cast<const SortPlanNode &>(*optimized_plan);
+    const auto &child_plan = sort_plan.GetChildPlan();
+    std::vector<uint32_t> left_cols;
+    std::vector<uint32_t> right_cols;
+    JoinType join_type;
+    if (child_plan->GetType() == PlanType::MergeJoin) {
+      const auto &merge_join = dynamic_cast<const MergeJoinPlanNode &>(*child_plan);
+      for (const auto &expr : merge_join.LeftJoinKeyExpressions()) {
+        left_cols.push_back(dynamic_cast<const ColumnValueExpression &>(*expr).GetColIdx());
+      }
+      for (const auto &expr : merge_join.RightJoinKeyExpressions()) {
+        right_cols.push_back(dynamic_cast<const ColumnValueExpression &>(*expr).GetColIdx());
+      }
+      join_type = merge_join.GetJoinType();
+    } else if (child_plan->GetType() == PlanType::NestedLoopJoin) {
+      const auto &nlj = dynamic_cast<const NestedLoopJoinPlanNode &>(*child_plan);
+      join_type = nlj.GetJoinType();
+      if (!(join_type == JoinType::INNER || join_type == JoinType::LEFT) ||
+          !ExtractEquiJoinKeys(nlj.Predicate(), &left_cols, &right_cols)) {
+        return optimized_plan;
+      }
+    } else {
+      return optimized_plan;
+    }
+
+    const auto &left = child_plan->GetChildAt(0);
+    const auto &right = child_plan->GetChildAt(1);
+    if (!OrderByMatchesJoinKeys(sort_plan.GetOrderBy(), left_cols, right_cols,
+                                left->OutputSchema().GetColumnCount(), join_type)) {
+      return optimized_plan;
+    }
+    if (child_plan->GetType() == PlanType::MergeJoin) {
+      return child_plan;
+    }
+    return std::make_shared<MergeJoinPlanNode>(child_plan->output_schema_, MakeSorted(left, left_cols),
+                                               MakeSorted(right, right_cols),
+                                               MakeKeyExpressions(left->OutputSchema(), left_cols, 0),
+                                               MakeKeyExpressions(right->OutputSchema(), right_cols, 1), join_type);
+  }
+
+  return optimized_plan;
+}
+
+}  // namespace bustub
@@ -11,9 +11,14 @@ auto Optimizer::OptimizeCustom(const AbstractPlanNodeRef &plan) -> AbstractPlanN
   auto p = plan;
   p = OptimizeMergeProjection(p);
   p = OptimizeMergeFilterNLJ(p);
-  p = OptimizeNLJAsHashJoin(p);
+  p = OptimizeMergeFilterScan(p);
+  // Before the merge join rule, so that the sorts it adds below a join are not read from an index.
   p = OptimizeOrderByAsIndexScan(p);
+  p = OptimizeNLJAsMergeJoin(p);
+  p = OptimizeNLJAsHashJoin(p);
   p = OptimizeSortLimitAsTopN(p);
+  // Pruning changes the output of scans, so it goes after every rule that matches on them.
+  p = OptimizeColumnPruning(p);
   return p;
 }
 
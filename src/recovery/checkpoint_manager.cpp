@@ -12,16 +12,107 @@
 
 #include "recovery/checkpoint_manager.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "storage/page/page_guard.h"
+#include "storage/page/table_page.h"
+
 namespace bustub {
 
-void CheckpointManager::BeginCheckpoint() {
-  // Block all the transactions and ensure that both the WAL and all dirty buffer pool pages are persisted to disk,
-  // creating a consistent checkpoint. Do NOT allow transactions to resume at the end of this method, resume them
-  // in CheckpointManager::EndCheckpoint() instead. This is for grading purposes.
+/** The entries of transactions and pages an ENDCHECKPOINT record holds, leaving room for its other fields. */
+static constexpr size_t MAX_CHECKPOINT_ENTRIES = (LOG_BUFFER_SIZE - 64) / sizeof(std::pair<page_id_t, lsn_t>);
+
+void CheckpointManager::RunCheckpointThread() {
+  if (checkpoint_thread_ != nullptr) {
+    return;
+  }
+  enable_checkpoint_ = true;
+  checkpoint_thread_ = new std::thread([this] {
+    lsn_t last_checkpoint_lsn = INVALID_LSN;
+    std::unique_lock<std::mutex> l(latch_);
+    while (!cv_.wait_for(l, checkpoint_interval, [&] { return !enable_checkpoint_; })) {
+      l.unlock();
+      FlushDirtyPages(last_checkpoint_lsn);
+      last_checkpoint_lsn = Checkpoint();
+      l.lock();
+    }
+  });
+}
+
+void CheckpointManager::StopCheckpointThread() {
+  if (checkpoint_thread_ == nullptr) {
+    return;
+  }
+  {
+    std::scoped_lock l(latch_);
+    enable_checkpoint_ = false;
+  }
+  cv_.notify_one();
+  checkpoint_thread_->join();
+  delete checkpoint_thread_;
+  checkpoint_thread_ = nullptr;
+}
+
+auto CheckpointManager::Checkpoint() -> lsn_t {
+  BUSTUB_ASSERT(enable_logging, "a checkpoint is taken with logging enabled");
+  LogRecord begin(INVALID_TXN_ID, INVALID_LSN, LogRecordType::BEGINCHECKPOINT);
+  auto checkpoint_lsn = log_manager_->AppendLogRecord(&begin);
+
+  // Read after the begin record, so every transaction begun and every page changed before it is found.
+  auto next_txn_id = transaction_manager_->GetNextTxnId();
+  auto active_txns = transaction_manager_->GetLoggedTransactions();
+  auto dirty_pages = log_manager_->GetDirtyPages();
+  BUSTUB_ASSERT(active_txns.size() < MAX_CHECKPOINT_ENTRIES, "too many transactions running for a checkpoint");
+  // A dirty page table too large for the record is cut down by writing out its oldest pages.
+  while (active_txns.size() + dirty_pages.size() > MAX_CHECKPOINT_ENTRIES) {
+    std::sort(dirty_pages.begin(), dirty_pages.end(), [](auto &a, auto &b) { return a.second < b.second; });
+    for (size_t i = 0; i < active_txns.size() + dirty_pages.size() - MAX_CHECKPOINT_ENTRIES; i++) {
+      FlushPage(dirty_pages[i].first, dirty_pages[i].second);
+    }
+    dirty_pages = log_manager_->GetDirtyPages();
+  }
+
+  // Recovery reads the log from the oldest record it may redo or undo.
+  auto first_lsn = checkpoint_lsn;
+  for (auto [txn_id, lsn] : active_txns) {
+    first_lsn = std::min(first_lsn, lsn);
+  }
+  for (auto [page_id, rec_lsn] : dirty_pages) {
+    first_lsn = std::min(first_lsn, rec_lsn);
+  }
+
+  LogRecord end(INVALID_TXN_ID, checkpoint_lsn, LogRecordType::ENDCHECKPOINT, next_txn_id, std::move(active_txns),
+                std::move(dirty_pages));
+  log_manager_->Flush(log_manager_->AppendLogRecord(&end));
+  disk_manager_->WriteMasterRecord(checkpoint_lsn, log_manager_->GetLogOffset(first_lsn));
+  log_manager_->TruncateLog(first_lsn);
+  return checkpoint_lsn;
+}
+
+void CheckpointManager::FlushDirtyPages(lsn_t lsn) {
+  for (auto [page_id, rec_lsn] : log_manager_->GetDirtyPages()) {
+    if (rec_lsn < lsn) {
+      FlushPage(page_id, rec_lsn);
+    }
+  }
 }
 
-void CheckpointManager::EndCheckpoint() {
-  // Allow transactions to resume, completing the checkpoint.
+void CheckpointManager::FlushPage(page_id_t page_id, lsn_t rec_lsn) {
+  // The page is latched against the changes, which enter it into the dirty page table again once it is written out.
+  // The buffer pool writes the page out pinned and latched, as it takes no page latch to write. A page not brought
+  // in, with every frame pinned, stays in the dirty page table.
+  auto guard = buffer_pool_manager_->FetchPageRead(page_id);
+  if (!guard.IsValid()) {
+    return;
+  }
+  log_manager_->MarkClean(page_id);
+  log_manager_->Flush(guard.As<TablePage>()->GetLSN());
+  if (!buffer_pool_manager_->FlushPage(page_id)) {
+    log_manager_->MarkDirty(page_id, rec_lsn);
+  }
 }
 
 }  // namespace bustub
@@ -12,43 +12,254 @@
 
 #include "recovery/log_manager.h"
 
+#include <cstring>
+
+#include "common/macros.h"
+#include "common/util/compression_util.h"
+
 namespace bustub {
+
 /*
  * set enable_logging = true
  * Start a separate thread to execute flush to disk operation periodically
- * The flush can be triggered when timeout or the log buffer is full or buffer
- * pool manager wants to force flush (it only happens when the flushed page has
- * a larger LSN than persistent LSN)
+ * The flush can be triggered when timeout or the log buffer is full or a transaction waits for its records in
+ * Flush()
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  enable_logging = true;
+  flush_thread_ = new std::thread([this] {
+    while (enable_logging) {
+      {
+        std::unique_lock<std::mutex> l(latch_);
+        cv_.wait_for(l, log_timeout, [&] { return flush_requested_ || !enable_logging; });
+        flush_requested_ = false;
+      }
+      FlushBuffer();
+    }
+    // Write out what was appended before the thread was stopped.
+    FlushBuffer();
+  });
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  if (flush_thread_ == nullptr) {
+    return;
+  }
+  {
+    std::scoped_lock l(latch_);
+    enable_logging = false;
+  }
+  cv_.notify_one();
+  flush_thread_->join();
+  delete flush_thread_;
+  flush_thread_ = nullptr;
+}
+
+auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t {
+  auto size = static_cast<uint64_t>(log_record->size_);
+  BUSTUB_ASSERT(size <= static_cast<uint64_t>(LOG_BUFFER_SIZE), "log record larger than the log buffer");
+  // Reserve the next LSN and the bytes of the record in the buffer appended to.
+  auto state = append_state_.load();
+  while (true) {
+    if (OffsetOf(state) + size > static_cast<uint64_t>(LOG_BUFFER_SIZE)) {
+      if (flush_thread_ == nullptr) {
+        FlushBuffer();
+        state = append_state_.load();
+        continue;
+      }
+      std::unique_lock<std::mutex> l(latch_);
+      flush_requested_ = true;
+      cv_.notify_one();
+      flushed_cv_.wait(l, [&] { return BufferOf(append_state_.load()) != BufferOf(state); });
+      state = append_state_.load();
+      continue;
+    }
+    if (append_state_.compare_exchange_weak(state, state + (uint64_t{1} << LSN_SHIFT) + size)) {
+      break;
+    }
+  }
+
+  log_record->lsn_ = LsnOf(state);
+  auto buffer = BufferOf(state);
+  SerializeLogRecord(*log_record, buffers_[buffer] + OffsetOf(state));
+  filled_[buffer].fetch_add(size);
+  return log_record->lsn_;
+}
+
+void LogManager::Flush(lsn_t lsn) {
+  if (persistent_lsn_ >= lsn) {
+    return;
+  }
+  if (flush_thread_ == nullptr) {
+    FlushBuffer();
+    return;
+  }
+  std::unique_lock<std::mutex> l(latch_);
+  if (persistent_lsn_ >= lsn) {
+    return;
+  }
+  flush_requested_ = true;
+  cv_.notify_one();
+  flushed_cv_.wait(l, [&] { return persistent_lsn_ >= lsn; });
+}
+
+void LogManager::SetNextLSN(lsn_t lsn) {
+  BUSTUB_ASSERT(OffsetOf(append_state_.load()) == 0, "records appended before the log was positioned");
+  append_state_ = (static_cast<uint64_t>(lsn) << LSN_SHIFT) | (append_state_.load() & BUFFER_BIT);
+  persistent_lsn_ = lsn - 1;
+}
+
+void LogManager::FlushBuffer() {
+  // Switch the appends to the other buffer. Its records were written out by the last call already, as the calls made
+  // by the appends and Flush() without the flush thread run one at a time.
+  std::scoped_lock flush_lock(flush_latch_);
+  auto state = append_state_.load();
+  {
+    std::scoped_lock l(latch_);
+    do {
+      if (OffsetOf(state) == 0) {
+        return;
+      }
+    } while (!append_state_.compare_exchange_weak(state, (state & ~OFFSET_MASK) ^ BUFFER_BIT));
+  }
+  flushed_cv_.notify_all();
+
+  // The appends that reserved their bytes before the switch may still be copying them.
+  auto buffer = BufferOf(state);
+  auto size = OffsetOf(state);
+  while (filled_[buffer].load() != size) {
+    std::this_thread::yield();
+  }
+  auto *data = buffers_[buffer];
+  auto data_size = static_cast<int>(size);
+  if (enable_log_compression) {
+    auto compressed = CompressionUtil::Compress({buffers_[buffer], size});
+    if (compressed.size() + BLOCK_HEADER_SIZE < size) {
+      int32_t block_header[2] = {-static_cast<int32_t>(compressed.size()), data_size};
+      memcpy(blocks_[buffer], block_header, BLOCK_HEADER_SIZE);
+      memcpy(blocks_[buffer] + BLOCK_HEADER_SIZE, compressed.data(), compressed.size());
+      data = blocks_[buffer];
+      data_size = static_cast<int>(BLOCK_HEADER_SIZE + compressed.size());
+    }
+  }
+  disk_manager_->WriteLog(data, data_size);
+  filled_[buffer] = 0;
+
+  {
+    std::scoped_lock l(latch_);
+    buffer_offsets_.emplace(persistent_lsn_ + 1, log_size_);
+    log_size_ += data_size;
+    persistent_lsn_ = LsnOf(state) - 1;
+  }
+  flushed_cv_.notify_all();
+}
+
+void LogManager::MarkDirty(page_id_t page_id, lsn_t lsn) {
+  std::scoped_lock l(dirty_pages_latch_);
+  dirty_pages_.emplace(page_id, lsn);
+}
+
+void LogManager::MarkClean(page_id_t page_id) {
+  std::scoped_lock l(dirty_pages_latch_);
+  dirty_pages_.erase(page_id);
+}
+
+auto LogManager::IsDirty(page_id_t page_id) -> bool {
+  std::scoped_lock l(dirty_pages_latch_);
+  return dirty_pages_.count(page_id) > 0;
+}
+
+auto LogManager::GetDirtyPages() -> std::vector<std::pair<page_id_t, lsn_t>> {
+  std::scoped_lock l(dirty_pages_latch_);
+  return {dirty_pages_.begin(), dirty_pages_.end()};
+}
+
+/*
+ * The offset of the buffer holding the record, the records before it in the buffer are read again
+ */
+auto LogManager::GetLogOffset(lsn_t lsn) -> int {
+  std::scoped_lock l(latch_);
+  auto buffer = buffer_offsets_.upper_bound(lsn);
+  BUSTUB_ASSERT(lsn <= persistent_lsn_ && buffer != buffer_offsets_.begin(), "the record is not on disk");
+  return std::prev(buffer)->second;
+}
+
+void LogManager::TruncateLog(lsn_t lsn) {
+  auto offset = GetLogOffset(lsn);
+  disk_manager_->TruncateLog(offset);
+  std::scoped_lock l(latch_);
+  buffer_offsets_.erase(buffer_offsets_.begin(), std::prev(buffer_offsets_.upper_bound(lsn)));
+}
 
 /*
- * append a log record into log buffer
- * you MUST set the log record's lsn within this method
- * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
+ * The header is the first 20 bytes of LogRecord, followed by the fields of the type of the record, see log_record.h.
  */
-auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t { return INVALID_LSN; }
+void LogManager::SerializeLogRecord(const LogRecord &log_record, char *data) {
+  memcpy(data, &log_record, LogRecord::HEADER_SIZE);
+  auto pos = data + LogRecord::HEADER_SIZE;
+  switch (log_record.log_record_type_) {
+    case LogRecordType::INSERT:
+      memcpy(pos, &log_record.rid_, sizeof(RID));
+      memcpy(pos + sizeof(RID), &log_record.new_meta_, TUPLE_META_SIZE);
+      log_record.new_tuple_.SerializeTo(pos + sizeof(RID) + TUPLE_META_SIZE);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+    case LogRecordType::UPDATEMETA:
+      memcpy(pos, &log_record.rid_, sizeof(RID));
+      memcpy(pos + sizeof(RID), &log_record.old_meta_, TUPLE_META_SIZE);
+      memcpy(pos + sizeof(RID) + TUPLE_META_SIZE, &log_record.new_meta_, TUPLE_META_SIZE);
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(pos, &log_record.rid_, sizeof(RID));
+      pos += sizeof(RID);
+      memcpy(pos, &log_record.old_meta_, TUPLE_META_SIZE);
+      pos += TUPLE_META_SIZE;
+      memcpy(pos, &log_record.new_meta_, TUPLE_META_SIZE);
+      pos += TUPLE_META_SIZE;
+      memcpy(pos, &log_record.prefix_size_, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      memcpy(pos, &log_record.suffix_size_, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      for (const auto *bytes : {&log_record.old_bytes_, &log_record.new_bytes_}) {
+        auto size = static_cast<int32_t>(bytes->size());
+        memcpy(pos, &size, sizeof(int32_t));
+        memcpy(pos + sizeof(int32_t), bytes->data(), size);
+        pos += sizeof(int32_t) + size;
+      }
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(pos, &log_record.prev_page_id_, sizeof(page_id_t));
+      memcpy(pos + sizeof(page_id_t), &log_record.page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::APPLYDELETE:
+      memcpy(pos, &log_record.page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::ENDCHECKPOINT: {
+      auto num_txns = static_cast<int32_t>(log_record.active_txns_.size());
+      auto num_pages = static_cast<int32_t>(log_record.dirty_pages_.size());
+      memcpy(pos, &log_record.next_txn_id_, sizeof(txn_id_t));
+      pos += sizeof(txn_id_t);
+      memcpy(pos, &num_txns, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      memcpy(pos, log_record.active_txns_.data(), num_txns * sizeof(log_record.active_txns_[0]));
+      pos += num_txns * sizeof(log_record.active_txns_[0]);
+      memcpy(pos, &num_pages, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      memcpy(pos, log_record.dirty_pages_.data(), num_pages * sizeof(log_record.dirty_pages_[0]));
+      break;
+    }
+    default:
+      break;
+  }
+}
 
 }  // namespace bustub
@@ -0,0 +1,442 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_recovery.cpp
+//
+// Identification: src/recovery/log_recovery.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_recovery.h"
+
+#include <cstring>
+#include <thread>  // NOLINT
+
+#include "common/macros.h"
+#include "common/util/compression_util.h"
+#include "storage/page/page_guard.h"
+#include "storage/page/table_page.h"
+
+namespace bustub {
+
+/** The number of records the redo pass hands out to its threads at a time. */
+static constexpr size_t REDO_BATCH_SIZE = 4096;
+
+/** @return whether a record of the type changes pages, rather than marks a transaction or a checkpoint */
+static auto ChangesPages(LogRecordType type) -> bool {
+  return type != LogRecordType::BEGIN && type != LogRecordType::COMMIT && type != LogRecordType::ABORT &&
+         type != LogRecordType::BEGINCHECKPOINT && type != LogRecordType::ENDCHECKPOINT;
+}
+
+/** @return the pages a record changes */
+static auto PagesOf(LogRecord *log_record) -> std::vector<page_id_t> {
+  switch (log_record->GetLogRecordType()) {
+    case LogRecordType::NEWPAGE:
+      if (log_record->GetNewPageRecord() == INVALID_PAGE_ID) {
+        return {log_record->GetPageId()};
+      }
+      return {log_record->GetNewPageRecord(), log_record->GetPageId()};
+    case LogRecordType::APPLYDELETE:
+      return {log_record->GetPageId()};
+    default:
+      return {log_record->GetRID().GetPageId()};
+  }
+}
+
+auto LogRecovery::DeserializeLogRecord(const char *data, int size, LogRecord *log_record) -> bool {
+  if (size < LogRecord::HEADER_SIZE) {
+    return false;
+  }
+  int32_t header[5];
+  memcpy(header, data, LogRecord::HEADER_SIZE);
+  log_record->size_ = header[0];
+  log_record->lsn_ = header[1];
+  log_record->txn_id_ = header[2];
+  log_record->prev_lsn_ = header[3];
+  log_record->log_record_type_ = static_cast<LogRecordType>(header[4]);
+  if (log_record->size_ < LogRecord::HEADER_SIZE || log_record->size_ > size ||
+      header[4] <= static_cast<int32_t>(LogRecordType::INVALID) ||
+      header[4] > static_cast<int32_t>(LogRecordType::ENDCHECKPOINT)) {
+    return false;
+  }
+
+  // Every field is checked to lie within the record, so that a torn record is not taken for a whole one.
+  auto pos = data + LogRecord::HEADER_SIZE;
+  auto end = data + log_record->size_;
+  auto read = [&](void *field, size_t field_size) {
+    if (pos + field_size > end) {
+      return false;
+    }
+    memcpy(field, pos, field_size);
+    pos += field_size;
+    return true;
+  };
+  auto read_tuple = [&](Tuple *tuple) {
+    int32_t tuple_size;
+    if (!read(&tuple_size, sizeof(int32_t)) || tuple_size < 0 || pos + tuple_size > end) {
+      return false;
+    }
+    tuple->DeserializeFrom(pos - sizeof(int32_t));
+    pos += tuple_size;
+    return true;
+  };
+  auto read_bytes = [&](std::string *bytes) {
+    int32_t bytes_size;
+    if (!read(&bytes_size, sizeof(int32_t)) || bytes_size < 0 || pos + bytes_size > end) {
+      return false;
+    }
+    bytes->assign(pos, bytes_size);
+    pos += bytes_size;
+    return true;
+  };
+  auto read_entries = [&](auto *entries) {
+    int32_t num_entries;
+    if (!read(&num_entries, sizeof(int32_t)) || num_entries < 0 ||
+        num_entries > (end - pos) / static_cast<int32_t>(sizeof((*entries)[0]))) {
+      return false;
+    }
+    entries->resize(num_entries);
+    return read(entries->data(), num_entries * sizeof((*entries)[0]));
+  };
+  bool ok = true;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      ok = read(&log_record->rid_, sizeof(RID)) && read(&log_record->new_meta_, TUPLE_META_SIZE) &&
+           read_tuple(&log_record->new_tuple_);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+    case LogRecordType::UPDATEMETA:
+      ok = read(&log_record->rid_, sizeof(RID)) && read(&log_record->old_meta_, TUPLE_META_SIZE) &&
+           read(&log_record->new_meta_, TUPLE_META_SIZE);
+      break;
+    case LogRecordType::UPDATE:
+      ok = read(&log_record->rid_, sizeof(RID)) && read(&log_record->old_meta_, TUPLE_META_SIZE) &&
+           read(&log_record->new_meta_, TUPLE_META_SIZE) && read(&log_record->prefix_size_, sizeof(int32_t)) &&
+           read(&log_record->suffix_size_, sizeof(int32_t)) && read_bytes(&log_record->old_bytes_) &&
+           read_bytes(&log_record->new_bytes_);
+      break;
+    case LogRecordType::NEWPAGE:
+      ok = read(&log_record->prev_page_id_, sizeof(page_id_t)) && read(&log_record->page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::APPLYDELETE:
+      ok = read(&log_record->page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::ENDCHECKPOINT:
+      ok = read(&log_record->next_txn_id_, sizeof(txn_id_t)) && read_entries(&log_record->active_txns_) &&
+           read_entries(&log_record->dirty_pages_);
+      break;
+    default:
+      break;
+  }
+  return ok && pos == end;
+}
+
+void LogRecovery::ScanLog(int offset, const std::function<bool(LogRecord *, int)> &visit) {
+  lsn_t next_lsn = INVALID_LSN;
+  // Hand a record on to `visit`, @return false once the scan ends
+  auto take = [&](LogRecord *log_record, int record_offset) {
+    // The LSNs follow each other in the log, anything else is the end of a log cut short.
+    if (next_lsn != INVALID_LSN && log_record->GetLSN() != next_lsn) {
+      return false;
+    }
+    next_lsn = log_record->GetLSN() + 1;
+    return visit(log_record, record_offset);
+  };
+  while (disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset)) {
+    int pos = 0;
+    while (pos + LogManager::BLOCK_HEADER_SIZE <= LOG_BUFFER_SIZE) {
+      int32_t block_header[2];
+      memcpy(block_header, log_buffer_ + pos, LogManager::BLOCK_HEADER_SIZE);
+      if (block_header[0] >= 0) {
+        LogRecord log_record;
+        if (!DeserializeLogRecord(log_buffer_ + pos, LOG_BUFFER_SIZE - pos, &log_record)) {
+          break;
+        }
+        if (!take(&log_record, offset + pos)) {
+          return;
+        }
+        pos += log_record.GetSize();
+        continue;
+      }
+
+      // A compressed block, whose records are all found at the offset of the block.
+      auto block_size = LogManager::BLOCK_HEADER_SIZE - block_header[0];
+      if (block_size > LOG_BUFFER_SIZE - pos) {
+        break;
+      }
+      auto records_size = block_header[1];
+      if (records_size <= 0 || records_size > LOG_BUFFER_SIZE ||
+          !CompressionUtil::Decompress({log_buffer_ + pos + LogManager::BLOCK_HEADER_SIZE,
+                                        static_cast<size_t>(-block_header[0])},
+                                       block_buffer_, records_size)) {
+        return;
+      }
+      for (int block_pos = 0; block_pos < records_size;) {
+        LogRecord log_record;
+        if (!DeserializeLogRecord(block_buffer_ + block_pos, records_size - block_pos, &log_record) ||
+            !take(&log_record, offset + pos)) {
+          return;
+        }
+        block_pos += log_record.GetSize();
+      }
+      pos += block_size;
+    }
+    // No record or block is larger than the buffer, so one that does not start the buffer is read again from its
+    // start.
+    if (pos == 0) {
+      return;
+    }
+    offset += pos;
+  }
+}
+
+void LogRecovery::Analyze() {
+  // Without a checkpoint, the log is read from its start, and every record counts for the dirty page table.
+  lsn_t checkpoint_lsn = INVALID_LSN;
+  int start_offset = 0;
+  disk_manager_->ReadMasterRecord(&checkpoint_lsn, &start_offset);
+  lsn_t first_lsn = INVALID_LSN;
+  std::vector<int> offsets;
+  ScanLog(start_offset, [&](LogRecord *log_record, int offset) {
+    auto lsn = log_record->GetLSN();
+    auto txn_id = log_record->GetTxnId();
+    if (first_lsn == INVALID_LSN) {
+      first_lsn = lsn;
+    }
+    offsets.push_back(offset);
+    next_lsn_ = lsn + 1;
+    next_txn_id_ = std::max(next_txn_id_, txn_id + 1);
+    switch (log_record->GetLogRecordType()) {
+      case LogRecordType::BEGIN:
+        active_txn_.emplace(txn_id, std::vector<lsn_t>{});
+        break;
+      case LogRecordType::COMMIT:
+      case LogRecordType::ABORT:
+        if (auto txn = active_txn_.find(txn_id); txn != active_txn_.end()) {
+          for (auto txn_lsn : txn->second) {
+            lsn_mapping_.erase(txn_lsn);
+          }
+          active_txn_.erase(txn);
+        }
+        break;
+      case LogRecordType::BEGINCHECKPOINT:
+        break;
+      case LogRecordType::ENDCHECKPOINT:
+        // The log is read from before the BEGIN record of every transaction running at the checkpoint, so they are
+        // found by their records. The pages changed before the checkpoint are the ones it found dirty.
+        if (log_record->GetPrevLSN() == checkpoint_lsn) {
+          next_txn_id_ = std::max(next_txn_id_, log_record->GetNextTxnId());
+          for (auto [page_id, rec_lsn] : log_record->GetDirtyPages()) {
+            auto page = dirty_pages_.emplace(page_id, rec_lsn).first;
+            page->second = std::min(page->second, rec_lsn);
+          }
+        }
+        break;
+      default:
+        if (lsn > checkpoint_lsn) {
+          for (auto page_id : PagesOf(log_record)) {
+            dirty_pages_.emplace(page_id, lsn);
+          }
+        }
+        // The records of no transaction begun in the log, such as the ones of the vacuum, are only redone.
+        if (auto txn = active_txn_.find(txn_id); txn != active_txn_.end()) {
+          txn->second.push_back(lsn);
+          lsn_mapping_[lsn] = offset;
+        }
+        break;
+    }
+    return true;
+  });
+  if (!dirty_pages_.empty()) {
+    auto rec_lsn = std::min_element(dirty_pages_.begin(), dirty_pages_.end(),
+                                    [](auto &a, auto &b) { return a.second < b.second; })
+                       ->second;
+    BUSTUB_ASSERT(rec_lsn >= first_lsn, "the log is read from the first record to redo");
+    offset_ = offsets[rec_lsn - first_lsn];
+  }
+  if (log_manager_ != nullptr) {
+    log_manager_->SetNextLSN(next_lsn_);
+  }
+}
+
+void LogRecovery::Redo() {
+  Analyze();
+  if (dirty_pages_.empty()) {
+    return;
+  }
+  std::vector<LogRecord> batch;
+  ScanLog(offset_, [&](LogRecord *log_record, int) {
+    if (ChangesPages(log_record->GetLogRecordType())) {
+      batch.push_back(std::move(*log_record));
+    }
+    if (batch.size() == REDO_BATCH_SIZE) {
+      RedoBatch(&batch);
+      batch.clear();
+    }
+    return true;
+  });
+  RedoBatch(&batch);
+}
+
+void LogRecovery::RedoBatch(std::vector<LogRecord> *batch) {
+  // Each page is given to one thread, which applies its records in the order of the log.
+  auto num_threads = std::max<size_t>(1, recovery_num_threads);
+  std::vector<std::vector<std::pair<page_id_t, LogRecord *>>> shares(num_threads);
+  for (auto &log_record : *batch) {
+    for (auto page_id : PagesOf(&log_record)) {
+      auto rec_lsn = dirty_pages_.find(page_id);
+      if (rec_lsn != dirty_pages_.end() && log_record.GetLSN() >= rec_lsn->second) {
+        shares[page_id % num_threads].emplace_back(page_id, &log_record);
+      }
+    }
+  }
+  auto redo_share = [this](const std::vector<std::pair<page_id_t, LogRecord *>> &share) {
+    WritePageGuard guard;
+    page_id_t guarded_page_id = INVALID_PAGE_ID;
+    for (auto [page_id, log_record] : share) {
+      if (page_id != guarded_page_id) {
+        guard = buffer_pool_manager_->FetchPageWrite(page_id);
+        guarded_page_id = page_id;
+      }
+      RedoRecord(log_record, page_id, guard.AsMut<TablePage>());
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; i++) {
+    if (!shares[i].empty()) {
+      threads.emplace_back(redo_share, std::cref(shares[i]));
+    }
+  }
+  redo_share(shares[0]);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void LogRecovery::RedoRecord(LogRecord *log_record, page_id_t page_id, TablePage *page) {
+  auto lsn = log_record->lsn_;
+  if (log_record->log_record_type_ == LogRecordType::NEWPAGE && page_id == log_record->page_id_) {
+    // A page never written out reads as zeros, whose LSN does not tell it apart from a page changed by record 0.
+    if (page->GetLSN() <= lsn) {
+      page->Init();
+      page->SetLSN(lsn);
+    }
+    return;
+  }
+  if (page->GetLSN() >= lsn) {
+    return;
+  }
+  switch (log_record->log_record_type_) {
+    case LogRecordType::NEWPAGE:
+      page->SetNextPageId(log_record->page_id_);
+      break;
+    case LogRecordType::INSERT: {
+      // The page is as it was when the record was logged, so the tuple lands in the same slot.
+      auto slot_id = page->InsertTuple(log_record->new_meta_, log_record->new_tuple_);
+      BUSTUB_ENSURE(slot_id == log_record->rid_.GetSlotNum(), "the redo of an insert must reproduce its slot");
+      break;
+    }
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+    case LogRecordType::UPDATEMETA:
+      page->UpdateTupleMeta(log_record->new_meta_, log_record->rid_);
+      break;
+    case LogRecordType::UPDATE: {
+      auto updated = log_record->RedoUpdate(page->GetTuple(log_record->rid_).second);
+      BUSTUB_ENSURE(updated.has_value(), "the redo of an update must find the version it was logged against");
+      page->UpdateTupleInPlaceUnsafe(log_record->new_meta_, *updated, log_record->rid_);
+      break;
+    }
+    case LogRecordType::APPLYDELETE:
+      page->Compact();
+      break;
+    default:
+      break;
+  }
+  page->SetLSN(lsn);
+}
+
+void LogRecovery::Undo() {
+  std::vector<lsn_t> lsns;
+  for (const auto &[txn_id, txn_lsns] : active_txn_) {
+    lsns.insert(lsns.end(), txn_lsns.begin(), txn_lsns.end());
+  }
+  std::sort(lsns.begin(), lsns.end(), std::greater<>());
+  for (auto lsn : lsns) {
+    LogRecord log_record;
+    ScanLog(lsn_mapping_[lsn], [&](LogRecord *record, int) {
+      if (record->GetLSN() == lsn) {
+        log_record = std::move(*record);
+      }
+      return record->GetLSN() < lsn;
+    });
+    BUSTUB_ENSURE(log_record.GetLSN() == lsn, "the record to undo was read by the analysis");
+    auto guard = buffer_pool_manager_->FetchPageWrite(log_record.rid_.GetPageId());
+    UndoRecord(&log_record, guard.AsMut<TablePage>());
+  }
+
+  if (log_manager_ != nullptr) {
+    for (const auto &[txn_id, txn_lsns] : active_txn_) {
+      LogRecord record(txn_id, txn_lsns.empty() ? INVALID_LSN : txn_lsns.back(), LogRecordType::ABORT);
+      log_manager_->AppendLogRecord(&record);
+    }
+    log_manager_->Flush(log_manager_->GetNextLSN() - 1);
+    // The pages recovered are written out, so that the dirty page table of the log manager starts out empty.
+    buffer_pool_manager_->FlushAllPages();
+    for (const auto &[page_id, rec_lsn] : log_manager_->GetDirtyPages()) {
+      log_manager_->MarkClean(page_id);
+    }
+  }
+  active_txn_.clear();
+  lsn_mapping_.clear();
+}
+
+void LogRecovery::UndoRecord(LogRecord *log_record, TablePage *page) {
+  const auto &rid = log_record->rid_;
+  auto [meta, tuple] = page->GetTuple(rid);
+  LogRecord compensation;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT: {
+      // As TransactionManager::Abort() does, the slot is left deleted for the vacuum.
+      TupleMeta removed{INVALID_TXN_ID, INVALID_TXN_ID, true};
+      compensation =
+          LogRecord(INVALID_TXN_ID, INVALID_LSN, LogRecord::MetaChangeType(meta, removed), rid, meta, removed);
+      page->UpdateTupleMeta(removed, rid);
+      break;
+    }
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+    case LogRecordType::UPDATEMETA:
+      compensation = LogRecord(INVALID_TXN_ID, INVALID_LSN, LogRecord::MetaChangeType(meta, log_record->old_meta_),
+                               rid, meta, log_record->old_meta_);
+      page->UpdateTupleMeta(log_record->old_meta_, rid);
+      break;
+    case LogRecordType::UPDATE: {
+      // A tuple found at the version before was undone by a recovery that did not finish.
+      auto original = log_record->UndoUpdate(tuple);
+      if (!original.has_value()) {
+        return;
+      }
+      // The versions a transaction writes keep the bytes of the ones they replace, see TableHeap::UpdateTupleInPlace(),
+      // so taking back the update of a loser cannot run out of room.
+      BUSTUB_ENSURE(page->FitsUpdate(*original, rid), "the version before an update of a loser does not fit");
+      compensation = LogRecord(INVALID_TXN_ID, INVALID_LSN, LogRecordType::UPDATE, rid, meta, tuple,
+                               log_record->old_meta_, *original);
+      page->UpdateTupleInPlaceUnsafe(log_record->old_meta_, *original, rid);
+      break;
+    }
+    default:
+      return;
+  }
+  if (log_manager_ != nullptr) {
+    // The buffer pool waits for the log before writing out only the pages in the dirty page table.
+    log_manager_->MarkDirty(rid.GetPageId(), log_manager_->GetNextLSN());
+    page->SetLSN(log_manager_->AppendLogRecord(&compensation));
+  }
+}
+
+}  // namespace bustub
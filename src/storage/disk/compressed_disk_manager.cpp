@@ -0,0 +1,238 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_disk_manager.cpp
+//
+// Identification: src/storage/disk/compressed_disk_manager.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/compressed_disk_manager.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iterator>
+#include <mutex>  // NOLINT
+#include <string_view>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/util/compression_util.h"
+
+namespace bustub {
+
+/** @return the nanoseconds since `start` */
+static auto NanosSince(std::chrono::steady_clock::time_point start) -> uint64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+CompressedDiskManager::CompressedDiskManager(const std::string &db_file)
+    : DiskManager(db_file) {
+  std::string::size_type n = file_name_.rfind('.');
+  if (n == std::string::npos) {
+    return;
+  }
+  map_name_ = file_name_.substr(0, n) + ".pagemap";
+
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  map_io_.open(map_name_, std::ios::binary | std::ios::in | std::ios::out);
+  // directory or file does not exist
+  if (!map_io_.is_open()) {
+    map_io_.clear();
+    // create a new file
+    map_io_.open(map_name_, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
+    if (!map_io_.is_open()) {
+      throw Exception("can't open page map file");
+    }
+  }
+  LoadPageMap();
+}
+
+void CompressedDiskManager::LoadPageMap() {
+  auto size = GetFileSize(map_name_);
+  locations_.resize(std::max(size, 0) / sizeof(PageLocation), PageLocation{0, 0, 0});
+  map_io_.seekg(0);
+  map_io_.read(reinterpret_cast<char *>(locations_.data()), locations_.size() * sizeof(PageLocation));
+  map_io_.clear();
+
+  // Everything between the extents in use is free.
+  std::vector<std::pair<uint64_t, uint64_t>> extents;
+  for (const auto &location : locations_) {
+    if (location.size_ != 0) {
+      extents.emplace_back(location.offset_, NumSectors(location.size_));
+    }
+  }
+  std::sort(extents.begin(), extents.end());
+  for (auto [offset, num_sectors] : extents) {
+    if (offset > file_end_) {
+      FreeExtent(file_end_, (offset - file_end_) / SECTOR_SIZE);
+    }
+    file_end_ = std::max(file_end_, offset + num_sectors * SECTOR_SIZE);
+  }
+}
+
+auto CompressedDiskManager::AllocateExtent(uint64_t num_sectors) -> uint64_t {
+  auto it = free_extents_by_size_.lower_bound({num_sectors, 0});
+  if (it == free_extents_by_size_.end()) {
+    auto offset = file_end_;
+    file_end_ += num_sectors * SECTOR_SIZE;
+    return offset;
+  }
+  auto [free_sectors, offset] = *it;
+  free_extents_by_size_.erase(it);
+  free_extents_.erase(offset);
+  if (free_sectors > num_sectors) {
+    auto rest = offset + num_sectors * SECTOR_SIZE;
+    free_extents_.emplace(rest, free_sectors - num_sectors);
+    free_extents_by_size_.emplace(free_sectors - num_sectors, rest);
+  }
+  return offset;
+}
+
+void CompressedDiskManager::FreeExtent(uint64_t offset, uint64_t num_sectors) {
+  auto next = free_extents_.lower_bound(offset);
+  if (next != free_extents_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second * SECTOR_SIZE == offset) {
+      offset = prev->first;
+      num_sectors += prev->second;
+      free_extents_by_size_.erase({prev->second, prev->first});
+      free_extents_.erase(prev);
+    }
+  }
+  if (next != free_extents_.end() && offset + num_sectors * SECTOR_SIZE == next->first) {
+    num_sectors += next->second;
+    free_extents_by_size_.erase({next->second, next->first});
+    free_extents_.erase(next);
+  }
+  if (offset + num_sectors * SECTOR_SIZE == file_end_) {
+    // The end of the file is free, so the next extents past it are appended there.
+    file_end_ = offset;
+    return;
+  }
+  free_extents_.emplace(offset, num_sectors);
+  free_extents_by_size_.emplace(num_sectors, offset);
+}
+
+void CompressedDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  // Compress before taking the latch, so that writers only wait for each other's I/O.
+  auto start = std::chrono::steady_clock::now();
+  auto compressed = CompressionUtil::Compress(std::string_view(page_data, BUSTUB_PAGE_SIZE));
+  compress_ns_ += NanosSince(start);
+  bool raw = NumSectors(compressed.size()) >= SECTORS_PER_PAGE;
+  const char *data = raw ? page_data : compressed.data();
+  uint32_t size = raw ? BUSTUB_PAGE_SIZE : compressed.size();
+
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  if (static_cast<size_t>(page_id) >= locations_.size()) {
+    locations_.resize(page_id + 1, PageLocation{0, 0, 0});
+  }
+  auto old_location = locations_[page_id];
+  auto num_sectors = NumSectors(size);
+  // Never overwrite the extent the map points at, a torn write would lose both versions of the page.
+  auto offset = AllocateExtent(num_sectors);
+
+  num_writes_ += 1;
+  db_io_.seekp(offset);
+  db_io_.write(data, size);
+  // check for I/O error
+  if (db_io_.bad()) {
+    LOG_DEBUG("I/O error while writing");
+    FreeExtent(offset, num_sectors);
+    return;
+  }
+  // needs to flush to keep disk file in sync
+  db_io_.flush();
+
+  // Point the map at the extent only once it is written.
+  locations_[page_id] = PageLocation{offset, size, 0};
+  map_io_.seekp(static_cast<size_t>(page_id) * sizeof(PageLocation));
+  map_io_.write(reinterpret_cast<const char *>(&locations_[page_id]), sizeof(PageLocation));
+  if (map_io_.bad()) {
+    LOG_DEBUG("I/O error while writing page map");
+    return;
+  }
+  map_io_.flush();
+  if (old_location.size_ != 0) {
+    FreeExtent(old_location.offset_, NumSectors(old_location.size_));
+  }
+
+  pages_written_ += 1;
+  pages_stored_raw_ += raw ? 1 : 0;
+  stored_bytes_ += num_sectors * SECTOR_SIZE;
+}
+
+void CompressedDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  std::string stored;
+  {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    if (static_cast<size_t>(page_id) >= locations_.size() || locations_[page_id].size_ == 0) {
+      LOG_DEBUG("I/O error reading a page never written");
+      memset(page_data, 0, BUSTUB_PAGE_SIZE);
+      return;
+    }
+    auto location = locations_[page_id];
+    if (location.size_ == BUSTUB_PAGE_SIZE) {
+      db_io_.seekp(location.offset_);
+      db_io_.read(page_data, BUSTUB_PAGE_SIZE);
+      if (db_io_.bad()) {
+        LOG_DEBUG("I/O error while reading");
+      }
+      return;
+    }
+    stored.resize(location.size_);
+    db_io_.seekp(location.offset_);
+    db_io_.read(stored.data(), location.size_);
+    if (db_io_.bad()) {
+      LOG_DEBUG("I/O error while reading");
+      return;
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  if (!CompressionUtil::Decompress(stored, page_data, BUSTUB_PAGE_SIZE)) {
+    throw Exception("corrupt compressed page " + std::to_string(page_id));
+  }
+  decompress_ns_ += NanosSince(start);
+}
+
+void CompressedDiskManager::DeallocatePage(page_id_t page_id) {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  if (static_cast<size_t>(page_id) >= locations_.size() || locations_[page_id].size_ == 0) {
+    return;
+  }
+  auto old_location = locations_[page_id];
+  // Clear the entry before the extent is reused, or a crash would leave it pointing at another page.
+  locations_[page_id] = PageLocation{0, 0, 0};
+  map_io_.seekp(static_cast<size_t>(page_id) * sizeof(PageLocation));
+  map_io_.write(reinterpret_cast<const char *>(&locations_[page_id]), sizeof(PageLocation));
+  if (map_io_.bad()) {
+    LOG_DEBUG("I/O error while writing page map");
+    return;
+  }
+  map_io_.flush();
+  FreeExtent(old_location.offset_, NumSectors(old_location.size_));
+}
+
+auto CompressedDiskManager::GetStats() const -> PageCompressionStats {
+  PageCompressionStats stats;
+  stats.pages_written_ = pages_written_;
+  stats.pages_stored_raw_ = pages_stored_raw_;
+  stats.page_bytes_ = stats.pages_written_ * BUSTUB_PAGE_SIZE;
+  stats.stored_bytes_ = stored_bytes_;
+  stats.compress_ns_ = compress_ns_;
+  stats.decompress_ns_ = decompress_ns_;
+  return stats;
+}
+
+auto CompressedDiskManager::GetDataSize() -> uint64_t {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  return file_end_;
+}
+
+}  // namespace bustub
@@ -10,8 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <mutex>  // NOLINT
@@ -37,6 +41,7 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  master_name_ = file_name_.substr(0, n) + ".master";
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -47,7 +52,11 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     if (!log_io_.is_open()) {
       throw Exception("can't open dblog file");
     }
+    // The checkpoints of an older log are not in this one.
+    remove(master_name_.c_str());
   }
+  // The stream cannot sync the file, so it is synced through a descriptor of its own.
+  log_fd_ = open(log_name_.c_str(), O_RDWR);
 
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
@@ -72,6 +81,10 @@ void DiskManager::ShutDown() {
     db_io_.close();
   }
   log_io_.close();
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
+  }
 }
 
 /**
@@ -93,6 +106,11 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
   db_io_.flush();
 }
 
+/**
+ * The pages of the database file are at the offset of their id, so the space of a deallocated page stays in the file.
+ */
+void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+
 /**
  * Read the contents of the specified page into the given memory area
  */
@@ -103,6 +121,8 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   if (offset > GetFileSize(file_name_)) {
     LOG_DEBUG("I/O error reading past end of file");
     // std::cerr << "I/O error while reading" << std::endl;
+    // A page never written reads as zeros, as the redo of the record creating it expects.
+    memset(page_data, 0, BUSTUB_PAGE_SIZE);
   } else {
     // set read cursor to offset
     db_io_.seekp(offset);
@@ -151,8 +171,11 @@ void DiskManager::WriteLog(char *log_data, int size) {
     LOG_DEBUG("I/O error while writing log");
     return;
   }
-  // needs to flush to keep disk file in sync
+  // needs to flush to keep disk file in sync, and to sync the file for the log to survive a crash
   log_io_.flush();
+  if (log_fd_ >= 0) {
+    fsync(log_fd_);
+  }
   flush_log_ = false;
 }
 
@@ -184,6 +207,52 @@ auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
   return true;
 }
 
+auto DiskManager::GetLogSize() -> int { return std::max(GetFileSize(log_name_), 0); }
+
+/**
+ * Punch a hole into the log file, so that it takes the disk space of the records after `offset` only
+ */
+void DiskManager::TruncateLog(int offset) {
+#ifdef FALLOC_FL_PUNCH_HOLE
+  if (log_fd_ >= 0 && offset > 0 && fallocate(log_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, offset) != 0) {
+    LOG_DEBUG("I/O error while truncating log");
+  }
+#endif
+}
+
+/**
+ * The master record is written in place, in a single write smaller than a sector, so that it is either the old or
+ * the new one after a crash
+ */
+void DiskManager::WriteMasterRecord(lsn_t checkpoint_lsn, int offset) {
+  int32_t record[2] = {checkpoint_lsn, offset};
+  int fd = open(master_name_.c_str(), O_WRONLY | O_CREAT, 0644);
+  if (fd < 0) {
+    throw Exception("can't open master record file");
+  }
+  bool written = pwrite(fd, record, sizeof(record), 0) == sizeof(record) && fsync(fd) == 0;
+  close(fd);
+  if (!written) {
+    throw Exception("can't write master record");
+  }
+}
+
+auto DiskManager::ReadMasterRecord(lsn_t *checkpoint_lsn, int *offset) -> bool {
+  int32_t record[2];
+  int fd = open(master_name_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  bool read_all = pread(fd, record, sizeof(record), 0) == sizeof(record);
+  close(fd);
+  if (!read_all) {
+    return false;
+  }
+  *checkpoint_lsn = record[0];
+  *offset = record[1];
+  return true;
+}
+
 /**
  * Returns number of flushes made so far
  */
@@ -28,7 +28,7 @@ INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
   return container_->Insert(index_key, rid, transaction);
 }
@@ -37,7 +37,7 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
   container_->Remove(index_key, transaction);
 }
@@ -46,7 +46,7 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
   container_->GetValue(index_key, result, transaction);
 }
@@ -0,0 +1,648 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_page.cpp
+//
+// Identification: src/storage/page/pax_table_page.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/pax_table_page.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/exception.h"
+#include "type/limits.h"
+
+namespace bustub {
+
+/** Bytes before the packed codes of a frame-of-reference minipage: | encoding (1) | width (1) | pad (2) | min (8) | */
+static constexpr uint32_t FOR_HEADER_SIZE = 12;
+
+/** Bytes before the runs of a run-length minipage: | encoding (1) | unused (1) | number of runs (2) | */
+static constexpr uint32_t RLE_HEADER_SIZE = 4;
+
+/** Bytes of a run: | value (8) | end slot, exclusive (2) | */
+static constexpr uint32_t RLE_RUN_SIZE = 10;
+
+/**
+ * Bytes before the heap offsets of a dictionary minipage: | encoding (1) | width (1) | number of offsets (2) |. The
+ * offsets take 2 bytes each and are followed by the packed codes.
+ */
+static constexpr uint32_t DICT_HEADER_SIZE = 4;
+
+/** @return the size of a varchar serialized into the heap, including its length */
+static auto VarcharPayloadSize(const Value &value) -> uint32_t {
+  return sizeof(uint32_t) + (value.IsNull() ? 0 : value.GetLength());
+}
+
+/** @return the size of a varchar serialized into the heap at `payload`, including its length */
+static auto VarcharPayloadSize(const char *payload) -> uint32_t {
+  auto len = *reinterpret_cast<const uint32_t *>(payload);
+  return sizeof(uint32_t) + (len == BUSTUB_VALUE_NULL ? 0 : len);
+}
+
+/** @return whether `type` is one of the integer types */
+static auto IsIntegerType(TypeId type) -> bool {
+  switch (type) {
+    case TypeId::TINYINT:
+    case TypeId::SMALLINT:
+    case TypeId::INTEGER:
+    case TypeId::BIGINT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** @return the integer of type `type` serialized at `data`, null values included */
+static auto ReadInteger(const char *data, TypeId type) -> int64_t {
+  switch (type) {
+    case TypeId::TINYINT:
+      return *reinterpret_cast<const int8_t *>(data);
+    case TypeId::SMALLINT:
+      return *reinterpret_cast<const int16_t *>(data);
+    case TypeId::INTEGER:
+      return *reinterpret_cast<const int32_t *>(data);
+    default:
+      return *reinterpret_cast<const int64_t *>(data);
+  }
+}
+
+/** Serialize `value` as an integer of type `type` to `data`. */
+static void WriteInteger(char *data, TypeId type, int64_t value) {
+  switch (type) {
+    case TypeId::TINYINT:
+      *reinterpret_cast<int8_t *>(data) = static_cast<int8_t>(value);
+      break;
+    case TypeId::SMALLINT:
+      *reinterpret_cast<int16_t *>(data) = static_cast<int16_t>(value);
+      break;
+    case TypeId::INTEGER:
+      *reinterpret_cast<int32_t *>(data) = static_cast<int32_t>(value);
+      break;
+    default:
+      *reinterpret_cast<int64_t *>(data) = value;
+      break;
+  }
+}
+
+/** @return the smallest and the largest non-null integer of type `type` */
+static auto IntegerRange(TypeId type) -> std::pair<int64_t, int64_t> {
+  switch (type) {
+    case TypeId::TINYINT:
+      return {BUSTUB_INT8_MIN, BUSTUB_INT8_MAX};
+    case TypeId::SMALLINT:
+      return {BUSTUB_INT16_MIN, BUSTUB_INT16_MAX};
+    case TypeId::INTEGER:
+      return {BUSTUB_INT32_MIN, BUSTUB_INT32_MAX};
+    default:
+      return {BUSTUB_INT64_MIN, BUSTUB_INT64_MAX};
+  }
+}
+
+/** @return the number of bits needed to store `value` */
+static auto BitWidth(uint64_t value) -> uint32_t {
+  uint32_t width = 0;
+  for (; value != 0; value >>= 1) {
+    width++;
+  }
+  return width;
+}
+
+/** @return the bytes of `n` codes of `width` bits, packed into whole 8-byte words */
+static auto PackedSize(size_t n, uint32_t width) -> uint32_t { return (n * width + 63) / 64 * 8; }
+
+/** Append `codes`, packed into `width` bits each, to `out`. */
+static void Pack(const std::vector<uint64_t> &codes, uint32_t width, std::string *out) {
+  std::vector<uint64_t> words(PackedSize(codes.size(), width) / 8, 0);
+  for (size_t i = 0; i < codes.size() && width > 0; i++) {
+    auto bit = i * width;
+    auto shift = bit % 64;
+    words[bit / 64] |= codes[i] << shift;
+    if (shift + width > 64) {
+      words[bit / 64 + 1] |= codes[i] >> (64 - shift);
+    }
+  }
+  out->append(reinterpret_cast<const char *>(words.data()), words.size() * 8);
+}
+
+/** @return code `i` of the codes packed into `width` bits each at `data` */
+static auto Unpack(const char *data, uint32_t width, size_t i) -> uint64_t {
+  if (width == 0) {
+    return 0;
+  }
+  auto bit = i * width;
+  auto shift = bit % 64;
+  uint64_t word;
+  memcpy(&word, data + bit / 64 * 8, sizeof(word));
+  auto code = word >> shift;
+  if (shift + width > 64) {
+    memcpy(&word, data + (bit / 64 + 1) * 8, sizeof(word));
+    code |= word << (64 - shift);
+  }
+  return width == 64 ? code : code & ((uint64_t{1} << width) - 1);
+}
+
+/** @return the integers `values` encoded as bit-packed differences from the smallest one */
+static auto EncodeFrameOfReference(const std::vector<uint64_t> &values) -> std::string {
+  auto base = static_cast<int64_t>(*std::min_element(values.begin(), values.end(), [](uint64_t a, uint64_t b) {
+    return static_cast<int64_t>(a) < static_cast<int64_t>(b);
+  }));
+  std::vector<uint64_t> codes;
+  codes.reserve(values.size());
+  uint64_t max_code = 0;
+  for (auto value : values) {
+    codes.push_back(value - static_cast<uint64_t>(base));
+    max_code = std::max(max_code, codes.back());
+  }
+  auto width = BitWidth(max_code);
+  std::string out(FOR_HEADER_SIZE, '\0');
+  out[0] = static_cast<char>(ColumnEncoding::FRAME_OF_REFERENCE);
+  out[1] = static_cast<char>(width);
+  memcpy(out.data() + 4, &base, sizeof(base));
+  Pack(codes, width, &out);
+  return out;
+}
+
+/** @return the integers `values` encoded as runs of equal values */
+static auto EncodeRunLength(const std::vector<uint64_t> &values) -> std::string {
+  std::string out(RLE_HEADER_SIZE, '\0');
+  out[0] = static_cast<char>(ColumnEncoding::RUN_LENGTH);
+  uint16_t num_runs = 0;
+  for (size_t begin = 0; begin < values.size();) {
+    auto end = begin + 1;
+    while (end < values.size() && values[end] == values[begin]) {
+      end++;
+    }
+    char run[RLE_RUN_SIZE];
+    auto end_slot = static_cast<uint16_t>(end);
+    memcpy(run, &values[begin], sizeof(uint64_t));
+    memcpy(run + sizeof(uint64_t), &end_slot, sizeof(end_slot));
+    out.append(run, RLE_RUN_SIZE);
+    num_runs++;
+    begin = end;
+  }
+  memcpy(out.data() + 2, &num_runs, sizeof(num_runs));
+  return out;
+}
+
+/** @return the heap offsets `offsets` encoded as bit-packed indexes into the list of the distinct ones */
+static auto EncodeDictionary(const std::vector<uint64_t> &offsets) -> std::string {
+  std::vector<uint64_t> dictionary(offsets);
+  std::sort(dictionary.begin(), dictionary.end());
+  dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+  std::vector<uint64_t> codes;
+  codes.reserve(offsets.size());
+  for (auto offset : offsets) {
+    codes.push_back(std::lower_bound(dictionary.begin(), dictionary.end(), offset) - dictionary.begin());
+  }
+  auto width = BitWidth(dictionary.size() - 1);
+  std::string out(DICT_HEADER_SIZE, '\0');
+  out[0] = static_cast<char>(ColumnEncoding::DICTIONARY);
+  out[1] = static_cast<char>(width);
+  auto size = static_cast<uint16_t>(dictionary.size());
+  memcpy(out.data() + 2, &size, sizeof(size));
+  for (auto offset : dictionary) {
+    auto heap_offset = static_cast<uint16_t>(offset);
+    out.append(reinterpret_cast<const char *>(&heap_offset), sizeof(heap_offset));
+  }
+  Pack(codes, width, &out);
+  return out;
+}
+
+void PaxTablePage::Init(const Schema &schema) {
+  next_page_id_ = INVALID_PAGE_ID;
+  num_tuples_ = 0;
+  num_deleted_tuples_ = 0;
+  capacity_ = ComputeCapacity(schema);
+  heap_start_ = BUSTUB_PAGE_SIZE;
+  encoded_columns_ = 0;
+}
+
+auto PaxTablePage::ComputeCapacity(const Schema &schema) -> uint16_t {
+  size_t tuple_size = TUPLE_META_SIZE;
+  for (const auto &column : schema.GetColumns()) {
+    tuple_size += EntrySize(column);
+    if (!column.IsInlined()) {
+      tuple_size += sizeof(uint32_t) + std::min(column.GetVariableLength(), PAX_VARCHAR_RESERVE);
+    }
+  }
+  auto capacity = (BUSTUB_PAGE_SIZE - PAX_TABLE_PAGE_HEADER_SIZE) / tuple_size;
+  return std::clamp<size_t>(capacity, 1, UINT16_MAX);
+}
+
+auto PaxTablePage::EntrySize(const Column &column) -> uint32_t {
+  return column.IsInlined() ? column.GetFixedLength() : sizeof(uint32_t);
+}
+
+auto PaxTablePage::EntryOffset(const Schema &schema, uint32_t column_idx, uint16_t slot) const -> uint32_t {
+  uint32_t offset = PAX_TABLE_PAGE_HEADER_SIZE + capacity_ * TUPLE_META_SIZE;
+  for (uint32_t i = 0; i < column_idx; i++) {
+    offset += capacity_ * EntrySize(schema.GetColumn(i));
+  }
+  return offset + slot * (column_idx < schema.GetColumnCount() ? EntrySize(schema.GetColumn(column_idx)) : 0);
+}
+
+auto PaxTablePage::ValueData(const Schema &schema, uint32_t column_idx, uint16_t slot) const -> const char * {
+  const char *entry = page_start_ + EntryOffset(schema, column_idx, slot);
+  if (schema.GetColumn(column_idx).IsInlined()) {
+    return entry;
+  }
+  return page_start_ + *reinterpret_cast<const uint32_t *>(entry);
+}
+
+auto PaxTablePage::InsertTuple(const Schema &schema, const TupleMeta &meta, const Tuple &tuple)
+    -> std::optional<uint16_t> {
+  if (num_tuples_ == capacity_ || encoded_columns_ != 0) {
+    return std::nullopt;
+  }
+  // Only the varchars the heap does not hold yet take space.
+  size_t heap_size = 0;
+  for (auto i : schema.GetUnlinedColumns()) {
+    auto value = tuple.GetValue(&schema, i);
+    if (!FindInHeap(value).has_value()) {
+      heap_size += VarcharPayloadSize(value);
+    }
+  }
+  auto minipages_end = EntryOffset(schema, schema.GetColumnCount(), 0);
+  if (heap_start_ < minipages_end + heap_size) {
+    return std::nullopt;
+  }
+
+  auto slot = num_tuples_;
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    const auto &column = schema.GetColumn(i);
+    char *entry = page_start_ + EntryOffset(schema, i, slot);
+    if (column.IsInlined()) {
+      memcpy(entry, tuple.GetData() + column.GetOffset(), column.GetFixedLength());
+      continue;
+    }
+    auto value = tuple.GetValue(&schema, i);
+    auto heap_offset = FindInHeap(value);
+    if (!heap_offset.has_value()) {
+      heap_start_ -= VarcharPayloadSize(value);
+      value.SerializeTo(page_start_ + heap_start_);
+      heap_offset = heap_start_;
+    }
+    *reinterpret_cast<uint32_t *>(entry) = *heap_offset;
+  }
+  TupleMetas()[slot] = meta;
+  num_tuples_++;
+  return slot;
+}
+
+auto PaxTablePage::FindInHeap(const Value &value) const -> std::optional<uint32_t> {
+  uint32_t len = value.IsNull() ? BUSTUB_VALUE_NULL : value.GetLength();
+  for (uint32_t offset = heap_start_; offset < BUSTUB_PAGE_SIZE; offset += VarcharPayloadSize(page_start_ + offset)) {
+    if (*reinterpret_cast<const uint32_t *>(page_start_ + offset) == len &&
+        (value.IsNull() || memcmp(page_start_ + offset + sizeof(uint32_t), value.GetData(), len) == 0)) {
+      return offset;
+    }
+  }
+  return std::nullopt;
+}
+
+void PaxTablePage::UpdateTupleMeta(const TupleMeta &meta, const RID &rid) {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  if (!TupleMetas()[tuple_id].is_deleted_ && meta.is_deleted_) {
+    num_deleted_tuples_++;
+  }
+  TupleMetas()[tuple_id] = meta;
+}
+
+auto PaxTablePage::GetTuple(const Schema &schema, const RID &rid) const -> std::pair<TupleMeta, Tuple> {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  std::vector<Value> values;
+  values.reserve(schema.GetColumnCount());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    values.emplace_back(ReadValue(schema, i, tuple_id));
+  }
+  return std::make_pair(TupleMetas()[tuple_id], Tuple(std::move(values), &schema));
+}
+
+auto PaxTablePage::GetTupleMeta(const RID &rid) const -> TupleMeta {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  return TupleMetas()[tuple_id];
+}
+
+auto PaxTablePage::GetValue(const Schema &schema, const RID &rid, uint32_t column_idx) const -> Value {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  return ReadValue(schema, column_idx, tuple_id);
+}
+
+auto PaxTablePage::FitsUpdate(const Schema &schema, const Tuple &tuple) const -> bool {
+  size_t heap_size = 0;
+  for (auto i : schema.GetUnlinedColumns()) {
+    auto value = tuple.GetValue(&schema, i);
+    if (!FindInHeap(value).has_value()) {
+      heap_size += VarcharPayloadSize(value);
+    }
+  }
+  return heap_start_ >= EntryOffset(schema, schema.GetColumnCount(), 0) + heap_size;
+}
+
+void PaxTablePage::UpdateTupleInPlaceUnsafe(const Schema &schema, const TupleMeta &meta, const Tuple &tuple,
+                                            RID rid) {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  // Make sure the new varchars fit before changing anything.
+  if (!FitsUpdate(schema, tuple)) {
+    throw bustub::Exception("Tuple does not fit into the page");
+  }
+  Unseal(schema);
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    const auto &column = schema.GetColumn(i);
+    char *entry = page_start_ + EntryOffset(schema, i, tuple_id);
+    if (column.IsInlined()) {
+      memcpy(entry, tuple.GetData() + column.GetOffset(), column.GetFixedLength());
+      continue;
+    }
+    // The old value may be shared with other tuples, so it is left in the heap.
+    auto value = tuple.GetValue(&schema, i);
+    auto heap_offset = FindInHeap(value);
+    if (!heap_offset.has_value()) {
+      heap_start_ -= VarcharPayloadSize(value);
+      value.SerializeTo(page_start_ + heap_start_);
+      heap_offset = heap_start_;
+    }
+    *reinterpret_cast<uint32_t *>(entry) = *heap_offset;
+  }
+  UpdateTupleMeta(meta, rid);
+}
+
+auto PaxTablePage::ReadValue(const Schema &schema, uint32_t column_idx, uint16_t slot) const -> Value {
+  const auto &column = schema.GetColumn(column_idx);
+  if (!IsEncoded(column_idx)) {
+    return Value::DeserializeFrom(ValueData(schema, column_idx, slot), column.GetType());
+  }
+  const char *minipage = page_start_ + EntryOffset(schema, column_idx, 0);
+  if (GetEncoding(schema, column_idx) == ColumnEncoding::DICTIONARY) {
+    uint32_t width = static_cast<uint8_t>(minipage[1]);
+    uint16_t size;
+    memcpy(&size, minipage + 2, sizeof(size));
+    uint16_t heap_offset;
+    auto code = Unpack(minipage + DICT_HEADER_SIZE + size * sizeof(uint16_t), width, slot);
+    memcpy(&heap_offset, minipage + DICT_HEADER_SIZE + code * sizeof(uint16_t), sizeof(heap_offset));
+    return Value::DeserializeFrom(page_start_ + heap_offset, column.GetType());
+  }
+  int64_t integer;
+  if (GetEncoding(schema, column_idx) == ColumnEncoding::FRAME_OF_REFERENCE) {
+    memcpy(&integer, minipage + 4, sizeof(integer));
+    integer += static_cast<int64_t>(Unpack(minipage + FOR_HEADER_SIZE, static_cast<uint8_t>(minipage[1]), slot));
+  } else {
+    uint16_t num_runs;
+    memcpy(&num_runs, minipage + 2, sizeof(num_runs));
+    // Find the first run ending after the slot.
+    uint16_t lo = 0;
+    uint16_t hi = num_runs - 1;
+    while (lo < hi) {
+      uint16_t mid = (lo + hi) / 2;
+      uint16_t end;
+      memcpy(&end, minipage + RLE_HEADER_SIZE + mid * RLE_RUN_SIZE + sizeof(int64_t), sizeof(end));
+      if (end <= slot) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    memcpy(&integer, minipage + RLE_HEADER_SIZE + lo * RLE_RUN_SIZE, sizeof(integer));
+  }
+  char data[sizeof(int64_t)];
+  WriteInteger(data, column.GetType(), integer);
+  return Value::DeserializeFrom(data, column.GetType());
+}
+
+auto PaxTablePage::DecodeEntries(const Schema &schema, uint32_t column_idx) const -> std::vector<uint64_t> {
+  const auto &column = schema.GetColumn(column_idx);
+  const char *minipage = page_start_ + EntryOffset(schema, column_idx, 0);
+  std::vector<uint64_t> entries;
+  entries.reserve(num_tuples_);
+  switch (GetEncoding(schema, column_idx)) {
+    case ColumnEncoding::PLAIN:
+      for (uint16_t slot = 0; slot < num_tuples_; slot++) {
+        const char *entry = minipage + slot * EntrySize(column);
+        entries.push_back(column.IsInlined() ? ReadInteger(entry, column.GetType())
+                                             : *reinterpret_cast<const uint32_t *>(entry));
+      }
+      break;
+    case ColumnEncoding::FRAME_OF_REFERENCE: {
+      uint64_t base;
+      memcpy(&base, minipage + 4, sizeof(base));
+      for (uint16_t slot = 0; slot < num_tuples_; slot++) {
+        entries.push_back(base + Unpack(minipage + FOR_HEADER_SIZE, static_cast<uint8_t>(minipage[1]), slot));
+      }
+      break;
+    }
+    case ColumnEncoding::RUN_LENGTH: {
+      uint16_t num_runs;
+      memcpy(&num_runs, minipage + 2, sizeof(num_runs));
+      for (uint16_t run = 0; run < num_runs; run++) {
+        uint64_t value;
+        uint16_t end;
+        memcpy(&value, minipage + RLE_HEADER_SIZE + run * RLE_RUN_SIZE, sizeof(value));
+        memcpy(&end, minipage + RLE_HEADER_SIZE + run * RLE_RUN_SIZE + sizeof(value), sizeof(end));
+        entries.resize(end, value);
+      }
+      break;
+    }
+    case ColumnEncoding::DICTIONARY: {
+      uint16_t size;
+      memcpy(&size, minipage + 2, sizeof(size));
+      uint32_t width = static_cast<uint8_t>(minipage[1]);
+      for (uint16_t slot = 0; slot < num_tuples_; slot++) {
+        auto code = Unpack(minipage + DICT_HEADER_SIZE + size * sizeof(uint16_t), width, slot);
+        uint16_t heap_offset;
+        memcpy(&heap_offset, minipage + DICT_HEADER_SIZE + code * sizeof(uint16_t), sizeof(heap_offset));
+        entries.push_back(heap_offset);
+      }
+      break;
+    }
+  }
+  return entries;
+}
+
+auto PaxTablePage::GetEncoding(const Schema &schema, uint32_t column_idx) const -> ColumnEncoding {
+  if (!IsEncoded(column_idx)) {
+    return ColumnEncoding::PLAIN;
+  }
+  return static_cast<ColumnEncoding>(page_start_[EntryOffset(schema, column_idx, 0)]);
+}
+
+void PaxTablePage::Seal(const Schema &schema) {
+  for (uint32_t i = 0; i < std::min<uint32_t>(schema.GetColumnCount(), 32) && num_tuples_ > 0; i++) {
+    const auto &column = schema.GetColumn(i);
+    if (IsEncoded(i) || (column.IsInlined() && !IsIntegerType(column.GetType()))) {
+      continue;
+    }
+    auto entries = DecodeEntries(schema, i);
+    std::string encoded;
+    if (column.IsInlined()) {
+      encoded = EncodeFrameOfReference(entries);
+      auto run_length = EncodeRunLength(entries);
+      if (run_length.size() < encoded.size()) {
+        encoded = std::move(run_length);
+      }
+    } else {
+      encoded = EncodeDictionary(entries);
+    }
+    if (encoded.size() >= num_tuples_ * EntrySize(column)) {
+      continue;
+    }
+    // Zero the rest of the minipage, so that it takes no space once the page is compressed.
+    char *minipage = page_start_ + EntryOffset(schema, i, 0);
+    memcpy(minipage, encoded.data(), encoded.size());
+    memset(minipage + encoded.size(), 0, capacity_ * EntrySize(column) - encoded.size());
+    encoded_columns_ |= uint32_t{1} << i;
+  }
+}
+
+void PaxTablePage::Unseal(const Schema &schema) {
+  for (uint32_t i = 0; i < schema.GetColumnCount() && encoded_columns_ != 0; i++) {
+    if (!IsEncoded(i)) {
+      continue;
+    }
+    const auto &column = schema.GetColumn(i);
+    auto entries = DecodeEntries(schema, i);
+    encoded_columns_ &= ~(uint32_t{1} << i);
+    char *minipage = page_start_ + EntryOffset(schema, i, 0);
+    for (uint16_t slot = 0; slot < num_tuples_; slot++) {
+      if (column.IsInlined()) {
+        WriteInteger(minipage + slot * EntrySize(column), column.GetType(), static_cast<int64_t>(entries[slot]));
+      } else {
+        *reinterpret_cast<uint32_t *>(minipage + slot * EntrySize(column)) = entries[slot];
+      }
+    }
+  }
+}
+
+auto PaxTablePage::MatchEqual(const Schema &schema, uint32_t column_idx, const Value &value,
+                              std::vector<bool> *matches) const -> bool {
+  const auto &column = schema.GetColumn(column_idx);
+  if (column.IsInlined() ? !IsIntegerType(column.GetType()) || !IsIntegerType(value.GetTypeId())
+                         : value.GetTypeId() != TypeId::VARCHAR) {
+    return false;
+  }
+  matches->assign(num_tuples_, false);
+  // Nothing equals null.
+  if (value.IsNull()) {
+    return true;
+  }
+
+  // Find the code of the value first, there is nothing to compare with if the page has none.
+  uint64_t target;
+  if (column.IsInlined()) {
+    auto integer = value.CastAs(TypeId::BIGINT).GetAs<int64_t>();
+    auto [min, max] = IntegerRange(column.GetType());
+    if (integer < min || integer > max) {
+      return true;
+    }
+    target = integer;
+  } else {
+    auto heap_offset = FindInHeap(value);
+    if (!heap_offset.has_value()) {
+      return true;
+    }
+    target = *heap_offset;
+  }
+
+  const char *minipage = page_start_ + EntryOffset(schema, column_idx, 0);
+  switch (GetEncoding(schema, column_idx)) {
+    case ColumnEncoding::PLAIN: {
+      for (uint16_t slot = 0; slot < num_tuples_; slot++) {
+        const char *entry = minipage + slot * EntrySize(column);
+        (*matches)[slot] = column.IsInlined()
+                               ? static_cast<uint64_t>(ReadInteger(entry, column.GetType())) == target
+                               : *reinterpret_cast<const uint32_t *>(entry) == target;
+      }
+      break;
+    }
+    case ColumnEncoding::FRAME_OF_REFERENCE: {
+      uint64_t base;
+      memcpy(&base, minipage + 4, sizeof(base));
+      uint32_t width = static_cast<uint8_t>(minipage[1]);
+      auto code = target - base;
+      if (static_cast<int64_t>(target) < static_cast<int64_t>(base) || (width < 64 && code >> width != 0)) {
+        break;
+      }
+      for (uint16_t slot = 0; slot < num_tuples_; slot++) {
+        (*matches)[slot] = Unpack(minipage + FOR_HEADER_SIZE, width, slot) == code;
+      }
+      break;
+    }
+    case ColumnEncoding::RUN_LENGTH: {
+      uint16_t num_runs;
+      memcpy(&num_runs, minipage + 2, sizeof(num_runs));
+      uint16_t begin = 0;
+      for (uint16_t run = 0; run < num_runs; run++) {
+        uint64_t run_value;
+        uint16_t end;
+        memcpy(&run_value, minipage + RLE_HEADER_SIZE + run * RLE_RUN_SIZE, sizeof(run_value));
+        memcpy(&end, minipage + RLE_HEADER_SIZE + run * RLE_RUN_SIZE + sizeof(run_value), sizeof(end));
+        if (run_value == target) {
+          std::fill(matches->begin() + begin, matches->begin() + end, true);
+        }
+        begin = end;
+      }
+      break;
+    }
+    case ColumnEncoding::DICTIONARY: {
+      uint16_t size;
+      memcpy(&size, minipage + 2, sizeof(size));
+      uint32_t width = static_cast<uint8_t>(minipage[1]);
+      for (uint16_t code = 0; code < size; code++) {
+        uint16_t heap_offset;
+        memcpy(&heap_offset, minipage + DICT_HEADER_SIZE + code * sizeof(uint16_t), sizeof(heap_offset));
+        if (heap_offset != target) {
+          continue;
+        }
+        for (uint16_t slot = 0; slot < num_tuples_; slot++) {
+          (*matches)[slot] = Unpack(minipage + DICT_HEADER_SIZE + size * sizeof(uint16_t), width, slot) == code;
+        }
+      }
+      break;
+    }
+  }
+  return true;
+}
+
+auto PaxTablePage::GetCodes(const Schema &schema, uint32_t column_idx, std::vector<uint32_t> *codes,
+                            std::vector<Value> *dictionary) const -> bool {
+  if (schema.GetColumn(column_idx).IsInlined()) {
+    return false;
+  }
+  codes->clear();
+  dictionary->clear();
+  std::unordered_map<uint64_t, uint32_t> code_of;
+  for (auto heap_offset : DecodeEntries(schema, column_idx)) {
+    auto [it, inserted] = code_of.emplace(heap_offset, dictionary->size());
+    if (inserted) {
+      dictionary->emplace_back(Value::DeserializeFrom(page_start_ + heap_offset, TypeId::VARCHAR));
+    }
+    codes->push_back(it->second);
+  }
+  return true;
+}
+
+}  // namespace bustub
@@ -12,10 +12,12 @@
 
 #include "storage/page/table_page.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <optional>
 #include <tuple>
+#include <vector>
 #include "common/config.h"
 #include "common/exception.h"
 #include "storage/table/tuple.h"
@@ -24,34 +26,99 @@ namespace bustub {
 
 void TablePage::Init() {
   next_page_id_ = INVALID_PAGE_ID;
+  lsn_ = INVALID_LSN;
   num_tuples_ = 0;
   num_deleted_tuples_ = 0;
+  tuple_start_ = BUSTUB_PAGE_SIZE;
+  num_free_slots_ = 0;
+}
+
+/** @return whether a slot holds a tuple whose deletion is complete, so its bytes can be given back */
+static auto IsReclaimable(uint16_t size, const TupleMeta &meta) -> bool {
+  return size > 0 && meta.is_deleted_ && meta.delete_txn_id_ == INVALID_TXN_ID;
 }
 
 auto TablePage::GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t> {
-  size_t slot_end_offset;
-  if (num_tuples_ > 0) {
-    auto &[offset, size, meta] = tuple_info_[num_tuples_ - 1];
-    slot_end_offset = offset;
-  } else {
-    slot_end_offset = BUSTUB_PAGE_SIZE;
+  if (tuple.GetLength() > tuple_start_) {
+    return std::nullopt;
   }
-  auto tuple_offset = slot_end_offset - tuple.GetLength();
-  auto offset_size = TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * (num_tuples_ + 1);
+  auto tuple_offset = tuple_start_ - tuple.GetLength();
+  auto offset_size = TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * (num_tuples_ + (num_free_slots_ > 0 ? 0 : 1));
   if (tuple_offset < offset_size) {
     return std::nullopt;
   }
   return tuple_offset;
 }
 
+auto TablePage::GetFreeSpace() const -> uint32_t {
+  return tuple_start_ - (TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * num_tuples_) +
+         (num_free_slots_ > 0 ? TUPLE_INFO_SIZE : 0);
+}
+
+auto TablePage::GetReclaimableSpace() const -> uint32_t {
+  // Everything past the free space pointer but the tuples kept, which includes the bytes left by moved tuples.
+  uint32_t reclaimable = BUSTUB_PAGE_SIZE - tuple_start_;
+  for (uint16_t i = 0; i < num_tuples_; i++) {
+    auto &[offset, size, meta] = tuple_info_[i];
+    if (!IsReclaimable(size, meta)) {
+      reclaimable -= size;
+    }
+  }
+  return reclaimable;
+}
+
+auto TablePage::Compact() -> uint32_t {
+  std::vector<uint16_t> live;
+  uint32_t reclaimed = BUSTUB_PAGE_SIZE - tuple_start_;
+  for (uint16_t i = 0; i < num_tuples_; i++) {
+    auto &[offset, size, meta] = tuple_info_[i];
+    if (IsReclaimable(size, meta)) {
+      size = 0;
+      num_free_slots_++;
+    } else if (size > 0) {
+      reclaimed -= size;
+      live.push_back(i);
+    }
+  }
+  if (reclaimed == 0) {
+    return 0;
+  }
+  // Move the tuples closest to the end of the page first, so that no tuple is overwritten before it is moved.
+  std::sort(live.begin(), live.end(),
+            [this](uint16_t a, uint16_t b) { return std::get<0>(tuple_info_[a]) > std::get<0>(tuple_info_[b]); });
+  size_t cursor = BUSTUB_PAGE_SIZE;
+  for (auto i : live) {
+    auto &[offset, size, meta] = tuple_info_[i];
+    cursor -= size;
+    memmove(page_start_ + cursor, page_start_ + offset, size);
+    offset = cursor;
+  }
+  tuple_start_ = cursor;
+  return reclaimed;
+}
+
 auto TablePage::InsertTuple(const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t> {
   auto tuple_offset = GetNextTupleOffset(meta, tuple);
   if (tuple_offset == std::nullopt) {
     return std::nullopt;
   }
-  auto tuple_id = num_tuples_;
+  uint16_t tuple_id = num_tuples_;
+  if (num_free_slots_ > 0) {
+    // Reuse the first slot freed by Compact(), it counted as a deleted tuple until now.
+    tuple_id = 0;
+    while (std::get<1>(tuple_info_[tuple_id]) != 0 || !std::get<2>(tuple_info_[tuple_id]).is_deleted_) {
+      tuple_id++;
+    }
+    num_free_slots_--;
+    num_deleted_tuples_--;
+  } else {
+    num_tuples_++;
+  }
+  if (meta.is_deleted_) {
+    num_deleted_tuples_++;
+  }
   tuple_info_[tuple_id] = std::make_tuple(*tuple_offset, tuple.GetLength(), meta);
-  num_tuples_++;
+  tuple_start_ = *tuple_offset;
   memcpy(page_start_ + *tuple_offset, tuple.data_.data(), tuple.GetLength());
   return tuple_id;
 }
@@ -81,6 +148,15 @@ auto TablePage::GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple> {
   return std::make_pair(meta, std::move(tuple));
 }
 
+auto TablePage::GetTupleRef(const RID &rid) const -> std::pair<TupleMeta, TupleRef> {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  auto &[offset, size, meta] = tuple_info_[tuple_id];
+  return std::make_pair(meta, TupleRef(page_start_ + offset, size, rid));
+}
+
 auto TablePage::GetTupleMeta(const RID &rid) const -> TupleMeta {
   auto tuple_id = rid.GetSlotNum();
   if (tuple_id >= num_tuples_) {
@@ -90,20 +166,45 @@ auto TablePage::GetTupleMeta(const RID &rid) const -> TupleMeta {
   return meta;
 }
 
+auto TablePage::FitsUpdate(const Tuple &tuple, RID rid) const -> bool {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    return false;
+  }
+  auto &[offset, size, meta] = tuple_info_[tuple_id];
+  if (tuple.GetLength() <= size) {
+    return true;
+  }
+  // The bytes of the old tuple are given back too, once it is moved.
+  uint32_t old_size = IsReclaimable(size, meta) ? 0 : size;
+  return tuple_start_ - (TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * num_tuples_) + GetReclaimableSpace() + old_size >=
+         tuple.GetLength();
+}
+
 void TablePage::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid) {
   auto tuple_id = rid.GetSlotNum();
   if (tuple_id >= num_tuples_) {
     throw bustub::Exception("Tuple ID out of range");
   }
+  if (!FitsUpdate(tuple, rid)) {
+    throw bustub::Exception("Tuple does not fit into the page");
+  }
   auto &[offset, size, old_meta] = tuple_info_[tuple_id];
-  if (size != tuple.GetLength()) {
-    throw bustub::Exception("Tuple size mismatch");
+  auto new_offset = offset;
+  if (tuple.GetLength() > size) {
+    if (tuple_start_ < TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * num_tuples_ + tuple.GetLength()) {
+      // Only compaction makes room. The old bytes are dropped with the gaps, as they are overwritten anyway.
+      size = 0;
+      Compact();
+    }
+    new_offset = tuple_start_ - tuple.GetLength();
+    tuple_start_ = new_offset;
   }
   if (!old_meta.is_deleted_ && meta.is_deleted_) {
     num_deleted_tuples_++;
   }
-  tuple_info_[tuple_id] = std::make_tuple(offset, size, meta);
-  memcpy(page_start_ + offset, tuple.data_.data(), tuple.GetLength());
+  tuple_info_[tuple_id] = std::make_tuple(new_offset, tuple.GetLength(), meta);
+  memcpy(page_start_ + new_offset, tuple.data_.data(), tuple.GetLength());
 }
 
 }  // namespace bustub
@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/table/free_space_map.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/free_space_map.h"
+
+#include "common/macros.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+void FreeSpaceMap::AddPage(page_id_t page_id, uint32_t free_bytes) {
+  std::scoped_lock guard(latch_);
+  auto entry = static_cast<uint32_t>(entries_.size());
+  if (entry % FREE_SPACE_MAP_PAGE_CAPACITY == 0) {
+    page_id_t map_page_id = INVALID_PAGE_ID;
+    auto map_page_guard = bpm_->NewPageGuarded(&map_page_id);
+    BUSTUB_ENSURE(map_page_id != INVALID_PAGE_ID, "cannot allocate page");
+    map_page_guard.AsMut<FreeSpaceMapPage>()->Init();
+    map_pages_.push_back(map_page_id);
+  }
+  auto map_page_guard = bpm_->FetchPageWrite(map_pages_.back());
+  map_page_guard.AsMut<FreeSpaceMapPage>()->Append(page_id, free_bytes);
+  entries_.emplace(page_id, entry);
+}
+
+auto FreeSpaceMap::Locate(page_id_t page_id) -> std::pair<page_id_t, uint32_t> {
+  std::scoped_lock guard(latch_);
+  auto it = entries_.find(page_id);
+  BUSTUB_ASSERT(it != entries_.end(), "page is not in the free-space map");
+  return {map_pages_[it->second / FREE_SPACE_MAP_PAGE_CAPACITY], it->second % FREE_SPACE_MAP_PAGE_CAPACITY};
+}
+
+void FreeSpaceMap::Update(page_id_t page_id, uint32_t free_bytes) {
+  auto [map_page_id, idx] = Locate(page_id);
+  auto map_page_guard = bpm_->FetchPageWrite(map_page_id);
+  map_page_guard.AsMut<FreeSpaceMapPage>()->Set(idx, free_bytes);
+}
+
+auto FreeSpaceMap::FindPage(uint32_t needed) -> std::optional<page_id_t> {
+  std::unique_lock guard(latch_);
+  auto num_map_pages = map_pages_.size();
+  guard.unlock();
+  if (num_map_pages == 0) {
+    return std::nullopt;
+  }
+
+  auto start = next_entry_.load();
+  auto start_map_idx = (start / FREE_SPACE_MAP_PAGE_CAPACITY) % num_map_pages;
+  for (size_t i = 0; i < num_map_pages; i++) {
+    auto map_idx = (start_map_idx + i) % num_map_pages;
+    guard.lock();
+    auto map_page_id = map_pages_[map_idx];
+    guard.unlock();
+
+    {
+      auto map_page_guard = bpm_->FetchPageRead(map_page_id);
+      auto map_page = map_page_guard.As<FreeSpaceMapPage>();
+      if (!map_page->MayFit(needed)) {
+        continue;
+      }
+      auto idx = map_page->Find(needed, i == 0 ? start % FREE_SPACE_MAP_PAGE_CAPACITY : 0);
+      if (idx.has_value()) {
+        next_entry_ = map_idx * FREE_SPACE_MAP_PAGE_CAPACITY + *idx + 1;
+        return map_page->GetPageId(*idx);
+      }
+    }
+    // The page claimed to have room but has none, lower its bound so that later searches skip it.
+    auto map_page_guard = bpm_->FetchPageWrite(map_page_id);
+    map_page_guard.AsMut<FreeSpaceMapPage>()->RefreshMaxCategory();
+  }
+  return std::nullopt;
+}
+
+}  // namespace bustub
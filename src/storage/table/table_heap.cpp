@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
 #include <mutex>  // NOLINT
 #include <utility>
@@ -26,37 +27,209 @@
 
 namespace bustub {
 
-TableHeap::TableHeap(BufferPoolManager *bpm) : bpm_(bpm) {
+/** @return the transaction that wrote the version of a tuple described by `meta` */
+static auto WriterOf(const TupleMeta &meta) -> txn_id_t {
+  return meta.is_deleted_ ? meta.delete_txn_id_ : meta.insert_txn_id_;
+}
+
+/**
+ * @return whether `txn` locked the tuple it inserted at `rid` exclusively; a lock manager that gives up on it by
+ * throwing refused it as well
+ */
+static auto LockInsertedTuple(LockManager *lock_mgr, Transaction *txn, table_oid_t oid, RID rid) -> bool {
+  try {
+    return lock_mgr->LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, rid);
+  } catch (TransactionAbortException &) {
+    return false;
+  }
+}
+
+TableHeap::TableHeap(BufferPoolManager *bpm, LogManager *log_manager)
+    : bpm_(bpm), log_manager_(log_manager), fsm_(std::make_unique<FreeSpaceMap>(bpm)) {
   // Initialize the first table page.
   auto guard = bpm->NewPageGuarded(&first_page_id_);
   last_page_id_ = first_page_id_;
   auto first_page = guard.AsMut<TablePage>();
   BUSTUB_ASSERT(first_page != nullptr,
                 "Couldn't create a page for the table heap. Have you completed the buffer pool manager project?");
-  first_page->Init();
+  InitNewPage(INVALID_PAGE_ID, nullptr, first_page_id_, guard.GetDataMut());
+  fsm_->AddPage(first_page_id_, first_page->GetFreeSpace());
+}
+
+TableHeap::TableHeap(BufferPoolManager *bpm, const Schema &schema, TableStorage storage, LogManager *log_manager)
+    : bpm_(bpm),
+      log_manager_(log_manager),
+      storage_(storage),
+      schema_(std::make_unique<const Schema>(schema)),
+      zone_map_(std::make_unique<ZoneMap>(schema)) {
+  auto guard = bpm->NewPageGuarded(&first_page_id_);
+  last_page_id_ = first_page_id_;
+  zone_map_->AddPage(first_page_id_);
+  auto first_page = guard.GetDataMut();
+  BUSTUB_ASSERT(first_page != nullptr,
+                "Couldn't create a page for the table heap. Have you completed the buffer pool manager project?");
+  InitNewPage(INVALID_PAGE_ID, nullptr, first_page_id_, first_page);
+  if (storage_ == TableStorage::ROW) {
+    fsm_ = std::make_unique<FreeSpaceMap>(bpm);
+    fsm_->AddPage(first_page_id_, reinterpret_cast<TablePage *>(first_page)->GetFreeSpace());
+    toast_ = std::make_unique<ToastStore>(bpm);
+  }
+}
+
+void TableHeap::InitPage(char *data) {
+  if (storage_ == TableStorage::PAX) {
+    reinterpret_cast<PaxTablePage *>(data)->Init(*schema_);
+  } else {
+    reinterpret_cast<TablePage *>(data)->Init();
+  }
+}
+
+auto TableHeap::GetNumTuples(const char *data) const -> uint32_t {
+  if (storage_ == TableStorage::PAX) {
+    return reinterpret_cast<const PaxTablePage *>(data)->GetNumTuples();
+  }
+  return reinterpret_cast<const TablePage *>(data)->GetNumTuples();
+}
+
+auto TableHeap::GetNextPageId(const char *data) const -> page_id_t {
+  if (storage_ == TableStorage::PAX) {
+    return reinterpret_cast<const PaxTablePage *>(data)->GetNextPageId();
+  }
+  return reinterpret_cast<const TablePage *>(data)->GetNextPageId();
+}
+
+void TableHeap::SealPage(char *data) {
+  if (pax_column_encoding) {
+    reinterpret_cast<PaxTablePage *>(data)->Seal(*schema_);
+  }
+}
+
+void TableHeap::UpdateFreeSpace(page_id_t page_id, const TablePage *page) {
+  fsm_->Update(page_id, page->GetFreeSpace() + page->GetReclaimableSpace());
+}
+
+void TableHeap::Log(LogRecord *record, page_id_t page_id, TablePage *page) {
+  // The page enters the dirty page table before the record is appended, so that a checkpoint begun after the record
+  // finds it. The next LSN is at most the one the record gets, so recovery redoes the record.
+  log_manager_->MarkDirty(page_id, log_manager_->GetNextLSN());
+  page->SetLSN(log_manager_->AppendLogRecord(record));
+}
+
+void TableHeap::Compact(page_id_t page_id, TablePage *page) {
+  if (page->Compact() > 0 && IsLogging()) {
+    LogRecord record(INVALID_TXN_ID, INVALID_LSN, LogRecordType::APPLYDELETE, page_id);
+    Log(&record, page_id, page);
+  }
+}
+
+auto TableHeap::InsertIntoPage(page_id_t page_id, TablePage *page, const TupleMeta &meta, const Tuple &tuple)
+    -> std::optional<uint16_t> {
+  auto slot_id = page->InsertTuple(meta, tuple);
+  if (slot_id.has_value() && IsLogging()) {
+    LogRecord record(WriterOf(meta), INVALID_LSN, LogRecordType::INSERT, RID(page_id, *slot_id), meta, tuple);
+    Log(&record, page_id, page);
+  }
+  return slot_id;
+}
+
+void TableHeap::InitNewPage(page_id_t prev_page_id, char *prev_data, page_id_t page_id, char *data) {
+  InitPage(data);
+  if (storage_ == TableStorage::PAX) {
+    if (prev_data != nullptr) {
+      reinterpret_cast<PaxTablePage *>(prev_data)->SetNextPageId(page_id);
+      SealPage(prev_data);
+    }
+    return;
+  }
+  auto page = reinterpret_cast<TablePage *>(data);
+  if (prev_data != nullptr) {
+    reinterpret_cast<TablePage *>(prev_data)->SetNextPageId(page_id);
+  }
+  if (IsLogging()) {
+    // The record is of both pages. The new page cannot be reached before the previous one links it.
+    LogRecord record(INVALID_TXN_ID, INVALID_LSN, LogRecordType::NEWPAGE, prev_page_id, page_id);
+    if (prev_data != nullptr) {
+      log_manager_->MarkDirty(prev_page_id, log_manager_->GetNextLSN());
+    }
+    Log(&record, page_id, page);
+    if (prev_data != nullptr) {
+      reinterpret_cast<TablePage *>(prev_data)->SetLSN(page->GetLSN());
+    }
+  }
+}
+
+auto TableHeap::InsertIntoFreeSpace(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr,
+                                    Transaction *txn, table_oid_t oid) -> std::optional<RID> {
+  auto needed = TablePage::GetRequiredSpace(tuple);
+  while (auto page_id = fsm_->FindPage(needed)) {
+    auto page_guard = bpm_->FetchPageWrite(*page_id);
+    auto page = page_guard.AsMut<TablePage>();
+    if (page->GetNextTupleOffset(meta, tuple) == std::nullopt) {
+      Compact(*page_id, page);
+    }
+    std::optional<uint16_t> slot_id;
+    if (page->GetNextTupleOffset(meta, tuple) != std::nullopt) {
+      if (zone_map_ != nullptr) {
+        zone_map_->Insert(*page_id, tuple);
+      }
+      slot_id = InsertIntoPage(*page_id, page, meta, tuple);
+    }
+    // Correct the entry either way, the map may have overstated the space of this page.
+    UpdateFreeSpace(*page_id, page);
+    if (!slot_id.has_value()) {
+      continue;
+    }
+    if (lock_mgr != nullptr && !LockInsertedTuple(lock_mgr, txn, oid, RID{*page_id, *slot_id})) {
+      page_guard.Drop();
+      AbandonInsertedTuples({RID{*page_id, *slot_id}}, txn);
+    }
+    return RID(*page_id, *slot_id);
+  }
+  return std::nullopt;
 }
 
 auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr, Transaction *txn,
                             table_oid_t oid) -> std::optional<RID> {
+  // Move the varchars that make the tuple too large out of line first.
+  std::optional<Tuple> toasted;
+  if (toast_ != nullptr && toast_->NeedsToast(tuple, *schema_)) {
+    toasted = toast_->Toast(tuple, *schema_);
+  }
+  const auto &stored = toasted.has_value() ? *toasted : tuple;
+
+  if (fsm_ != nullptr) {
+    if (auto rid = InsertIntoFreeSpace(meta, stored, lock_mgr, txn, oid); rid.has_value()) {
+      return rid;
+    }
+  }
+
   std::unique_lock<std::mutex> guard(latch_);
   auto page_guard = bpm_->FetchPageWrite(last_page_id_);
+  std::optional<uint16_t> slot_id;
   while (true) {
-    auto page = page_guard.AsMut<TablePage>();
-    if (page->GetNextTupleOffset(meta, tuple) != std::nullopt) {
+    if (storage_ == TableStorage::PAX) {
+      slot_id = page_guard.AsMut<PaxTablePage>()->InsertTuple(*schema_, meta, stored);
+      if (slot_id != std::nullopt) {
+        break;
+      }
+    } else if (page_guard.As<TablePage>()->GetNextTupleOffset(meta, stored) != std::nullopt) {
       break;
     }
 
     // if there's no tuple in the page, and we can't insert the tuple, then this tuple is too large.
-    BUSTUB_ENSURE(page->GetNumTuples() != 0, "tuple is too large, cannot insert");
+    BUSTUB_ENSURE(GetNumTuples(page_guard.GetData()) != 0, "tuple is too large, cannot insert");
 
     page_id_t next_page_id = INVALID_PAGE_ID;
     auto npg = bpm_->NewPage(&next_page_id);
     BUSTUB_ENSURE(next_page_id != INVALID_PAGE_ID, "cannot allocate page");
 
-    page->SetNextPageId(next_page_id);
-
-    auto next_page = reinterpret_cast<TablePage *>(npg->GetData());
-    next_page->Init();
+    InitNewPage(last_page_id_, page_guard.GetDataMut(), next_page_id, npg->GetData());
+    if (zone_map_ != nullptr) {
+      zone_map_->AddPage(next_page_id);
+    }
+    if (fsm_ != nullptr) {
+      fsm_->AddPage(next_page_id, reinterpret_cast<TablePage *>(npg->GetData())->GetFreeSpace());
+    }
 
     page_guard.Drop();
 
@@ -69,38 +242,265 @@ auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManag
   }
   auto last_page_id = last_page_id_;
 
-  auto page = page_guard.AsMut<TablePage>();
-  auto slot_id = *page->InsertTuple(meta, tuple);
+  // Widen the zones before releasing the table latch, so that iterators made after this insertion see them.
+  if (zone_map_ != nullptr) {
+    zone_map_->Insert(last_page_id, stored);
+  }
+  if (storage_ == TableStorage::ROW) {
+    slot_id = InsertIntoPage(last_page_id, page_guard.AsMut<TablePage>(), meta, stored);
+    UpdateFreeSpace(last_page_id, page_guard.As<TablePage>());
+  }
 
   // only allow one insertion at a time, otherwise it will deadlock.
   guard.unlock();
 
-  if (lock_mgr != nullptr) {
-    BUSTUB_ENSURE(lock_mgr->LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{last_page_id, slot_id}),
-                  "failed to lock when inserting new tuple");
+  if (lock_mgr != nullptr && !LockInsertedTuple(lock_mgr, txn, oid, RID{last_page_id, *slot_id})) {
+    page_guard.Drop();
+    AbandonInsertedTuples({RID{last_page_id, *slot_id}}, txn);
   }
 
   page_guard.Drop();
 
-  return RID(last_page_id, slot_id);
+  return RID(last_page_id, *slot_id);
+}
+
+auto TableHeap::FillPage(page_id_t page_id, char *data, const TupleMeta &meta, const std::vector<Tuple> &tuples,
+                         size_t next, std::vector<RID> *rids) -> size_t {
+  for (; next < tuples.size(); next++) {
+    std::optional<uint16_t> slot_id;
+    if (storage_ == TableStorage::PAX) {
+      slot_id = reinterpret_cast<PaxTablePage *>(data)->InsertTuple(*schema_, meta, tuples[next]);
+    } else {
+      slot_id = InsertIntoPage(page_id, reinterpret_cast<TablePage *>(data), meta, tuples[next]);
+    }
+    if (!slot_id.has_value()) {
+      break;
+    }
+    // The page is still latched, so scans cannot read the tuple before its zones are widened.
+    if (zone_map_ != nullptr) {
+      zone_map_->Insert(page_id, tuples[next]);
+    }
+    rids->emplace_back(page_id, *slot_id);
+  }
+  if (fsm_ != nullptr) {
+    UpdateFreeSpace(page_id, reinterpret_cast<TablePage *>(data));
+  }
+  return next;
+}
+
+auto TableHeap::InsertTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples, LockManager *lock_mgr,
+                             Transaction *txn, table_oid_t oid) -> std::vector<RID> {
+  // Move the varchars that make a tuple too large out of line first, copying the batch only if there are any.
+  std::vector<Tuple> toasted;
+  if (toast_ != nullptr && std::any_of(tuples.begin(), tuples.end(),
+                                       [&](const Tuple &tuple) { return toast_->NeedsToast(tuple, *schema_); })) {
+    toasted.reserve(tuples.size());
+    for (const auto &tuple : tuples) {
+      toasted.push_back(toast_->NeedsToast(tuple, *schema_) ? toast_->Toast(tuple, *schema_) : tuple);
+    }
+  }
+  const auto &stored = toasted.empty() ? tuples : toasted;
+
+  std::vector<RID> rids;
+  rids.reserve(stored.size());
+  size_t next = 0;
+  // Lock the tuples inserted since the last call, while their page is still latched.
+  size_t num_locked = 0;
+  auto lock_rows = [&]() {
+    for (; lock_mgr != nullptr && num_locked < rids.size(); num_locked++) {
+      if (!LockInsertedTuple(lock_mgr, txn, oid, rids[num_locked])) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // Fill the pages that have room first.
+  while (fsm_ != nullptr && next < stored.size()) {
+    auto page_id = fsm_->FindPage(TablePage::GetRequiredSpace(stored[next]));
+    if (!page_id.has_value()) {
+      break;
+    }
+    auto page_guard = bpm_->FetchPageWrite(*page_id);
+    auto page = page_guard.AsMut<TablePage>();
+    if (page->GetNextTupleOffset(meta, stored[next]) == std::nullopt) {
+      Compact(*page_id, page);
+    }
+    next = FillPage(*page_id, page_guard.GetDataMut(), meta, stored, next, &rids);
+    if (!lock_rows()) {
+      page_guard.Drop();
+      AbandonInsertedTuples(rids, txn);
+    }
+  }
+
+  // Append the rest to the end of the table, a page at a time.
+  while (next < stored.size()) {
+    std::unique_lock<std::mutex> guard(latch_);
+    auto page_id = last_page_id_;
+    auto page_guard = bpm_->FetchPageWrite(page_id);
+    auto filled = FillPage(page_id, page_guard.GetDataMut(), meta, stored, next, &rids);
+    if (filled == next) {
+      // if there's no tuple in the page, and we can't insert the tuple, then this tuple is too large.
+      BUSTUB_ENSURE(GetNumTuples(page_guard.GetData()) != 0, "tuple is too large, cannot insert");
+
+      page_id_t next_page_id = INVALID_PAGE_ID;
+      auto next_page_guard = bpm_->NewPageGuarded(&next_page_id);
+      BUSTUB_ENSURE(next_page_id != INVALID_PAGE_ID, "cannot allocate page");
+      InitNewPage(page_id, page_guard.GetDataMut(), next_page_id, next_page_guard.GetDataMut());
+      if (zone_map_ != nullptr) {
+        zone_map_->AddPage(next_page_id);
+      }
+      if (fsm_ != nullptr) {
+        fsm_->AddPage(next_page_id, next_page_guard.As<TablePage>()->GetFreeSpace());
+      }
+      last_page_id_ = next_page_id;
+      continue;
+    }
+    // only allow one insertion at a time, otherwise it will deadlock.
+    guard.unlock();
+    if (!lock_rows()) {
+      page_guard.Drop();
+      AbandonInsertedTuples(rids, txn);
+    }
+    next = filled;
+  }
+  return rids;
 }
 
-void TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid) {
+void TableHeap::AbandonInsertedTuples(const std::vector<RID> &rids, Transaction *txn) {
+  for (auto rid : rids) {
+    UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, rid);
+  }
+  txn->SetState(TransactionState::ABORTED);
+  throw ExecutionException(
+      fmt::format("transaction {} aborted: cannot lock the tuples it inserted", txn->GetTransactionId()));
+}
+
+void TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid) { UpdateTupleMeta(meta, rid, nullptr); }
+
+/** @return the bytes of a serialized row up to the end of its values, short of the padding after them */
+static auto UnpaddedLength(const char *data, const Schema &schema) -> uint32_t {
+  uint32_t length = schema.GetLength();
+  for (auto i : schema.GetUnlinedColumns()) {
+    uint16_t end = *reinterpret_cast<const uint16_t *>(data + schema.GetColumn(i).GetOffset()) & ~VARLEN_EXTERNAL;
+    length = std::max<uint32_t>(length, end);
+  }
+  return length;
+}
+
+/** @return whether a tuple with `meta` is deleted and read by nobody, so its slot can be reclaimed */
+static auto IsReclaimable(const TupleMeta &meta) -> bool {
+  return meta.is_deleted_ && meta.delete_txn_id_ == INVALID_TXN_ID;
+}
+
+auto TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid, const WriteCheck &check) -> bool {
   auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
+  if (check != nullptr) {
+    auto [current_meta, current_tuple] = ReadTuple(page_guard.GetData(), rid);
+    if (!check(current_meta, current_tuple, rid)) {
+      return false;
+    }
+  }
+  if (storage_ == TableStorage::PAX) {
+    page_guard.AsMut<PaxTablePage>()->UpdateTupleMeta(meta, rid);
+    return true;
+  }
   auto page = page_guard.AsMut<TablePage>();
+  auto old_meta = page->GetTupleMeta(rid);
+  if (IsLogging()) {
+    LogRecord record(WriterOf(meta), INVALID_LSN, LogRecord::MetaChangeType(old_meta, meta), rid, old_meta, meta);
+    Log(&record, rid.GetPageId(), page);
+  }
+  // Once the slot can be reclaimed nobody reads the tuple, so neither its out-of-line varchars.
+  std::vector<ToastPointer> chains;
+  if (toast_ != nullptr && IsReclaimable(meta) && !IsReclaimable(old_meta)) {
+    chains = ToastStore::GetChains(page->GetTupleRef(rid).second.GetData(), *schema_);
+  }
   page->UpdateTupleMeta(meta, rid);
+  if (meta.is_deleted_ && fsm_ != nullptr) {
+    UpdateFreeSpace(rid.GetPageId(), page);
+  }
+  page_guard.Drop();
+  for (const auto &chain : chains) {
+    toast_->Free(chain);
+  }
+  return true;
 }
 
 auto TableHeap::GetTuple(RID rid) -> std::pair<TupleMeta, Tuple> {
   auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
-  auto page = page_guard.As<TablePage>();
-  auto [meta, tuple] = page->GetTuple(rid);
+  return ReadTuple(page_guard.GetData(), rid);
+}
+
+auto TableHeap::ReadTuple(const char *data, RID rid) const -> std::pair<TupleMeta, Tuple> {
+  auto [meta, tuple] = storage_ == TableStorage::PAX
+                           ? reinterpret_cast<const PaxTablePage *>(data)->GetTuple(*schema_, rid)
+                           : reinterpret_cast<const TablePage *>(data)->GetTuple(rid);
   tuple.rid_ = rid;
+  tuple.toast_ = toast_.get();
   return std::make_pair(meta, std::move(tuple));
 }
 
+/** Make `guard` guard the page `page_id`, reusing it if it already does. */
+static void FetchPageReadInto(BufferPoolManager *bpm, page_id_t page_id, ReadPageGuard *guard) {
+  if (!guard->IsValid() || guard->PageId() != page_id) {
+    // Drop the old page first, so at most one page is latched at a time.
+    guard->Drop();
+    *guard = bpm->FetchPageRead(page_id);
+  }
+}
+
+auto TableHeap::GetTupleRef(RID rid, ReadPageGuard *guard, Tuple *pax_tuple) -> std::pair<TupleMeta, TupleRef> {
+  FetchPageReadInto(bpm_, rid.GetPageId(), guard);
+  if (storage_ == TableStorage::PAX) {
+    // The columns of a tuple are spread over the minipages, so assemble them into the caller's buffer.
+    auto [meta, tuple] = ReadTuple(guard->GetData(), rid);
+    *pax_tuple = std::move(tuple);
+    return {meta, TupleRef(*pax_tuple)};
+  }
+  auto [meta, tuple_ref] = guard->As<TablePage>()->GetTupleRef(rid);
+  return {meta, TupleRef(tuple_ref.GetData(), tuple_ref.GetLength(), rid, toast_.get())};
+}
+
+auto TableHeap::GetValues(RID rid, const std::vector<uint32_t> &column_ids, ReadPageGuard *guard,
+                          std::vector<Value> *values) -> TupleMeta {
+  BUSTUB_ENSURE(storage_ == TableStorage::PAX, "read the columns of row tables through GetTupleRef");
+  values->clear();
+  FetchPageReadInto(bpm_, rid.GetPageId(), guard);
+  auto page = guard->As<PaxTablePage>();
+  for (auto column_idx : column_ids) {
+    values->emplace_back(page->GetValue(*schema_, rid, column_idx));
+  }
+  return page->GetTupleMeta(rid);
+}
+
+auto TableHeap::GetTupleMeta(RID rid, ReadPageGuard *guard) -> TupleMeta {
+  FetchPageReadInto(bpm_, rid.GetPageId(), guard);
+  if (storage_ == TableStorage::PAX) {
+    return guard->As<PaxTablePage>()->GetTupleMeta(rid);
+  }
+  return guard->As<TablePage>()->GetTupleMeta(rid);
+}
+
+auto TableHeap::MatchEqual(page_id_t page_id, uint32_t column_idx, const Value &value, ReadPageGuard *guard,
+                           std::vector<bool> *matches) -> bool {
+  BUSTUB_ENSURE(storage_ == TableStorage::PAX, "only PAX pages keep codes");
+  FetchPageReadInto(bpm_, page_id, guard);
+  return guard->As<PaxTablePage>()->MatchEqual(*schema_, column_idx, value, matches);
+}
+
+auto TableHeap::GetCodes(page_id_t page_id, uint32_t column_idx, ReadPageGuard *guard, std::vector<uint32_t> *codes,
+                         std::vector<Value> *dictionary) -> bool {
+  BUSTUB_ENSURE(storage_ == TableStorage::PAX, "only PAX pages keep codes");
+  FetchPageReadInto(bpm_, page_id, guard);
+  return guard->As<PaxTablePage>()->GetCodes(*schema_, column_idx, codes, dictionary);
+}
+
 auto TableHeap::GetTupleMeta(RID rid) -> TupleMeta {
   auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
+  if (storage_ == TableStorage::PAX) {
+    return page_guard.As<PaxTablePage>()->GetTupleMeta(rid);
+  }
   auto page = page_guard.As<TablePage>();
   return page->GetTupleMeta(rid);
 }
@@ -111,16 +511,137 @@ auto TableHeap::MakeIterator() -> TableIterator {
   guard.unlock();
 
   auto page_guard = bpm_->FetchPageRead(last_page_id);
-  auto page = page_guard.As<TablePage>();
-  return {this, {first_page_id_, 0}, {last_page_id, page->GetNumTuples()}};
+  return {this, {first_page_id_, 0}, {last_page_id, GetNumTuples(page_guard.GetData())}};
 }
 
 auto TableHeap::MakeEagerIterator() -> TableIterator { return {this, {first_page_id_, 0}, {INVALID_PAGE_ID, 0}}; }
 
 void TableHeap::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid) {
+  UpdateTupleInPlace(meta, tuple, rid, nullptr);
+}
+
+auto TableHeap::UpdateTupleInPlace(const TupleMeta &meta, const Tuple &tuple, RID rid, const WriteCheck &check)
+    -> bool {
+  std::optional<Tuple> toasted;
+  if (toast_ != nullptr && toast_->NeedsToast(tuple, *schema_)) {
+    toasted = toast_->Toast(tuple, *schema_);
+  }
+  const auto &stored = toasted.has_value() ? *toasted : tuple;
+  auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
+  bool fits = storage_ == TableStorage::PAX ? page_guard.As<PaxTablePage>()->FitsUpdate(*schema_, stored)
+                                            : page_guard.As<TablePage>()->FitsUpdate(stored, rid);
+  if (!fits) {
+    return false;
+  }
+  if (check != nullptr) {
+    auto [current_meta, current_tuple] = ReadTuple(page_guard.GetData(), rid);
+    if (!check(current_meta, current_tuple, rid)) {
+      return false;
+    }
+  }
+  if (zone_map_ != nullptr) {
+    zone_map_->Update(rid.GetPageId(), stored);
+  }
+  if (storage_ == TableStorage::PAX) {
+    page_guard.AsMut<PaxTablePage>()->UpdateTupleInPlaceUnsafe(*schema_, meta, stored, rid);
+    return true;
+  }
+  auto page = page_guard.AsMut<TablePage>();
+  // A shorter version would give back bytes of the slot, which other tuples may take once the page is compacted.
+  // Until its writer is seen by all, the version it replaced may be restored, so the new one is padded to keep the
+  // bytes of that version, see TrimTuple().
+  std::optional<Tuple> padded;
+  if (auto reserved = page->GetTupleRef(rid).second.GetLength();
+      WriterOf(meta) != INVALID_TXN_ID && stored.GetLength() < reserved) {
+    padded = stored;
+    padded->data_.resize(reserved, 0);
+  }
+  const auto &row = padded.has_value() ? *padded : stored;
+  if (IsLogging()) {
+    auto [old_meta, old_tuple] = page->GetTuple(rid);
+    LogRecord record(WriterOf(meta), INVALID_LSN, LogRecordType::UPDATE, rid, old_meta, old_tuple, meta, row);
+    Log(&record, rid.GetPageId(), page);
+  }
+  std::vector<ToastPointer> old_chains;
+  if (toast_ != nullptr) {
+    old_chains = ToastStore::GetChains(page->GetTupleRef(rid).second.GetData(), *schema_);
+  }
+  page->UpdateTupleInPlaceUnsafe(meta, row, rid);
+  if (fsm_ != nullptr) {
+    UpdateFreeSpace(rid.GetPageId(), page);
+  }
+  page_guard.Drop();
+  if (old_chains.empty()) {
+    return true;
+  }
+  // The old version stays readable from the version chain, and by the readers that copied it, until the writer is
+  // seen by all. Without a transaction there is no one to wait for.
+  auto writer = WriterOf(meta);
+  if (writer == INVALID_TXN_ID) {
+    for (const auto &chain : old_chains) {
+      toast_->Free(chain);
+    }
+    return true;
+  }
+  std::scoped_lock lck(retired_chains_latch_);
+  for (const auto &chain : old_chains) {
+    retired_chains_.emplace_back(writer, chain);
+  }
+  return true;
+}
+
+void TableHeap::TrimTuple(RID rid) {
+  if (storage_ == TableStorage::PAX || schema_ == nullptr) {
+    return;
+  }
   auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
   auto page = page_guard.AsMut<TablePage>();
-  page->UpdateTupleInPlaceUnsafe(meta, tuple, rid);
+  auto [meta, tuple] = page->GetTuple(rid);
+  if (WriterOf(meta) != INVALID_TXN_ID || meta.is_deleted_) {
+    return;
+  }
+  auto length = UnpaddedLength(tuple.GetData(), *schema_);
+  if (length >= tuple.GetLength()) {
+    return;
+  }
+  auto trimmed = tuple;
+  trimmed.data_.resize(length);
+  if (IsLogging()) {
+    LogRecord record(INVALID_TXN_ID, INVALID_LSN, LogRecordType::UPDATE, rid, meta, tuple, meta, trimmed);
+    Log(&record, rid.GetPageId(), page);
+  }
+  page->UpdateTupleInPlaceUnsafe(meta, trimmed, rid);
+  if (fsm_ != nullptr) {
+    UpdateFreeSpace(rid.GetPageId(), page);
+  }
+}
+
+void TableHeap::FreeRetiredChains(const std::function<bool(txn_id_t)> &can_free) {
+  std::vector<ToastPointer> freed;
+  {
+    std::scoped_lock lck(retired_chains_latch_);
+    auto kept = std::partition(retired_chains_.begin(), retired_chains_.end(),
+                               [&](const auto &retired) { return !can_free(retired.first); });
+    for (auto it = kept; it != retired_chains_.end(); ++it) {
+      freed.push_back(it->second);
+    }
+    retired_chains_.erase(kept, retired_chains_.end());
+  }
+  for (const auto &chain : freed) {
+    toast_->Free(chain);
+  }
+}
+
+void TableHeap::CompactPage(page_id_t page_id) {
+  if (storage_ == TableStorage::PAX) {
+    return;
+  }
+  auto page_guard = bpm_->FetchPageWrite(page_id);
+  auto page = page_guard.AsMut<TablePage>();
+  Compact(page_id, page);
+  if (fsm_ != nullptr) {
+    UpdateFreeSpace(page_id, page);
+  }
 }
 
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #include <cassert>
 #include <optional>
+#include <utility>
 
 #include "common/config.h"
 #include "common/exception.h"
@@ -25,21 +26,67 @@ TableIterator::TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid)
   // If the rid doesn't correspond to a tuple (i.e., the table has just been initialized), then
   // we set rid_ to invalid.
   auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId());
-  auto page = page_guard.As<TablePage>();
-  if (rid_.GetSlotNum() >= page->GetNumTuples()) {
+  if (rid_.GetSlotNum() >= table_heap_->GetNumTuples(page_guard.GetData())) {
     rid_ = RID{INVALID_PAGE_ID, 0};
   }
 }
 
-auto TableIterator::GetTuple() -> std::pair<TupleMeta, Tuple> { return table_heap_->GetTuple(rid_); }
+auto TableIterator::GetTuple() -> std::pair<TupleMeta, Tuple> {
+  if (!page_guard_.IsValid()) {
+    return table_heap_->GetTuple(rid_);
+  }
+  // The page is already latched by this iterator, so read from it rather than latching it again.
+  if (table_heap_->storage_ == TableStorage::PAX) {
+    auto [meta, tuple] = page_guard_.As<PaxTablePage>()->GetTuple(*table_heap_->schema_, rid_);
+    tuple.rid_ = rid_;
+    return std::make_pair(meta, std::move(tuple));
+  }
+  auto [meta, tuple_ref] = GetTupleRef();
+  return std::make_pair(meta, tuple_ref.ToTuple());
+}
+
+auto TableIterator::GetTupleRef() -> std::pair<TupleMeta, TupleRef> {
+  return table_heap_->GetTupleRef(rid_, &page_guard_, &pax_tuple_);
+}
+
+auto TableIterator::GetTupleMeta() -> TupleMeta { return table_heap_->GetTupleMeta(rid_, &page_guard_); }
+
+auto TableIterator::GetValues(const std::vector<uint32_t> &column_ids, std::vector<Value> *values) -> TupleMeta {
+  return table_heap_->GetValues(rid_, column_ids, &page_guard_, values);
+}
+
+auto TableIterator::MatchEqual(uint32_t column_idx, const Value &value, std::vector<bool> *matches) -> bool {
+  return table_heap_->MatchEqual(rid_.GetPageId(), column_idx, value, &page_guard_, matches);
+}
+
+auto TableIterator::GetCodes(uint32_t column_idx, std::vector<uint32_t> *codes, std::vector<Value> *dictionary)
+    -> bool {
+  return table_heap_->GetCodes(rid_.GetPageId(), column_idx, &page_guard_, codes, dictionary);
+}
+
+void TableIterator::SkipPage() {
+  BUSTUB_ASSERT(table_heap_->zone_map_ != nullptr, "skipping pages needs a zone map");
+  page_guard_.Drop();
+  if (rid_.GetPageId() == stop_at_rid_.GetPageId()) {
+    rid_ = RID{INVALID_PAGE_ID, 0};
+    return;
+  }
+  rid_ = RID{table_heap_->zone_map_->GetNextPageId(rid_.GetPageId()), 0};
+  if (rid_ == stop_at_rid_) {
+    rid_ = RID{INVALID_PAGE_ID, 0};
+  }
+}
 
 auto TableIterator::GetRID() -> RID { return rid_; }
 
 auto TableIterator::IsEnd() -> bool { return rid_.GetPageId() == INVALID_PAGE_ID; }
 
 auto TableIterator::operator++() -> TableIterator & {
-  auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId());
-  auto page = page_guard.As<TablePage>();
+  ReadPageGuard page_guard;
+  if (!page_guard_.IsValid()) {
+    page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId());
+  }
+  auto page = page_guard_.IsValid() ? page_guard_.GetData() : page_guard.GetData();
   auto next_tuple_id = rid_.GetSlotNum() + 1;
 
   if (stop_at_rid_.GetPageId() != INVALID_PAGE_ID) {
@@ -54,15 +101,18 @@ auto TableIterator::operator++() -> TableIterator & {
 
   if (rid_ == stop_at_rid_) {
     rid_ = RID{INVALID_PAGE_ID, 0};
-  } else if (next_tuple_id < page->GetNumTuples()) {
+  } else if (next_tuple_id < table_heap_->GetNumTuples(page)) {
     // that's fine
   } else {
-    auto next_page_id = page->GetNextPageId();
+    auto next_page_id = table_heap_->GetNextPageId(page);
     // if next page is invalid, RID is set to invalid page; otherwise, it's the first tuple in that page.
     rid_ = RID{next_page_id, 0};
   }
 
   page_guard.Drop();
+  if (page_guard_.IsValid() && rid_.GetPageId() != page_guard_.PageId()) {
+    page_guard_.Drop();
+  }
 
   return *this;
 }
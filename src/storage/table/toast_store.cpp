@@ -0,0 +1,171 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// toast_store.cpp
+//
+// Identification: src/storage/table/toast_store.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/toast_store.h"
+
+#include <cstring>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/util/compression_util.h"
+#include "storage/page/overflow_page.h"
+#include "storage/page/page_guard.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** @return the end offset slot of a varchar column */
+static auto EndOffset(const char *data, const Column &column) -> uint16_t {
+  return *reinterpret_cast<const uint16_t *>(data + column.GetOffset());
+}
+
+auto ToastStore::NeedsToast(const Tuple &tuple, const Schema &schema) const -> bool {
+  if (tuple.GetLength() > toast_tuple_threshold) {
+    return true;
+  }
+  for (auto column_idx : schema.GetUnlinedColumns()) {
+    if ((EndOffset(tuple.GetData(), schema.GetColumn(column_idx)) & VARLEN_EXTERNAL) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto ToastStore::Toast(const Tuple &tuple, const Schema &schema) const -> Tuple {
+  std::vector<Value> values;
+  values.reserve(schema.GetColumnCount());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    values.push_back(tuple.GetValue(&schema, i));
+  }
+
+  const auto &varchars = schema.GetUnlinedColumns();
+  std::vector<bool> external(varchars.size(), false);
+  auto payload_size = [&](size_t i) -> uint32_t {
+    const auto &value = values[varchars[i]];
+    return value.IsNull() || value.GetLength() == 0 ? 0 : value.GetLength() - 1;
+  };
+  uint32_t length = schema.GetLength();
+  for (size_t i = 0; i < varchars.size(); i++) {
+    length += payload_size(i);
+  }
+
+  // Move the largest varchars out first, they shrink the tuple the most for the pages they take.
+  while (length > toast_tuple_threshold) {
+    size_t largest = varchars.size();
+    for (size_t i = 0; i < varchars.size(); i++) {
+      if (!external[i] && payload_size(i) > sizeof(ToastPointer) &&
+          (largest == varchars.size() || payload_size(i) > payload_size(largest))) {
+        largest = i;
+      }
+    }
+    if (largest == varchars.size()) {
+      break;
+    }
+    auto &value = values[varchars[largest]];
+    length -= payload_size(largest) - sizeof(ToastPointer);
+    auto pointer = Store(std::string_view(value.GetData(), payload_size(largest)));
+    value = ValueFactory::GetVarcharValue(std::string(reinterpret_cast<const char *>(&pointer), sizeof(pointer)));
+    external[largest] = true;
+  }
+
+  Tuple toasted(values, &schema);
+  for (size_t i = 0; i < varchars.size(); i++) {
+    if (external[i]) {
+      *reinterpret_cast<uint16_t *>(toasted.data_.data() + schema.GetColumn(varchars[i]).GetOffset()) |=
+          VARLEN_EXTERNAL;
+    }
+  }
+  toasted.toast_ = this;
+  return toasted;
+}
+
+auto ToastStore::Store(std::string_view bytes) const -> ToastPointer {
+  std::string compressed;
+  if (toast_compression) {
+    compressed = CompressionUtil::Compress(bytes);
+  }
+  std::string_view stored = toast_compression && compressed.size() < bytes.size() ? compressed : bytes;
+  ToastPointer pointer{INVALID_PAGE_ID, static_cast<uint32_t>(bytes.size()), static_cast<uint32_t>(stored.size())};
+
+  // Nobody knows the pages of the chain until it is returned, so they need no latches.
+  BasicPageGuard prev_guard;
+  OverflowPage *prev_page = nullptr;
+  size_t written = 0;
+  do {
+    page_id_t page_id = INVALID_PAGE_ID;
+    auto guard = bpm_->NewPageGuarded(&page_id);
+    BUSTUB_ENSURE(page_id != INVALID_PAGE_ID, "cannot allocate page");
+    auto page = guard.AsMut<OverflowPage>();
+    page->Init();
+    written += page->Write(stored.data() + written, stored.size() - written);
+    if (prev_page == nullptr) {
+      pointer.first_page_id_ = page_id;
+    } else {
+      prev_page->SetNextPageId(page_id);
+    }
+    prev_guard = std::move(guard);
+    prev_page = page;
+  } while (written < stored.size());
+  return pointer;
+}
+
+auto ToastStore::Fetch(const ToastPointer &pointer) const -> std::string {
+  std::string stored;
+  stored.reserve(pointer.stored_size_);
+  for (auto page_id = pointer.first_page_id_; page_id != INVALID_PAGE_ID;) {
+    auto guard = bpm_->FetchPageRead(page_id);
+    auto page = guard.As<OverflowPage>();
+    stored.append(page->GetData(), page->GetSize());
+    page_id = page->GetNextPageId();
+  }
+  BUSTUB_ENSURE(stored.size() == pointer.stored_size_, "overflow chain does not match its pointer");
+  if (pointer.stored_size_ == pointer.size_) {
+    return stored;
+  }
+  std::string bytes(pointer.size_, '\0');
+  BUSTUB_ENSURE(CompressionUtil::Decompress(stored, bytes.data(), bytes.size()), "corrupt compressed value");
+  return bytes;
+}
+
+auto ToastStore::GetChains(const char *data, const Schema &schema) -> std::vector<ToastPointer> {
+  std::vector<ToastPointer> chains;
+  for (auto column_idx : schema.GetUnlinedColumns()) {
+    const auto &column = schema.GetColumn(column_idx);
+    if ((EndOffset(data, column) & VARLEN_EXTERNAL) == 0) {
+      continue;
+    }
+    // The payload begins where the previous varchar ends, see Tuple::GetValue.
+    uint32_t begin = column.GetOffset() == schema.GetVarlenOffsetsStart()
+                         ? schema.GetLength()
+                         : *reinterpret_cast<const uint16_t *>(data + column.GetOffset() - sizeof(uint16_t)) &
+                               ~VARLEN_EXTERNAL;
+    ToastPointer pointer;
+    memcpy(&pointer, data + begin, sizeof(pointer));
+    chains.push_back(pointer);
+  }
+  return chains;
+}
+
+void ToastStore::Free(const ToastPointer &pointer) const {
+  for (auto page_id = pointer.first_page_id_; page_id != INVALID_PAGE_ID;) {
+    page_id_t next_page_id;
+    {
+      auto guard = bpm_->FetchPageRead(page_id);
+      next_page_id = guard.As<OverflowPage>()->GetNextPageId();
+    }
+    BUSTUB_ENSURE(bpm_->DeletePage(page_id), "overflow page still pinned when its chain is freed");
+    page_id = next_page_id;
+  }
+}
+
+}  // namespace bustub
@@ -12,31 +12,35 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "common/macros.h"
+#include "storage/table/toast_store.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
-// TODO(Amadou): It does not look like nulls are supported. Add a null bitmap?
+/** @return the number of payload bytes of a varchar, without the terminator its Value carries */
+static auto VarcharSize(const Value &value) -> uint32_t {
+  return value.IsNull() || value.GetLength() == 0 ? 0 : value.GetLength() - 1;
+}
+
 Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
   assert(values.size() == schema->GetColumnCount());
 
   // 1. Calculate the size of the tuple.
   uint32_t tuple_size = schema->GetLength();
   for (auto &i : schema->GetUnlinedColumns()) {
-    auto len = values[i].GetLength();
-    if (len == BUSTUB_VALUE_NULL) {
-      len = 0;
-    }
-    tuple_size += (len + sizeof(uint32_t));
+    tuple_size += VarcharSize(values[i]);
   }
+  BUSTUB_ENSURE(tuple_size <= TUPLE_MAX_SIZE, "tuple is too large");
 
   // 2. Allocate memory.
-  data_.resize(tuple_size);
-  std::fill(data_.begin(), data_.end(), 0);
+  data_.assign(tuple_size, 0);
 
   // 3. Serialize each attribute based on the input value.
   uint32_t column_count = schema->GetColumnCount();
@@ -44,28 +48,53 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
 
   for (uint32_t i = 0; i < column_count; i++) {
     const auto &col = schema->GetColumn(i);
+    if (values[i].IsNull()) {
+      data_[i / 8] |= static_cast<char>(1 << (i % 8));
+    }
     if (!col.IsInlined()) {
-      // Serialize relative offset, where the actual varchar data is stored.
-      *reinterpret_cast<uint32_t *>(data_.data() + col.GetOffset()) = offset;
-      // Serialize varchar value, in place (size+data).
-      values[i].SerializeTo(data_.data() + offset);
-      auto len = values[i].GetLength();
-      if (len == BUSTUB_VALUE_NULL) {
-        len = 0;
-      }
-      offset += (len + sizeof(uint32_t));
+      // Append the varchar bytes and record where they end.
+      auto len = VarcharSize(values[i]);
+      memcpy(data_.data() + offset, values[i].GetData(), len);
+      offset += len;
+      *reinterpret_cast<uint16_t *>(data_.data() + col.GetOffset()) = offset;
     } else {
       values[i].SerializeTo(data_.data() + col.GetOffset());
     }
   }
 }
 
-auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
+/**
+ * @return the value of a column of the serialized tuple starting at `data`, reading it from `toast` if it is stored
+ * out of line
+ */
+static auto ColumnValue(const char *data, const Schema *schema, const uint32_t column_idx, const ToastStore *toast)
+    -> Value {
   assert(schema);
-  const TypeId column_type = schema->GetColumn(column_idx).GetType();
-  const char *data_ptr = GetDataPtr(schema, column_idx);
-  // the third parameter "is_inlined" is unused
-  return Value::DeserializeFrom(data_ptr, column_type);
+  const auto &col = schema->GetColumn(column_idx);
+  if ((data[column_idx / 8] >> (column_idx % 8) & 1) != 0) {
+    return ValueFactory::GetNullValueByType(col.GetType());
+  }
+  // For inline type, data is stored where it is.
+  if (col.IsInlined()) {
+    return Value::DeserializeFrom(data + col.GetOffset(), col.GetType());
+  }
+  // A varchar starts where the previous one ends.
+  uint32_t begin = col.GetOffset() == schema->GetVarlenOffsetsStart()
+                       ? schema->GetLength()
+                       : *reinterpret_cast<const uint16_t *>(data + col.GetOffset() - sizeof(uint16_t)) &
+                             ~VARLEN_EXTERNAL;
+  uint16_t end = *reinterpret_cast<const uint16_t *>(data + col.GetOffset());
+  if ((end & VARLEN_EXTERNAL) != 0) {
+    BUSTUB_ENSURE(toast != nullptr, "value is stored out of line, but the tuple has no toast store");
+    ToastPointer pointer;
+    memcpy(&pointer, data + begin, sizeof(pointer));
+    return ValueFactory::GetVarcharValue(toast->Fetch(pointer));
+  }
+  return ValueFactory::GetVarcharValue(std::string(data + begin, end - begin));
+}
+
+auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
+  return ColumnValue(data_.data(), schema, column_idx, toast_);
 }
 
 auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs)
@@ -78,20 +107,6 @@ auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const s
   return {values, &key_schema};
 }
 
-auto Tuple::GetDataPtr(const Schema *schema, const uint32_t column_idx) const -> const char * {
-  assert(schema);
-  const auto &col = schema->GetColumn(column_idx);
-  bool is_inlined = col.IsInlined();
-  // For inline type, data is stored where it is.
-  if (is_inlined) {
-    return (data_.data() + col.GetOffset());
-  }
-  // We read the relative offset from the tuple data.
-  int32_t offset = *reinterpret_cast<const int32_t *>(data_.data() + col.GetOffset());
-  // And return the beginning address of the real data for the VARCHAR type.
-  return (data_.data() + offset);
-}
-
 auto Tuple::ToString(const Schema *schema) const -> std::string {
   std::stringstream os;
 
@@ -129,4 +144,20 @@ void Tuple::DeserializeFrom(const char *storage) {
   memcpy(this->data_.data(), storage + sizeof(int32_t), size);
 }
 
+auto TupleRef::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
+  return ColumnValue(data_, schema, column_idx, toast_);
+}
+
+auto TupleRef::ToTuple() const -> Tuple {
+  Tuple tuple;
+  CopyTo(&tuple);
+  return tuple;
+}
+
+void TupleRef::CopyTo(Tuple *tuple) const {
+  tuple->rid_ = rid_;
+  tuple->data_.assign(data_, data_ + size_);
+  tuple->toast_ = toast_;
+}
+
 }  // namespace bustub
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.cpp
+//
+// Identification: src/storage/table/zone_map.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/zone_map.h"
+
+#include "common/macros.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+ZoneMap::ZoneMap(const Schema &schema) : schema_(schema) {}
+
+void ZoneMap::AddPage(page_id_t page_id) {
+  PageZone zone;
+  zone.columns_.reserve(schema_.GetColumnCount());
+  for (const auto &column : schema_.GetColumns()) {
+    auto null_value = ValueFactory::GetNullValueByType(column.GetType());
+    zone.columns_.push_back(ColumnZone{null_value, null_value, 0});
+  }
+  std::scoped_lock guard(latch_);
+  zones_.emplace(page_id, std::make_pair(pages_.size(), std::move(zone)));
+  pages_.push_back(page_id);
+}
+
+void ZoneMap::Insert(page_id_t page_id, const Tuple &tuple) {
+  std::scoped_lock guard(latch_);
+  auto it = zones_.find(page_id);
+  BUSTUB_ASSERT(it != zones_.end(), "page is not in the zone map");
+  it->second.second.num_tuples_++;
+  Widen(&it->second.second, tuple, true);
+}
+
+void ZoneMap::Update(page_id_t page_id, const Tuple &tuple) {
+  std::scoped_lock guard(latch_);
+  auto it = zones_.find(page_id);
+  BUSTUB_ASSERT(it != zones_.end(), "page is not in the zone map");
+  Widen(&it->second.second, tuple, false);
+}
+
+void ZoneMap::Widen(PageZone *zone, const Tuple &tuple, bool count_nulls) const {
+  for (uint32_t i = 0; i < schema_.GetColumnCount(); i++) {
+    if (!IsTracked(i)) {
+      continue;
+    }
+    auto &column_zone = zone->columns_[i];
+    auto value = tuple.GetValue(&schema_, i);
+    if (value.IsNull()) {
+      column_zone.null_count_ += count_nulls ? 1 : 0;
+      continue;
+    }
+    if (column_zone.min_.IsNull() || value.CompareLessThan(column_zone.min_) == CmpBool::CmpTrue) {
+      column_zone.min_ = value;
+    }
+    if (column_zone.max_.IsNull() || value.CompareGreaterThan(column_zone.max_) == CmpBool::CmpTrue) {
+      column_zone.max_ = value;
+    }
+  }
+}
+
+auto ZoneMap::GetPageZone(page_id_t page_id, PageZone *zone) const -> bool {
+  std::scoped_lock guard(latch_);
+  auto it = zones_.find(page_id);
+  if (it == zones_.end()) {
+    return false;
+  }
+  *zone = it->second.second;
+  return true;
+}
+
+auto ZoneMap::GetNextPageId(page_id_t page_id) const -> page_id_t {
+  std::scoped_lock guard(latch_);
+  auto it = zones_.find(page_id);
+  BUSTUB_ASSERT(it != zones_.end(), "page is not in the zone map");
+  auto next = it->second.first + 1;
+  return next < pages_.size() ? pages_[next] : INVALID_PAGE_ID;
+}
+
+}  // namespace bustub
@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util_test.cpp
+//
+// Identification: test/common/compression_util_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/util/compression_util.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(CompressionUtilTest, RoundTripTest) {
+  std::mt19937 gen(7);
+  std::vector<std::string> inputs{"", "a", "abcd", std::string(100000, 'x'), "abcabcabcabcabcabcabcabcabc"};
+  std::string text;
+  for (int i = 0; i < 2000; i++) {
+    text += "key" + std::to_string(gen() % 50) + "=value" + std::to_string(gen() % 7) + ";";
+  }
+  inputs.push_back(text);
+  std::string noise(70000, '\0');
+  for (auto &c : noise) {
+    c = static_cast<char>(gen());
+  }
+  inputs.push_back(noise);
+
+  for (const auto &input : inputs) {
+    auto compressed = CompressionUtil::Compress(input);
+    std::string output(input.size(), '\0');
+    ASSERT_TRUE(CompressionUtil::Decompress(compressed, output.data(), output.size()));
+    ASSERT_EQ(output, input);
+    if (input.size() > 1) {
+      // The wrong size is rejected.
+      ASSERT_FALSE(CompressionUtil::Decompress(compressed, output.data(), output.size() - 1));
+    }
+  }
+  EXPECT_LT(CompressionUtil::Compress(std::string(100000, 'x')).size(), 500);
+  EXPECT_LT(CompressionUtil::Compress(text).size(), text.size() / 2);
+}
+
+// NOLINTNEXTLINE
+TEST(CompressionUtilTest, CorruptInputTest) {
+  auto compressed = CompressionUtil::Compress("hello hello hello hello");
+  std::string output(23, '\0');
+  // Cutting the input anywhere must not read or write out of bounds.
+  for (size_t len = 0; len < compressed.size(); len++) {
+    CompressionUtil::Decompress(std::string_view(compressed).substr(0, len), output.data(), output.size());
+  }
+  // An offset pointing before the start of the output.
+  EXPECT_FALSE(CompressionUtil::Decompress(std::string("\x10" "a" "\x05\x00", 4), output.data(), output.size()));
+}
+
+}  // namespace bustub
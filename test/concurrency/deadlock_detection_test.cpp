@@ -12,7 +12,7 @@
 #include "gtest/gtest.h"
 
 namespace bustub {
-TEST(LockManagerDeadlockDetectionTest, DISABLED_EdgeTest) {
+TEST(LockManagerDeadlockDetectionTest, EdgeTest) {
   LockManager lock_mgr{};
   TransactionManager txn_mgr{&lock_mgr};
   lock_mgr.txn_manager_ = &txn_mgr;
@@ -56,7 +56,7 @@ TEST(LockManagerDeadlockDetectionTest, DISABLED_EdgeTest) {
   }
 }
 
-TEST(LockManagerDeadlockDetectionTest, DISABLED_BasicDeadlockDetectionTest) {
+TEST(LockManagerDeadlockDetectionTest, BasicDeadlockDetectionTest) {
   LockManager lock_mgr{};
   TransactionManager txn_mgr{&lock_mgr};
   lock_mgr.txn_manager_ = &txn_mgr;
@@ -117,4 +117,100 @@ TEST(LockManagerDeadlockDetectionTest, DISABLED_BasicDeadlockDetectionTest) {
   delete txn0;
   delete txn1;
 }
+
+TEST(LockManagerDeadlockDetectionTest, FastPathDeadlockTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  lock_mgr.txn_manager_ = &txn_mgr;
+  lock_mgr.StartDeadlockDetection();
+
+  // Each transaction waits for the intention lock the other holds on the fast path.
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(txn0, LockManager::LockMode::INTENTION_EXCLUSIVE, 0));
+  EXPECT_TRUE(lock_mgr.LockTable(txn1, LockManager::LockMode::INTENTION_EXCLUSIVE, 1));
+  std::thread t0([&] {
+    EXPECT_TRUE(lock_mgr.LockTable(txn0, LockManager::LockMode::SHARED, 1));
+    txn_mgr.Commit(txn0);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  // The newest transaction is aborted.
+  EXPECT_FALSE(lock_mgr.LockTable(txn1, LockManager::LockMode::SHARED, 0));
+  EXPECT_EQ(txn1->GetState(), TransactionState::ABORTED);
+  txn_mgr.Abort(txn1);
+  t0.join();
+  EXPECT_EQ(txn0->GetState(), TransactionState::COMMITTED);
+
+  delete txn0;
+  delete txn1;
+}
+
+/**
+ * Lock two rows in opposite orders from two transactions, the older one asking first if `older_first`, and check
+ * that the younger one aborts while the older one gets both rows.
+ */
+static void CrossLockTest(DeadlockPolicy policy, bool check_on_wait, bool older_first) {
+  auto saved_policy = deadlock_policy;
+  auto saved_check_on_wait = deadlock_check_on_wait;
+  deadlock_policy = policy;
+  deadlock_check_on_wait = check_on_wait;
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  lock_mgr.txn_manager_ = &txn_mgr;
+
+  table_oid_t toid{0};
+  RID rid0{0, 0};
+  RID rid1{1, 1};
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+  for (auto *txn : {txn0, txn1}) {
+    EXPECT_TRUE(lock_mgr.LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, toid));
+  }
+  EXPECT_TRUE(lock_mgr.LockRow(txn0, LockManager::LockMode::EXCLUSIVE, toid, rid0));
+  EXPECT_TRUE(lock_mgr.LockRow(txn1, LockManager::LockMode::EXCLUSIVE, toid, rid1));
+
+  std::thread t0;
+  std::thread t1;
+  auto start_txn0 = [&] {
+    t0 = std::thread([&] {
+      EXPECT_TRUE(lock_mgr.LockRow(txn0, LockManager::LockMode::EXCLUSIVE, toid, rid1));
+      txn_mgr.Commit(txn0);
+    });
+  };
+  auto start_txn1 = [&] {
+    t1 = std::thread([&] {
+      EXPECT_FALSE(lock_mgr.LockRow(txn1, LockManager::LockMode::EXCLUSIVE, toid, rid0));
+      EXPECT_EQ(TransactionState::ABORTED, txn1->GetState());
+      txn_mgr.Abort(txn1);
+    });
+  };
+  if (older_first) {
+    start_txn0();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    start_txn1();
+  } else {
+    start_txn1();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    start_txn0();
+  }
+  t0.join();
+  t1.join();
+  EXPECT_EQ(TransactionState::COMMITTED, txn0->GetState());
+
+  delete txn0;
+  delete txn1;
+  deadlock_policy = saved_policy;
+  deadlock_check_on_wait = saved_check_on_wait;
+}
+
+TEST(LockManagerDeadlockDetectionTest, CheckOnWaitTest) { CrossLockTest(DeadlockPolicy::DETECTION, true, true); }
+
+TEST(LockManagerDeadlockDetectionTest, WaitDieTest) { CrossLockTest(DeadlockPolicy::WAIT_DIE, false, true); }
+
+TEST(LockManagerDeadlockDetectionTest, WoundWaitTest) {
+  // The younger transaction is wounded while running, then while waiting.
+  CrossLockTest(DeadlockPolicy::WOUND_WAIT, false, true);
+  CrossLockTest(DeadlockPolicy::WOUND_WAIT, false, false);
+}
+
 }  // namespace bustub
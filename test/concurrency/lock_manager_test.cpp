@@ -2,13 +2,19 @@
  * lock_manager_test.cpp
  */
 
+#include <atomic>
 #include <random>
 #include <thread>  // NOLINT
 
+#include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
+#include "common/exception.h"
 #include "common_checker.h"  // NOLINT
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction_manager.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
 
 #include "gtest/gtest.h"
 
@@ -110,7 +116,7 @@ void TableLockTest1() {
     delete txns[i];
   }
 }
-TEST(LockManagerTest, DISABLED_TableLockTest1) { TableLockTest1(); }  // NOLINT
+TEST(LockManagerTest, TableLockTest1) { TableLockTest1(); }  // NOLINT
 
 /** Upgrading single transaction from S -> X */
 void TableLockUpgradeTest1() {
@@ -135,7 +141,7 @@ void TableLockUpgradeTest1() {
 
   delete txn1;
 }
-TEST(LockManagerTest, DISABLED_TableLockUpgradeTest1) { TableLockUpgradeTest1(); }  // NOLINT
+TEST(LockManagerTest, TableLockUpgradeTest1) { TableLockUpgradeTest1(); }  // NOLINT
 
 void RowLockTest1() {
   LockManager lock_mgr{};
@@ -191,7 +197,7 @@ void RowLockTest1() {
     delete txns[i];
   }
 }
-TEST(LockManagerTest, DISABLED_RowLockTest1) { RowLockTest1(); }  // NOLINT
+TEST(LockManagerTest, RowLockTest1) { RowLockTest1(); }  // NOLINT
 
 void TwoPLTest1() {
   LockManager lock_mgr{};
@@ -240,7 +246,7 @@ void TwoPLTest1() {
   delete txn;
 }
 
-TEST(LockManagerTest, DISABLED_TwoPLTest1) { TwoPLTest1(); }  // NOLINT
+TEST(LockManagerTest, TwoPLTest1) { TwoPLTest1(); }  // NOLINT
 
 void AbortTest1() {
   fmt::print(stderr, "AbortTest1: multiple X should block\n");
@@ -302,6 +308,207 @@ void AbortTest1() {
   delete txn3;
 }
 
-TEST(LockManagerTest, DISABLED_RowAbortTest1) { AbortTest1(); }  // NOLINT
+TEST(LockManagerTest, RowAbortTest1) { AbortTest1(); }  // NOLINT
+
+// NOLINTNEXTLINE
+TEST(LockManagerTest, FastPathTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  table_oid_t oid = 0;
+
+  // Intention locks granted on the fast path still hold off a shared lock on the table.
+  auto *writer = txn_mgr.Begin();
+  auto *reader = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(writer, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+  EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::EXCLUSIVE, oid, RID{0, 0}));
+  std::atomic<bool> granted{false};
+  std::thread reader_task([&] {
+    EXPECT_TRUE(lock_mgr.LockTable(reader, LockManager::LockMode::SHARED, oid));
+    granted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+  txn_mgr.Commit(writer);
+  reader_task.join();
+  EXPECT_TRUE(granted);
+
+  // While the shared lock is held, the intention locks go through the queue and wait for it.
+  auto *writer2 = txn_mgr.Begin();
+  granted = false;
+  std::thread writer_task([&] {
+    EXPECT_TRUE(lock_mgr.LockTable(writer2, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+    granted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+  txn_mgr.Commit(reader);
+  writer_task.join();
+  EXPECT_TRUE(granted);
+  txn_mgr.Commit(writer2);
+
+  // Writers of different rows of the same table do not block each other.
+  std::vector<std::thread> threads;
+  std::atomic<int> committed{0};
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < 200; j++) {
+        auto *txn = txn_mgr.Begin();
+        EXPECT_TRUE(lock_mgr.LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+        EXPECT_TRUE(lock_mgr.LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{i, static_cast<uint32_t>(j)}));
+        txn_mgr.Commit(txn);
+        committed += txn->GetState() == TransactionState::COMMITTED ? 1 : 0;
+        delete txn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(committed, 1600);
+
+  delete writer;
+  delete reader;
+  delete writer2;
+}
+
+// NOLINTNEXTLINE
+TEST(LockManagerTest, EscalationTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  table_oid_t oid = 0;
+  auto threshold = lock_escalation_threshold;
+  lock_escalation_threshold = 10;
+
+  // Escalation waits for the other intention exclusive lock to go.
+  auto *txn = txn_mgr.Begin();
+  auto *other = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+  EXPECT_TRUE(lock_mgr.LockTable(other, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+  for (uint32_t i = 0; i < 15; i++) {
+    EXPECT_TRUE(lock_mgr.LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{0, i}));
+  }
+  CheckTableLockSizes(txn, 0, 0, 0, 1, 0);
+  CheckTxnRowLockSize(txn, oid, 0, 15);
+  txn_mgr.Commit(other);
+
+  // The next attempt trades the row locks for a table lock, which covers the rows locked later.
+  for (uint32_t i = 15; i < 21; i++) {
+    EXPECT_TRUE(lock_mgr.LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{0, i}));
+  }
+  CheckTableLockSizes(txn, 0, 1, 0, 0, 0);
+  CheckTxnRowLockSize(txn, oid, 0, 0);
+  EXPECT_TRUE(lock_mgr.LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{1, 0}));
+  EXPECT_TRUE(lock_mgr.UnlockRow(txn, oid, RID{0, 3}));
+  CheckTxnRowLockSize(txn, oid, 0, 0);
+  CheckGrowing(txn);
+
+  // Shared rows escalate to a shared table lock.
+  auto *reader = txn_mgr.Begin();
+  auto *blocked = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(reader, LockManager::LockMode::INTENTION_SHARED, oid + 1));
+  for (uint32_t i = 0; i < 11; i++) {
+    EXPECT_TRUE(lock_mgr.LockRow(reader, LockManager::LockMode::SHARED, oid + 1, RID{0, i}));
+  }
+  EXPECT_TRUE(reader->IsTableSharedLocked(oid + 1));
+  CheckTxnRowLockSize(reader, oid + 1, 0, 0);
+  std::atomic<bool> granted{false};
+  std::thread blocked_task([&] {
+    EXPECT_TRUE(lock_mgr.LockTable(blocked, LockManager::LockMode::INTENTION_EXCLUSIVE, oid + 1));
+    granted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+  txn_mgr.Commit(reader);
+  blocked_task.join();
+  EXPECT_TRUE(granted);
+
+  // Writing a row under an escalated shared lock does not wait for the table: it takes SIX and locks the row when
+  // another transaction reads rows, and gives up when another reads the table.
+  auto *writer = txn_mgr.Begin();
+  auto *row_reader = txn_mgr.Begin();
+  auto *table_reader = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(row_reader, LockManager::LockMode::INTENTION_SHARED, oid + 2));
+  EXPECT_TRUE(lock_mgr.LockTable(writer, LockManager::LockMode::INTENTION_SHARED, oid + 2));
+  for (uint32_t i = 0; i < 11; i++) {
+    EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::SHARED, oid + 2, RID{0, i}));
+  }
+  EXPECT_TRUE(writer->IsTableSharedLocked(oid + 2));
+  EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::EXCLUSIVE, oid + 2, RID{1, 0}));
+  EXPECT_TRUE(writer->IsTableSharedIntentionExclusiveLocked(oid + 2));
+  CheckTxnRowLockSize(writer, oid + 2, 0, 1);
+  txn_mgr.Commit(row_reader);
+  txn_mgr.Commit(writer);
+  delete writer;
+
+  writer = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(table_reader, LockManager::LockMode::SHARED, oid + 3));
+  EXPECT_TRUE(lock_mgr.LockTable(writer, LockManager::LockMode::INTENTION_SHARED, oid + 3));
+  for (uint32_t i = 0; i < 11; i++) {
+    EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::SHARED, oid + 3, RID{0, i}));
+  }
+  EXPECT_TRUE(writer->IsTableSharedLocked(oid + 3));
+  EXPECT_FALSE(lock_mgr.LockRow(writer, LockManager::LockMode::EXCLUSIVE, oid + 3, RID{1, 0}));
+  EXPECT_EQ(writer->GetState(), TransactionState::ABORTED);
+  txn_mgr.Abort(writer);
+  txn_mgr.Commit(table_reader);
+
+  txn_mgr.Commit(txn);
+  txn_mgr.Commit(blocked);
+  CheckTableLockSizes(txn, 0, 0, 0, 0, 0);
+  lock_escalation_threshold = threshold;
+  delete txn;
+  delete other;
+  delete reader;
+  delete blocked;
+  delete writer;
+  delete row_reader;
+  delete table_reader;
+}
+
+// NOLINTNEXTLINE
+TEST(LockManagerTest, InsertLockFailureTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManager bpm(16, &disk_manager);
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}}};
+  TableHeap heap(&bpm, schema, TableStorage::ROW);
+  table_oid_t oid = 0;
+  auto threshold = lock_escalation_threshold;
+  lock_escalation_threshold = 10;
+
+  // The writer cannot lock the tuples it inserts under its escalated shared lock while another reads the table.
+  auto *table_reader = txn_mgr.Begin();
+  auto *writer = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(table_reader, LockManager::LockMode::SHARED, oid));
+  EXPECT_TRUE(lock_mgr.LockTable(writer, LockManager::LockMode::INTENTION_SHARED, oid));
+  for (uint32_t i = 0; i < 11; i++) {
+    EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::SHARED, oid, RID{100, i}));
+  }
+  TupleMeta meta{writer->GetTransactionId(), INVALID_TXN_ID, false};
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < 3; i++) {
+    tuples.push_back(Tuple{{ValueFactory::GetIntegerValue(i)}, &schema});
+  }
+  EXPECT_THROW(heap.InsertTuple(meta, tuples[0], &lock_mgr, writer, oid), ExecutionException);
+  EXPECT_THROW(heap.InsertTuples(meta, tuples, &lock_mgr, writer, oid), ExecutionException);
+  CheckAborted(writer);
+
+  // The writer has no record of them, so they are deleted for good right away.
+  size_t num_tuples = 0;
+  for (auto iter = heap.MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto meta = iter.GetTuple().first;
+    EXPECT_TRUE(meta.is_deleted_);
+    EXPECT_EQ(meta.insert_txn_id_, INVALID_TXN_ID);
+    EXPECT_EQ(meta.delete_txn_id_, INVALID_TXN_ID);
+    num_tuples++;
+  }
+  EXPECT_EQ(num_tuples, 4);
+  txn_mgr.Abort(writer);
+  txn_mgr.Commit(table_reader);
+  lock_escalation_threshold = threshold;
+  delete writer;
+  delete table_reader;
+}
 
 }  // namespace bustub
@@ -0,0 +1,399 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mvcc_test.cpp
+//
+// Identification: test/concurrency/mvcc_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/exception.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** Drives a table heap the way the insert, update, delete and scan executors do. */
+class MvccTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    disk_manager_ = std::make_unique<DiskManagerUnlimitedMemory>();
+    bpm_ = std::make_unique<BufferPoolManager>(32, disk_manager_.get());
+    heap_ = std::make_unique<TableHeap>(bpm_.get(), schema_, TableStorage::ROW);
+  }
+
+  auto Begin(IsolationLevel isolation_level = IsolationLevel::SNAPSHOT_ISOLATION) -> Transaction * {
+    txns_.emplace_back(txn_mgr_.Begin(nullptr, isolation_level));
+    return txns_.back().get();
+  }
+
+  auto Insert(Transaction *txn, int a) -> RID {
+    auto rid = heap_->InsertTuple(TupleMeta{txn->GetTransactionId(), INVALID_TXN_ID, false}, MakeTuple(a));
+    TableWriteRecord write_record{0, *rid, heap_.get()};
+    write_record.wtype_ = WType::INSERT;
+    txn->AppendTableWriteRecord(write_record);
+    return *rid;
+  }
+
+  auto Update(Transaction *txn, RID rid, int a) -> bool {
+    auto check = [&](const TupleMeta &meta, const Tuple &tuple, RID) {
+      return txn_mgr_.PrepareWrite(txn, meta, tuple, rid);
+    };
+    if (!heap_->UpdateTupleInPlace(TupleMeta{txn->GetTransactionId(), INVALID_TXN_ID, false}, MakeTuple(a), rid,
+                                   check)) {
+      return false;
+    }
+    TableWriteRecord write_record{0, rid, heap_.get()};
+    write_record.wtype_ = WType::UPDATE;
+    txn->AppendTableWriteRecord(write_record);
+    return true;
+  }
+
+  auto Delete(Transaction *txn, RID rid) -> bool {
+    TupleMeta meta{INVALID_TXN_ID, txn->GetTransactionId(), true};
+    auto check = [&](const TupleMeta &current_meta, const Tuple &tuple, RID) {
+      meta.insert_txn_id_ = current_meta.insert_txn_id_;
+      return txn_mgr_.PrepareWrite(txn, current_meta, tuple, rid);
+    };
+    if (!heap_->UpdateTupleMeta(meta, rid, check)) {
+      return false;
+    }
+    TableWriteRecord write_record{0, rid, heap_.get()};
+    write_record.wtype_ = WType::DELETE;
+    txn->AppendTableWriteRecord(write_record);
+    return true;
+  }
+
+  /** @return the value of the tuple `rid` that `txn` reads, std::nullopt if it reads none */
+  auto Read(Transaction *txn, RID rid) -> std::optional<int> {
+    if (txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC) {
+      txn->AddIntoReadSet(rid);
+    }
+    auto [meta, tuple] = heap_->GetTuple(rid);
+    if (!txn_mgr_.SeesVersion(txn, meta)) {
+      auto version = txn_mgr_.GetVersion(txn, rid);
+      if (!version.has_value()) {
+        return std::nullopt;
+      }
+      tuple = *version;
+    } else if (meta.is_deleted_) {
+      return std::nullopt;
+    }
+    return tuple.GetValue(&schema_, 0).GetAs<int32_t>();
+  }
+
+  /** Record a scan of the tuples with a value of at least `min`, as the scan executors do for optimistic ones. */
+  void RecordScan(Transaction *txn, int min) {
+    auto matches = [this, min](const Tuple &tuple) { return tuple.GetValue(&schema_, 0).GetAs<int32_t>() >= min; };
+    txn->AppendScanRecord(ScanRecord{heap_.get(), matches});
+  }
+
+  auto MakeTuple(int a) -> Tuple { return Tuple{{ValueFactory::GetIntegerValue(a)}, &schema_}; }
+
+  Schema schema_{std::vector<Column>{Column{"a", TypeId::INTEGER}}};
+  std::unique_ptr<DiskManagerUnlimitedMemory> disk_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  std::unique_ptr<TableHeap> heap_;
+  LockManager lock_mgr_;
+  TransactionManager txn_mgr_{&lock_mgr_};
+  std::vector<std::unique_ptr<Transaction>> txns_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(MvccTest, SnapshotReadTest) {
+  auto *loader = Begin();
+  auto rid1 = Insert(loader, 1);
+  auto rid2 = Insert(loader, 2);
+  txn_mgr_.Commit(loader);
+
+  auto *reader = Begin();
+  auto *writer = Begin();
+  ASSERT_TRUE(Update(writer, rid1, 10));
+  ASSERT_TRUE(Update(writer, rid1, 11));
+  ASSERT_TRUE(Delete(writer, rid2));
+  auto rid3 = Insert(writer, 3);
+
+  // The writer reads its own writes, the others the versions committed before they began.
+  EXPECT_EQ(Read(writer, rid1), 11);
+  EXPECT_EQ(Read(writer, rid2), std::nullopt);
+  EXPECT_EQ(Read(writer, rid3), 3);
+  EXPECT_EQ(Read(reader, rid1), 1);
+  EXPECT_EQ(Read(reader, rid2), 2);
+  EXPECT_EQ(Read(reader, rid3), std::nullopt);
+
+  txn_mgr_.Commit(writer);
+  EXPECT_EQ(Read(reader, rid1), 1);
+  EXPECT_EQ(Read(reader, rid2), 2);
+  EXPECT_EQ(Read(reader, rid3), std::nullopt);
+
+  auto *late_reader = Begin();
+  EXPECT_EQ(Read(late_reader, rid1), 11);
+  EXPECT_EQ(Read(late_reader, rid2), std::nullopt);
+  EXPECT_EQ(Read(late_reader, rid3), 3);
+
+  // Transactions not under snapshot isolation read the newest versions.
+  auto *locking_reader = Begin(IsolationLevel::READ_COMMITTED);
+  auto *writer2 = Begin();
+  ASSERT_TRUE(Update(writer2, rid1, 12));
+  EXPECT_EQ(Read(locking_reader, rid1), 12);
+  EXPECT_EQ(Read(late_reader, rid1), 11);
+  EXPECT_EQ(Read(reader, rid1), 1);
+}
+
+// NOLINTNEXTLINE
+TEST_F(MvccTest, WriteConflictTest) {
+  auto *loader = Begin();
+  auto rid = Insert(loader, 1);
+  txn_mgr_.Commit(loader);
+
+  auto *txn1 = Begin();
+  auto *txn2 = Begin();
+  auto *txn3 = Begin();
+  ASSERT_TRUE(Update(txn1, rid, 10));
+  // The first writer wins, the second aborts instead of waiting.
+  EXPECT_THROW(Update(txn2, rid, 20), ExecutionException);
+  EXPECT_EQ(txn2->GetState(), TransactionState::ABORTED);
+  txn_mgr_.Abort(txn2);
+
+  txn_mgr_.Commit(txn1);
+  // txn3 does not see the version of txn1, so it may not overwrite it either.
+  EXPECT_THROW(Delete(txn3, rid), ExecutionException);
+  txn_mgr_.Abort(txn3);
+
+  auto *txn4 = Begin();
+  EXPECT_EQ(Read(txn4, rid), 10);
+  ASSERT_TRUE(Delete(txn4, rid));
+  txn_mgr_.Commit(txn4);
+  // A deleted tuple is left alone.
+  auto *txn5 = Begin();
+  EXPECT_FALSE(Update(txn5, rid, 50));
+  EXPECT_EQ(Read(txn5, rid), std::nullopt);
+}
+
+// NOLINTNEXTLINE
+TEST_F(MvccTest, AbortTest) {
+  auto *loader = Begin();
+  auto rid1 = Insert(loader, 1);
+  auto rid2 = Insert(loader, 2);
+  txn_mgr_.Commit(loader);
+
+  auto *reader = Begin();
+  auto *txn = Begin();
+  ASSERT_TRUE(Update(txn, rid1, 10));
+  ASSERT_TRUE(Update(txn, rid1, 11));
+  ASSERT_TRUE(Delete(txn, rid1));
+  ASSERT_TRUE(Delete(txn, rid2));
+  auto rid3 = Insert(txn, 3);
+  ASSERT_TRUE(Update(txn, rid3, 30));
+  txn_mgr_.Abort(txn);
+  EXPECT_EQ(txn->GetState(), TransactionState::ABORTED);
+
+  // The versions before the transaction are back in the table heap, and nothing is left in the version chains.
+  for (auto *after : {reader, Begin(), Begin(IsolationLevel::READ_COMMITTED)}) {
+    EXPECT_EQ(Read(after, rid1), 1);
+    EXPECT_EQ(Read(after, rid2), 2);
+    EXPECT_EQ(Read(after, rid3), std::nullopt);
+  }
+  EXPECT_EQ(txn_mgr_.GetUndoLog(rid1), nullptr);
+  EXPECT_EQ(txn_mgr_.GetUndoLog(rid2), nullptr);
+  EXPECT_EQ(heap_->GetTupleMeta(rid1).insert_txn_id_, loader->GetTransactionId());
+
+  // The tuples can be written again.
+  auto *txn2 = Begin();
+  ASSERT_TRUE(Update(txn2, rid1, 100));
+  txn_mgr_.Commit(txn2);
+  EXPECT_EQ(Read(Begin(), rid1), 100);
+  EXPECT_EQ(Read(reader, rid1), 1);
+}
+
+// NOLINTNEXTLINE
+TEST_F(MvccTest, AbortShrinkingUpdateTest) {
+  // The values stay in the page.
+  auto old_threshold = toast_tuple_threshold;
+  toast_tuple_threshold = BUSTUB_PAGE_SIZE;
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 4000}}};
+  TableHeap heap(bpm_.get(), schema, TableStorage::ROW);
+  auto make_tuple = [&](size_t length) {
+    return Tuple{{ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue(std::string(length, 'x'))}, &schema};
+  };
+  auto length_of = [&](RID rid) { return heap.GetTuple(rid).second.GetValue(&schema, 1).ToString().size(); };
+  auto update = [&](Transaction *txn, RID rid, size_t length) {
+    auto check = [&](const TupleMeta &meta, const Tuple &tuple, RID) {
+      return txn_mgr_.PrepareWrite(txn, meta, tuple, rid);
+    };
+    if (!heap.UpdateTupleInPlace(TupleMeta{txn->GetTransactionId(), INVALID_TXN_ID, false}, make_tuple(length), rid,
+                                 check)) {
+      return false;
+    }
+    TableWriteRecord write_record{0, rid, &heap};
+    write_record.wtype_ = WType::UPDATE;
+    txn->AppendTableWriteRecord(write_record);
+    return true;
+  };
+
+  // Two tuples fill most of a page.
+  auto *loader = Begin();
+  auto rid1 = *heap.InsertTuple(TupleMeta{loader->GetTransactionId(), INVALID_TXN_ID, false}, make_tuple(1800));
+  auto rid2 = *heap.InsertTuple(TupleMeta{loader->GetTransactionId(), INVALID_TXN_ID, false}, make_tuple(1800));
+  ASSERT_EQ(rid1.GetPageId(), rid2.GetPageId());
+  txn_mgr_.Commit(loader);
+
+  // The bytes the first tuple no longer needs are kept for its restore, so the second cannot grow into them.
+  auto *shrinker = Begin();
+  ASSERT_TRUE(update(shrinker, rid1, 10));
+  auto *grower = Begin();
+  EXPECT_FALSE(update(grower, rid2, 3400));
+  txn_mgr_.Abort(shrinker);
+  EXPECT_EQ(length_of(rid1), 1800);
+  EXPECT_EQ(length_of(rid2), 1800);
+  txn_mgr_.Abort(grower);
+
+  // Once the shrinking transaction is seen by all, the vacuum gives the bytes back.
+  auto *committer = Begin();
+  ASSERT_TRUE(update(committer, rid1, 10));
+  txn_mgr_.Commit(committer);
+  auto *grower2 = Begin();
+  EXPECT_FALSE(update(grower2, rid2, 3400));
+  txn_mgr_.Abort(grower2);
+  txn_mgr_.Vacuum();
+  auto *grower3 = Begin();
+  EXPECT_TRUE(update(grower3, rid2, 3400));
+  EXPECT_EQ(length_of(rid1), 10);
+  EXPECT_EQ(length_of(rid2), 3400);
+  toast_tuple_threshold = old_threshold;
+}
+
+// NOLINTNEXTLINE
+TEST_F(MvccTest, VacuumTest) {
+  auto *loader = Begin();
+  auto rid1 = Insert(loader, 1);
+  auto rid2 = Insert(loader, 2);
+  auto rid3 = Insert(loader, 3);
+  txn_mgr_.Commit(loader);
+
+  auto *reader = Begin();
+  auto *writer = Begin();
+  ASSERT_TRUE(Update(writer, rid1, 10));
+  ASSERT_TRUE(Update(writer, rid1, 11));
+  ASSERT_TRUE(Delete(writer, rid2));
+  txn_mgr_.Commit(writer);
+  EXPECT_EQ(txn_mgr_.GetWatermark(), reader->GetReadTs());
+
+  // The reader still reads the versions before the writer, so only the writes of the loader are vacuumed.
+  txn_mgr_.Vacuum();
+  EXPECT_EQ(heap_->GetTupleMeta(rid3).insert_txn_id_, INVALID_TXN_ID);
+  EXPECT_EQ(heap_->GetTupleMeta(rid1).insert_txn_id_, writer->GetTransactionId());
+  EXPECT_NE(txn_mgr_.GetUndoLog(rid1), nullptr);
+  EXPECT_EQ(Read(reader, rid1), 1);
+  EXPECT_EQ(Read(reader, rid2), 2);
+  EXPECT_EQ(Read(reader, rid3), 3);
+
+  // A newer transaction holds back nothing the writer replaced.
+  auto *late_reader = Begin();
+  txn_mgr_.Commit(reader);
+  EXPECT_EQ(txn_mgr_.GetWatermark(), late_reader->GetReadTs());
+  txn_mgr_.Vacuum();
+  EXPECT_EQ(txn_mgr_.GetUndoLog(rid1), nullptr);
+  EXPECT_EQ(txn_mgr_.GetUndoLog(rid2), nullptr);
+  auto meta1 = heap_->GetTupleMeta(rid1);
+  EXPECT_EQ(meta1.insert_txn_id_, INVALID_TXN_ID);
+  EXPECT_FALSE(meta1.is_deleted_);
+  auto meta2 = heap_->GetTupleMeta(rid2);
+  EXPECT_EQ(meta2.delete_txn_id_, INVALID_TXN_ID);
+  EXPECT_TRUE(meta2.is_deleted_);
+  EXPECT_EQ(Read(late_reader, rid1), 11);
+  EXPECT_EQ(Read(late_reader, rid2), std::nullopt);
+
+  // The slot of the deleted tuple is given back to new tuples.
+  auto *inserter = Begin();
+  EXPECT_EQ(Insert(inserter, 4), rid2);
+  EXPECT_EQ(Read(inserter, rid2), 4);
+  EXPECT_EQ(Read(late_reader, rid2), std::nullopt);
+}
+
+// NOLINTNEXTLINE
+TEST_F(MvccTest, OptimisticValidationTest) {
+  auto *loader = Begin();
+  auto rid1 = Insert(loader, 1);
+  auto rid2 = Insert(loader, 2);
+  txn_mgr_.Commit(loader);
+
+  // txn1 read a tuple that txn2 overwrote and committed since, so it fails validation.
+  auto *txn1 = Begin(IsolationLevel::OPTIMISTIC);
+  auto *txn2 = Begin(IsolationLevel::OPTIMISTIC);
+  EXPECT_EQ(Read(txn1, rid1), 1);
+  ASSERT_TRUE(Update(txn1, rid2, 20));
+  ASSERT_TRUE(Update(txn2, rid1, 10));
+  EXPECT_TRUE(txn_mgr_.Commit(txn2));
+  EXPECT_FALSE(txn_mgr_.Commit(txn1));
+  EXPECT_EQ(txn1->GetState(), TransactionState::ABORTED);
+  EXPECT_EQ(Read(Begin(), rid2), 2);
+
+  // Writes to tuples not read pass.
+  auto *txn3 = Begin(IsolationLevel::OPTIMISTIC);
+  auto *txn4 = Begin(IsolationLevel::OPTIMISTIC);
+  EXPECT_EQ(Read(txn3, rid1), 10);
+  ASSERT_TRUE(Update(txn3, rid1, 11));
+  ASSERT_TRUE(Update(txn4, rid2, 21));
+  EXPECT_TRUE(txn_mgr_.Commit(txn4));
+  EXPECT_TRUE(txn_mgr_.Commit(txn3));
+  EXPECT_EQ(Read(Begin(), rid1), 11);
+  EXPECT_EQ(Read(Begin(), rid2), 21);
+
+  // A transaction that wrote nothing commits at its snapshot.
+  auto *reader = Begin(IsolationLevel::OPTIMISTIC);
+  auto *txn5 = Begin(IsolationLevel::OPTIMISTIC);
+  EXPECT_EQ(Read(reader, rid1), 11);
+  ASSERT_TRUE(Update(txn5, rid1, 12));
+  EXPECT_TRUE(txn_mgr_.Commit(txn5));
+  EXPECT_EQ(Read(reader, rid1), 11);
+  EXPECT_TRUE(txn_mgr_.Commit(reader));
+}
+
+// NOLINTNEXTLINE
+TEST_F(MvccTest, OptimisticPhantomTest) {
+  auto *loader = Begin();
+  Insert(loader, 1);
+  auto rid2 = Insert(loader, 2);
+  txn_mgr_.Commit(loader);
+
+  // A tuple inserted since, that the scan would read, is a phantom.
+  auto *txn1 = Begin(IsolationLevel::OPTIMISTIC);
+  RecordScan(txn1, 10);
+  Insert(txn1, 100);
+  auto *txn2 = Begin(IsolationLevel::OPTIMISTIC);
+  Insert(txn2, 20);
+  EXPECT_TRUE(txn_mgr_.Commit(txn2));
+  EXPECT_FALSE(txn_mgr_.Commit(txn1));
+
+  // So is a tuple updated since to one the scan would read, unlike one the scan would not read.
+  auto *txn3 = Begin(IsolationLevel::OPTIMISTIC);
+  auto *txn4 = Begin(IsolationLevel::OPTIMISTIC);
+  RecordScan(txn3, 30);
+  RecordScan(txn4, 30);
+  Insert(txn3, 4);
+  Insert(txn4, 5);
+  auto *txn5 = Begin(IsolationLevel::OPTIMISTIC);
+  Insert(txn5, 3);
+  EXPECT_TRUE(txn_mgr_.Commit(txn5));
+  EXPECT_TRUE(txn_mgr_.Commit(txn3));
+  auto *txn6 = Begin(IsolationLevel::OPTIMISTIC);
+  ASSERT_TRUE(Update(txn6, rid2, 50));
+  EXPECT_TRUE(txn_mgr_.Commit(txn6));
+  EXPECT_FALSE(txn_mgr_.Commit(txn4));
+}
+
+}  // namespace bustub
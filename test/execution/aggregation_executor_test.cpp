@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_executor_test.cpp
+//
+// Identification: test/execution/aggregation_executor_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "execution/executor_context.h"
+#include "execution/executors/aggregation_executor.h"
+#include "execution/expressions/column_value_expression.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** Produces a fixed list of tuples. */
+class VectorExecutor : public AbstractExecutor {
+ public:
+  VectorExecutor(ExecutorContext *exec_ctx, const Schema *schema, std::vector<Tuple> tuples)
+      : AbstractExecutor(exec_ctx), schema_(schema), tuples_(std::move(tuples)) {}
+
+  void Init() override { cursor_ = 0; }
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override {
+    if (cursor_ == tuples_.size()) {
+      return false;
+    }
+    *tuple = tuples_[cursor_++];
+    return true;
+  }
+
+  auto GetOutputSchema() const -> const Schema & override { return *schema_; }
+
+ private:
+  const Schema *schema_;
+  std::vector<Tuple> tuples_;
+  size_t cursor_{0};
+};
+
+/**
+ * Runs `SELECT g, COUNT(*), COUNT(v), SUM(v), MIN(v), MAX(v) FROM input GROUP BY g` and checks every group.
+ * @param[out] num_spills if not nullptr, the number of times the executor spilled a table
+ */
+static void CheckGroupedAggregation(size_t memory_budget, size_t num_threads, size_t *num_spills = nullptr) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager.get());
+  ExecutorContext exec_ctx(nullptr, nullptr, bpm.get(), nullptr, nullptr, false);
+
+  const int num_tuples = 20000;
+  const int num_groups = 3000;
+  auto input_schema = std::make_shared<Schema>(
+      std::vector<Column>{Column{"g", TypeId::INTEGER}, Column{"v", TypeId::INTEGER}});
+  std::vector<Tuple> input;
+  for (int i = 0; i < num_tuples; i++) {
+    // Every seventh value is NULL, so COUNT(v) and COUNT(*) differ.
+    auto v = i % 7 == 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(i);
+    input.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(i % num_groups), v}, input_schema.get());
+  }
+
+  auto g = std::make_shared<ColumnValueExpression>(0, 0, TypeId::INTEGER);
+  auto v = std::make_shared<ColumnValueExpression>(0, 1, TypeId::INTEGER);
+  auto output_schema = std::make_shared<Schema>(std::vector<Column>{
+      Column{"g", TypeId::INTEGER}, Column{"count_star", TypeId::INTEGER}, Column{"count", TypeId::INTEGER},
+      Column{"sum", TypeId::INTEGER}, Column{"min", TypeId::INTEGER}, Column{"max", TypeId::INTEGER}});
+  AggregationPlanNode plan(output_schema, nullptr, {g}, {v, v, v, v, v},
+                           {AggregationType::CountStarAggregate, AggregationType::CountAggregate,
+                            AggregationType::SumAggregate, AggregationType::MinAggregate,
+                            AggregationType::MaxAggregate});
+
+  auto saved_budget = aggregation_memory_budget;
+  auto saved_threads = aggregation_num_threads;
+  aggregation_memory_budget = memory_budget;
+  aggregation_num_threads = num_threads;
+  AggregationExecutor executor(&exec_ctx, &plan,
+                               std::make_unique<VectorExecutor>(&exec_ctx, input_schema.get(), std::move(input)));
+  executor.Init();
+
+  std::map<int, std::vector<int>> expected;
+  for (int i = 0; i < num_tuples; i++) {
+    auto &row = expected[i % num_groups];
+    if (row.empty()) {
+      row = {0, 0, 0, INT32_MAX, INT32_MIN};
+    }
+    row[0]++;
+    if (i % 7 != 0) {
+      row[1]++;
+      row[2] += i;
+      row[3] = std::min(row[3], i);
+      row[4] = std::max(row[4], i);
+    }
+  }
+  Tuple tuple;
+  RID rid;
+  size_t num_output = 0;
+  while (executor.Next(&tuple, &rid)) {
+    auto group = tuple.GetValue(output_schema.get(), 0).GetAs<int32_t>();
+    ASSERT_EQ(expected.count(group), 1) << "duplicate or unknown group " << group;
+    for (uint32_t i = 0; i < 5; i++) {
+      ASSERT_EQ(tuple.GetValue(output_schema.get(), i + 1).GetAs<int32_t>(), expected[group][i]) << group;
+    }
+    expected.erase(group);
+    num_output++;
+  }
+  aggregation_memory_budget = saved_budget;
+  aggregation_num_threads = saved_threads;
+  ASSERT_EQ(num_output, num_groups);
+  if (num_spills != nullptr) {
+    *num_spills = executor.GetNumSpills();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(AggregationExecutorTest, InMemoryTest) { CheckGroupedAggregation(64 * 1024 * 1024, 1); }
+
+// NOLINTNEXTLINE
+TEST(AggregationExecutorTest, ParallelTest) { CheckGroupedAggregation(64 * 1024 * 1024, 4); }
+
+// NOLINTNEXTLINE
+TEST(AggregationExecutorTest, SpillTest) { CheckGroupedAggregation(16 * 1024, 1); }
+
+// NOLINTNEXTLINE
+TEST(AggregationExecutorTest, ParallelSpillTest) { CheckGroupedAggregation(16 * 1024, 4); }
+
+// NOLINTNEXTLINE
+TEST(AggregationExecutorTest, SpillCountTest) {
+  size_t num_spills = 0;
+  CheckGroupedAggregation(16 * 1024, 1, &num_spills);
+  // A spill empties the table, so the next one waits until the table fills its budget again. If the cleared table
+  // still counted as full, every tuple after the first spill would be spilled on its own, some 20000 spills.
+  EXPECT_GT(num_spills, 0);
+  EXPECT_LT(num_spills, 20000 / 16);
+}
+
+}  // namespace bustub
@@ -0,0 +1,208 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bulk_loader_test.cpp
+//
+// Identification: test/execution/bulk_loader_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/catalog.h"
+#include "common/exception.h"
+#include "concurrency/transaction.h"
+#include "concurrency/transaction_manager.h"
+#include "execution/bulk_loader.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class BulkLoaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    disk_manager_ = std::make_unique<DiskManagerUnlimitedMemory>();
+    bpm_ = std::make_unique<BufferPoolManager>(64, disk_manager_.get());
+    catalog_ = std::make_unique<Catalog>(bpm_.get(), nullptr, nullptr);
+    Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 64},
+                                      Column{"c", TypeId::DECIMAL}}};
+    table_info_ = catalog_->CreateTable(nullptr, "t", schema);
+  }
+
+  auto Load(const std::string &input, const CopyOptions &options, size_t num_threads = 4, Transaction *txn = nullptr)
+      -> size_t {
+    std::istringstream stream(input);
+    BulkLoader loader(catalog_.get(), table_info_, indexes, txn, options, num_threads);
+    return loader.Load(stream);
+  }
+
+  /** @return the rows of the table as strings, sorted */
+  auto Rows() -> std::vector<std::string> {
+    std::vector<std::string> rows;
+    const auto &schema = table_info_->schema_;
+    for (auto iter = table_info_->table_->MakeIterator(); !iter.IsEnd(); ++iter) {
+      auto [meta, tuple] = iter.GetTuple();
+      std::string row;
+      for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+        row += (i == 0 ? "" : "|") + tuple.GetValue(&schema, i).ToString();
+      }
+      rows.push_back(row);
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+  }
+
+  std::unique_ptr<DiskManagerUnlimitedMemory> disk_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  std::unique_ptr<Catalog> catalog_;
+  TableInfo *table_info_;
+  std::vector<IndexInfo *> indexes;
+};
+
+// NOLINTNEXTLINE
+TEST_F(BulkLoaderTest, CsvTest) {
+  // Chunks of a few bytes put record boundaries, quotes and escapes at every position of a chunk.
+  auto old_chunk_size = copy_chunk_size;
+  copy_chunk_size = 7;
+  CopyOptions options;
+  options.header_ = true;
+  auto num_rows = Load(
+      "a,b,c\n"
+      "1,plain,1.5\n"
+      "2,\"with, comma\",-2\r\n"
+      "3,\"with \"\"quotes\"\"\",0\n"
+      "4,\"two\nlines\",3.25\n"
+      "5,,\n"
+      "6,\"\",7",
+      options);
+  copy_chunk_size = old_chunk_size;
+
+  ASSERT_EQ(num_rows, 6);
+  std::vector<std::string> expected{"1|plain|1.500000",      "2|with, comma|-2.000000",    "3|with \"quotes\"|0.000000",
+                                    "4|two\nlines|3.250000", "5|varlen_null|decimal_null", "6||7.000000"};
+  EXPECT_EQ(Rows(), expected);
+}
+
+// NOLINTNEXTLINE
+TEST_F(BulkLoaderTest, ManyRowsTest) {
+  std::string input;
+  for (int i = 0; i < 20000; i++) {
+    input += std::to_string(i) + ";row" + std::to_string(i) + ";" + std::to_string(i % 7) + "\n";
+  }
+  auto old_chunk_size = copy_chunk_size;
+  copy_chunk_size = 4096;
+  CopyOptions options;
+  options.delimiter_ = ';';
+  ASSERT_EQ(Load(input, options), 20000);
+  copy_chunk_size = old_chunk_size;
+
+  std::vector<bool> seen(20000);
+  const auto &schema = table_info_->schema_;
+  for (auto iter = table_info_->table_->MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto tuple = iter.GetTuple().second;
+    auto a = tuple.GetValue(&schema, 0).GetAs<int32_t>();
+    ASSERT_FALSE(seen[a]);
+    seen[a] = true;
+    EXPECT_EQ(tuple.GetValue(&schema, 1).ToString(), "row" + std::to_string(a));
+  }
+  EXPECT_EQ(std::count(seen.begin(), seen.end(), true), 20000);
+}
+
+// NOLINTNEXTLINE
+TEST_F(BulkLoaderTest, BinaryTest) {
+  const auto &schema = table_info_->schema_;
+  std::string input;
+  for (int i = 0; i < 100; i++) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(i % 10, 'x')),
+                 ValueFactory::GetDecimalValue(i / 2.0)},
+                &schema};
+    std::string record(sizeof(uint32_t) + tuple.GetLength(), '\0');
+    tuple.SerializeTo(record.data());
+    input += record;
+  }
+  CopyOptions options;
+  options.format_ = CopyFormat::BINARY;
+  ASSERT_EQ(Load(input, options), 100);
+  EXPECT_EQ(Rows().size(), 100);
+
+  // A record cut short is rejected.
+  input.pop_back();
+  EXPECT_THROW(Load(input, options), ExecutionException);
+}
+
+// NOLINTNEXTLINE
+TEST_F(BulkLoaderTest, TransactionTest) {
+  // The rows belong to the loading transaction until it commits, and it can undo every one of them.
+  Transaction txn(42);
+  std::string input;
+  for (int i = 0; i < 1000; i++) {
+    input += std::to_string(i) + ",row,1\n";
+  }
+  ASSERT_EQ(Load(input, CopyOptions{}, 4, &txn), 1000);
+  size_t num_rows = 0;
+  for (auto iter = table_info_->table_->MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto meta = iter.GetTuple().first;
+    EXPECT_EQ(meta.insert_txn_id_, txn.GetTransactionId());
+    EXPECT_FALSE(meta.is_deleted_);
+    num_rows++;
+  }
+  EXPECT_EQ(num_rows, 1000);
+  EXPECT_EQ(txn.GetWriteSet()->size(), 1000);
+}
+
+// NOLINTNEXTLINE
+TEST_F(BulkLoaderTest, AbortWithIndexTest) {
+  // Aborting the load takes its entries out of the indexes as well as its rows out of the table.
+  const auto &schema = table_info_->schema_;
+  Schema key_schema{std::vector<Column>{Column{"a", TypeId::INTEGER}}};
+  indexes.push_back(catalog_->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
+      nullptr, "t_a", "t", schema, key_schema, {0}, TWO_INTEGER_SIZE, IntegerHashFunctionType{}));
+  LockManager lock_mgr;
+  TransactionManager txn_mgr{&lock_mgr};
+  auto *txn = txn_mgr.Begin();
+  std::string input;
+  for (int i = 0; i < 1000; i++) {
+    input += std::to_string(i) + ",row,1\n";
+  }
+  ASSERT_EQ(Load(input, CopyOptions{}, 4, txn), 1000);
+  EXPECT_EQ(txn->GetIndexWriteSet()->size(), 1000);
+  txn_mgr.Abort(txn);
+
+  for (int i = 0; i < 1000; i++) {
+    std::vector<RID> rids;
+    indexes[0]->index_->ScanKey(Tuple{{ValueFactory::GetIntegerValue(i)}, &key_schema}, &rids, nullptr);
+    EXPECT_TRUE(rids.empty()) << i;
+  }
+  delete txn;
+}
+
+// NOLINTNEXTLINE
+TEST_F(BulkLoaderTest, ErrorTest) {
+  CopyOptions options;
+  auto message = [&](const std::string &input) {
+    try {
+      Load(input, options, 2);
+    } catch (ExecutionException &e) {
+      return std::string(e.what());
+    }
+    return std::string();
+  };
+  EXPECT_NE(message("1,a,1\n2,b,1\nx,c,1\n").find("line 3"), std::string::npos);
+  EXPECT_NE(message("1,a,1\n2,b\n").find("expected 3 fields"), std::string::npos);
+  EXPECT_NE(message("1,a,1,1\n").find("more than 3 fields"), std::string::npos);
+  EXPECT_NE(message("99999999999,a,1\n").find("invalid input for column a"), std::string::npos);
+  EXPECT_NE(message("1,\"a,1\n").find("unterminated"), std::string::npos);
+}
+
+}  // namespace bustub
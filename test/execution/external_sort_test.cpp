@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort_test.cpp
+//
+// Identification: test/execution/external_sort_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "execution/external_sort.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+static auto EncodeOne(const Value &value, bool descending) -> std::string {
+  std::string key;
+  SortKeyEncoder::AppendValue(value, descending, &key);
+  return key;
+}
+
+// NOLINTNEXTLINE
+TEST(SortKeyEncoderTest, OrderPreservingTest) {
+  std::vector<Value> integers{ValueFactory::GetNullValueByType(TypeId::INTEGER), ValueFactory::GetIntegerValue(-100),
+                              ValueFactory::GetIntegerValue(-1), ValueFactory::GetIntegerValue(0),
+                              ValueFactory::GetIntegerValue(7), ValueFactory::GetIntegerValue(1 << 30)};
+  std::vector<Value> decimals{ValueFactory::GetDecimalValue(-3.5), ValueFactory::GetDecimalValue(-0.25),
+                              ValueFactory::GetDecimalValue(0), ValueFactory::GetDecimalValue(1e-3),
+                              ValueFactory::GetDecimalValue(42.0)};
+  std::vector<Value> varchars{ValueFactory::GetVarcharValue(""), ValueFactory::GetVarcharValue("a"),
+                              ValueFactory::GetVarcharValue("ab"), ValueFactory::GetVarcharValue("b"),
+                              ValueFactory::GetVarcharValue("\xff")};
+
+  for (const auto *values : {&integers, &decimals, &varchars}) {
+    for (size_t i = 0; i + 1 < values->size(); i++) {
+      EXPECT_LT(EncodeOne((*values)[i], false), EncodeOne((*values)[i + 1], false)) << (*values)[i].ToString();
+      EXPECT_GT(EncodeOne((*values)[i], true), EncodeOne((*values)[i + 1], true)) << (*values)[i].ToString();
+    }
+  }
+
+  // A shorter string followed by another column must not compare as a longer string.
+  std::string a;
+  SortKeyEncoder::AppendValue(ValueFactory::GetVarcharValue("a"), false, &a);
+  SortKeyEncoder::AppendValue(ValueFactory::GetIntegerValue(100), false, &a);
+  std::string ab;
+  SortKeyEncoder::AppendValue(ValueFactory::GetVarcharValue("ab"), false, &ab);
+  SortKeyEncoder::AppendValue(ValueFactory::GetIntegerValue(0), false, &ab);
+  EXPECT_LT(a, ab);
+}
+
+// NOLINTNEXTLINE
+TEST(ExternalSortTest, SpillAndMergeTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(16, disk_manager.get());
+
+  Schema schema{std::vector<Column>{Column{"v", TypeId::INTEGER}}};
+  std::vector<int> input(5000);
+  std::iota(input.begin(), input.end(), 0);
+  std::shuffle(input.begin(), input.end(), std::mt19937(15445));
+
+  {
+    // A budget of a few KiB spills dozens of runs, more than the pool can merge in one pass.
+    ExternalSorter sorter(bpm.get(), 4096);
+    for (auto v : input) {
+      auto value = ValueFactory::GetIntegerValue(v);
+      sorter.Add(EncodeOne(value, false), Tuple{{value}, &schema});
+    }
+    sorter.Finish();
+    ASSERT_GT(sorter.GetNumSpilledRuns(), 8);
+
+    Tuple tuple;
+    for (int expected = 0; expected < static_cast<int>(input.size()); expected++) {
+      ASSERT_TRUE(sorter.Next(&tuple));
+      ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), expected);
+    }
+    ASSERT_FALSE(sorter.Next(&tuple));
+  }
+
+  // The pages of the runs, all allocated before this one, are gone from the pool with the sorter.
+  page_id_t next_page_id;
+  ASSERT_NE(bpm->NewPage(&next_page_id), nullptr);
+  ASSERT_GT(next_page_id, 8);
+  for (page_id_t page_id = 0; page_id < next_page_id; page_id++) {
+    ASSERT_FALSE(bpm->FlushPage(page_id)) << page_id;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// nested_loop_join_executor_test.cpp
+//
+// Identification: test/execution/nested_loop_join_executor_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "execution/execution_engine.h"
+#include "execution/executor_context.h"
+#include "execution/executors/init_check_executor.h"
+#include "execution/executors/nested_loop_join_executor.h"
+#include "execution/executors/values_executor.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/plans/values_plan.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** @return a plan producing the integers 0, 1, ..., num_rows - 1 in a column named `name` */
+static auto MakeValuesPlan(const std::string &name, int num_rows) -> std::shared_ptr<ValuesPlanNode> {
+  auto schema = std::make_shared<Schema>(std::vector<Column>{Column{name, TypeId::INTEGER}});
+  std::vector<std::vector<AbstractExpressionRef>> values;
+  for (int i = 0; i < num_rows; i++) {
+    values.push_back({std::make_shared<ConstantValueExpression>(ValueFactory::GetIntegerValue(i))});
+  }
+  return std::make_shared<ValuesPlanNode>(std::move(schema), std::move(values));
+}
+
+/**
+ * Runs a cross join of `num_left` by `num_right` tuples with the NLJ check wired in as the executor factory does,
+ * and runs the check afterwards.
+ * @return whether the join kept its inner side in memory
+ */
+static auto RunCheckedCrossJoin(int num_left, int num_right) -> bool {
+  ExecutorContext exec_ctx(nullptr, nullptr, nullptr, nullptr, nullptr, false);
+  auto left_plan = MakeValuesPlan("l", num_left);
+  auto right_plan = MakeValuesPlan("r", num_right);
+  auto output_schema = std::make_shared<Schema>(
+      std::vector<Column>{Column{"l", TypeId::INTEGER}, Column{"r", TypeId::INTEGER}});
+  NestedLoopJoinPlanNode plan(output_schema, left_plan, right_plan,
+                              std::make_shared<ConstantValueExpression>(ValueFactory::GetBooleanValue(true)),
+                              JoinType::INNER);
+
+  auto left_check = std::make_unique<InitCheckExecutor>(
+      &exec_ctx, left_plan, std::make_unique<ValuesExecutor>(&exec_ctx, left_plan.get()));
+  auto right_check = std::make_unique<InitCheckExecutor>(
+      &exec_ctx, right_plan, std::make_unique<ValuesExecutor>(&exec_ctx, right_plan.get()));
+  auto *left_check_ptr = left_check.get();
+  auto *right_check_ptr = right_check.get();
+  NestedLoopJoinExecutor join(&exec_ctx, &plan, std::move(left_check), std::move(right_check));
+  exec_ctx.AddCheckExecutor(left_check_ptr, right_check_ptr, &join);
+
+  join.Init();
+  Tuple tuple;
+  RID rid;
+  int num_output = 0;
+  while (join.Next(&tuple, &rid)) {
+    num_output++;
+  }
+  EXPECT_EQ(num_left * num_right, num_output);
+
+  ExecutionEngine engine(nullptr, nullptr, nullptr);
+  engine.PerformChecks(&exec_ctx);
+  return join.IsInnerMaterialized();
+}
+
+// NOLINTNEXTLINE
+TEST(NestedLoopJoinExecutorTest, MaterializeThresholdBoundary) {
+  auto saved_block_size = nlj_block_size;
+  auto saved_threshold = nlj_inner_materialize_threshold;
+  nlj_block_size = 4;
+  nlj_inner_materialize_threshold = 8;
+
+  // Enough outer blocks that the per-block rescan bound fails unless the check knows the inner side was kept.
+  const int num_left = 10 * static_cast<int>(nlj_block_size);
+  const int threshold = static_cast<int>(nlj_inner_materialize_threshold);
+  EXPECT_TRUE(RunCheckedCrossJoin(num_left, threshold - 1));
+  EXPECT_TRUE(RunCheckedCrossJoin(num_left, threshold));
+  EXPECT_FALSE(RunCheckedCrossJoin(num_left, threshold + 1));
+
+  nlj_block_size = saved_block_size;
+  nlj_inner_materialize_threshold = saved_threshold;
+}
+
+}  // namespace bustub
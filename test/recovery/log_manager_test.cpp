@@ -0,0 +1,283 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_test.cpp
+//
+// Identification: test/recovery/log_manager_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class LogManagerTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+  };
+
+  /** @return the field of the header of the record at `offset` in `log`, see log_record.h */
+  static auto HeaderField(const std::vector<char> &log, size_t offset, int field) -> int32_t {
+    int32_t value;
+    memcpy(&value, log.data() + offset + field * sizeof(int32_t), sizeof(int32_t));
+    return value;
+  }
+
+  /**
+   * Append records from several threads, many times the log buffer, then check that they are on disk in the order
+   * of their LSNs. Without the flush thread, the threads also flush the log every so often, racing the appends that
+   * write out the full buffers.
+   */
+  void ConcurrentAppend(bool flush_thread) {
+    const int num_threads = 4;
+    const int num_records = 2000;
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager);
+    if (flush_thread) {
+      log_manager.RunFlushThread();
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([&, i] {
+        Tuple tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(100, 'a' + i))},
+                    &schema_};
+        for (int j = 0; j < num_records; j++) {
+          TupleMeta meta{i, INVALID_TXN_ID, false};
+          LogRecord record(i, INVALID_LSN, LogRecordType::INSERT, RID(i, j), meta, tuple);
+          auto lsn = log_manager.AppendLogRecord(&record);
+          if (!flush_thread && j % 50 == 0) {
+            log_manager.Flush(lsn);
+            EXPECT_GE(log_manager.GetPersistentLSN(), lsn);
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    log_manager.Flush(num_threads * num_records - 1);
+    log_manager.StopFlushThread();
+    EXPECT_GT(disk_manager.GetNumFlushes(), 1);
+
+    // The records are on disk in the order of their LSNs, and each thread's in the order appended.
+    std::vector<char> log(num_threads * num_records * 200);
+    ASSERT_TRUE(disk_manager.ReadLog(log.data(), log.size(), 0));
+    std::vector<int> next_slot(num_threads, 0);
+    size_t offset = 0;
+    for (int lsn = 0; lsn < num_threads * num_records; lsn++) {
+      ASSERT_EQ(HeaderField(log, offset, 1), lsn);
+      auto txn_id = HeaderField(log, offset, 2);
+      RID rid;
+      memcpy(&rid, log.data() + offset + 20, sizeof(RID));
+      ASSERT_EQ(rid, RID(txn_id, next_slot[txn_id]++));
+      offset += HeaderField(log, offset, 0);
+    }
+    EXPECT_EQ(HeaderField(log, offset, 0), 0);
+    disk_manager.ShutDown();
+  }
+
+  Schema schema_{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 128}}};
+};
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, AppendTest) {
+  DiskManager disk_manager("test.db");
+  LogManager log_manager(&disk_manager);
+  log_manager.RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+
+  Tuple tuple{{ValueFactory::GetIntegerValue(42), ValueFactory::GetVarcharValue("terrier")}, &schema_};
+  LogRecord begin(7, INVALID_LSN, LogRecordType::BEGIN);
+  TupleMeta meta{7, INVALID_TXN_ID, false};
+  LogRecord insert(7, 0, LogRecordType::INSERT, RID(3, 4), meta, tuple);
+  LogRecord commit(7, 1, LogRecordType::COMMIT);
+  EXPECT_EQ(log_manager.AppendLogRecord(&begin), 0);
+  EXPECT_EQ(log_manager.AppendLogRecord(&insert), 1);
+  EXPECT_EQ(log_manager.AppendLogRecord(&commit), 2);
+  log_manager.Flush(2);
+  EXPECT_EQ(log_manager.GetPersistentLSN(), 2);
+
+  std::vector<char> log(begin.GetSize() + insert.GetSize() + commit.GetSize());
+  ASSERT_TRUE(disk_manager.ReadLog(log.data(), log.size(), 0));
+  size_t offset = 0;
+  for (auto *record : {&begin, &insert, &commit}) {
+    EXPECT_EQ(HeaderField(log, offset, 0), record->GetSize());
+    EXPECT_EQ(HeaderField(log, offset, 1), record->GetLSN());
+    EXPECT_EQ(HeaderField(log, offset, 2), 7);
+    EXPECT_EQ(HeaderField(log, offset, 3), record->GetPrevLSN());
+    EXPECT_EQ(HeaderField(log, offset, 4), static_cast<int32_t>(record->GetLogRecordType()));
+    offset += record->GetSize();
+  }
+  RID rid;
+  memcpy(&rid, log.data() + begin.GetSize() + 20, sizeof(RID));
+  EXPECT_EQ(rid, RID(3, 4));
+  TupleMeta logged_meta;
+  memcpy(&logged_meta, log.data() + begin.GetSize() + 20 + sizeof(RID), TUPLE_META_SIZE);
+  EXPECT_EQ(logged_meta.insert_txn_id_, 7);
+  Tuple logged;
+  logged.DeserializeFrom(log.data() + begin.GetSize() + 20 + sizeof(RID) + TUPLE_META_SIZE);
+  EXPECT_EQ(logged.GetValue(&schema_, 1).ToString(), "terrier");
+
+  log_manager.StopFlushThread();
+  EXPECT_FALSE(enable_logging);
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, ConcurrentAppendTest) {
+  // The appends wait for the flush thread to switch buffers.
+  ConcurrentAppend(true);
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, ConcurrentAppendWithoutFlushThreadTest) { ConcurrentAppend(false); }
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, WriteAheadTest) {
+  DiskManager disk_manager("test.db");
+  LogManager log_manager(&disk_manager);
+  BufferPoolManager bpm(2, &disk_manager, LRUK_REPLACER_K, &log_manager);
+  Tuple tuple{{ValueFactory::GetIntegerValue(1), ValueFactory::GetVarcharValue("wal")}, &schema_};
+  TupleMeta meta{1, INVALID_TXN_ID, false};
+  auto change_page = [&](page_id_t *page_id) {
+    auto *page = bpm.NewPage(page_id);
+    LogRecord record(1, INVALID_LSN, LogRecordType::INSERT, RID(*page_id, 0), meta, tuple);
+    // As TableHeap::Log() does: only the pages in the dirty page table keep an LSN the buffer pool waits for.
+    log_manager.MarkDirty(*page_id, log_manager.GetNextLSN());
+    auto lsn = log_manager.AppendLogRecord(&record);
+    page->SetLSN(lsn);
+    bpm.UnpinPage(*page_id, true);
+    return lsn;
+  };
+
+  // A page flushed, then a page evicted, is written after the records of its changes.
+  page_id_t page_id;
+  auto lsn = change_page(&page_id);
+  EXPECT_LT(log_manager.GetPersistentLSN(), lsn);
+  bpm.FlushPage(page_id);
+  EXPECT_GE(log_manager.GetPersistentLSN(), lsn);
+
+  lsn = change_page(&page_id);
+  EXPECT_LT(log_manager.GetPersistentLSN(), lsn);
+  page_id_t other_page_id;
+  for (int i = 0; i < 2; i++) {
+    ASSERT_NE(bpm.NewPage(&other_page_id), nullptr);
+    bpm.UnpinPage(other_page_id, false);
+  }
+  EXPECT_GE(log_manager.GetPersistentLSN(), lsn);
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, GroupCommitTest) {
+  const int num_threads = 8;
+  const int num_txns = 100;
+  DiskManager disk_manager("test.db");
+  LogManager log_manager(&disk_manager);
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, &log_manager);
+  log_manager.RunFlushThread();
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < num_txns; j++) {
+        auto *txn = txn_manager.Begin();
+        EXPECT_TRUE(txn_manager.Commit(txn));
+        // The commit returns once its record is on disk.
+        EXPECT_GE(log_manager.GetPersistentLSN(), txn->GetPrevLSN());
+        delete txn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // The commits waiting together share a sync of the log.
+  EXPECT_LT(disk_manager.GetNumFlushes(), num_threads * num_txns);
+  EXPECT_EQ(log_manager.GetPersistentLSN(), 2 * num_threads * num_txns - 1);
+  log_manager.StopFlushThread();
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, UpdateDeltaTest) {
+  Tuple old_tuple{{ValueFactory::GetIntegerValue(1), ValueFactory::GetVarcharValue(std::string(100, 'a'))}, &schema_};
+  Tuple new_tuple{{ValueFactory::GetIntegerValue(2), ValueFactory::GetVarcharValue(std::string(100, 'a'))}, &schema_};
+  Tuple longer{{ValueFactory::GetIntegerValue(1), ValueFactory::GetVarcharValue(std::string(120, 'a'))}, &schema_};
+  TupleMeta meta{1, INVALID_TXN_ID, false};
+
+  // The record carries the bytes of the integer only.
+  LogRecord update(1, INVALID_LSN, LogRecordType::UPDATE, RID(0, 0), meta, old_tuple, meta, new_tuple);
+  EXPECT_LT(update.GetSize(), old_tuple.GetLength());
+  auto redone = update.RedoUpdate(old_tuple);
+  ASSERT_TRUE(redone.has_value());
+  EXPECT_EQ(redone->GetValue(&schema_, 0).GetAs<int32_t>(), 2);
+  EXPECT_EQ(redone->GetValue(&schema_, 1).ToString(), std::string(100, 'a'));
+  auto undone = update.UndoUpdate(new_tuple);
+  ASSERT_TRUE(undone.has_value());
+  EXPECT_EQ(undone->GetValue(&schema_, 0).GetAs<int32_t>(), 1);
+  // A version the update was not logged against is left alone.
+  EXPECT_FALSE(update.RedoUpdate(new_tuple).has_value());
+  EXPECT_FALSE(update.UndoUpdate(old_tuple).has_value());
+
+  LogRecord grow(1, INVALID_LSN, LogRecordType::UPDATE, RID(0, 0), meta, old_tuple, meta, longer);
+  redone = grow.RedoUpdate(old_tuple);
+  ASSERT_TRUE(redone.has_value());
+  EXPECT_EQ(redone->GetValue(&schema_, 1).ToString(), std::string(120, 'a'));
+  undone = grow.UndoUpdate(longer);
+  ASSERT_TRUE(undone.has_value());
+  EXPECT_EQ(undone->GetValue(&schema_, 1).ToString(), std::string(100, 'a'));
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, CompressionTest) {
+  const int num_records = 1000;
+  enable_log_compression = true;
+  DiskManager disk_manager("test.db");
+  LogManager log_manager(&disk_manager);
+  log_manager.RunFlushThread();
+
+  Tuple tuple{{ValueFactory::GetIntegerValue(42), ValueFactory::GetVarcharValue(std::string(100, 'a'))}, &schema_};
+  int records_size = 0;
+  for (int i = 0; i < num_records; i++) {
+    LogRecord record(0, INVALID_LSN, LogRecordType::INSERT, RID(0, i), TupleMeta{0, INVALID_TXN_ID, false}, tuple);
+    log_manager.AppendLogRecord(&record);
+    records_size += record.GetSize();
+  }
+  log_manager.Flush(num_records - 1);
+  log_manager.StopFlushThread();
+  enable_log_compression = false;
+  EXPECT_LT(disk_manager.GetLogSize(), records_size / 2);
+
+  // The blocks are told apart from the records by their negated size.
+  std::vector<char> log(disk_manager.GetLogSize());
+  ASSERT_TRUE(disk_manager.ReadLog(log.data(), log.size(), 0));
+  EXPECT_LT(HeaderField(log, 0, 0), 0);
+  disk_manager.ShutDown();
+}
+
+}  // namespace bustub
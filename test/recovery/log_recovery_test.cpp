@@ -0,0 +1,426 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_recovery_test.cpp
+//
+// Identification: test/recovery/log_recovery_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/table_page.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class LogRecoveryTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+    disk_manager_ = std::make_unique<DiskManager>("test.db");
+    Restart();
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    log_manager_.reset();
+    bpm_.reset();
+    disk_manager_->ShutDown();
+    remove("test.db");
+    remove("test.log");
+    remove("test.master");
+  };
+
+  /** Start over with nothing but the files, dropping the pages not written out as a crash does. */
+  void Restart() {
+    log_manager_.reset();
+    bpm_ = std::make_unique<BufferPoolManager>(32, disk_manager_.get());
+    log_manager_ = std::make_unique<LogManager>(disk_manager_.get());
+  }
+
+  /** Recover from the log. @return the next transaction id */
+  auto Recover() -> txn_id_t {
+    LogRecovery log_recovery(disk_manager_.get(), bpm_.get(), log_manager_.get());
+    log_recovery.Redo();
+    log_recovery.Undo();
+    return log_recovery.GetNextTxnId();
+  }
+
+  /** Write out the log and then every page, as the buffer pool would before evicting them. */
+  void Checkpoint() {
+    log_manager_->Flush(log_manager_->GetNextLSN() - 1);
+    bpm_->FlushAllPages();
+  }
+
+  auto MakeTuple(int a, const std::string &b) -> Tuple {
+    return Tuple{{ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(b)}, &schema_};
+  }
+
+  /** @return the live tuples of the table starting at `first_page_id`, read from the pages */
+  auto ReadTable(page_id_t first_page_id) -> std::map<int, std::string> {
+    std::map<int, std::string> rows;
+    for (auto page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+      auto guard = bpm_->FetchPageRead(page_id);
+      auto page = guard.As<TablePage>();
+      for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+        auto [meta, tuple] = page->GetTuple(RID(page_id, slot));
+        if (!meta.is_deleted_) {
+          rows[tuple.GetValue(&schema_, 0).GetAs<int32_t>()] = tuple.GetValue(&schema_, 1).ToString();
+        }
+      }
+      page_id = page->GetNextPageId();
+    }
+    return rows;
+  }
+
+  Schema schema_{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 128}}};
+  std::unique_ptr<DiskManager> disk_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  std::unique_ptr<LogManager> log_manager_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, RedoTest) {
+  const size_t num_threads = recovery_num_threads;
+  recovery_num_threads = 4;
+  log_manager_->RunFlushThread();
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager_.get());
+  auto heap = std::make_unique<TableHeap>(bpm_.get(), schema_, TableStorage::ROW, log_manager_.get());
+  auto first_page_id = heap->GetFirstPageId();
+
+  auto *txn = txn_manager.Begin();
+  auto txn_id = txn->GetTransactionId();
+  TupleMeta inserted{txn_id, INVALID_TXN_ID, false};
+  std::map<int, std::string> expected;
+  std::vector<RID> rids;
+  for (int i = 0; i < 2000; i++) {
+    rids.push_back(*heap->InsertTuple(inserted, MakeTuple(i, "value")));
+    expected[i] = "value";
+    if (i == 500) {
+      // Some pages are on disk with the first records applied, which the redo skips.
+      Checkpoint();
+    }
+  }
+  // The space of the deleted tuples is given back, and taken by the tuples growing and the new tuples.
+  for (int i = 0; i < 2000; i += 7) {
+    heap->UpdateTupleMeta(TupleMeta{txn_id, txn_id, true}, rids[i]);
+    heap->UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, rids[i]);
+    expected.erase(i);
+  }
+  for (int i = 3; i < 2000; i += 7) {
+    ASSERT_TRUE(heap->UpdateTupleInPlace(inserted, MakeTuple(i, "a longer value"), rids[i], nullptr));
+    expected[i] = "a longer value";
+  }
+  for (int i = 5; i < 2000; i += 7) {
+    heap->UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, rids[i]);
+    expected.erase(i);
+  }
+  heap->CompactPage(first_page_id);
+  for (int i = 2000; i < 2100; i++) {
+    heap->InsertTuple(inserted, MakeTuple(i, "new"));
+    expected[i] = "new";
+  }
+  ASSERT_EQ(ReadTable(first_page_id), expected);
+  ASSERT_TRUE(txn_manager.Commit(txn));
+  delete txn;
+
+  heap.reset();
+  log_manager_->StopFlushThread();
+  Restart();
+  EXPECT_NE(ReadTable(first_page_id), expected);
+  EXPECT_GT(Recover(), txn_id);
+  EXPECT_EQ(ReadTable(first_page_id), expected);
+  recovery_num_threads = num_threads;
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, UndoTest) {
+  log_manager_->RunFlushThread();
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager_.get());
+  auto heap = std::make_unique<TableHeap>(bpm_.get(), schema_, TableStorage::ROW, log_manager_.get());
+  auto first_page_id = heap->GetFirstPageId();
+
+  auto *winner = txn_manager.Begin();
+  std::map<int, std::string> expected;
+  std::vector<RID> rids;
+  for (int i = 0; i < 500; i++) {
+    rids.push_back(*heap->InsertTuple(TupleMeta{winner->GetTransactionId(), INVALID_TXN_ID, false},
+                                      MakeTuple(i, "committed")));
+    expected[i] = "committed";
+  }
+  ASSERT_TRUE(txn_manager.Commit(winner));
+
+  // The loser's changes all reach the disk before the crash, and have to be taken back.
+  auto *loser = txn_manager.Begin();
+  auto loser_id = loser->GetTransactionId();
+  for (int i = 500; i < 600; i++) {
+    heap->InsertTuple(TupleMeta{loser_id, INVALID_TXN_ID, false}, MakeTuple(i, "lost"));
+  }
+  for (int i = 0; i < 500; i += 5) {
+    heap->UpdateTupleMeta(TupleMeta{winner->GetTransactionId(), loser_id, true}, rids[i]);
+  }
+  for (int i = 1; i < 500; i += 5) {
+    ASSERT_TRUE(heap->UpdateTupleInPlace(TupleMeta{loser_id, INVALID_TXN_ID, false}, MakeTuple(i, "lost"), rids[i],
+                                         nullptr));
+  }
+  // The tuples shrunk keep their bytes, or the tuples inserted after would take them from the versions restored.
+  for (int i = 2; i < 500; i += 5) {
+    ASSERT_TRUE(
+        heap->UpdateTupleInPlace(TupleMeta{loser_id, INVALID_TXN_ID, false}, MakeTuple(i, ""), rids[i], nullptr));
+  }
+  for (int i = 600; i < 700; i++) {
+    heap->InsertTuple(TupleMeta{loser_id, INVALID_TXN_ID, false}, MakeTuple(i, "lost and longer"));
+  }
+  Checkpoint();
+  delete winner;
+  delete loser;
+
+  heap.reset();
+  log_manager_->StopFlushThread();
+  Restart();
+  EXPECT_NE(ReadTable(first_page_id), expected);
+  Recover();
+  EXPECT_EQ(ReadTable(first_page_id), expected);
+
+  // The undo was logged and the loser aborted, so recovering again from the same disk repeats it without undoing.
+  Restart();
+  Recover();
+  EXPECT_EQ(ReadTable(first_page_id), expected);
+
+  // The log goes on after the records of the last recovery.
+  auto next_lsn = log_manager_->GetNextLSN();
+  log_manager_->RunFlushThread();
+  TransactionManager restarted(&lock_manager, log_manager_.get());
+  auto *txn = restarted.Begin();
+  EXPECT_EQ(txn->GetPrevLSN(), next_lsn);
+  ASSERT_TRUE(restarted.Commit(txn));
+  delete txn;
+  log_manager_->StopFlushThread();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, CheckpointTest) {
+  log_manager_->RunFlushThread();
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager_.get());
+  CheckpointManager checkpoint_manager(&txn_manager, log_manager_.get(), bpm_.get(), disk_manager_.get());
+  auto heap = std::make_unique<TableHeap>(bpm_.get(), schema_, TableStorage::ROW, log_manager_.get());
+  auto first_page_id = heap->GetFirstPageId();
+
+  auto *txn = txn_manager.Begin();
+  auto writer_id = txn->GetTransactionId();
+  std::map<int, std::string> expected;
+  std::vector<RID> rids;
+  for (int i = 0; i < 500; i++) {
+    rids.push_back(*heap->InsertTuple(TupleMeta{writer_id, INVALID_TXN_ID, false}, MakeTuple(i, "committed")));
+    expected[i] = "committed";
+  }
+  ASSERT_TRUE(txn_manager.Commit(txn));
+  delete txn;
+
+  // The loser runs across the checkpoint, so its records before it are read by recovery.
+  auto *loser = txn_manager.Begin();
+  auto loser_id = loser->GetTransactionId();
+  for (int i = 500; i < 550; i++) {
+    heap->InsertTuple(TupleMeta{loser_id, INVALID_TXN_ID, false}, MakeTuple(i, "lost"));
+  }
+  for (int i = 0; i < 500; i += 5) {
+    heap->UpdateTupleMeta(TupleMeta{writer_id, loser_id, true}, rids[i]);
+  }
+  checkpoint_manager.FlushDirtyPages(log_manager_->GetNextLSN());
+  EXPECT_TRUE(log_manager_->GetDirtyPages().empty());
+
+  // The pages changed since they were written out are redone from the dirty page table of the checkpoint.
+  txn = txn_manager.Begin();
+  for (int i = 1; i < 500; i += 5) {
+    ASSERT_TRUE(heap->UpdateTupleInPlace(TupleMeta{txn->GetTransactionId(), INVALID_TXN_ID, false},
+                                         MakeTuple(i, "updated"), rids[i], nullptr));
+    expected[i] = "updated";
+  }
+  ASSERT_TRUE(txn_manager.Commit(txn));
+  delete txn;
+  EXPECT_FALSE(log_manager_->GetDirtyPages().empty());
+  auto checkpoint_lsn = checkpoint_manager.Checkpoint();
+
+  txn = txn_manager.Begin();
+  auto last_txn_id = txn->GetTransactionId();
+  for (int i = 550; i < 650; i++) {
+    heap->InsertTuple(TupleMeta{txn->GetTransactionId(), INVALID_TXN_ID, false}, MakeTuple(i, "after"));
+    expected[i] = "after";
+  }
+  ASSERT_TRUE(txn_manager.Commit(txn));
+  delete txn;
+  delete loser;
+
+  heap.reset();
+  log_manager_->StopFlushThread();
+  lsn_t master_lsn;
+  int offset;
+  ASSERT_TRUE(disk_manager_->ReadMasterRecord(&master_lsn, &offset));
+  EXPECT_EQ(master_lsn, checkpoint_lsn);
+  EXPECT_GT(offset, 0);
+  // The log before the checkpoint is not read again, whatever it holds.
+  {
+    std::fstream log("test.log", std::ios::binary | std::ios::in | std::ios::out);
+    std::string garbage(offset, '\xff');
+    log.write(garbage.data(), offset);
+  }
+
+  Restart();
+  EXPECT_GT(Recover(), last_txn_id);
+  EXPECT_EQ(ReadTable(first_page_id), expected);
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, CheckpointUnderLoadTest) {
+  // Checkpoints are taken while transactions and the vacuum of their pages append records, so that records are
+  // appended while the checkpoints read the dirty page table.
+  const int num_threads = 4;
+  const int num_rows = 400;
+  log_manager_->RunFlushThread();
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager_.get());
+  CheckpointManager checkpoint_manager(&txn_manager, log_manager_.get(), bpm_.get(), disk_manager_.get());
+  auto heap = std::make_unique<TableHeap>(bpm_.get(), schema_, TableStorage::ROW, log_manager_.get());
+  auto first_page_id = heap->GetFirstPageId();
+
+  std::atomic<int> num_done{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < num_rows; j++) {
+        auto *txn = txn_manager.Begin();
+        auto txn_id = txn->GetTransactionId();
+        auto rid = heap->InsertTuple(TupleMeta{txn_id, INVALID_TXN_ID, false}, MakeTuple(i * num_rows + j, "row"));
+        // Every other row is deleted again, leaving slots for the vacuum to reclaim.
+        if (j % 2 == 1) {
+          heap->UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, *rid);
+        }
+        EXPECT_TRUE(txn_manager.Commit(txn));
+        delete txn;
+      }
+      num_done++;
+    });
+  }
+  lsn_t last_checkpoint_lsn = INVALID_LSN;
+  while (num_done < num_threads) {
+    checkpoint_manager.FlushDirtyPages(last_checkpoint_lsn);
+    last_checkpoint_lsn = checkpoint_manager.Checkpoint();
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::map<int, std::string> expected;
+  for (int i = 0; i < num_threads * num_rows; i += 2) {
+    expected[i] = "row";
+  }
+
+  heap.reset();
+  log_manager_->StopFlushThread();
+  Restart();
+  Recover();
+  EXPECT_EQ(ReadTable(first_page_id), expected);
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, CompressedLogTest) {
+  enable_log_compression = true;
+  log_manager_->RunFlushThread();
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager_.get());
+  auto heap = std::make_unique<TableHeap>(bpm_.get(), schema_, TableStorage::ROW, log_manager_.get());
+  auto first_page_id = heap->GetFirstPageId();
+
+  auto *winner = txn_manager.Begin();
+  std::map<int, std::string> expected;
+  std::vector<RID> rids;
+  for (int i = 0; i < 1000; i++) {
+    rids.push_back(*heap->InsertTuple(TupleMeta{winner->GetTransactionId(), INVALID_TXN_ID, false},
+                                      MakeTuple(i, "committed")));
+    expected[i] = "committed";
+  }
+  for (int i = 0; i < 1000; i += 3) {
+    ASSERT_TRUE(heap->UpdateTupleInPlace(TupleMeta{winner->GetTransactionId(), INVALID_TXN_ID, false},
+                                         MakeTuple(i, "Committed"), rids[i], nullptr));
+    expected[i] = "Committed";
+  }
+  ASSERT_TRUE(txn_manager.Commit(winner));
+  auto *loser = txn_manager.Begin();
+  for (int i = 1; i < 1000; i += 3) {
+    ASSERT_TRUE(heap->UpdateTupleInPlace(TupleMeta{loser->GetTransactionId(), INVALID_TXN_ID, false},
+                                         MakeTuple(i, "lost"), rids[i], nullptr));
+  }
+  Checkpoint();
+  delete winner;
+  delete loser;
+
+  heap.reset();
+  log_manager_->StopFlushThread();
+  Restart();
+  Recover();
+  enable_log_compression = false;
+  EXPECT_EQ(ReadTable(first_page_id), expected);
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, WriteAheadTest) {
+  // Without the flush thread, the log is written out only when its buffer fills up or a page is.
+  enable_logging = true;
+  BufferPoolManager bpm(4, disk_manager_.get(), LRUK_REPLACER_K, log_manager_.get());
+  auto heap = std::make_unique<TableHeap>(&bpm, schema_, TableStorage::ROW, log_manager_.get());
+  heap->InsertTuple(TupleMeta{0, INVALID_TXN_ID, false}, MakeTuple(0, "logged"));
+  auto persistent_lsn = log_manager_->GetPersistentLSN();
+  ASSERT_LT(persistent_lsn, log_manager_->GetNextLSN() - 1);
+
+  // A page no record is for does not wait for the log, whatever its bytes at the offset of the LSN.
+  page_id_t page_id;
+  auto *page = bpm.NewPage(&page_id);
+  memset(page->GetData(), 0x7f, BUSTUB_PAGE_SIZE);
+  bpm.UnpinPage(page_id, true);
+  ASSERT_TRUE(bpm.FlushPage(page_id));
+  EXPECT_EQ(log_manager_->GetPersistentLSN(), persistent_lsn);
+
+  ASSERT_TRUE(bpm.FlushPage(heap->GetFirstPageId()));
+  EXPECT_EQ(log_manager_->GetPersistentLSN(), log_manager_->GetNextLSN() - 1);
+
+  // The pages evicted reach the disk after the records of their changes.
+  std::set<page_id_t> page_ids;
+  for (int i = 1; i < 2000; i++) {
+    page_ids.insert(heap->InsertTuple(TupleMeta{0, INVALID_TXN_ID, false}, MakeTuple(i, "logged"))->GetPageId());
+  }
+  ASSERT_GT(page_ids.size(), 4);
+  std::vector<char> data(BUSTUB_PAGE_SIZE);
+  for (auto id : page_ids) {
+    disk_manager_->ReadPage(id, data.data());
+    EXPECT_LE(reinterpret_cast<TablePage *>(data.data())->GetLSN(), log_manager_->GetPersistentLSN()) << id;
+  }
+  heap.reset();
+  enable_logging = false;
+}
+
+}  // namespace bustub
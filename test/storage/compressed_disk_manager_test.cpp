@@ -0,0 +1,209 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_disk_manager_test.cpp
+//
+// Identification: test/storage/compressed_disk_manager_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/compressed_disk_manager.h"
+
+namespace bustub {
+
+class CompressedDiskManagerTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.pagemap");
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.pagemap");
+  };
+
+  /**
+   * @return a page of text that repeats itself after `variant` * 900 random bytes, so that the variants compress to
+   * very different sizes
+   */
+  static auto TextPage(int id, int variant) -> std::vector<char> {
+    std::vector<char> page(BUSTUB_PAGE_SIZE, 0);
+    std::mt19937 gen(id * 4 + variant);
+    size_t noise_size = variant * 900;
+    for (size_t i = 0; i < noise_size; i++) {
+      page[i] = static_cast<char>(gen());
+    }
+    std::string text;
+    while (text.size() < BUSTUB_PAGE_SIZE - noise_size) {
+      text += "page " + std::to_string(id) + " variant " + std::to_string(variant) + "; ";
+    }
+    memcpy(page.data() + noise_size, text.data(), BUSTUB_PAGE_SIZE - noise_size);
+    return page;
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(CompressedDiskManagerTest, ReadWritePageTest) {
+  std::mt19937 gen(3);
+  std::vector<char> noise(BUSTUB_PAGE_SIZE);
+  for (auto &c : noise) {
+    c = static_cast<char>(gen());
+  }
+  std::vector<char> buf(BUSTUB_PAGE_SIZE);
+  {
+    CompressedDiskManager dm("test.db");
+    dm.ReadPage(0, buf.data());  // tolerate empty read
+    for (int i = 0; i < 100; i++) {
+      dm.WritePage(i, TextPage(i, 0).data());
+    }
+    dm.WritePage(100, noise.data());
+    for (int i = 0; i < 100; i++) {
+      dm.ReadPage(i, buf.data());
+      ASSERT_EQ(buf, TextPage(i, 0));
+    }
+    dm.ReadPage(100, buf.data());
+    ASSERT_EQ(buf, noise);
+
+    auto stats = dm.GetStats();
+    EXPECT_EQ(stats.pages_written_, 101);
+    EXPECT_EQ(stats.pages_stored_raw_, 1);
+    EXPECT_GT(stats.Ratio(), 4);
+    EXPECT_LT(dm.GetDataSize(), 101 * BUSTUB_PAGE_SIZE / 4);
+    dm.ShutDown();
+  }
+
+  // The pages are found again through the page map.
+  CompressedDiskManager dm("test.db");
+  for (int i = 0; i < 100; i++) {
+    dm.ReadPage(i, buf.data());
+    ASSERT_EQ(buf, TextPage(i, 0));
+  }
+  dm.ReadPage(100, buf.data());
+  ASSERT_EQ(buf, noise);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(CompressedDiskManagerTest, ReuseExtentsTest) {
+  std::vector<char> buf(BUSTUB_PAGE_SIZE);
+  {
+    CompressedDiskManager dm("test.db");
+    for (int i = 0; i < 50; i++) {
+      dm.WritePage(i, TextPage(i, 0).data());
+    }
+    uint64_t data_size = 0;
+    // Pages that keep changing their compressed size reuse the extents freed by each other.
+    for (int round = 0; round < 20; round++) {
+      for (int i = 0; i < 50; i++) {
+        dm.WritePage(i, TextPage(i, (i + round) % 4).data());
+      }
+      if (round == 4) {
+        data_size = dm.GetDataSize();
+      }
+    }
+    EXPECT_LE(dm.GetDataSize(), data_size * 2);
+    for (int i = 0; i < 50; i++) {
+      dm.ReadPage(i, buf.data());
+      ASSERT_EQ(buf, TextPage(i, (i + 19) % 4));
+    }
+    dm.ShutDown();
+  }
+
+  // Reopening rebuilds the free extents, so new pages fill the holes first.
+  CompressedDiskManager dm("test.db");
+  auto data_size = dm.GetDataSize();
+  dm.WritePage(50, TextPage(50, 3).data());
+  EXPECT_EQ(dm.GetDataSize(), data_size);
+  for (int i = 0; i < 50; i++) {
+    dm.ReadPage(i, buf.data());
+    ASSERT_EQ(buf, TextPage(i, (i + 19) % 4));
+  }
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(CompressedDiskManagerTest, MergeFreeExtentsTest) {
+  CompressedDiskManager dm("test.db");
+  const int num_pages = 64;
+  for (int i = 0; i < num_pages; i++) {
+    dm.WritePage(i, TextPage(i, 0).data());
+  }
+  auto small_size = dm.GetDataSize();
+  dm.WritePage(num_pages, TextPage(num_pages, 0).data());
+  auto stored_before = dm.GetStats().stored_bytes_;
+  // Every page grows to several times its extent. The grown pages are written past the end of the file first, and
+  // into the extents of the small pages once enough neighbours are freed to merge into an extent large enough.
+  for (int i = 0; i < num_pages; i++) {
+    dm.WritePage(i, TextPage(i, 3).data());
+  }
+  auto large_size = dm.GetStats().stored_bytes_ - stored_before;
+  EXPECT_LT(dm.GetDataSize(), large_size + small_size / 2);
+  std::vector<char> buf(BUSTUB_PAGE_SIZE);
+  for (int i = 0; i < num_pages; i++) {
+    dm.ReadPage(i, buf.data());
+    ASSERT_EQ(buf, TextPage(i, 3));
+  }
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(CompressedDiskManagerTest, DeallocatePageTest) {
+  std::vector<char> buf(BUSTUB_PAGE_SIZE);
+  {
+    CompressedDiskManager dm("test.db");
+    for (int i = 0; i < 50; i++) {
+      dm.WritePage(i, TextPage(i, 2).data());
+    }
+    auto data_size = dm.GetDataSize();
+    // Pages that are replaced by new ones under churn give their extents to them, the file does not grow.
+    for (int i = 50; i < 1000; i++) {
+      dm.DeallocatePage(i - 50);
+      dm.WritePage(i, TextPage(i, 2).data());
+    }
+    EXPECT_LE(dm.GetDataSize(), data_size + BUSTUB_PAGE_SIZE);
+    dm.ReadPage(0, buf.data());
+    EXPECT_EQ(buf, std::vector<char>(BUSTUB_PAGE_SIZE, 0));
+    for (int i = 950; i < 1000; i++) {
+      dm.DeallocatePage(i);
+    }
+    EXPECT_EQ(dm.GetDataSize(), 0);
+    dm.ShutDown();
+  }
+
+  // The buffer pool deallocates the pages it deletes, whether they are in memory or were evicted.
+  CompressedDiskManager dm("test.db");
+  EXPECT_EQ(dm.GetDataSize(), 0);
+  BufferPoolManager bpm(2, &dm);
+  std::vector<page_id_t> page_ids(3);
+  for (auto &page_id : page_ids) {
+    auto *page = bpm.NewPage(&page_id);
+    ASSERT_NE(page, nullptr);
+    memcpy(page->GetData(), TextPage(page_id, 1).data(), BUSTUB_PAGE_SIZE);
+    bpm.UnpinPage(page_id, true);
+  }
+  bpm.FlushAllPages();
+  EXPECT_GT(dm.GetDataSize(), 0);
+  for (auto page_id : page_ids) {
+    EXPECT_TRUE(bpm.DeletePage(page_id));
+  }
+  EXPECT_EQ(dm.GetDataSize(), 0);
+  dm.ShutDown();
+}
+
+}  // namespace bustub
@@ -0,0 +1,183 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_page_test.cpp
+//
+// Identification: test/storage/pax_table_page_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/util/compression_util.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/page/pax_table_page.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** @return whether `a` and `b` are both null or equal */
+static auto SameValue(const Value &a, const Value &b) -> bool {
+  return a.IsNull() ? b.IsNull() : a.CompareEquals(b) == CmpBool::CmpTrue;
+}
+
+class PaxTablePageTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    page_ = reinterpret_cast<PaxTablePage *>(data_);
+    page_->Init(schema_);
+    std::mt19937 gen(7);
+    std::vector<std::string> statuses{"open", "closed", "pending"};
+    for (int i = 0; page_->GetNumTuples() < PaxTablePage::ComputeCapacity(schema_); i++) {
+      auto noise = static_cast<int64_t>(uint64_t{gen()} << 32 | gen() | 1);
+      std::vector<Value> values{ValueFactory::GetIntegerValue(1000 + i), ValueFactory::GetIntegerValue(i / 50),
+                                ValueFactory::GetVarcharValue(statuses[gen() % statuses.size()]),
+                                ValueFactory::GetBigIntValue(noise)};
+      if (i % 17 == 0) {
+        values[2] = ValueFactory::GetNullValueByType(TypeId::VARCHAR);
+      }
+      if (!page_->InsertTuple(schema_, TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, Tuple{values, &schema_})) {
+        break;
+      }
+      rows_.push_back(values);
+    }
+  }
+
+  void CheckValues() {
+    for (size_t slot = 0; slot < rows_.size(); slot++) {
+      RID rid(0, slot);
+      auto tuple = page_->GetTuple(schema_, rid).second;
+      for (uint32_t i = 0; i < schema_.GetColumnCount(); i++) {
+        ASSERT_TRUE(SameValue(page_->GetValue(schema_, rid, i), rows_[slot][i])) << slot << " " << i;
+        ASSERT_TRUE(SameValue(tuple.GetValue(&schema_, i), rows_[slot][i])) << slot << " " << i;
+      }
+    }
+  }
+
+  /** @return the slots whose column `column_idx` equals `value`, found by comparing the values */
+  auto ExpectedMatches(uint32_t column_idx, const Value &value) -> std::vector<bool> {
+    std::vector<bool> matches;
+    for (const auto &row : rows_) {
+      matches.push_back(row[column_idx].CompareEquals(value) == CmpBool::CmpTrue);
+    }
+    return matches;
+  }
+
+  Schema schema_{std::vector<Column>{Column{"id", TypeId::INTEGER}, Column{"batch", TypeId::INTEGER},
+                                     Column{"status", TypeId::VARCHAR, 16}, Column{"noise", TypeId::BIGINT}}};
+  char data_[BUSTUB_PAGE_SIZE]{};
+  PaxTablePage *page_;
+  std::vector<std::vector<Value>> rows_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(PaxTablePageTest, SealTest) {
+  ASSERT_EQ(rows_.size(), PaxTablePage::ComputeCapacity(schema_));
+  auto compressed_size = CompressionUtil::Compress(std::string_view(data_, BUSTUB_PAGE_SIZE)).size();
+
+  page_->Seal(schema_);
+  EXPECT_EQ(page_->GetEncoding(schema_, 0), ColumnEncoding::FRAME_OF_REFERENCE);
+  EXPECT_EQ(page_->GetEncoding(schema_, 1), ColumnEncoding::RUN_LENGTH);
+  EXPECT_EQ(page_->GetEncoding(schema_, 2), ColumnEncoding::DICTIONARY);
+  EXPECT_EQ(page_->GetEncoding(schema_, 3), ColumnEncoding::PLAIN);
+  // The bytes freed by the encodings are zeroed, so the page compresses better.
+  EXPECT_LT(CompressionUtil::Compress(std::string_view(data_, BUSTUB_PAGE_SIZE)).size(), compressed_size);
+  CheckValues();
+
+  // A sealed page takes no more tuples.
+  EXPECT_FALSE(page_->InsertTuple(schema_, TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false},
+                                  Tuple{rows_[0], &schema_}));
+
+  // Updating a tuple decodes the page.
+  rows_[3][1] = ValueFactory::GetIntegerValue(-8);
+  rows_[3][2] = ValueFactory::GetVarcharValue("reopened");
+  rows_[4][2] = ValueFactory::GetVarcharValue("open");
+  page_->UpdateTupleInPlaceUnsafe(schema_, TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false},
+                                  Tuple{rows_[3], &schema_}, RID(0, 3));
+  page_->UpdateTupleInPlaceUnsafe(schema_, TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false},
+                                  Tuple{rows_[4], &schema_}, RID(0, 4));
+  for (uint32_t i = 0; i < schema_.GetColumnCount(); i++) {
+    EXPECT_EQ(page_->GetEncoding(schema_, i), ColumnEncoding::PLAIN);
+  }
+  CheckValues();
+}
+
+// NOLINTNEXTLINE
+TEST_F(PaxTablePageTest, MatchEqualTest) {
+  std::vector<std::pair<uint32_t, Value>> filters{
+      {0, ValueFactory::GetIntegerValue(1010)},   {0, ValueFactory::GetBigIntValue(1LL << 40)},
+      {1, ValueFactory::GetIntegerValue(1)},      {1, ValueFactory::GetSmallIntValue(0)},
+      {2, ValueFactory::GetVarcharValue("open")}, {2, ValueFactory::GetVarcharValue("missing")},
+      {3, rows_[5][3]},                           {1, ValueFactory::GetNullValueByType(TypeId::INTEGER)}};
+  std::vector<bool> matches;
+  for (bool sealed : {false, true}) {
+    if (sealed) {
+      page_->Seal(schema_);
+    }
+    for (const auto &[column_idx, value] : filters) {
+      ASSERT_TRUE(page_->MatchEqual(schema_, column_idx, value, &matches));
+      EXPECT_EQ(matches, ExpectedMatches(column_idx, value)) << column_idx << " " << value.ToString();
+    }
+    // Comparisons with other types are left to the executors.
+    EXPECT_FALSE(page_->MatchEqual(schema_, 0, ValueFactory::GetVarcharValue("1"), &matches));
+    EXPECT_FALSE(page_->MatchEqual(schema_, 2, ValueFactory::GetIntegerValue(1), &matches));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(PaxTablePageTest, GetCodesTest) {
+  std::vector<uint32_t> codes;
+  std::vector<Value> dictionary;
+  EXPECT_FALSE(page_->GetCodes(schema_, 0, &codes, &dictionary));
+  for (bool sealed : {false, true}) {
+    if (sealed) {
+      page_->Seal(schema_);
+    }
+    ASSERT_TRUE(page_->GetCodes(schema_, 2, &codes, &dictionary));
+    // Three statuses and null.
+    EXPECT_EQ(dictionary.size(), 4);
+    ASSERT_EQ(codes.size(), rows_.size());
+    for (size_t slot = 0; slot < rows_.size(); slot++) {
+      ASSERT_TRUE(SameValue(dictionary[codes[slot]], rows_[slot][2]));
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(PaxTablePageTest, TableIteratorTupleRefTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(16, disk_manager.get());
+  TableHeap table(bpm.get(), schema_, TableStorage::PAX);
+  for (const auto &row : rows_) {
+    ASSERT_TRUE(table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, Tuple{row, &schema_}));
+  }
+  // Twice as many rows as fit in a page, so the iterator crosses into another page.
+  for (const auto &row : rows_) {
+    ASSERT_TRUE(table.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, Tuple{row, &schema_}));
+  }
+
+  size_t num_tuples = 0;
+  for (auto iter = table.MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto [meta, tuple_ref] = iter.GetTupleRef();
+    ASSERT_FALSE(meta.is_deleted_);
+    ASSERT_EQ(tuple_ref.GetRid(), iter.GetRID());
+    const auto &row = rows_[num_tuples % rows_.size()];
+    for (uint32_t i = 0; i < schema_.GetColumnCount(); i++) {
+      ASSERT_TRUE(SameValue(tuple_ref.GetValue(&schema_, i), row[i])) << num_tuples << " " << i;
+    }
+    num_tuples++;
+  }
+  EXPECT_EQ(num_tuples, 2 * rows_.size());
+}
+
+}  // namespace bustub
@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_test.cpp
+//
+// Identification: test/table/free_space_map_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <deque>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, ReuseSpaceOfDeletedTuples) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(32, disk_manager.get());
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 64}}};
+  TableHeap heap(bpm.get(), schema, TableStorage::ROW);
+  auto make_tuple = [&](int i) {
+    return Tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(i % 50, 'q'))}, &schema};
+  };
+  auto num_pages = [&]() {
+    std::set<page_id_t> pages;
+    for (auto iter = heap.MakeIterator(); !iter.IsEnd(); ++iter) {
+      pages.insert(iter.GetRID().GetPageId());
+    }
+    return pages.size();
+  };
+
+  // Use the table as a queue: delete the oldest tuple for every new one.
+  std::deque<RID> queue;
+  for (int i = 0; i < 2000; i++) {
+    queue.push_back(*heap.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, make_tuple(i)));
+  }
+  auto initial_pages = num_pages();
+  for (int i = 2000; i < 20000; i++) {
+    heap.UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, queue.front());
+    queue.pop_front();
+    queue.push_back(*heap.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, make_tuple(i)));
+  }
+  EXPECT_LE(num_pages(), initial_pages + 1);
+
+  // Compaction moves tuples within their page but keeps their RIDs.
+  for (int i = 0; i < 2000; i++) {
+    auto [meta, tuple] = heap.GetTuple(queue[i]);
+    EXPECT_FALSE(meta.is_deleted_);
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), 18000 + i);
+    EXPECT_EQ(tuple.GetValue(&schema, 1).ToString(), std::string((18000 + i) % 50, 'q'));
+  }
+
+  // A deletion that is not complete yet keeps its space.
+  heap.UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, 1, true}, queue.front());
+  for (int i = 0; i < 2000; i++) {
+    heap.InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, make_tuple(i));
+  }
+  EXPECT_EQ(heap.GetTuple(queue.front()).second.GetValue(&schema, 0).GetAs<int32_t>(), 18000);
+}
+
+}  // namespace bustub
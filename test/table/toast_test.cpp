@@ -0,0 +1,180 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// toast_test.cpp
+//
+// Identification: test/table/toast_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/page/overflow_page.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class ToastTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    disk_manager_ = std::make_unique<DiskManagerUnlimitedMemory>();
+    bpm_ = std::make_unique<BufferPoolManager>(32, disk_manager_.get());
+    heap_ = std::make_unique<TableHeap>(bpm_.get(), schema_, TableStorage::ROW);
+  }
+
+  auto MakeTuple(int a, const std::string &b, const std::string &c) -> Tuple {
+    return Tuple{{ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(b), ValueFactory::GetVarcharValue(c)},
+                 &schema_};
+  }
+
+  /** @return the number of pages allocated since the last call */
+  auto NewPages() -> page_id_t {
+    page_id_t page_id;
+    bpm_->NewPageGuarded(&page_id);
+    auto new_pages = page_id - last_page_id_ - 1;
+    last_page_id_ = page_id;
+    return new_pages;
+  }
+
+  /** @return the pages of the chain of the value out of line in the tuple `rid` */
+  auto ChainPages(RID rid) -> std::vector<page_id_t> {
+    auto chains = ToastStore::GetChains(heap_->GetTuple(rid).second.GetData(), schema_);
+    EXPECT_EQ(chains.size(), 1);
+    std::vector<page_id_t> page_ids;
+    for (auto page_id = chains[0].first_page_id_; page_id != INVALID_PAGE_ID;) {
+      page_ids.push_back(page_id);
+      page_id = bpm_->FetchPageRead(page_id).As<OverflowPage>()->GetNextPageId();
+    }
+    return page_ids;
+  }
+
+  /** @return whether every page of `page_ids` was deleted */
+  auto AllDeleted(const std::vector<page_id_t> &page_ids) -> bool {
+    // The pool is large enough to hold every page of the tests, so a page is only gone from it once deleted.
+    return std::none_of(page_ids.begin(), page_ids.end(), [&](page_id_t page_id) { return bpm_->FlushPage(page_id); });
+  }
+
+  Schema schema_{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 32768},
+                                     Column{"c", TypeId::VARCHAR, 32}}};
+  std::unique_ptr<DiskManagerUnlimitedMemory> disk_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  std::unique_ptr<TableHeap> heap_;
+  page_id_t last_page_id_{0};
+};
+
+// NOLINTNEXTLINE
+TEST_F(ToastTest, LargeValuesTest) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::vector<std::string> large;
+  std::vector<RID> rids;
+  for (int i = 0; i < 40; i++) {
+    std::string value(1000 * (i % 20), ' ');
+    for (auto &c : value) {
+      c = static_cast<char>(letter(gen));
+    }
+    large.push_back(value);
+    auto rid = heap_->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, MakeTuple(i, value, "small"));
+    ASSERT_TRUE(rid.has_value());
+    rids.push_back(*rid);
+  }
+  // A batch goes through the same path.
+  std::vector<Tuple> batch{MakeTuple(40, large[19], "x"), MakeTuple(41, "y", "z")};
+  auto batch_rids = heap_->InsertTuples(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, batch);
+  rids.insert(rids.end(), batch_rids.begin(), batch_rids.end());
+  large.emplace_back(large[19]);
+  large.emplace_back("y");
+
+  int count = 0;
+  for (auto iter = heap_->MakeIterator(); !iter.IsEnd(); ++iter, count++) {
+    auto [meta, tuple_ref] = iter.GetTupleRef();
+    auto a = tuple_ref.GetValue(&schema_, 0).GetAs<int32_t>();
+    EXPECT_LE(tuple_ref.GetLength(), toast_tuple_threshold);
+    EXPECT_EQ(tuple_ref.GetValue(&schema_, 1).ToString(), large[a]);
+    EXPECT_EQ(tuple_ref.ToTuple().GetValue(&schema_, 1).ToString(), large[a]);
+    EXPECT_EQ(heap_->GetTuple(rids[a]).second.GetValue(&schema_, 1).ToString(), large[a]);
+  }
+  EXPECT_EQ(count, 42);
+
+  // The other columns are read without the store, which is only needed for the values out of line.
+  auto tuple = heap_->GetTuple(rids[19]).second;
+  TupleRef without_store(tuple.GetData(), tuple.GetLength(), tuple.GetRid());
+  EXPECT_EQ(without_store.GetValue(&schema_, 0).GetAs<int32_t>(), 19);
+  EXPECT_EQ(without_store.GetValue(&schema_, 2).ToString(), "small");
+  EXPECT_THROW(without_store.GetValue(&schema_, 1), std::logic_error);
+
+  // Updating a tuple in place stores its large value again.
+  heap_->UpdateTupleInPlaceUnsafe(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, MakeTuple(19, large[18], "small"),
+                                  rids[19]);
+  EXPECT_EQ(heap_->GetTuple(rids[19]).second.GetValue(&schema_, 1).ToString(), large[18]);
+}
+
+// NOLINTNEXTLINE
+TEST_F(ToastTest, CompressionTest) {
+  std::string value;
+  for (int i = 0; value.size() < 30000; i++) {
+    value += "row " + std::to_string(i % 100) + " is much like the others; ";
+  }
+  NewPages();
+
+  auto rid = heap_->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, MakeTuple(1, value, "c"));
+  EXPECT_LE(NewPages(), 2);
+
+  auto old_compression = toast_compression;
+  toast_compression = false;
+  auto raw_rid = heap_->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, MakeTuple(2, value, "c"));
+  toast_compression = old_compression;
+  EXPECT_GE(NewPages(), 30000 / BUSTUB_PAGE_SIZE);
+
+  EXPECT_EQ(heap_->GetTuple(*rid).second.GetValue(&schema_, 1).ToString(), value);
+  EXPECT_EQ(heap_->GetTuple(*raw_rid).second.GetValue(&schema_, 1).ToString(), value);
+}
+
+// NOLINTNEXTLINE
+TEST_F(ToastTest, FreeChainsTest) {
+  auto old_compression = toast_compression;
+  toast_compression = false;
+  std::string first(10000, 'a');
+  std::string second(10000, 'b');
+  auto rid = heap_->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, MakeTuple(1, first, "c"));
+  ASSERT_TRUE(rid.has_value());
+  auto first_pages = ChainPages(*rid);
+  EXPECT_GE(first_pages.size(), 10000 / BUSTUB_PAGE_SIZE);
+  EXPECT_FALSE(AllDeleted(first_pages));
+
+  // Without a transaction, nobody can read the overwritten value anymore.
+  heap_->UpdateTupleInPlaceUnsafe(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, MakeTuple(1, second, "c"), *rid);
+  EXPECT_TRUE(AllDeleted(first_pages));
+  EXPECT_EQ(heap_->GetTuple(*rid).second.GetValue(&schema_, 1).ToString(), second);
+
+  // A value overwritten by a transaction is kept until the versions it overwrote are read by nobody.
+  auto second_pages = ChainPages(*rid);
+  heap_->UpdateTupleInPlaceUnsafe(TupleMeta{5, INVALID_TXN_ID, false}, MakeTuple(1, first, "c"), *rid);
+  heap_->FreeRetiredChains([](txn_id_t) { return false; });
+  EXPECT_FALSE(AllDeleted(second_pages));
+  heap_->FreeRetiredChains([](txn_id_t txn_id) { return txn_id == 5; });
+  EXPECT_TRUE(AllDeleted(second_pages));
+  EXPECT_EQ(heap_->GetTuple(*rid).second.GetValue(&schema_, 1).ToString(), first);
+
+  // A deleted value is kept until its slot can be reclaimed.
+  auto third_pages = ChainPages(*rid);
+  heap_->UpdateTupleMeta(TupleMeta{5, 7, true}, *rid);
+  EXPECT_FALSE(AllDeleted(third_pages));
+  heap_->UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, *rid);
+  EXPECT_TRUE(AllDeleted(third_pages));
+  toast_compression = old_compression;
+}
+
+}  // namespace bustub
@@ -21,6 +21,7 @@
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -61,4 +62,68 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, TupleRefTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Column col3{"c", TypeId::BIGINT};
+  Column col4{"d", TypeId::BOOLEAN};
+  Column col5{"e", TypeId::VARCHAR, 16};
+  Schema schema{std::vector<Column>{col1, col2, col3, col4, col5}};
+  Tuple tuple = ConstructTuple(&schema);
+
+  TupleRef tuple_ref(tuple);
+  ASSERT_EQ(tuple_ref.GetData(), tuple.GetData());
+  ASSERT_EQ(tuple_ref.GetLength(), tuple.GetLength());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    ASSERT_EQ(tuple_ref.GetValue(&schema, i).ToString(), tuple.GetValue(&schema, i).ToString());
+  }
+
+  Tuple copy = tuple_ref.ToTuple();
+  ASSERT_NE(copy.GetData(), tuple.GetData());
+  ASSERT_EQ(copy.ToString(&schema), tuple.ToString(&schema));
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, NullBitmapTest) {
+  std::vector<Column> cols;
+  for (int i = 0; i < 10; i++) {
+    if (i % 3 == 0) {
+      cols.emplace_back("v" + std::to_string(i), TypeId::VARCHAR, 16);
+    } else {
+      cols.emplace_back("c" + std::to_string(i), i % 3 == 1 ? TypeId::SMALLINT : TypeId::BIGINT);
+    }
+  }
+  Schema schema{cols};
+  // 2 bytes of bitmap, 3 bigints, 3 smallints and 4 varchar end offsets
+  ASSERT_EQ(schema.GetNullBitmapSize(), 2);
+  ASSERT_EQ(schema.GetLength(), 2 + 3 * 8 + 3 * 2 + 4 * 2);
+  ASSERT_EQ(schema.GetColumn(2).GetOffset(), 2);
+
+  std::vector<Value> values;
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    auto type = schema.GetColumn(i).GetType();
+    if (i % 4 == 3) {
+      values.push_back(ValueFactory::GetNullValueByType(type));
+    } else if (type == TypeId::VARCHAR) {
+      values.push_back(ValueFactory::GetVarcharValue(std::string(i, 'x')));
+    } else {
+      values.push_back(ValueFactory::GetBigIntValue(i).CastAs(type));
+    }
+  }
+  Tuple tuple{values, &schema};
+  // The varchars of columns 0, 6 and 9 take 0, 6 and 9 bytes, the NULL of column 3 none.
+  ASSERT_EQ(tuple.GetLength(), schema.GetLength() + 6 + 9);
+
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    ASSERT_EQ(tuple.IsNull(&schema, i), i % 4 == 3) << i;
+    auto value = tuple.GetValue(&schema, i);
+    ASSERT_EQ(value.IsNull(), i % 4 == 3) << i;
+    if (!value.IsNull()) {
+      ASSERT_EQ(value.CompareEquals(values[i]), CmpBool::CmpTrue) << i;
+    }
+    ASSERT_EQ(TupleRef(tuple).GetValue(&schema, i).ToString(), value.ToString());
+  }
+}
+
 }  // namespace bustub
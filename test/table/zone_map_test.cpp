@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map_test.cpp
+//
+// Identification: test/table/zone_map_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/table/zone_map.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ZoneMapTest, WidenOnInsertAndUpdate) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 16}}};
+  ZoneMap zone_map(schema);
+  zone_map.AddPage(3);
+  zone_map.AddPage(7);
+  EXPECT_TRUE(zone_map.IsTracked(0));
+  EXPECT_FALSE(zone_map.IsTracked(1));
+
+  auto make_tuple = [&](const Value &a) { return Tuple{{a, ValueFactory::GetVarcharValue("x")}, &schema}; };
+  zone_map.Insert(3, make_tuple(ValueFactory::GetIntegerValue(10)));
+  zone_map.Insert(3, make_tuple(ValueFactory::GetIntegerValue(-5)));
+  zone_map.Insert(3, make_tuple(ValueFactory::GetNullValueByType(TypeId::INTEGER)));
+  zone_map.Update(3, make_tuple(ValueFactory::GetIntegerValue(42)));
+
+  PageZone zone;
+  ASSERT_TRUE(zone_map.GetPageZone(3, &zone));
+  EXPECT_EQ(zone.num_tuples_, 3);
+  EXPECT_EQ(zone.columns_[0].min_.GetAs<int32_t>(), -5);
+  EXPECT_EQ(zone.columns_[0].max_.GetAs<int32_t>(), 42);
+  EXPECT_EQ(zone.columns_[0].null_count_, 1);
+
+  // A page without tuples has no range.
+  ASSERT_TRUE(zone_map.GetPageZone(7, &zone));
+  EXPECT_EQ(zone.num_tuples_, 0);
+  EXPECT_TRUE(zone.columns_[0].min_.IsNull());
+  EXPECT_FALSE(zone_map.GetPageZone(5, &zone));
+
+  EXPECT_EQ(zone_map.GetNextPageId(3), 7);
+  EXPECT_EQ(zone_map.GetNextPageId(7), INVALID_PAGE_ID);
+}
+
+}  // namespace bustub
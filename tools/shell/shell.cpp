@@ -27,14 +27,23 @@ auto GetWidthOfUtf8(const void *beg, const void *end, size_t *width) -> int {
 auto main(int argc, char **argv) -> int {
   ft_set_u8strwid_func(&GetWidthOfUtf8);
 
-  auto bustub = std::make_unique<bustub::BustubInstance>("test.db");
-
   auto default_prompt = "bustub> ";
   auto emoji_prompt = "\U0001f6c1> ";  // the bathtub emoji
   bool use_emoji_prompt = false;
   bool disable_tty = false;
+  bool stream_results = false;
 
   for (int i = 1; i < argc; i++) {
+    // Print rows as soon as they are produced instead of rendering a table once the query finishes.
+    if (strcmp(argv[i], "--stream") == 0) {
+      stream_results = true;
+      continue;
+    }
+    // Compress the pages of the database file.
+    if (strcmp(argv[i], "--compress-pages") == 0) {
+      bustub::enable_page_compression = true;
+      continue;
+    }
     if (strcmp(argv[i], "--emoji-prompt") == 0) {
       use_emoji_prompt = true;
       break;
@@ -45,6 +54,8 @@ auto main(int argc, char **argv) -> int {
     }
   }
 
+  auto bustub = std::make_unique<bustub::BustubInstance>("test.db");
+
   bustub->GenerateMockTable();
 
   if (bustub->buffer_pool_manager_ != nullptr) {
@@ -95,6 +106,11 @@ auto main(int argc, char **argv) -> int {
     }
 
     try {
+      if (stream_results) {
+        auto writer = bustub::SimpleStreamWriter(std::cout);
+        bustub->ExecuteSql(query, writer);
+        continue;
+      }
       auto writer = bustub::FortTableWriter();
       bustub->ExecuteSql(query, writer);
       for (const auto &table : writer.tables_) {
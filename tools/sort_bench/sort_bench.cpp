@@ -0,0 +1,67 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/bustub_instance.h"
+#include "common/config.h"
+#include "fmt/core.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-sort-bench");
+  program.add_argument("--table").help("mock table to sort, defaults to __mock_t4_1m");
+  program.add_argument("--budget").help("sort memory budget in KiB, defaults to a sweep from 64 MiB down to 256 KiB");
+  program.add_argument("--repeat").help("run every query n times");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  std::string table = "__mock_t4_1m";
+  if (program.present("--table")) {
+    table = program.get("--table");
+  }
+
+  std::vector<size_t> budgets_kb{64 * 1024, 16 * 1024, 4 * 1024, 1024, 256};
+  if (program.present("--budget")) {
+    budgets_kb = {std::stoul(program.get("--budget"))};
+  }
+
+  size_t repeat = 3;
+  if (program.present("--repeat")) {
+    repeat = std::stoul(program.get("--repeat"));
+  }
+
+  auto bustub = std::make_unique<bustub::BustubInstance>();
+  auto sql = fmt::format("SELECT * FROM {} ORDER BY x DESC, y", table);
+  fmt::print(stderr, "[info] query=\"{}\", repeat={}\n", sql, repeat);
+
+  fmt::print("<<< BEGIN\n");
+  for (auto budget_kb : budgets_kb) {
+    bustub::sort_memory_budget = budget_kb * 1024;
+    for (size_t i = 0; i < repeat; i++) {
+      bustub::NoopWriter writer;
+      auto start = ClockMs();
+      bustub->ExecuteSql(sql, writer);
+      fmt::print("budget_kb={} run={} elapsed_ms={}\n", budget_kb, i, ClockMs() - start);
+    }
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
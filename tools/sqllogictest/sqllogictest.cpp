@@ -93,6 +93,12 @@ auto ProcessExtraOptions(const std::string &sql, bustub::BustubInstance &instanc
           fmt::print("HashJoin should appear exactly thrice\n");
           return false;
         }
+      } else if (opt == "ensure:merge_join") {
+        if (!bustub::StringUtil::Contains(result.str(), "MergeJoin") ||
+            bustub::StringUtil::Contains(result.str(), "IndexScan")) {
+          fmt::print("MergeJoin over sorted inputs not found\n");
+          return false;
+        }
       } else if (opt == "ensure:topn") {
         if (!bustub::StringUtil::Contains(result.str(), "TopN")) {
           fmt::print("TopN not found\n");
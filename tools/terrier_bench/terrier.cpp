@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -30,6 +31,16 @@ auto ClockMs() -> uint64_t {
 static const size_t BUSTUB_TERRIER_THREAD = 2;
 static const size_t BUSTUB_TERRIER_CNT = 100;
 
+/** @return the 99th percentile of `latencies_us` in milliseconds, 0 if there are none */
+auto P99Ms(std::vector<uint64_t> latencies_us) -> double {
+  if (latencies_us.empty()) {
+    return 0;
+  }
+  auto nth = latencies_us.begin() + (latencies_us.size() - 1) * 99 / 100;
+  std::nth_element(latencies_us.begin(), nth, latencies_us.end());
+  return *nth / 1000.0;
+}
+
 struct TerrierTotalMetrics {
   uint64_t aborted_count_txn_cnt_{0};
   uint64_t committed_count_txn_cnt_{0};
@@ -38,26 +49,44 @@ struct TerrierTotalMetrics {
   uint64_t aborted_verify_txn_cnt_{0};
   uint64_t committed_verify_txn_cnt_{0};
   uint64_t start_time_{0};
+  std::vector<uint64_t> count_latencies_us_;
+  std::vector<uint64_t> update_latencies_us_;
+  std::vector<uint64_t> verify_latencies_us_;
   std::mutex mutex_;
 
   void Begin() { start_time_ = ClockMs(); }
 
-  void ReportVerify(uint64_t aborted_cnt, uint64_t committed_cnt) {
+  void ReportVerify(uint64_t aborted_cnt, uint64_t committed_cnt, const std::vector<uint64_t> &latencies_us) {
     std::unique_lock<std::mutex> l(mutex_);
     aborted_verify_txn_cnt_ += aborted_cnt;
     committed_verify_txn_cnt_ += committed_cnt;
+    verify_latencies_us_.insert(verify_latencies_us_.end(), latencies_us.begin(), latencies_us.end());
   }
 
-  void ReportCount(uint64_t aborted_cnt, uint64_t committed_cnt) {
+  void ReportCount(uint64_t aborted_cnt, uint64_t committed_cnt, const std::vector<uint64_t> &latencies_us) {
     std::unique_lock<std::mutex> l(mutex_);
     aborted_count_txn_cnt_ += aborted_cnt;
     committed_count_txn_cnt_ += committed_cnt;
+    count_latencies_us_.insert(count_latencies_us_.end(), latencies_us.begin(), latencies_us.end());
   }
 
-  void ReportUpdate(uint64_t aborted_cnt, uint64_t committed_cnt) {
+  void ReportUpdate(uint64_t aborted_cnt, uint64_t committed_cnt, const std::vector<uint64_t> &latencies_us) {
     std::unique_lock<std::mutex> l(mutex_);
     aborted_update_txn_cnt_ += aborted_cnt;
     committed_update_txn_cnt_ += committed_cnt;
+    update_latencies_us_.insert(update_latencies_us_.end(), latencies_us.begin(), latencies_us.end());
+  }
+
+  /** Print the abort rate and the 99th percentile latency of each kind of transaction. */
+  void ReportAbortsAndLatency(const std::string &deadlock_policy) {
+    auto report = [](const char *name, uint64_t aborted, uint64_t committed, const std::vector<uint64_t> &latencies) {
+      auto abort_rate = aborted + committed == 0 ? 0 : aborted / static_cast<double>(aborted + committed);
+      fmt::print("{}: abort_rate={:.4f} p99_latency_ms={:.3f}\n", name, abort_rate, P99Ms(latencies));
+    };
+    fmt::print("deadlock policy: {}\n", deadlock_policy);
+    report("update", aborted_update_txn_cnt_, committed_update_txn_cnt_, update_latencies_us_);
+    report("count", aborted_count_txn_cnt_, committed_count_txn_cnt_, count_latencies_us_);
+    report("verify", aborted_verify_txn_cnt_, committed_verify_txn_cnt_, verify_latencies_us_);
   }
 
   void Report() {
@@ -87,13 +116,29 @@ struct TerrierMetrics {
   uint64_t aborted_txn_cnt_{0};
   std::string reporter_;
   uint64_t duration_ms_;
+  std::chrono::steady_clock::time_point txn_start_;
+  /** The latency of each transaction, committed or aborted, in microseconds */
+  std::vector<uint64_t> latencies_us_;
 
   explicit TerrierMetrics(std::string reporter, uint64_t duration_ms)
       : reporter_(std::move(reporter)), duration_ms_(duration_ms) {}
 
-  void TxnAborted() { aborted_txn_cnt_ += 1; }
+  void TxnBegin() { txn_start_ = std::chrono::steady_clock::now(); }
 
-  void TxnCommitted() { committed_txn_cnt_ += 1; }
+  void TxnAborted() {
+    aborted_txn_cnt_ += 1;
+    TxnEnd();
+  }
+
+  void TxnCommitted() {
+    committed_txn_cnt_ += 1;
+    TxnEnd();
+  }
+
+  void TxnEnd() {
+    auto latency = std::chrono::steady_clock::now() - txn_start_;
+    latencies_us_.push_back(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+  }
 
   void Begin() { start_time_ = ClockMs(); }
 
@@ -141,6 +186,10 @@ auto main(int argc, char **argv) -> int {
   program.add_argument("--force-create-index").help("create index in terrier bench");
   program.add_argument("--force-enable-update").help("use update statement in terrier bench");
   program.add_argument("--nft").help("number of NFTs in the bench");
+  program.add_argument("--deadlock-policy").help("detection, wait-die or wound-wait");
+  program.add_argument("--check-on-wait").help("check for a deadlock when a transaction waits, under detection");
+  program.add_argument("--cc").help("concurrency control: 2pl takes locks, occ validates at commit instead");
+  program.add_argument("--contention").help("share of the updates that may pick the NFT of another thread, 0 to 1");
 
   size_t bustub_nft_num = 10;
 
@@ -152,6 +201,34 @@ auto main(int argc, char **argv) -> int {
     return 1;
   }
 
+  std::string deadlock_policy = "detection";
+  if (program.present("--deadlock-policy")) {
+    deadlock_policy = program.get("--deadlock-policy");
+  }
+  if (deadlock_policy == "wait-die") {
+    bustub::deadlock_policy = bustub::DeadlockPolicy::WAIT_DIE;
+  } else if (deadlock_policy == "wound-wait") {
+    bustub::deadlock_policy = bustub::DeadlockPolicy::WOUND_WAIT;
+  } else if (deadlock_policy != "detection") {
+    throw bustub::Exception(fmt::format("unexpected deadlock policy: {}", deadlock_policy));
+  }
+  if (program.present("--check-on-wait")) {
+    bustub::deadlock_check_on_wait = ParseBool(program.get("--check-on-wait"));
+  }
+
+  std::string cc = "2pl";
+  if (program.present("--cc")) {
+    cc = program.get("--cc");
+  }
+  if (cc != "2pl" && cc != "occ") {
+    throw bustub::Exception(fmt::format("unexpected concurrency control: {}", cc));
+  }
+  auto isolation_level = cc == "occ" ? bustub::IsolationLevel::OPTIMISTIC : bustub::IsolationLevel::REPEATABLE_READ;
+  double contention = 0;
+  if (program.present("--contention")) {
+    contention = std::stod(program.get("--contention"));
+  }
+
   auto bustub = std::make_unique<bustub::BustubInstance>();
   auto writer = bustub::SimpleStreamWriter(std::cerr);
 
@@ -245,13 +322,17 @@ auto main(int argc, char **argv) -> int {
 
   for (size_t thread_id = 0; thread_id < BUSTUB_TERRIER_THREAD; thread_id++) {
     threads.emplace_back(
-        std::thread([verbose, thread_id, &bustub, enable_update, duration_ms, &total_metrics, bustub_nft_num] {
+        std::thread([verbose, thread_id, &bustub, enable_update, duration_ms, &total_metrics, bustub_nft_num,
+                     isolation_level, contention] {
           const size_t nft_range_size = bustub_nft_num / BUSTUB_TERRIER_THREAD;
           const size_t nft_range_begin = thread_id * nft_range_size;
           const size_t nft_range_end = (thread_id + 1) * nft_range_size;
           std::random_device r;
           std::default_random_engine gen(r());
           std::uniform_int_distribution<int> nft_uniform_dist(nft_range_begin, nft_range_end - 1);
+          // Only updates leave the NFTs in place, so only they may pick those of the other threads.
+          std::uniform_int_distribution<int> any_nft_dist(0, bustub_nft_num - 1);
+          std::bernoulli_distribution contended_dist(enable_update ? contention : 0);
           std::uniform_int_distribution<int> terrier_uniform_dist(0, BUSTUB_TERRIER_CNT - 1);
 
           TerrierMetrics metrics(fmt::format("Update {}", thread_id), duration_ms);
@@ -260,16 +341,17 @@ auto main(int argc, char **argv) -> int {
           while (!metrics.ShouldFinish()) {
             std::stringstream ss;
             auto writer = bustub::SimpleStreamWriter(ss, true);
-            auto nft_id = nft_uniform_dist(gen);
+            auto nft_id = contended_dist(gen) ? any_nft_dist(gen) : nft_uniform_dist(gen);
             auto terrier_id = terrier_uniform_dist(gen);
             bool txn_success = true;
+            metrics.TxnBegin();
 
             if (verbose) {
               fmt::print("begin: thread {} update nft {} to terrier {}\n", thread_id, nft_id, terrier_id);
             }
 
             if (enable_update) {
-              auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+              auto txn = bustub->txn_manager_->Begin(nullptr, isolation_level);
               std::string query = fmt::format("UPDATE nft SET terrier = {} WHERE id = {}", terrier_id, nft_id);
               if (!bustub->ExecuteSqlTxn(query, writer, txn)) {
                 txn_success = false;
@@ -282,15 +364,18 @@ auto main(int argc, char **argv) -> int {
 
               if (txn_success) {
                 CheckTableLock(txn);
-                bustub->txn_manager_->Commit(txn);
-                metrics.TxnCommitted();
+                if (bustub->txn_manager_->Commit(txn)) {
+                  metrics.TxnCommitted();
+                } else {
+                  metrics.TxnAborted();
+                }
               } else {
                 bustub->txn_manager_->Abort(txn);
                 metrics.TxnAborted();
               }
               delete txn;
             } else {
-              auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+              auto txn = bustub->txn_manager_->Begin(nullptr, isolation_level);
 
               std::string query = fmt::format("DELETE FROM nft WHERE id = {}", nft_id);
               if (!bustub->ExecuteSqlTxn(query, writer, txn)) {
@@ -322,8 +407,11 @@ auto main(int argc, char **argv) -> int {
                   metrics.TxnAborted();
                 } else {
                   CheckTableLock(txn);
-                  bustub->txn_manager_->Commit(txn);
-                  metrics.TxnCommitted();
+                  if (bustub->txn_manager_->Commit(txn)) {
+                    metrics.TxnCommitted();
+                  } else {
+                    metrics.TxnAborted();
+                  }
                 }
                 delete txn;
               }
@@ -336,12 +424,12 @@ auto main(int argc, char **argv) -> int {
             metrics.Report();
           }
 
-          total_metrics.ReportUpdate(metrics.aborted_txn_cnt_, metrics.committed_txn_cnt_);
+          total_metrics.ReportUpdate(metrics.aborted_txn_cnt_, metrics.committed_txn_cnt_, metrics.latencies_us_);
         }));
   }
 
   for (size_t thread_id = 0; thread_id < BUSTUB_TERRIER_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &bustub, duration_ms, &total_metrics] {
+    threads.emplace_back(std::thread([thread_id, &bustub, duration_ms, &total_metrics, isolation_level] {
       std::random_device r;
       std::default_random_engine gen(r());
       std::uniform_int_distribution<int> terrier_uniform_dist(0, BUSTUB_TERRIER_CNT - 1);
@@ -354,7 +442,8 @@ auto main(int argc, char **argv) -> int {
         auto writer = bustub::SimpleStreamWriter(ss, true);
         auto terrier_id = terrier_uniform_dist(gen);
 
-        auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+        metrics.TxnBegin();
+        auto txn = bustub->txn_manager_->Begin(nullptr, isolation_level);
         bool txn_success = true;
 
         std::string query = fmt::format("SELECT count(*) FROM nft WHERE terrier = {}", terrier_id);
@@ -364,8 +453,11 @@ auto main(int argc, char **argv) -> int {
 
         if (txn_success) {
           CheckTableLock(txn);
-          bustub->txn_manager_->Commit(txn);
-          metrics.TxnCommitted();
+          if (bustub->txn_manager_->Commit(txn)) {
+            metrics.TxnCommitted();
+          } else {
+            metrics.TxnAborted();
+          }
         } else {
           bustub->txn_manager_->Abort(txn);
           metrics.TxnAborted();
@@ -375,11 +467,11 @@ auto main(int argc, char **argv) -> int {
         metrics.Report();
       }
 
-      total_metrics.ReportCount(metrics.aborted_txn_cnt_, metrics.committed_txn_cnt_);
+      total_metrics.ReportCount(metrics.aborted_txn_cnt_, metrics.committed_txn_cnt_, metrics.latencies_us_);
     }));
   }
 
-  threads.emplace_back(std::thread([&bustub, duration_ms, &total_metrics, bustub_nft_num] {
+  threads.emplace_back(std::thread([&bustub, duration_ms, &total_metrics, bustub_nft_num, isolation_level] {
     std::random_device r;
     std::default_random_engine gen(r());
     std::uniform_int_distribution<int> terrier_uniform_dist(0, BUSTUB_TERRIER_CNT - 1);
@@ -391,7 +483,8 @@ auto main(int argc, char **argv) -> int {
       std::stringstream ss;
       auto writer = bustub::SimpleStreamWriter(ss, true);
 
-      auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+      metrics.TxnBegin();
+      auto txn = bustub->txn_manager_->Begin(nullptr, isolation_level);
       bool txn_success = true;
 
       std::string query = "SELECT * FROM nft";
@@ -449,8 +542,11 @@ auto main(int argc, char **argv) -> int {
             exit(1);
           }
           CheckTableLock(txn);
-          bustub->txn_manager_->Commit(txn);
-          metrics.TxnCommitted();
+          if (bustub->txn_manager_->Commit(txn)) {
+            metrics.TxnCommitted();
+          } else {
+            metrics.TxnAborted();
+          }
         } else {
           bustub->txn_manager_->Abort(txn);
           metrics.TxnAborted();
@@ -469,7 +565,7 @@ auto main(int argc, char **argv) -> int {
       }
     }
 
-    total_metrics.ReportVerify(metrics.aborted_txn_cnt_, metrics.committed_txn_cnt_);
+    total_metrics.ReportVerify(metrics.aborted_txn_cnt_, metrics.committed_txn_cnt_, metrics.latencies_us_);
   }));
 
   for (auto &thread : threads) {
@@ -516,6 +612,8 @@ auto main(int argc, char **argv) -> int {
   }
 
   total_metrics.Report();
+  fmt::print("concurrency control: {}, contention: {}\n", cc, contention);
+  total_metrics.ReportAbortsAndLatency(deadlock_policy);
 
   if (total_metrics.committed_verify_txn_cnt_ <= 3 || total_metrics.committed_update_txn_cnt_ < 3 ||
       total_metrics.committed_count_txn_cnt_ < 3) {